@@ -0,0 +1,465 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QUuid>
+#include <QStringList>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QTemporaryDir>
+#include <QXmlStreamReader>
+#include <cstdio>
+#include <cmath>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <fstream>
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+#include "json.hpp"
+#include "snapshot.h"
+#include "snapshotxml.h"
+#include "ds3file.h"
+#include "imageforever.h"
+#include "fileforever.h"
+#include "meshgenerator.h"
+#include "meshresultpostprocessor.h"
+#include "texturegenerator.h"
+#include "riggenerator.h"
+#include "generateddiskcache.h"
+#include "rigtype.h"
+#include "util.h"
+
+// Run the whole generation pipeline (mesh, post processing, texture and rig) headlessly over the bundled models
+// and a set of synthetic large skeletons, in these scenarios:
+//
+//   uncached      no generated cache at all, each round is a full generation
+//   memory-warm   one cache context shared by all rounds, what the editor sees when nothing has changed
+//   disk-cold     a fresh cache context and an emptied disk cache each round, the cost of writing the disk cache
+//   disk-warm     a fresh cache context each round over a filled disk cache, what a reopened document sees
+//
+// With --coarse the mesh generator builds the coarse tier the editor shows while nodes are dragged, only the
+// uncached and memory-warm scenarios are run, and the pipeline stops after the mesh generator as the editor does.
+//
+// The median and p95 of each stage and the peak RSS of the process are written as JSON;
+// given a baseline file written by a previous run, the stages slower than the baseline are reported and the exit code is 1.
+//
+// usage: generation [--rounds N] [--coarse] [--output result.json] [--baseline baseline.json] [--threshold 0.1] [model.ds3|model.xml ...]
+//
+// The model paths are relative to the working directory, the default models are looked up from the root of the source tree.
+
+static const int defaultRoundCount = 5;
+static const double defaultThreshold = 0.1;
+static const double regressionNoiseFloorMilliseconds = 1.0;
+
+struct BenchmarkModel
+{
+    QString name;
+    Snapshot snapshot;
+};
+
+struct StageTimings
+{
+    std::map<std::string, std::vector<double>> milliseconds;
+};
+
+static bool loadModel(const QString &path, Snapshot *snapshot)
+{
+    if (path.endsWith(".xml")) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return false;
+        QXmlStreamReader stream(&file);
+        loadSkeletonFromXmlStream(snapshot, stream);
+        return true;
+    }
+    
+    if (!QFileInfo(path).exists())
+        return false;
+    
+    Ds3FileReader ds3Reader(path);
+    bool isModelLoaded = false;
+    for (int i = 0; i < ds3Reader.items().size(); ++i) {
+        Ds3ReaderItem item = ds3Reader.items().at(i);
+        if (item.type == "asset") {
+            if (item.name.startsWith("images/")) {
+                QString filename = item.name.split("/")[1];
+                QString imageIdString = filename.split(".")[0];
+                QUuid imageId = QUuid(imageIdString);
+                if (!imageId.isNull()) {
+                    QByteArray data;
+                    ds3Reader.loadItem(item.name, &data);
+                    QImage image = QImage::fromData(data, "PNG");
+                    (void)ImageForever::add(&image, imageId);
+                }
+            } else if (item.name.startsWith("files/")) {
+                QString filename = item.name.split("/")[1];
+                QString fileIdString = filename.split(".")[0];
+                QUuid fileId = QUuid(fileIdString);
+                if (!fileId.isNull()) {
+                    QByteArray data;
+                    ds3Reader.loadItem(item.name, &data);
+                    (void)FileForever::add(item.name, data, fileId);
+                }
+            }
+        }
+    }
+    for (int i = 0; i < ds3Reader.items().size(); ++i) {
+        Ds3ReaderItem item = ds3Reader.items().at(i);
+        if (item.type == "model") {
+            QByteArray data;
+            ds3Reader.loadItem(item.name, &data);
+            QXmlStreamReader stream(data);
+            loadSkeletonFromXmlStream(snapshot, stream);
+            isModelLoaded = true;
+        }
+    }
+    return isModelLoaded;
+}
+
+// Chains of nodes laid out side by side; when the spacing is smaller than the radius the parts overlap,
+// so each combination is a real boolean operation instead of a disjoint merge
+static void buildSyntheticSnapshot(Snapshot *snapshot, int partCount, int nodeCountPerPart,
+    float partSpacing, bool xMirrored)
+{
+    snapshot->canvas["originX"] = "0.5";
+    snapshot->canvas["originY"] = "0.5";
+    snapshot->canvas["originZ"] = "0.5";
+    QStringList rootChildren;
+    for (int i = 0; i < partCount; ++i) {
+        QString partIdString = QUuid::createUuid().toString();
+        auto &part = snapshot->parts[partIdString];
+        part["id"] = partIdString;
+        part["subdived"] = (i % 2) ? "true" : "false";
+        part["rounded"] = "true";
+        part["color"] = (i % 3) ? "#ff8800" : "#0088ff";
+        if (xMirrored)
+            part["xMirrored"] = "true";
+        QString previousNodeIdString;
+        for (int j = 0; j < nodeCountPerPart; ++j) {
+            QString nodeIdString = QUuid::createUuid().toString();
+            auto &node = snapshot->nodes[nodeIdString];
+            node["id"] = nodeIdString;
+            node["partId"] = partIdString;
+            node["radius"] = QString::number(0.01 + 0.005 * std::sin(j * 0.7));
+            node["x"] = QString::number(0.52 + (i % 10) * partSpacing);
+            node["y"] = QString::number(0.2 + j * 0.02);
+            node["z"] = QString::number(0.5 + (i / 10) * partSpacing + 0.01 * std::cos(j * 0.5));
+            if (!previousNodeIdString.isEmpty()) {
+                QString edgeIdString = QUuid::createUuid().toString();
+                auto &edge = snapshot->edges[edgeIdString];
+                edge["id"] = edgeIdString;
+                edge["partId"] = partIdString;
+                edge["from"] = previousNodeIdString;
+                edge["to"] = nodeIdString;
+            }
+            previousNodeIdString = nodeIdString;
+        }
+        QString componentIdString = QUuid::createUuid().toString();
+        auto &component = snapshot->components[componentIdString];
+        component["id"] = componentIdString;
+        component["linkDataType"] = "partId";
+        component["linkData"] = partIdString;
+        component["combineMode"] = "Normal";
+        rootChildren.append(componentIdString);
+    }
+    snapshot->rootComponent["children"] = rootChildren.join(",");
+}
+
+static void runPipeline(const Snapshot &snapshot, bool coarseTier, GeneratedCacheContext *cacheContext,
+    GeneratedDiskCache *diskCache, StageTimings *timings)
+{
+    QElapsedTimer timer;
+    auto record = [&](const char *stage) {
+        if (nullptr != timings)
+            timings->milliseconds[stage].push_back(timer.nsecsElapsed() / 1000000.0);
+    };
+    
+    timer.start();
+    MeshGenerator *meshGenerator = new MeshGenerator(new Snapshot(snapshot));
+    meshGenerator->setGeneratedCacheContext(cacheContext);
+    meshGenerator->setCoarseTierEnabled(coarseTier);
+    meshGenerator->setDiskCache(diskCache);
+    meshGenerator->generate();
+    Object *object = meshGenerator->takeObject();
+    delete meshGenerator;
+    record("MeshGenerator");
+    if (nullptr == object)
+        return;
+    if (coarseTier) {
+        delete object;
+        return;
+    }
+    
+    timer.restart();
+    MeshResultPostProcessor *postProcessor = new MeshResultPostProcessor(*object);
+    postProcessor->poseProcess();
+    Object *postProcessedObject = postProcessor->takePostProcessedObject();
+    delete postProcessor;
+    record("MeshResultPostProcessor");
+    
+    timer.restart();
+    TextureGenerator *textureGenerator = new TextureGenerator(*postProcessedObject, new Snapshot(snapshot));
+    textureGenerator->generate();
+    delete textureGenerator;
+    record("TextureGenerator");
+    
+    RigType rigType = RigTypeFromString(valueOfKeyInMapOrEmpty(snapshot.canvas, "rigType").toUtf8().constData());
+    if (RigType::None != rigType) {
+        timer.restart();
+        RigGenerator *rigGenerator = new RigGenerator(rigType, *postProcessedObject);
+        rigGenerator->generate();
+        delete rigGenerator;
+        record("RigGenerator");
+    }
+    
+    delete postProcessedObject;
+    delete object;
+}
+
+static void runScenario(const std::string &scenario, const Snapshot &snapshot, bool coarseTier, int roundCount,
+    const QString &diskCacheDirectory, StageTimings *timings)
+{
+    if ("uncached" == scenario) {
+        for (int round = 0; round < roundCount; ++round)
+            runPipeline(snapshot, coarseTier, nullptr, nullptr, timings);
+    } else if ("memory-warm" == scenario) {
+        GeneratedCacheContext cacheContext;
+        runPipeline(snapshot, coarseTier, &cacheContext, nullptr, nullptr);
+        for (int round = 0; round < roundCount; ++round)
+            runPipeline(snapshot, coarseTier, &cacheContext, nullptr, timings);
+    } else if ("disk-cold" == scenario) {
+        GeneratedDiskCache diskCache(diskCacheDirectory, GeneratedDiskCache::defaultMaxSize);
+        for (int round = 0; round < roundCount; ++round) {
+            diskCache.clear();
+            GeneratedCacheContext cacheContext;
+            runPipeline(snapshot, coarseTier, &cacheContext, &diskCache, timings);
+        }
+    } else if ("disk-warm" == scenario) {
+        GeneratedDiskCache diskCache(diskCacheDirectory, GeneratedDiskCache::defaultMaxSize);
+        diskCache.clear();
+        {
+            GeneratedCacheContext cacheContext;
+            runPipeline(snapshot, coarseTier, &cacheContext, &diskCache, nullptr);
+        }
+        diskCache.flush();
+        for (int round = 0; round < roundCount; ++round) {
+            GeneratedCacheContext cacheContext;
+            runPipeline(snapshot, coarseTier, &cacheContext, &diskCache, timings);
+        }
+    }
+}
+
+static double percentile(std::vector<double> values, double fraction)
+{
+    if (values.empty())
+        return 0;
+    std::sort(values.begin(), values.end());
+    size_t rank = (size_t)std::ceil(fraction * values.size());
+    if (rank > 0)
+        --rank;
+    return values[std::min(rank, values.size() - 1)];
+}
+
+static qint64 peakResidentSetSizeInKilobytes()
+{
+#ifdef Q_OS_WIN
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return counters.PeakWorkingSetSize / 1024;
+#else
+    struct rusage usage;
+    if (0 != getrusage(RUSAGE_SELF, &usage))
+        return 0;
+#ifdef Q_OS_MAC
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+static std::string resultKey(const nlohmann::json &result)
+{
+    return result["model"].get<std::string>() + "/" +
+        result["scenario"].get<std::string>() + "/" +
+        result["stage"].get<std::string>();
+}
+
+// Returns the number of regressions
+static int compareWithBaseline(const nlohmann::json &report, const nlohmann::json &baseline, double threshold)
+{
+    std::map<std::string, double> baselineMedians;
+    for (const auto &result: baseline["results"])
+        baselineMedians[resultKey(result)] = result["medianMs"].get<double>();
+    
+    int regressionCount = 0;
+    for (const auto &result: report["results"]) {
+        std::string key = resultKey(result);
+        auto findBaseline = baselineMedians.find(key);
+        if (findBaseline == baselineMedians.end()) {
+            fprintf(stderr, "new:        %s %.3f ms\n", key.c_str(), result["medianMs"].get<double>());
+            continue;
+        }
+        double median = result["medianMs"].get<double>();
+        double baselineMedian = findBaseline->second;
+        if (median > baselineMedian * (1.0 + threshold) &&
+                median - baselineMedian > regressionNoiseFloorMilliseconds) {
+            fprintf(stderr, "REGRESSION: %s %.3f ms -> %.3f ms (%+.1f%%)\n", key.c_str(),
+                baselineMedian, median, (median / baselineMedian - 1.0) * 100);
+            ++regressionCount;
+        } else if (median < baselineMedian * (1.0 - threshold) &&
+                baselineMedian - median > regressionNoiseFloorMilliseconds) {
+            fprintf(stderr, "improved:   %s %.3f ms -> %.3f ms (%+.1f%%)\n", key.c_str(),
+                baselineMedian, median, (median / baselineMedian - 1.0) * 100);
+        }
+    }
+    
+    qint64 baselinePeakRss = baseline.value("peakRssKb", (qint64)0);
+    qint64 peakRss = report["peakRssKb"].get<qint64>();
+    if (baselinePeakRss > 0 && peakRss > baselinePeakRss * (1.0 + threshold)) {
+        fprintf(stderr, "REGRESSION: peak RSS %lld KB -> %lld KB\n", (long long)baselinePeakRss, (long long)peakRss);
+        ++regressionCount;
+    }
+    return regressionCount;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    
+    int roundCount = defaultRoundCount;
+    bool coarseTier = false;
+    double threshold = defaultThreshold;
+    QString outputPath;
+    QString baselinePath;
+    QStringList modelPaths;
+    QStringList arguments = app.arguments();
+    for (int i = 1; i < arguments.size(); ++i) {
+        const QString &argument = arguments[i];
+        bool hasValue = i + 1 < arguments.size();
+        if ("--rounds" == argument && hasValue)
+            roundCount = std::max(1, arguments[++i].toInt());
+        else if ("--coarse" == argument)
+            coarseTier = true;
+        else if ("--output" == argument && hasValue)
+            outputPath = arguments[++i];
+        else if ("--baseline" == argument && hasValue)
+            baselinePath = arguments[++i];
+        else if ("--threshold" == argument && hasValue)
+            threshold = arguments[++i].toDouble();
+        else
+            modelPaths.append(argument);
+    }
+    
+    std::vector<BenchmarkModel> models;
+    if (modelPaths.isEmpty()) {
+        QString sourceRoot = QString(SOURCE_ROOT_DIR);
+        modelPaths << sourceRoot + "resources/material-demo-model.ds3";
+        modelPaths << sourceRoot + "resources/model-cat.ds3";
+    }
+    for (const auto &path: modelPaths) {
+        BenchmarkModel model;
+        model.name = QFileInfo(path).fileName();
+        if (!loadModel(path, &model.snapshot)) {
+            fprintf(stderr, "Load model failed: %s\n", path.toUtf8().constData());
+            return 2;
+        }
+        models.push_back(model);
+    }
+    {
+        BenchmarkModel model;
+        model.name = "synthetic-chains-100x20";
+        buildSyntheticSnapshot(&model.snapshot, 100, 20, 0.05, false);
+        models.push_back(model);
+    }
+    {
+        BenchmarkModel model;
+        model.name = "synthetic-overlapped-100x20";
+        buildSyntheticSnapshot(&model.snapshot, 100, 20, 0.008, false);
+        models.push_back(model);
+    }
+    {
+        BenchmarkModel model;
+        model.name = "synthetic-mirrored-50x20";
+        buildSyntheticSnapshot(&model.snapshot, 50, 20, 0.008, true);
+        models.push_back(model);
+    }
+    
+    QTemporaryDir diskCacheDirectory;
+    if (!diskCacheDirectory.isValid()) {
+        fprintf(stderr, "Create temporary directory failed\n");
+        return 2;
+    }
+    
+    // The coarse tier does not use the disk cache
+    std::vector<std::string> scenarios = {
+        "uncached",
+        "memory-warm"
+    };
+    if (!coarseTier) {
+        scenarios.push_back("disk-cold");
+        scenarios.push_back("disk-warm");
+    }
+    
+    nlohmann::json report = {
+        {"rounds", roundCount},
+        {"coarse", coarseTier},
+        {"results", nlohmann::json::array()}
+    };
+    for (const auto &model: models) {
+        for (const auto &scenario: scenarios) {
+            StageTimings timings;
+            runScenario(scenario, model.snapshot, coarseTier, roundCount, diskCacheDirectory.path(), &timings);
+            for (const auto &it: timings.milliseconds) {
+                nlohmann::json result = {
+                    {"model", model.name.toUtf8().toStdString()},
+                    {"scenario", scenario},
+                    {"stage", it.first},
+                    {"samples", it.second.size()},
+                    {"medianMs", percentile(it.second, 0.5)},
+                    {"p95Ms", percentile(it.second, 0.95)}
+                };
+                fprintf(stderr, "%s %s %s: median %.3f ms p95 %.3f ms\n",
+                    model.name.toUtf8().constData(), scenario.c_str(), it.first.c_str(),
+                    result["medianMs"].get<double>(), result["p95Ms"].get<double>());
+                report["results"].push_back(result);
+            }
+        }
+    }
+    report["peakRssKb"] = peakResidentSetSizeInKilobytes();
+    
+    std::string content = report.dump(4);
+    if (outputPath.isEmpty()) {
+        printf("%s\n", content.c_str());
+    } else {
+        std::ofstream file(outputPath.toLocal8Bit().constData());
+        file << content << std::endl;
+    }
+    
+    if (!baselinePath.isEmpty()) {
+        std::ifstream file(baselinePath.toLocal8Bit().constData());
+        if (!file) {
+            fprintf(stderr, "Open baseline failed: %s\n", baselinePath.toUtf8().constData());
+            return 2;
+        }
+        nlohmann::json baseline;
+        try {
+            file >> baseline;
+        } catch (const std::exception &exception) {
+            fprintf(stderr, "Parse baseline failed: %s\n", exception.what());
+            return 2;
+        }
+        int regressionCount = compareWithBaseline(report, baseline, threshold);
+        fprintf(stderr, "regressions: %d (threshold %.0f%%)\n", regressionCount, threshold * 100);
+        if (regressionCount > 0)
+            return 1;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,27 @@
+TEMPLATE = app
+
+CONFIG += console
+CONFIG -= app_bundle
+
+VPATH += ../../
+
+SOURCE_ROOT = ../../
+
+include(../../dust3d.pro)
+
+TARGET = generation
+
+SOURCES -= src/main.cpp
+SOURCES += benchmark/generation/generation.cpp
+
+for(path, INCLUDEPATH) {
+    PREFIXED_INCLUDEPATH += "../../$$path"
+}
+
+INCLUDEPATH += $$PREFIXED_INCLUDEPATH
+
+DEFINES += SOURCE_ROOT_DIR=\\\"$$PWD/../../\\\"
+
+win32 {
+    LIBS += -lpsapi
+}
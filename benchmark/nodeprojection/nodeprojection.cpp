@@ -0,0 +1,133 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QVector3D>
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <random>
+#include <limits>
+#include <algorithm>
+#include "projectfacestonodes.h"
+#include "util.h"
+
+// Compare the projection of the remeshed faces to the interpolated nodes, the brute force scan over all the nodes,
+// as it was before the node sphere tree, against projectFacesToNodes, for 100,000 faces by 5,000 nodes
+
+static const int nodeCount = 5000;
+static const int faceCount = 100000;
+static const int chainCount = 20;
+static const int roundCount = 3;
+
+static void buildNodes(std::vector<std::pair<QVector3D, float>> *nodes)
+{
+    std::mt19937 generator(0);
+    std::uniform_real_distribution<float> distribution(-1.0, 1.0);
+    int nodesPerChain = nodeCount / chainCount;
+    for (int chain = 0; chain < chainCount; ++chain) {
+        QVector3D position(distribution(generator), distribution(generator), distribution(generator));
+        QVector3D direction = QVector3D(distribution(generator), distribution(generator), distribution(generator)).normalized();
+        for (int i = 0; i < nodesPerChain; ++i) {
+            float radius = 0.01f + 0.01f * (1.0f + distribution(generator));
+            nodes->push_back({position, radius});
+            direction = (direction + 0.2f * QVector3D(distribution(generator), distribution(generator), distribution(generator))).normalized();
+            position += direction * radius * 0.5f;
+        }
+    }
+}
+
+static void buildFaces(const std::vector<std::pair<QVector3D, float>> &nodes,
+    std::vector<QVector3D> *vertices, std::vector<std::vector<size_t>> *faces)
+{
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<float> distribution(-1.0, 1.0);
+    std::uniform_int_distribution<size_t> nodeDistribution(0, nodes.size() - 1);
+    for (int i = 0; i < faceCount; ++i) {
+        const auto &node = nodes[nodeDistribution(generator)];
+        QVector3D normal = QVector3D(distribution(generator), distribution(generator), distribution(generator)).normalized();
+        QVector3D center = node.first + normal * node.second * (1.0f + 0.1f * distribution(generator));
+        QVector3D tangent = QVector3D::crossProduct(normal, QVector3D(0.577f, 0.577f, 0.577f)).normalized();
+        QVector3D bitangent = QVector3D::crossProduct(normal, tangent);
+        float size = node.second * 0.2f;
+        size_t begin = vertices->size();
+        vertices->push_back(center + tangent * size);
+        vertices->push_back(center + (bitangent * 0.866f - tangent * 0.5f) * size);
+        vertices->push_back(center + (-bitangent * 0.866f - tangent * 0.5f) * size);
+        faces->push_back({begin, begin + 1, begin + 2});
+    }
+}
+
+static void bruteForceProjectFacesToNodes(const std::vector<QVector3D> &vertices,
+    const std::vector<std::vector<size_t>> &faces,
+    const std::vector<std::pair<QVector3D, float>> &sourceNodes,
+    std::vector<size_t> *faceSources)
+{
+    faceSources->resize(faces.size(), std::numeric_limits<size_t>::max());
+    for (size_t i = 0; i < faces.size(); ++i) {
+        const auto &face = faces[i];
+        std::vector<std::pair<size_t, float>> distanceWithNodes;
+        for (size_t j = 0; j < sourceNodes.size(); ++j) {
+            const auto &nodePosition = sourceNodes[j].first;
+            float nodeRadius = sourceNodes[j].second;
+            QVector3D faceCenter;
+            for (const auto &it: face)
+                faceCenter += vertices[it];
+            faceCenter /= face.size();
+            auto ray = (nodePosition - faceCenter).normalized();
+            auto inversedFaceNormal = -polygonNormal(vertices, face);
+            float distance = (faceCenter - nodePosition).length();
+            if (distance > nodeRadius * 1.5f)
+                continue;
+            if (QVector3D::dotProduct(ray, inversedFaceNormal) < 0.707) {
+                if (distance > nodeRadius * 1.01f)
+                    continue;
+            }
+            distanceWithNodes.push_back(std::make_pair(j, distance));
+        }
+        if (distanceWithNodes.empty())
+            continue;
+        (*faceSources)[i] = std::min_element(distanceWithNodes.begin(), distanceWithNodes.end(), [](const std::pair<size_t, float> &first, const std::pair<size_t, float> &second) {
+            return first.second < second.second;
+        })->first;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    std::vector<std::pair<QVector3D, float>> nodes;
+    std::vector<QVector3D> vertices;
+    std::vector<std::vector<size_t>> faces;
+    buildNodes(&nodes);
+    buildFaces(nodes, &vertices, &faces);
+
+    printf("faces: %d nodes: %d rounds: %d\n", (int)faces.size(), (int)nodes.size(), roundCount);
+
+    QElapsedTimer timer;
+    std::vector<size_t> bruteForceSources;
+    timer.start();
+    bruteForceProjectFacesToNodes(vertices, faces, nodes, &bruteForceSources);
+    printf("brute force: %lld ms\n", (long long)timer.elapsed());
+
+    std::vector<size_t> faceSources;
+    qint64 milliseconds = 0;
+    for (int round = 0; round < roundCount; ++round) {
+        faceSources.clear();
+        timer.restart();
+        projectFacesToNodes(vertices, faces, nodes, &faceSources);
+        milliseconds += timer.elapsed();
+    }
+    printf("node sphere tree: %.1f ms\n", (double)milliseconds / roundCount);
+
+    size_t projected = 0;
+    size_t mismatched = 0;
+    for (size_t i = 0; i < faces.size(); ++i) {
+        if (faceSources[i] != bruteForceSources[i])
+            ++mismatched;
+        if (faceSources[i] < nodes.size())
+            ++projected;
+    }
+    printf("projected: %d mismatched: %d\n", (int)projected, (int)mismatched);
+
+    return 0;
+}
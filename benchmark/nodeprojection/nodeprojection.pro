@@ -0,0 +1,21 @@
+TEMPLATE = app
+
+CONFIG += console
+CONFIG -= app_bundle
+
+VPATH += ../../
+
+SOURCE_ROOT = ../../
+
+include(../../dust3d.pro)
+
+TARGET = nodeprojection
+
+SOURCES -= src/main.cpp
+SOURCES += benchmark/nodeprojection/nodeprojection.cpp
+
+for(path, INCLUDEPATH) {
+    PREFIXED_INCLUDEPATH += "../../$$path"
+}
+
+INCLUDEPATH += $$PREFIXED_INCLUDEPATH
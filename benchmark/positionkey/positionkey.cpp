@@ -0,0 +1,72 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QVector3D>
+#include <cstdio>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <random>
+#include "positionkey.h"
+#include "openhashmap.h"
+
+// Compare the position lookups of the generation pipeline (vertex sources, seam exclusion, node vertices)
+// on std::map, std::unordered_map and the open addressing map, for 1,000,000 vertices of which half are found
+
+static const int vertexCount = 1000000;
+static const int roundCount = 5;
+
+static void buildPositions(std::vector<QVector3D> *inserted, std::vector<QVector3D> *queried)
+{
+    std::mt19937 generator(0);
+    std::uniform_real_distribution<float> distribution(-1.0, 1.0);
+    for (int i = 0; i < vertexCount; ++i)
+        inserted->push_back(QVector3D(distribution(generator), distribution(generator), distribution(generator)));
+    for (int i = 0; i < vertexCount; ++i) {
+        if (0 == i % 2)
+            queried->push_back((*inserted)[(i * 7919) % vertexCount]);
+        else
+            queried->push_back(QVector3D(distribution(generator), distribution(generator), distribution(generator)));
+    }
+}
+
+template <class Map>
+static void run(const char *name, const std::vector<QVector3D> &inserted, const std::vector<QVector3D> &queried)
+{
+    QElapsedTimer timer;
+    qint64 insertNanoseconds = 0;
+    qint64 lookupNanoseconds = 0;
+    size_t found = 0;
+    for (int round = 0; round < roundCount; ++round) {
+        Map map;
+        timer.restart();
+        for (size_t i = 0; i < inserted.size(); ++i)
+            map.insert({PositionKey(inserted[i]), i});
+        insertNanoseconds += timer.nsecsElapsed();
+        timer.restart();
+        for (const auto &position: queried) {
+            if (map.find(PositionKey(position)) != map.end())
+                ++found;
+        }
+        lookupNanoseconds += timer.nsecsElapsed();
+    }
+    printf("%s: insert %.1f M/s, lookup %.1f M/s, found %d\n", name,
+        (double)vertexCount * roundCount / insertNanoseconds * 1000,
+        (double)vertexCount * roundCount / lookupNanoseconds * 1000,
+        (int)(found / roundCount));
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    std::vector<QVector3D> inserted;
+    std::vector<QVector3D> queried;
+    buildPositions(&inserted, &queried);
+
+    printf("vertices: %d rounds: %d key size: %d bytes\n", vertexCount, roundCount, (int)sizeof(PositionKey));
+    run<std::map<PositionKey, size_t>>("std::map", inserted, queried);
+    run<std::unordered_map<PositionKey, size_t>>("std::unordered_map", inserted, queried);
+    run<OpenHashMap<PositionKey, size_t>>("OpenHashMap", inserted, queried);
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+// The self intersection test of MeshCombiner, with the same define before the CGAL includes
+#define CGAL_LINKED_WITH_TBB
+#include <CGAL/Polygon_mesh_processing/self_intersections.h>
+#include <tbb/task_arena.h>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include "booleanmesh.h"
+
+// Time does_self_intersect given CGAL::Sequential_tag and CGAL::Parallel_tag on closed spheres of growing face counts,
+// the numbers behind the face count from which MeshCombiner switches to the parallel test
+//
+// usage: selfintersection [--threads N]
+
+static const int ringCounts[] = {8, 12, 16, 24, 32, 48, 64, 96, 128};
+
+// A closed sphere of about four times ringCount squared triangles
+static CgalMesh buildSphere(int ringCount)
+{
+    CgalMesh mesh;
+    int segmentCount = ringCount * 2;
+    std::vector<CgalMesh::Vertex_index> vertices;
+    auto top = mesh.add_vertex(CgalKernel::Point_3(0, 1, 0));
+    for (int ring = 1; ring < ringCount; ++ring) {
+        double polar = M_PI * ring / ringCount;
+        for (int segment = 0; segment < segmentCount; ++segment) {
+            double azimuth = 2 * M_PI * segment / segmentCount;
+            vertices.push_back(mesh.add_vertex(CgalKernel::Point_3(std::sin(polar) * std::cos(azimuth),
+                std::cos(polar), std::sin(polar) * std::sin(azimuth))));
+        }
+    }
+    auto bottom = mesh.add_vertex(CgalKernel::Point_3(0, -1, 0));
+    auto vertexAt = [&](int ring, int segment) {
+        return vertices[(ring - 1) * segmentCount + (segment % segmentCount)];
+    };
+    for (int segment = 0; segment < segmentCount; ++segment)
+        mesh.add_face(top, vertexAt(1, segment + 1), vertexAt(1, segment));
+    for (int ring = 1; ring < ringCount - 1; ++ring) {
+        for (int segment = 0; segment < segmentCount; ++segment) {
+            mesh.add_face(vertexAt(ring, segment), vertexAt(ring, segment + 1), vertexAt(ring + 1, segment + 1));
+            mesh.add_face(vertexAt(ring, segment), vertexAt(ring + 1, segment + 1), vertexAt(ring + 1, segment));
+        }
+    }
+    for (int segment = 0; segment < segmentCount; ++segment)
+        mesh.add_face(bottom, vertexAt(ringCount - 1, segment), vertexAt(ringCount - 1, segment + 1));
+    return mesh;
+}
+
+template <class ConcurrencyTag>
+static double medianMicroseconds(const CgalMesh &mesh, int roundCount, bool *selfIntersects)
+{
+    std::vector<double> microseconds;
+    QElapsedTimer timer;
+    for (int round = 0; round < roundCount; ++round) {
+        timer.restart();
+        *selfIntersects = CGAL::Polygon_mesh_processing::does_self_intersect<ConcurrencyTag>(mesh);
+        microseconds.push_back(timer.nsecsElapsed() / 1000.0);
+    }
+    std::sort(microseconds.begin(), microseconds.end());
+    return microseconds[microseconds.size() / 2];
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    int threadCount = tbb::task_arena::automatic;
+    QStringList arguments = app.arguments();
+    for (int i = 1; i < arguments.size(); ++i) {
+        if ("--threads" == arguments[i] && i + 1 < arguments.size())
+            threadCount = std::max(1, arguments[++i].toInt());
+    }
+
+    bool failed = false;
+    tbb::task_arena arena(threadCount);
+    arena.execute([&]() {
+        printf("threads: %d\n", tbb::this_task_arena::max_concurrency());
+        for (int ringCount: ringCounts) {
+            CgalMesh mesh = buildSphere(ringCount);
+            int roundCount = std::max(5, 200000 / (int)mesh.number_of_faces());
+            bool sequentialSelfIntersects = false;
+            bool parallelSelfIntersects = false;
+            double sequentialMicroseconds = medianMicroseconds<CGAL::Sequential_tag>(mesh, roundCount, &sequentialSelfIntersects);
+            double parallelMicroseconds = medianMicroseconds<CGAL::Parallel_tag>(mesh, roundCount, &parallelSelfIntersects);
+            printf("faces %6d sequential %9.1f us parallel %9.1f us ratio %.2f\n", (int)mesh.number_of_faces(),
+                sequentialMicroseconds, parallelMicroseconds, parallelMicroseconds / sequentialMicroseconds);
+            if (sequentialSelfIntersects || parallelSelfIntersects)
+                failed = true;
+        }
+    });
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,21 @@
+TEMPLATE = app
+
+CONFIG += console
+CONFIG -= app_bundle
+
+VPATH += ../../
+
+SOURCE_ROOT = ../../
+
+include(../../dust3d.pro)
+
+TARGET = selfintersection
+
+SOURCES -= src/main.cpp
+SOURCES += benchmark/selfintersection/selfintersection.cpp
+
+for(path, INCLUDEPATH) {
+    PREFIXED_INCLUDEPATH += "../../$$path"
+}
+
+INCLUDEPATH += $$PREFIXED_INCLUDEPATH
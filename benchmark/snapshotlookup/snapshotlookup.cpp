@@ -0,0 +1,157 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QUuid>
+#include <QStringList>
+#include <cstdio>
+#include <map>
+#include <set>
+#include "snapshot.h"
+#include "compiledsnapshot.h"
+#include "util.h"
+
+// Compare the attribute lookups of the generation pipeline on the raw snapshot maps
+// with the same lookups on the compiled snapshot, for a document of 2,000 nodes
+
+static const int partCount = 100;
+static const int nodeCountPerPart = 20;
+static const int roundCount = 100;
+
+static void buildSnapshot(Snapshot *snapshot)
+{
+    snapshot->canvas["originX"] = "0.5";
+    snapshot->canvas["originY"] = "0.5";
+    snapshot->canvas["originZ"] = "0.5";
+    QStringList rootChildren;
+    for (int i = 0; i < partCount; ++i) {
+        QString partIdString = QUuid::createUuid().toString();
+        auto &part = snapshot->parts[partIdString];
+        part["id"] = partIdString;
+        part["subdived"] = "true";
+        part["rounded"] = "false";
+        part["color"] = "#ff8800";
+        part["deformThickness"] = "1.2";
+        part["deformWidth"] = "0.8";
+        part["cutFace"] = "Quad";
+        QString previousNodeIdString;
+        for (int j = 0; j < nodeCountPerPart; ++j) {
+            QString nodeIdString = QUuid::createUuid().toString();
+            auto &node = snapshot->nodes[nodeIdString];
+            node["id"] = nodeIdString;
+            node["partId"] = partIdString;
+            node["radius"] = QString::number(0.01 + j * 0.001);
+            node["x"] = QString::number(0.5 + i * 0.001);
+            node["y"] = QString::number(0.5 + j * 0.01);
+            node["z"] = QString::number(0.5);
+            if (!previousNodeIdString.isEmpty()) {
+                QString edgeIdString = QUuid::createUuid().toString();
+                auto &edge = snapshot->edges[edgeIdString];
+                edge["id"] = edgeIdString;
+                edge["partId"] = partIdString;
+                edge["from"] = previousNodeIdString;
+                edge["to"] = nodeIdString;
+            }
+            previousNodeIdString = nodeIdString;
+        }
+        QString componentIdString = QUuid::createUuid().toString();
+        auto &component = snapshot->components[componentIdString];
+        component["id"] = componentIdString;
+        component["linkDataType"] = "partId";
+        component["linkData"] = partIdString;
+        component["combineMode"] = "Normal";
+        rootChildren.append(componentIdString);
+    }
+    snapshot->rootComponent["children"] = rootChildren.join(",");
+}
+
+static float lookupSnapshot(const Snapshot &snapshot)
+{
+    float sum = 0;
+    std::map<QString, std::set<QString>> partNodeIds;
+    for (const auto &nodeIt: snapshot.nodes)
+        partNodeIds[valueOfKeyInMapOrEmpty(nodeIt.second, "partId")].insert(nodeIt.first);
+    for (const auto &childIdString: valueOfKeyInMapOrEmpty(snapshot.rootComponent, "children").split(",")) {
+        if (childIdString.isEmpty())
+            continue;
+        const auto &component = snapshot.components.find(childIdString)->second;
+        if (CombineMode::Inversion == CombineModeFromString(valueOfKeyInMapOrEmpty(component, "combineMode").toUtf8().constData()))
+            sum += 1;
+        QString partIdString = valueOfKeyInMapOrEmpty(component, "linkData");
+        const auto &part = snapshot.parts.find(partIdString)->second;
+        if (isTrueValueString(valueOfKeyInMapOrEmpty(part, "subdived")))
+            sum += 1;
+        if (isTrueValueString(valueOfKeyInMapOrEmpty(part, "rounded")))
+            sum += 1;
+        sum += valueOfKeyInMapOrEmpty(part, "deformThickness").toFloat();
+        sum += valueOfKeyInMapOrEmpty(part, "deformWidth").toFloat();
+        for (const auto &nodeIdString: partNodeIds[partIdString]) {
+            const auto &node = snapshot.nodes.find(nodeIdString)->second;
+            sum += valueOfKeyInMapOrEmpty(node, "radius").toFloat();
+            sum += valueOfKeyInMapOrEmpty(node, "x").toFloat();
+            sum += valueOfKeyInMapOrEmpty(node, "y").toFloat();
+            sum += valueOfKeyInMapOrEmpty(node, "z").toFloat();
+        }
+    }
+    return sum;
+}
+
+static float lookupCompiledSnapshot(const CompiledSnapshot &compiledSnapshot)
+{
+    float sum = 0;
+    for (const auto &childIndex: compiledSnapshot.components[0].childIndices) {
+        const auto &component = compiledSnapshot.components[childIndex];
+        if (CombineMode::Inversion == component.combineMode)
+            sum += 1;
+        const auto &part = compiledSnapshot.parts[component.linkPartIndex];
+        if (part.subdived)
+            sum += 1;
+        if (part.rounded)
+            sum += 1;
+        sum += part.deformThickness;
+        sum += part.deformWidth;
+        for (const auto &nodeIndex: part.nodeIndices) {
+            const auto &node = compiledSnapshot.nodes[nodeIndex];
+            sum += node.radius;
+            sum += node.x;
+            sum += node.y;
+            sum += node.z;
+        }
+    }
+    return sum;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    Snapshot snapshot;
+    buildSnapshot(&snapshot);
+
+    QElapsedTimer timer;
+    float checksum = 0;
+
+    timer.start();
+    for (int i = 0; i < roundCount; ++i)
+        checksum += lookupSnapshot(snapshot);
+    qint64 snapshotNanoseconds = timer.nsecsElapsed();
+
+    // The compilation happens once per generation, so it is part of each round
+    CompiledSnapshot compiledSnapshot;
+    qint64 compileNanoseconds = 0;
+    qint64 compiledSnapshotNanoseconds = 0;
+    for (int i = 0; i < roundCount; ++i) {
+        timer.restart();
+        compiledSnapshot.compile(snapshot);
+        compileNanoseconds += timer.nsecsElapsed();
+        timer.restart();
+        checksum -= lookupCompiledSnapshot(compiledSnapshot);
+        compiledSnapshotNanoseconds += timer.nsecsElapsed();
+    }
+
+    printf("nodes: %d rounds: %d\n", (int)snapshot.nodes.size(), roundCount);
+    printf("snapshot lookup: %.3f ms/round\n", snapshotNanoseconds / 1000000.0 / roundCount);
+    printf("compile: %.3f ms/round\n", compileNanoseconds / 1000000.0 / roundCount);
+    printf("compiled snapshot lookup: %.3f ms/round\n", compiledSnapshotNanoseconds / 1000000.0 / roundCount);
+    printf("checksum difference: %f\n", checksum);
+
+    return 0;
+}
@@ -0,0 +1,216 @@
+#include <QGuiApplication>
+#include <QElapsedTimer>
+#include <QUuid>
+#include <QStringList>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QXmlStreamReader>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include "snapshot.h"
+#include "snapshotxml.h"
+#include "ds3file.h"
+#include "imageforever.h"
+#include "meshgenerator.h"
+#include "meshresultpostprocessor.h"
+#include "texturegenerator.h"
+
+// Generate the texture maps of the models both by QPainter, one map after another as it was before the texture baker,
+// and by the baker in parallel tiles, then compare the maps: the largest and the mean difference of the premultiplied
+// components, and the pixels off by more than the tolerance; the exit code is 1 when there are too many of them.
+//
+// usage: texturebaking [--rounds N] [model.ds3|model.xml ...]
+//
+// Run with -platform offscreen where there is no display.
+
+static const int defaultRoundCount = 5;
+static const int tolerance = 4;
+static const double maxOffPixelRatio = 0.001;
+
+static bool loadModel(const QString &path, Snapshot *snapshot)
+{
+    if (path.endsWith(".xml")) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return false;
+        QXmlStreamReader stream(&file);
+        loadSkeletonFromXmlStream(snapshot, stream);
+        return true;
+    }
+
+    if (!QFileInfo(path).exists())
+        return false;
+
+    Ds3FileReader ds3Reader(path);
+    bool isModelLoaded = false;
+    for (int i = 0; i < ds3Reader.items().size(); ++i) {
+        Ds3ReaderItem item = ds3Reader.items().at(i);
+        if (item.type == "asset" && item.name.startsWith("images/")) {
+            QString filename = item.name.split("/")[1];
+            QString imageIdString = filename.split(".")[0];
+            QUuid imageId = QUuid(imageIdString);
+            if (!imageId.isNull()) {
+                QByteArray data;
+                ds3Reader.loadItem(item.name, &data);
+                QImage image = QImage::fromData(data, "PNG");
+                (void)ImageForever::add(&image, imageId);
+            }
+        }
+    }
+    for (int i = 0; i < ds3Reader.items().size(); ++i) {
+        Ds3ReaderItem item = ds3Reader.items().at(i);
+        if (item.type == "model") {
+            QByteArray data;
+            ds3Reader.loadItem(item.name, &data);
+            QXmlStreamReader stream(data);
+            loadSkeletonFromXmlStream(snapshot, stream);
+            isModelLoaded = true;
+        }
+    }
+    return isModelLoaded;
+}
+
+struct TextureMaps
+{
+    QImage *images[5] = {nullptr, nullptr, nullptr, nullptr, nullptr};
+
+    ~TextureMaps()
+    {
+        for (auto &image: images)
+            delete image;
+    }
+};
+
+static double generateTexture(const Object &object, const Snapshot &snapshot, bool painterEnabled, TextureMaps *maps)
+{
+    QElapsedTimer timer;
+    timer.start();
+    TextureGenerator *textureGenerator = new TextureGenerator(object, new Snapshot(snapshot));
+    textureGenerator->setPainterEnabled(painterEnabled);
+    textureGenerator->generate();
+    double milliseconds = timer.nsecsElapsed() / 1000000.0;
+    if (nullptr != maps) {
+        maps->images[0] = textureGenerator->takeResultTextureColorImage();
+        maps->images[1] = textureGenerator->takeResultTextureNormalImage();
+        maps->images[2] = textureGenerator->takeResultTextureMetalnessImage();
+        maps->images[3] = textureGenerator->takeResultTextureRoughnessImage();
+        maps->images[4] = textureGenerator->takeResultTextureAmbientOcclusionImage();
+    }
+    delete textureGenerator;
+    return milliseconds;
+}
+
+static double median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+// Returns the number of the pixels off by more than the tolerance
+static size_t compareImages(const char *name, const QImage *painted, const QImage *baked)
+{
+    if (nullptr == painted && nullptr == baked)
+        return 0;
+    if (nullptr == painted || nullptr == baked || painted->size() != baked->size()) {
+        fprintf(stderr, "  %-16s mismatched\n", name);
+        return 1;
+    }
+    int maxDifference = 0;
+    double differenceSum = 0;
+    size_t offPixelCount = 0;
+    for (int y = 0; y < painted->height(); ++y) {
+        const QRgb *paintedLine = (const QRgb *)painted->constScanLine(y);
+        const QRgb *bakedLine = (const QRgb *)baked->constScanLine(y);
+        for (int x = 0; x < painted->width(); ++x) {
+            QRgb paintedPixel = qPremultiply(paintedLine[x]);
+            QRgb bakedPixel = qPremultiply(bakedLine[x]);
+            int difference = std::max({std::abs(qRed(paintedPixel) - qRed(bakedPixel)),
+                std::abs(qGreen(paintedPixel) - qGreen(bakedPixel)),
+                std::abs(qBlue(paintedPixel) - qBlue(bakedPixel)),
+                std::abs(qAlpha(paintedPixel) - qAlpha(bakedPixel))});
+            maxDifference = std::max(maxDifference, difference);
+            differenceSum += difference;
+            if (difference > tolerance)
+                ++offPixelCount;
+        }
+    }
+    fprintf(stderr, "  %-16s max difference %d mean %.4f off by more than %d: %d pixels\n", name,
+        maxDifference, differenceSum / ((double)painted->width() * painted->height()), tolerance, (int)offPixelCount);
+    return offPixelCount;
+}
+
+int main(int argc, char *argv[])
+{
+    QGuiApplication app(argc, argv);
+
+    int roundCount = defaultRoundCount;
+    QStringList modelPaths;
+    QStringList arguments = app.arguments();
+    for (int i = 1; i < arguments.size(); ++i) {
+        const QString &argument = arguments[i];
+        if ("--rounds" == argument && i + 1 < arguments.size())
+            roundCount = std::max(1, arguments[++i].toInt());
+        else
+            modelPaths.append(argument);
+    }
+    if (modelPaths.isEmpty()) {
+        QString sourceRoot = QString(SOURCE_ROOT_DIR);
+        modelPaths << sourceRoot + "resources/material-demo-model.ds3";
+        modelPaths << sourceRoot + "resources/model-cat.ds3";
+        modelPaths << sourceRoot + "resources/model-giraffe.ds3";
+    }
+
+    const char *mapNames[5] = {"color", "normal", "metalness", "roughness", "ambient occlusion"};
+    bool failed = false;
+    for (const auto &path: modelPaths) {
+        Snapshot snapshot;
+        if (!loadModel(path, &snapshot)) {
+            fprintf(stderr, "Load model failed: %s\n", path.toUtf8().constData());
+            return 2;
+        }
+
+        MeshGenerator *meshGenerator = new MeshGenerator(new Snapshot(snapshot));
+        meshGenerator->generate();
+        Object *object = meshGenerator->takeObject();
+        delete meshGenerator;
+        if (nullptr == object) {
+            fprintf(stderr, "Generate mesh failed: %s\n", path.toUtf8().constData());
+            return 2;
+        }
+        MeshResultPostProcessor *postProcessor = new MeshResultPostProcessor(*object);
+        postProcessor->poseProcess();
+        Object *postProcessedObject = postProcessor->takePostProcessedObject();
+        delete postProcessor;
+        delete object;
+
+        std::vector<double> paintedMilliseconds;
+        std::vector<double> bakedMilliseconds;
+        for (int round = 0; round < roundCount; ++round) {
+            paintedMilliseconds.push_back(generateTexture(*postProcessedObject, snapshot, true, nullptr));
+            bakedMilliseconds.push_back(generateTexture(*postProcessedObject, snapshot, false, nullptr));
+        }
+        fprintf(stderr, "%s: painted %.1f ms baked %.1f ms (median of %d)\n",
+            QFileInfo(path).fileName().toUtf8().constData(),
+            median(paintedMilliseconds), median(bakedMilliseconds), roundCount);
+
+        TextureMaps paintedMaps;
+        TextureMaps bakedMaps;
+        generateTexture(*postProcessedObject, snapshot, true, &paintedMaps);
+        generateTexture(*postProcessedObject, snapshot, false, &bakedMaps);
+        for (int i = 0; i < 5; ++i) {
+            size_t offPixelCount = compareImages(mapNames[i], paintedMaps.images[i], bakedMaps.images[i]);
+            if (nullptr != paintedMaps.images[i] &&
+                    offPixelCount > maxOffPixelRatio * paintedMaps.images[i]->width() * paintedMaps.images[i]->height())
+                failed = true;
+            if (nullptr == paintedMaps.images[i] && offPixelCount > 0)
+                failed = true;
+        }
+
+        delete postProcessedObject;
+    }
+
+    return failed ? 1 : 0;
+}
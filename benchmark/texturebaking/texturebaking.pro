@@ -0,0 +1,23 @@
+TEMPLATE = app
+
+CONFIG += console
+CONFIG -= app_bundle
+
+VPATH += ../../
+
+SOURCE_ROOT = ../../
+
+include(../../dust3d.pro)
+
+TARGET = texturebaking
+
+SOURCES -= src/main.cpp
+SOURCES += benchmark/texturebaking/texturebaking.cpp
+
+for(path, INCLUDEPATH) {
+    PREFIXED_INCLUDEPATH += "../../$$path"
+}
+
+INCLUDEPATH += $$PREFIXED_INCLUDEPATH
+
+DEFINES += SOURCE_ROOT_DIR=\\\"$$PWD/../../\\\"
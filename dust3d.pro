@@ -197,6 +197,15 @@ HEADERS += src/turnaroundloader.h
 SOURCES += src/snapshot.cpp
 HEADERS += src/snapshot.h
 
+SOURCES += src/compiledsnapshot.cpp
+HEADERS += src/compiledsnapshot.h
+
+SOURCES += src/generateddiskcache.cpp
+HEADERS += src/generateddiskcache.h
+
+SOURCES += src/tracer.cpp
+HEADERS += src/tracer.h
+
 SOURCES += src/snapshotxml.cpp
 HEADERS += src/snapshotxml.h
 
@@ -214,6 +223,8 @@ HEADERS += src/model.h
 
 SOURCES += src/texturegenerator.cpp
 HEADERS += src/texturegenerator.h
+SOURCES += src/texturebaker.cpp
+HEADERS += src/texturebaker.h
 
 SOURCES += src/object.cpp
 HEADERS += src/object.h
@@ -430,6 +441,16 @@ HEADERS += src/meshcombiner.h
 SOURCES += src/positionkey.cpp
 HEADERS += src/positionkey.h
 
+HEADERS += src/openhashmap.h
+
+HEADERS += src/facelist.h
+
+SOURCES += src/halfedgetable.cpp
+HEADERS += src/halfedgetable.h
+
+SOURCES += src/sdfmeshbuilder.cpp
+HEADERS += src/sdfmeshbuilder.h
+
 SOURCES += src/strokemodifier.cpp
 HEADERS += src/strokemodifier.h
 
@@ -457,6 +478,9 @@ HEADERS += src/remesher.h
 SOURCES += src/clothsimulator.cpp
 HEADERS += src/clothsimulator.h
 
+SOURCES += src/meshdistancefield.cpp
+HEADERS += src/meshdistancefield.h
+
 SOURCES += src/componentlayer.cpp
 HEADERS += src/componentlayer.h
 
@@ -21,6 +21,9 @@ extern "C" {
 #define DUST3D_ERROR                1
 #define DUST3D_UNSUPPORTED          2
 
+#define DUST3D_GENERATION_EXACT         0
+#define DUST3D_GENERATION_SDF_PREVIEW   1
+
 typedef struct _dust3d dust3d;
 
 DUST3D_DLL void         DUST3D_API dust3dInitialize(int argc, char *argv[]);
@@ -28,6 +31,8 @@ DUST3D_DLL dust3d *     DUST3D_API dust3dOpenFromMemory(const char *documentType
 DUST3D_DLL dust3d *     DUST3D_API dust3dOpen(const char *fileName);
 DUST3D_DLL void         DUST3D_API dust3dSetUserData(dust3d *ds3, void *userData);
 DUST3D_DLL void *       DUST3D_API dust3dGetUserData(dust3d *ds3);
+DUST3D_DLL void         DUST3D_API dust3dSetGenerationMode(dust3d *ds3, int generationMode);
+DUST3D_DLL void         DUST3D_API dust3dSetAccurateClothCollision(dust3d *ds3, int enabled);
 DUST3D_DLL int          DUST3D_API dust3dGenerateMesh(dust3d *ds3);
 DUST3D_DLL int          DUST3D_API dust3dGetMeshVertexCount(dust3d *ds3);
 DUST3D_DLL int          DUST3D_API dust3dGetMeshTriangleCount(dust3d *ds3);
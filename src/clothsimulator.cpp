@@ -1,5 +1,6 @@
 #include <MassSpringSolver.h>
 #include <set>
+#include <algorithm>
 #include <CGAL/Simple_cartesian.h>
 #include <CGAL/AABB_tree.h>
 #include <CGAL/AABB_traits.h>
@@ -11,6 +12,7 @@
 #include <CGAL/Side_of_triangle_mesh.h>
 #include "clothsimulator.h"
 #include "booleanmesh.h"
+#include "meshdistancefield.h"
 
 typedef CGAL::Simple_cartesian<double> K;
 typedef K::Point_3 Point;
@@ -63,33 +65,80 @@ private:
 //    static const float g = 9.8f * m; // gravitational force | 9.8f
 //}
 
-// Point - mesh collision node
-class CgMeshCollisionNode : public CgPointNode {
+struct CollisionPolyhedron
+{
+    Polyhedron polyhedron;
+    Tree *aabbTree = nullptr;
+    Point_inside *insideTester = nullptr;
+};
+
+ClothCollisionShape::ClothCollisionShape(const std::vector<QVector3D> &vertices,
+        const std::vector<std::vector<size_t>> &triangles,
+        bool accurate)
+{
+    if (triangles.empty())
+        return;
+    if (!accurate) {
+        m_distanceField = new MeshDistanceField(vertices, triangles);
+        return;
+    }
+    m_polyhedron = new CollisionPolyhedron;
+    Build_mesh<HalfedgeDS> mesh(&vertices, &triangles);
+    m_polyhedron->polyhedron.delegate(mesh);
+    m_polyhedron->aabbTree = new Tree(faces(m_polyhedron->polyhedron).first, faces(m_polyhedron->polyhedron).second, m_polyhedron->polyhedron);
+    // Built now instead of on the first query, the simulators query concurrently
+    m_polyhedron->aabbTree->build();
+    m_polyhedron->aabbTree->accelerate_distance_queries();
+    m_polyhedron->insideTester = new Point_inside(*m_polyhedron->aabbTree);
+}
+
+ClothCollisionShape::~ClothCollisionShape()
+{
+    delete m_distanceField;
+    if (nullptr != m_polyhedron) {
+        delete m_polyhedron->insideTester;
+        delete m_polyhedron->aabbTree;
+        delete m_polyhedron;
+    }
+}
+
+bool ClothCollisionShape::collide(const QVector3D &position, QVector3D *resolvedPosition) const
+{
+    if (nullptr != m_distanceField) {
+        float distance = 0;
+        QVector3D gradient;
+        if (!m_distanceField->sample(position, &distance, &gradient) || distance > 0)
+            return false;
+        // Pushed out along the gradient by the distance
+        if (nullptr != resolvedPosition)
+            *resolvedPosition = position - gradient.normalized() * distance;
+        return true;
+    }
+    if (nullptr != m_polyhedron) {
+        Point point(position.x(), position.y(), position.z());
+        if ((*m_polyhedron->insideTester)(point) == CGAL::ON_UNBOUNDED_SIDE)
+            return false;
+        if (nullptr != resolvedPosition) {
+            Point closestPoint = m_polyhedron->aabbTree->closest_point(point);
+            *resolvedPosition = QVector3D(closestPoint.x(), closestPoint.y(), closestPoint.z());
+        }
+        return true;
+    }
+    return false;
+}
+
+// Point - collision shape node
+class CgCollisionNode : public CgPointNode {
 private:
-    Tree *m_aabbTree = nullptr;
-    Point_inside *m_insideTester = nullptr;
-    Polyhedron m_polyhedron;
+    const ClothCollisionShape *m_collisionShape = nullptr;
 public:
-    CgMeshCollisionNode(mass_spring_system *system, float *vbuff,
-            const std::vector<QVector3D> &collisionVertices,
-            const std::vector<std::vector<size_t>> &collisionTriangles) :
-        CgPointNode(system, vbuff)
+    CgCollisionNode(mass_spring_system *system, float *vbuff,
+            const ClothCollisionShape *collisionShape) :
+        CgPointNode(system, vbuff),
+        m_collisionShape(collisionShape)
     {
-        if (!collisionTriangles.empty()) {
-            Build_mesh<HalfedgeDS> mesh(&collisionVertices, &collisionTriangles);
-            m_polyhedron.delegate(mesh);
-            m_aabbTree = new Tree(faces(m_polyhedron).first, faces(m_polyhedron).second, m_polyhedron);
-            m_aabbTree->accelerate_distance_queries();
-            m_insideTester = new Point_inside(*m_aabbTree);
-        }
     }
     
-    ~CgMeshCollisionNode()
-    {
-        delete m_insideTester;
-        delete m_aabbTree;
-    };
-    
     bool query(unsigned int i) const
     {
         return false;
@@ -99,16 +148,12 @@ public:
     {
         for (unsigned int i = 0; i < system->n_points; i++) {
             auto offset = 3 * i;
-            Point point(vbuff[offset + 0],
-                vbuff[offset + 1],
-                vbuff[offset + 2]);
-            if (nullptr != m_insideTester &&
-                    (*m_insideTester)(point) != CGAL::ON_UNBOUNDED_SIDE) {
-                Point closestPoint = m_aabbTree->closest_point(point);
-                vbuff[offset + 0] = closestPoint.x();
-                vbuff[offset + 1] = closestPoint.y();
-                vbuff[offset + 2] = closestPoint.z();
-            }
+            QVector3D resolvedPosition;
+            if (!m_collisionShape->collide(QVector3D(vbuff[offset + 0], vbuff[offset + 1], vbuff[offset + 2]), &resolvedPosition))
+                continue;
+            vbuff[offset + 0] = resolvedPosition.x();
+            vbuff[offset + 1] = resolvedPosition.y();
+            vbuff[offset + 2] = resolvedPosition.z();
         }
     }
     
@@ -116,40 +161,19 @@ public:
     {
         for (unsigned int i = 0; i < system->n_points; i++) {
             auto offset = 3 * i;
-            Point point(vbuff[offset + 0],
-                vbuff[offset + 1],
-                vbuff[offset + 2]);
-            if (nullptr != m_insideTester &&
-                    (*m_insideTester)(point) != CGAL::ON_UNBOUNDED_SIDE) {
+            if (m_collisionShape->collide(QVector3D(vbuff[offset + 0], vbuff[offset + 1], vbuff[offset + 2])))
                 fixNode->fixPoint(i);
-            }
-        }
-    }
-    
-    void collectErrorPoints(std::vector<size_t> *points)
-    {
-        for (unsigned int i = 0; i < system->n_points; i++) {
-            auto offset = 3 * i;
-            Point point(vbuff[offset + 0],
-                vbuff[offset + 1],
-                vbuff[offset + 2]);
-            if (nullptr != m_insideTester &&
-                    (*m_insideTester)(point) != CGAL::ON_UNBOUNDED_SIDE) {
-                points->push_back(i);
-            }
         }
     }
 };
 
 ClothSimulator::ClothSimulator(const std::vector<QVector3D> &vertices,
         const std::vector<std::vector<size_t>> &faces,
-        const std::vector<QVector3D> &collisionVertices,
-        const std::vector<std::vector<size_t>> &collisionTriangles,
+        std::shared_ptr<const ClothCollisionShape> collisionShape,
         const std::vector<QVector3D> &externalForces) :
     m_vertices(vertices),
     m_faces(faces),
-    m_collisionVertices(collisionVertices),
-    m_collisionTriangles(collisionTriangles),
+    m_collisionShape(collisionShape),
     m_externalForces(externalForces)
 {
 }
@@ -160,7 +184,7 @@ ClothSimulator::~ClothSimulator()
     delete m_massSpringSolver;
     delete m_rootNode;
     delete m_deformationNode;
-    delete m_meshCollisionNode;
+    delete m_collisionNode;
     delete m_fixNode;
 }
 
@@ -169,6 +193,21 @@ void ClothSimulator::setStiffness(float stiffness)
     m_stiffness = 1.0f + 5.0f * stiffness;
 }
 
+void ClothSimulator::setSolverMatrices(std::shared_ptr<const mass_spring_matrices> solverMatrices)
+{
+    m_solverMatrices = solverMatrices;
+}
+
+std::shared_ptr<const mass_spring_matrices> ClothSimulator::solverMatrices() const
+{
+    return m_solverMatrices;
+}
+
+void ClothSimulator::setInitialVertices(const std::vector<QVector3D> &initialVertices)
+{
+    m_initialVertices = initialVertices;
+}
+
 void ClothSimulator::convertMeshToCloth()
 {
     m_clothPointSources.reserve(m_vertices.size());
@@ -219,11 +258,30 @@ void ClothSimulator::step()
     if (nullptr == m_massSpringSolver)
         return;
         
+    m_lastStepPointBuffer = m_clothPointBuffer;
+    
     m_massSpringSolver->solve(5);
     m_massSpringSolver->solve(5);
     
     CgSatisfyVisitor visitor;
     visitor.satisfy(*m_rootNode);
+    
+    float maxMovement2 = 0.0f;
+    for (size_t i = 0; i < m_clothPointBuffer.size(); i += 3) {
+        QVector3D movement(m_clothPointBuffer[i + 0] - m_lastStepPointBuffer[i + 0],
+            m_clothPointBuffer[i + 1] - m_lastStepPointBuffer[i + 1],
+            m_clothPointBuffer[i + 2] - m_lastStepPointBuffer[i + 2]);
+        maxMovement2 = std::max(maxMovement2, movement.lengthSquared());
+    }
+    if (maxMovement2 < m_settledMovement * m_settledMovement)
+        ++m_settledStepCount;
+    else
+        m_settledStepCount = 0;
+}
+
+bool ClothSimulator::isSettled() const
+{
+    return m_settledStepCount >= SettledStepCount;
 }
 
 void ClothSimulator::create()
@@ -251,6 +309,9 @@ void ClothSimulator::create()
         stiffnesses[i] = m_stiffness;
     }
     
+    if (!m_clothSprings.empty())
+        m_settledMovement = 0.001f * restLengths.sum() / m_clothSprings.size();
+    
     mass_spring_system::VectorXf fext(m_clothPointSources.size() * 3);
     for (size_t i = 0; i < m_clothPointSources.size(); ++i) {
         const auto &externalForce = m_externalForces[i] * gravitationalForce;
@@ -262,8 +323,27 @@ void ClothSimulator::create()
     
     m_massSpringSystem = new mass_spring_system(m_clothPointSources.size(), m_clothSprings.size(), timeStep, springList, restLengths,
         stiffnesses, masses, fext, damping);
-
-    m_massSpringSolver = new MassSpringSolver(m_massSpringSystem, m_clothPointBuffer.data());
+    
+    // The points inside the body are fixed where they rest, before the warm start moves the points
+    m_fixNode = new CgPointFixNode(m_massSpringSystem, m_clothPointBuffer.data());
+    if (nullptr != m_collisionShape) {
+        m_collisionNode = new CgCollisionNode(m_massSpringSystem, m_clothPointBuffer.data(), m_collisionShape.get());
+        m_collisionNode->fixPoints(m_fixNode);
+    }
+    
+    if (m_initialVertices.size() == m_vertices.size()) {
+        for (size_t i = 0; i < m_clothPointSources.size(); ++i) {
+            const auto &position = m_initialVertices[m_clothPointSources[i]];
+            auto offset = i * 3;
+            m_clothPointBuffer[offset + 0] = position.x();
+            m_clothPointBuffer[offset + 1] = position.y();
+            m_clothPointBuffer[offset + 2] = position.z();
+        }
+    }
+    
+    if (nullptr == m_solverMatrices)
+        m_solverMatrices = std::make_shared<const mass_spring_matrices>(m_massSpringSystem);
+    m_massSpringSolver = new MassSpringSolver(m_massSpringSystem, m_clothPointBuffer.data(), m_solverMatrices);
     
     // deformation constraint parameters
     const float tauc = 0.12f; // critical spring deformation | 0.12f
@@ -278,13 +358,8 @@ void ClothSimulator::create()
     m_rootNode = new CgRootNode(m_massSpringSystem, m_clothPointBuffer.data());
     m_rootNode->addChild(m_deformationNode);
 
-    m_meshCollisionNode = new CgMeshCollisionNode(m_massSpringSystem, m_clothPointBuffer.data(),
-        m_collisionVertices,
-        m_collisionTriangles);
-    
-    m_fixNode = new CgPointFixNode(m_massSpringSystem, m_clothPointBuffer.data());
-    m_meshCollisionNode->fixPoints(m_fixNode);
     m_deformationNode->addChild(m_fixNode);
     
-    m_rootNode->addChild(m_meshCollisionNode);
+    if (nullptr != m_collisionNode)
+        m_rootNode->addChild(m_collisionNode);
 }
@@ -3,44 +3,77 @@
 #include <QObject>
 #include <QVector3D>
 #include <vector>
+#include <memory>
 
 struct mass_spring_system;
+struct mass_spring_matrices;
 class MassSpringSolver;
 class CgRootNode;
 class CgSpringDeformationNode;
-class CgMeshCollisionNode;
+class CgCollisionNode;
 class CgPointFixNode;
+class MeshDistanceField;
+struct CollisionPolyhedron;
+
+// The body the cloth collides with, read only once built, so one shape is shared by all the cloth simulated against the same body
+class ClothCollisionShape
+{
+public:
+    // The accurate shape collides against the mesh itself instead of its distance field, exact but much slower
+    ClothCollisionShape(const std::vector<QVector3D> &vertices,
+        const std::vector<std::vector<size_t>> &triangles,
+        bool accurate=false);
+    ~ClothCollisionShape();
+    // Returns true when the position is inside the body, along with the position it should be pushed out to, if asked
+    bool collide(const QVector3D &position, QVector3D *resolvedPosition=nullptr) const;
+private:
+    MeshDistanceField *m_distanceField = nullptr;
+    CollisionPolyhedron *m_polyhedron = nullptr;
+};
 
 class ClothSimulator : public QObject
 {
     Q_OBJECT
 public:
+    static const size_t SettledStepCount = 10;
+    
     ClothSimulator(const std::vector<QVector3D> &vertices,
         const std::vector<std::vector<size_t>> &faces,
-        const std::vector<QVector3D> &collisionVertices,
-        const std::vector<std::vector<size_t>> &collisionTriangles,
+        std::shared_ptr<const ClothCollisionShape> collisionShape,
         const std::vector<QVector3D> &externalForces);
     ~ClothSimulator();
     void setStiffness(float stiffness);
+    // The matrices prefactored by a simulation of the same faces with the same stiffness
+    void setSolverMatrices(std::shared_ptr<const mass_spring_matrices> solverMatrices);
+    std::shared_ptr<const mass_spring_matrices> solverMatrices() const;
+    // Starts from the vertices simulated before, instead of the rest positions, the points inside the body stay fixed at rest
+    void setInitialVertices(const std::vector<QVector3D> &initialVertices);
     void create();
     void step();
+    // Settled once no point moved farther than a thousandth of the average spring length for a few steps in a row,
+    // the next steps would change nothing visible
+    bool isSettled() const;
     void getCurrentVertices(std::vector<QVector3D> *currentVertices);
 private:
     std::vector<QVector3D> m_vertices;
     std::vector<std::vector<size_t>> m_faces;
-    std::vector<QVector3D> m_collisionVertices;
-    std::vector<std::vector<size_t>> m_collisionTriangles;
+    std::shared_ptr<const ClothCollisionShape> m_collisionShape;
     std::vector<QVector3D> m_externalForces;
+    std::vector<QVector3D> m_initialVertices;
+    std::shared_ptr<const mass_spring_matrices> m_solverMatrices;
     std::vector<float> m_clothPointBuffer;
     std::vector<size_t> m_clothPointSources;
     std::vector<std::pair<size_t, size_t>> m_clothSprings;
+    std::vector<float> m_lastStepPointBuffer;
     float m_stiffness = 1.0f;
+    float m_settledMovement = 0.0f;
+    size_t m_settledStepCount = 0;
     QVector3D m_offset;
     mass_spring_system *m_massSpringSystem = nullptr;
     MassSpringSolver *m_massSpringSolver = nullptr;
     CgRootNode *m_rootNode = nullptr;
     CgSpringDeformationNode *m_deformationNode = nullptr;
-    CgMeshCollisionNode *m_meshCollisionNode = nullptr;
+    CgCollisionNode *m_collisionNode = nullptr;
     CgPointFixNode *m_fixNode = nullptr;
     void convertMeshToCloth();
 };
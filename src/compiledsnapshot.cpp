@@ -0,0 +1,363 @@
+#include <QDebug>
+#include <QVector3D>
+#include <functional>
+#include <set>
+#include "compiledsnapshot.h"
+#include "util.h"
+#include "cutface.h"
+
+const size_t CompiledSnapshot::InvalidIndex = (size_t)-1;
+
+void CompiledSnapshot::compile(const Snapshot &snapshot)
+{
+    nodes.clear();
+    edges.clear();
+    parts.clear();
+    components.clear();
+    canvas = Component();
+    cutTemplates.clear();
+    m_partIndexMap.clear();
+    m_componentIndexMap.clear();
+    m_cutTemplateIndexMap.clear();
+
+    mainProfileMiddleX = valueOfKeyInMapOrEmpty(snapshot.canvas, "originX").toFloat();
+    mainProfileMiddleY = valueOfKeyInMapOrEmpty(snapshot.canvas, "originY").toFloat();
+    sideProfileMiddleX = valueOfKeyInMapOrEmpty(snapshot.canvas, "originZ").toFloat();
+
+    // The snapshot maps are ordered by id string, so are the dense indices,
+    // any container ordered by index keeps the same order as the one ordered by id string
+    parts.reserve(snapshot.parts.size());
+    for (const auto &it: snapshot.parts) {
+        const auto &map = it.second;
+        m_partIndexMap.insert({it.first, parts.size()});
+        parts.push_back(Part());
+        auto &part = parts.back();
+        part.idString = it.first;
+        part.id = QUuid(it.first);
+        part.dirty = isTrueValueString(valueOfKeyInMapOrEmpty(map, "__dirty"));
+        part.disabled = isTrueValueString(valueOfKeyInMapOrEmpty(map, "disabled"));
+        part.xMirrored = isTrueValueString(valueOfKeyInMapOrEmpty(map, "xMirrored"));
+        part.subdived = isTrueValueString(valueOfKeyInMapOrEmpty(map, "subdived"));
+        part.rounded = isTrueValueString(valueOfKeyInMapOrEmpty(map, "rounded"));
+        part.chamfered = isTrueValueString(valueOfKeyInMapOrEmpty(map, "chamfered"));
+        part.countershaded = isTrueValueString(valueOfKeyInMapOrEmpty(map, "countershaded"));
+        part.smooth = isTrueValueString(valueOfKeyInMapOrEmpty(map, "smooth"));
+        part.deformUnified = isTrueValueString(valueOfKeyInMapOrEmpty(map, "deformUnified"));
+        part.mirroredByPartIdString = valueOfKeyInMapOrEmpty(map, "__mirroredByPartId");
+        part.mirrorFromPartIdString = valueOfKeyInMapOrEmpty(map, "__mirrorFromPartId");
+        part.colorString = valueOfKeyInMapOrEmpty(map, "color");
+        part.target = PartTargetFromString(valueOfKeyInMapOrEmpty(map, "target").toUtf8().constData());
+        part.base = PartBaseFromString(valueOfKeyInMapOrEmpty(map, "base").toUtf8().constData());
+        part.cutFace = valueOfKeyInMapOrEmpty(map, "cutFace");
+
+        QString cutRotationString = valueOfKeyInMapOrEmpty(map, "cutRotation");
+        if (!cutRotationString.isEmpty())
+            part.cutRotation = cutRotationString.toFloat();
+
+        QString hollowThicknessString = valueOfKeyInMapOrEmpty(map, "hollowThickness");
+        if (!hollowThicknessString.isEmpty())
+            part.hollowThickness = hollowThicknessString.toFloat();
+
+        QString thicknessString = valueOfKeyInMapOrEmpty(map, "deformThickness");
+        if (!thicknessString.isEmpty())
+            part.deformThickness = thicknessString.toFloat();
+
+        QString widthString = valueOfKeyInMapOrEmpty(map, "deformWidth");
+        if (!widthString.isEmpty())
+            part.deformWidth = widthString.toFloat();
+
+        part.deformMapImageIdString = valueOfKeyInMapOrEmpty(map, "deformMapImageId");
+
+        QString deformMapScaleString = valueOfKeyInMapOrEmpty(map, "deformMapScale");
+        if (!deformMapScaleString.isEmpty())
+            part.deformMapScale = deformMapScaleString.toFloat();
+
+        QString materialIdString = valueOfKeyInMapOrEmpty(map, "materialId");
+        if (!materialIdString.isEmpty())
+            part.materialId = QUuid(materialIdString);
+
+        QString colorSolubilityString = valueOfKeyInMapOrEmpty(map, "colorSolubility");
+        if (!colorSolubilityString.isEmpty()) {
+            part.hasColorSolubility = true;
+            part.colorSolubility = colorSolubilityString.toFloat();
+        }
+
+        QString metalnessString = valueOfKeyInMapOrEmpty(map, "metallic");
+        if (!metalnessString.isEmpty())
+            part.metalness = metalnessString.toFloat();
+
+        QString roughnessString = valueOfKeyInMapOrEmpty(map, "roughness");
+        if (!roughnessString.isEmpty())
+            part.roughness = roughnessString.toFloat();
+
+        QString fillMeshString = valueOfKeyInMapOrEmpty(map, "fillMesh");
+        if (!fillMeshString.isEmpty())
+            part.fillMeshFileId = QUuid(fillMeshString);
+    }
+    for (auto &part: parts) {
+        if (!part.mirrorFromPartIdString.isEmpty())
+            part.mirrorFromPartIndex = findPart(part.mirrorFromPartIdString);
+    }
+
+    std::map<QString, size_t> nodeIndexMap;
+    nodes.reserve(snapshot.nodes.size());
+    for (const auto &it: snapshot.nodes) {
+        const auto &map = it.second;
+        size_t partIndex = findPart(valueOfKeyInMapOrEmpty(map, "partId"));
+        if (InvalidIndex == partIndex)
+            continue;
+        nodeIndexMap.insert({it.first, nodes.size()});
+        parts[partIndex].nodeIndices.push_back(nodes.size());
+        nodes.push_back(Node());
+        auto &node = nodes.back();
+        node.idString = it.first;
+        node.id = QUuid(it.first);
+        node.partIndex = partIndex;
+        node.radius = valueOfKeyInMapOrEmpty(map, "radius").toFloat();
+        node.x = valueOfKeyInMapOrEmpty(map, "x").toFloat();
+        node.y = valueOfKeyInMapOrEmpty(map, "y").toFloat();
+        node.z = valueOfKeyInMapOrEmpty(map, "z").toFloat();
+        node.boneMark = BoneMarkFromString(valueOfKeyInMapOrEmpty(map, "boneMark").toUtf8().constData());
+        const auto &cutFaceIt = map.find("cutFace");
+        if (cutFaceIt != map.end()) {
+            node.cutFace = cutFaceIt->second;
+            node.hasCutFaceSettings = true;
+            const auto &cutRotationIt = map.find("cutRotation");
+            if (cutRotationIt != map.end())
+                node.cutRotation = cutRotationIt->second.toFloat();
+        }
+    }
+
+    edges.reserve(snapshot.edges.size());
+    for (const auto &it: snapshot.edges) {
+        const auto &map = it.second;
+        size_t partIndex = findPart(valueOfKeyInMapOrEmpty(map, "partId"));
+        if (InvalidIndex == partIndex)
+            continue;
+        QString fromNodeIdString = valueOfKeyInMapOrEmpty(map, "from");
+        QString toNodeIdString = valueOfKeyInMapOrEmpty(map, "to");
+        auto findFromNode = nodeIndexMap.find(fromNodeIdString);
+        if (findFromNode == nodeIndexMap.end()) {
+            qDebug() << "Find from-node failed:" << fromNodeIdString;
+            continue;
+        }
+        auto findToNode = nodeIndexMap.find(toNodeIdString);
+        if (findToNode == nodeIndexMap.end()) {
+            qDebug() << "Find to-node failed:" << toNodeIdString;
+            continue;
+        }
+        parts[partIndex].edgeIndices.push_back(edges.size());
+        edges.push_back(Edge());
+        auto &edge = edges.back();
+        edge.idString = it.first;
+        edge.partIndex = partIndex;
+        edge.fromNodeIndex = findFromNode->second;
+        edge.toNodeIndex = findToNode->second;
+    }
+
+    components.reserve(snapshot.components.size() + 1);
+    components.push_back(Component());
+    components.front().idString = QUuid().toString();
+    m_componentIndexMap.insert({components.front().idString, 0});
+    for (const auto &it: snapshot.components) {
+        m_componentIndexMap.insert({it.first, components.size()});
+        components.push_back(Component());
+        components.back().idString = it.first;
+        components.back().id = QUuid(it.first);
+    }
+    compileComponent(canvas, snapshot.canvas);
+    compileComponent(components[0], snapshot.rootComponent);
+    size_t componentIndex = 1;
+    for (const auto &it: snapshot.components)
+        compileComponent(components[componentIndex++], it.second);
+
+    for (auto &part: parts)
+        part.cutTemplateIndex = compileCutTemplate(part.cutFace);
+    for (auto &node: nodes) {
+        if (node.hasCutFaceSettings)
+            node.cutTemplateIndex = compileCutTemplate(node.cutFace);
+    }
+}
+
+void CompiledSnapshot::compileComponent(Component &component, const std::map<QString, QString> &map)
+{
+    component.dirty = isTrueValueString(valueOfKeyInMapOrEmpty(map, "__dirty"));
+    component.combineMode = CombineModeFromString(valueOfKeyInMapOrEmpty(map, "combineMode").toUtf8().constData());
+    component.inverse = isTrueValueString(valueOfKeyInMapOrEmpty(map, "inverse"));
+    component.layer = ComponentLayerFromString(valueOfKeyInMapOrEmpty(map, "layer").toUtf8().constData());
+    component.polyCount = PolyCountFromString(valueOfKeyInMapOrEmpty(map, "polyCount").toUtf8().constData());
+    component.clothForce = ClothForceFromString(valueOfKeyInMapOrEmpty(map, "clothForce").toUtf8().constData());
+    component.clothOffset = valueOfKeyInMapOrEmpty(map, "clothOffset").toFloat();
+    auto findClothStiffness = map.find("clothStiffness");
+    if (findClothStiffness != map.end()) {
+        component.hasClothStiffness = true;
+        component.clothStiffness = findClothStiffness->second.toFloat();
+    }
+    auto findClothIteration = map.find("clothIteration");
+    if (findClothIteration != map.end()) {
+        component.hasClothIteration = true;
+        component.clothIteration = findClothIteration->second.toUInt();
+    }
+
+    if ("partId" == valueOfKeyInMapOrEmpty(map, "linkDataType")) {
+        component.linkToPart = true;
+        component.linkPartIdString = valueOfKeyInMapOrEmpty(map, "linkData");
+        component.linkPartIndex = findPart(component.linkPartIdString);
+        if (InvalidIndex == component.linkPartIndex) {
+            qDebug() << "Find part failed:" << component.linkPartIdString;
+        } else {
+            const auto &part = parts[component.linkPartIndex];
+            if (part.hasColorSolubility)
+                component.colorName = QString("+");
+            else if (part.colorString.isEmpty())
+                component.colorName = QString("-");
+            else
+                component.colorName = part.colorString;
+        }
+    }
+
+    for (const auto &childIdString: valueOfKeyInMapOrEmpty(map, "children").split(",")) {
+        if (childIdString.isEmpty())
+            continue;
+        size_t childIndex = findComponent(childIdString);
+        if (InvalidIndex == childIndex) {
+            qDebug() << "Component not found:" << childIdString;
+            continue;
+        }
+        component.childIndices.push_back(childIndex);
+    }
+}
+
+size_t CompiledSnapshot::findPart(const QString &partIdString) const
+{
+    auto findIndex = m_partIndexMap.find(partIdString);
+    if (findIndex == m_partIndexMap.end())
+        return InvalidIndex;
+    return findIndex->second;
+}
+
+size_t CompiledSnapshot::findComponent(const QString &componentIdString) const
+{
+    auto findIndex = m_componentIndexMap.find(componentIdString);
+    if (findIndex == m_componentIndexMap.end())
+        return InvalidIndex;
+    return findIndex->second;
+}
+
+size_t CompiledSnapshot::compileCutTemplate(const QString &cutFaceString)
+{
+    auto findIndex = m_cutTemplateIndexMap.find(cutFaceString);
+    if (findIndex != m_cutTemplateIndexMap.end())
+        return findIndex->second;
+    size_t cutTemplateIndex = cutTemplates.size();
+    cutTemplates.push_back(std::vector<QVector2D>());
+    cutFaceStringToCutTemplate(cutFaceString, cutTemplates.back());
+    m_cutTemplateIndexMap.insert({cutFaceString, cutTemplateIndex});
+    return cutTemplateIndex;
+}
+
+void CompiledSnapshot::cutFaceStringToCutTemplate(const QString &cutFaceString, std::vector<QVector2D> &cutTemplate)
+{
+    QUuid cutFaceLinkedPartId = QUuid(cutFaceString);
+    if (!cutFaceLinkedPartId.isNull()) {
+        size_t cutFaceLinkedPartIndex = findPart(cutFaceString);
+        if (InvalidIndex == cutFaceLinkedPartIndex) {
+            qDebug() << "Find cut face linked part failed:" << cutFaceString;
+        } else {
+            const auto &cutFaceLinkedPart = parts[cutFaceLinkedPartIndex];
+            // Build node info map
+            std::map<size_t, std::tuple<float, float, float>> cutFaceNodeMap;
+            for (const auto &nodeIndex: cutFaceLinkedPart.nodeIndices) {
+                const auto &node = nodes[nodeIndex];
+                float radius = node.radius;
+                float x = (node.x - mainProfileMiddleX);
+                float y = (mainProfileMiddleY - node.y);
+                cutFaceNodeMap.insert({nodeIndex, std::make_tuple(radius, x, y)});
+            }
+            // Build edge link
+            std::map<size_t, std::vector<size_t>> cutFaceNodeLinkMap;
+            for (const auto &edgeIndex: cutFaceLinkedPart.edgeIndices) {
+                const auto &edge = edges[edgeIndex];
+                cutFaceNodeLinkMap[edge.fromNodeIndex].push_back(edge.toNodeIndex);
+                cutFaceNodeLinkMap[edge.toNodeIndex].push_back(edge.fromNodeIndex);
+            }
+            // Find endpoint
+            size_t endPointNodeIndex = InvalidIndex;
+            std::vector<std::pair<size_t, std::tuple<float, float, float>>> endpointNodes;
+            for (const auto &it: cutFaceNodeLinkMap) {
+                if (1 == it.second.size()) {
+                    const auto &findNode = cutFaceNodeMap.find(it.first);
+                    if (findNode != cutFaceNodeMap.end())
+                        endpointNodes.push_back({it.first, findNode->second});
+                }
+            }
+            bool isRing = endpointNodes.empty();
+            if (endpointNodes.empty()) {
+                for (const auto &it: cutFaceNodeMap) {
+                    endpointNodes.push_back({it.first, it.second});
+                }
+            }
+            if (!endpointNodes.empty()) {
+                // Calculate the center points
+                QVector2D sumOfPositions;
+                for (const auto &it: endpointNodes) {
+                    sumOfPositions += QVector2D(std::get<1>(it.second), std::get<2>(it.second));
+                }
+                QVector2D center = sumOfPositions / endpointNodes.size();
+
+                // Calculate all the directions emit from center to the endpoint,
+                // choose the minimal angle, angle: (0, 0 -> -1, -1) to the direction
+                const QVector3D referenceDirection = QVector3D(-1, -1, 0).normalized();
+                int choosenEndpoint = -1;
+                float choosenRadian = 0;
+                for (int i = 0; i < (int)endpointNodes.size(); ++i) {
+                    const auto &it = endpointNodes[i];
+                    QVector2D direction2d = (QVector2D(std::get<1>(it.second), std::get<2>(it.second)) -
+                        center);
+                    QVector3D direction = QVector3D(direction2d.x(), direction2d.y(), 0).normalized();
+                    float radian = radianBetweenVectors(referenceDirection, direction);
+                    if (-1 == choosenEndpoint || radian < choosenRadian) {
+                        choosenRadian = radian;
+                        choosenEndpoint = i;
+                    }
+                }
+                endPointNodeIndex = endpointNodes[choosenEndpoint].first;
+            }
+            // Loop all linked nodes
+            std::vector<std::tuple<float, float, float, QString>> cutFaceNodes;
+            std::set<size_t> cutFaceVisitedNodeIndices;
+            std::function<void (size_t)> loopNodeLink;
+            loopNodeLink = [&](size_t fromNodeIndex) {
+                auto findCutFaceNode = cutFaceNodeMap.find(fromNodeIndex);
+                if (findCutFaceNode == cutFaceNodeMap.end())
+                    return;
+                if (cutFaceVisitedNodeIndices.find(fromNodeIndex) != cutFaceVisitedNodeIndices.end())
+                    return;
+                cutFaceVisitedNodeIndices.insert(fromNodeIndex);
+                cutFaceNodes.push_back(std::make_tuple(std::get<0>(findCutFaceNode->second),
+                    std::get<1>(findCutFaceNode->second),
+                    std::get<2>(findCutFaceNode->second),
+                    nodes[fromNodeIndex].idString));
+                auto findNeighbor = cutFaceNodeLinkMap.find(fromNodeIndex);
+                if (findNeighbor == cutFaceNodeLinkMap.end())
+                    return;
+                for (const auto &it: findNeighbor->second) {
+                    if (cutFaceVisitedNodeIndices.find(it) == cutFaceVisitedNodeIndices.end()) {
+                        loopNodeLink(it);
+                        break;
+                    }
+                }
+            };
+            if (InvalidIndex != endPointNodeIndex) {
+                loopNodeLink(endPointNodeIndex);
+            }
+            // Fetch points from linked nodes
+            std::vector<QString> cutTemplateNames;
+            cutFacePointsFromNodes(cutTemplate, cutFaceNodes, isRing, &cutTemplateNames);
+        }
+    }
+    if (cutTemplate.size() < 3) {
+        CutFace cutFace = CutFaceFromString(cutFaceString.toUtf8().constData());
+        cutTemplate = CutFaceToPoints(cutFace);
+    }
+}
@@ -0,0 +1,132 @@
+#ifndef DUST3D_COMPILED_SNAPSHOT_H
+#define DUST3D_COMPILED_SNAPSHOT_H
+#include <vector>
+#include <map>
+#include <QString>
+#include <QUuid>
+#include <QVector2D>
+#include "snapshot.h"
+#include "bonemark.h"
+#include "parttarget.h"
+#include "partbase.h"
+#include "combinemode.h"
+#include "componentlayer.h"
+#include "polycount.h"
+#include "clothforce.h"
+
+// The snapshot compiled once per generation, all the attributes are parsed into typed fields,
+// the nodes, edges, parts and components are addressed by dense indices instead of id strings
+
+class CompiledSnapshot
+{
+public:
+    static const size_t InvalidIndex;
+
+    struct Node
+    {
+        QString idString;
+        QUuid id;
+        size_t partIndex = InvalidIndex;
+        float radius = 0;
+        float x = 0;
+        float y = 0;
+        float z = 0;
+        BoneMark boneMark = BoneMark::None;
+        bool hasCutFaceSettings = false;
+        float cutRotation = 0.0;
+        QString cutFace;
+        size_t cutTemplateIndex = InvalidIndex;
+    };
+
+    struct Edge
+    {
+        QString idString;
+        size_t partIndex = InvalidIndex;
+        size_t fromNodeIndex = InvalidIndex;
+        size_t toNodeIndex = InvalidIndex;
+    };
+
+    struct Part
+    {
+        QString idString;
+        QUuid id;
+        bool dirty = false;
+        bool disabled = false;
+        bool xMirrored = false;
+        bool subdived = false;
+        bool rounded = false;
+        bool chamfered = false;
+        bool countershaded = false;
+        bool smooth = false;
+        bool deformUnified = false;
+        QString mirroredByPartIdString;
+        QString mirrorFromPartIdString;
+        size_t mirrorFromPartIndex = InvalidIndex;
+        QString colorString;
+        PartTarget target = PartTarget::Model;
+        PartBase base = PartBase::XYZ;
+        QString cutFace;
+        size_t cutTemplateIndex = InvalidIndex;
+        float cutRotation = 0.0;
+        float hollowThickness = 0.0;
+        float deformThickness = 1.0;
+        float deformWidth = 1.0;
+        QString deformMapImageIdString;
+        float deformMapScale = 1.0;
+        QUuid materialId;
+        bool hasColorSolubility = false;
+        float colorSolubility = 0;
+        float metalness = 0;
+        float roughness = 1.0;
+        QUuid fillMeshFileId;
+        std::vector<size_t> nodeIndices;
+        std::vector<size_t> edgeIndices;
+    };
+
+    struct Component
+    {
+        QString idString;
+        QUuid id;
+        bool dirty = false;
+        CombineMode combineMode = CombineMode::Normal;
+        bool inverse = false;
+        ComponentLayer layer = ComponentLayer::Body;
+        PolyCount polyCount = PolyCount::Original;
+        bool linkToPart = false;
+        QString linkPartIdString;
+        size_t linkPartIndex = InvalidIndex;
+        QString colorName;
+        bool hasClothStiffness = false;
+        float clothStiffness = 0;
+        bool hasClothIteration = false;
+        size_t clothIteration = 0;
+        ClothForce clothForce = ClothForce::Gravitational;
+        float clothOffset = 0;
+        std::vector<size_t> childIndices;
+    };
+
+    void compile(const Snapshot &snapshot);
+    size_t findPart(const QString &partIdString) const;
+    size_t findComponent(const QString &componentIdString) const;
+
+    float mainProfileMiddleX = 0;
+    float mainProfileMiddleY = 0;
+    float sideProfileMiddleX = 0;
+    std::vector<Node> nodes;
+    std::vector<Edge> edges;
+    std::vector<Part> parts;
+    std::vector<Component> components; // The root component is always at index 0
+    Component canvas;
+    std::vector<std::vector<QVector2D>> cutTemplates;
+
+private:
+    std::map<QString, size_t> m_partIndexMap;
+    std::map<QString, size_t> m_componentIndexMap;
+    std::map<QString, size_t> m_cutTemplateIndexMap;
+
+    void compileComponent(Component &component, const std::map<QString, QString> &map);
+    size_t compileCutTemplate(const QString &cutFaceString);
+    void cutFaceStringToCutTemplate(const QString &cutFaceString, std::vector<QVector2D> &cutTemplate);
+};
+
+#endif
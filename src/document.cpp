@@ -46,6 +46,11 @@ Document::Document() :
     // private
     m_isResultMeshObsolete(false),
     m_meshGenerator(nullptr),
+    m_isPreviewMeshObsolete(false),
+    m_previewMeshGenerator(nullptr),
+    m_isInteractiveEditing(false),
+    m_isCoarseMeshGenerating(false),
+    m_isResultMeshCoarse(false),
     m_resultMesh(nullptr),
     m_paintedMesh(nullptr),
     //m_resultMeshCutFaceTransforms(nullptr),
@@ -85,6 +90,7 @@ Document::Document() :
     connect(&Preferences::instance(), &Preferences::partColorChanged, this, &Document::applyPreferencePartColorChange);
     connect(&Preferences::instance(), &Preferences::flatShadingChanged, this, &Document::applyPreferenceFlatShadingChange);
     connect(&Preferences::instance(), &Preferences::textureSizeChanged, this, &Document::applyPreferenceTextureSizeChange);
+    connect(&Preferences::instance(), &Preferences::accurateClothCollisionChanged, this, &Document::applyPreferenceAccurateClothCollisionChange);
 }
 
 void Document::applyPreferencePartColorChange()
@@ -103,6 +109,11 @@ void Document::applyPreferenceTextureSizeChange()
     generateTexture();
 }
 
+void Document::applyPreferenceAccurateClothCollisionChange()
+{
+    regenerateMesh();
+}
+
 Document::~Document()
 {
     delete m_resultMesh;
@@ -1883,9 +1894,39 @@ Model *Document::takeResultRigWeightMesh()
 
 void Document::meshReady()
 {
+    if (m_meshGenerator->isCancelled()) {
+        delete m_meshGenerator;
+        m_meshGenerator = nullptr;
+        m_isCoarseMeshGenerating = false;
+        
+        qDebug() << "Mesh generation cancelled";
+        
+        if (m_isResultMeshObsolete)
+            generateMesh();
+        return;
+    }
+    
     Model *resultMesh = m_meshGenerator->takeResultMesh();
+    
+    // The coarse result is only shown, the full one replaces it once the editing settles
+    if (m_isCoarseMeshGenerating) {
+        delete m_meshGenerator;
+        m_meshGenerator = nullptr;
+        m_isCoarseMeshGenerating = false;
+        
+        delete m_resultMesh;
+        m_resultMesh = resultMesh;
+        m_isResultMeshCoarse = true;
+        emit resultPreviewMeshChanged();
+        
+        if (m_isResultMeshObsolete || !m_isInteractiveEditing)
+            generateMesh();
+        return;
+    }
+    
     Object *object = m_meshGenerator->takeObject();
     bool isSuccessful = m_meshGenerator->isSuccessful();
+    m_isResultMeshCoarse = false;
     
     bool partPreviewsChanged = false;
     for (auto &partId: m_meshGenerator->generatedPreviewPartIds()) {
@@ -2011,6 +2052,19 @@ void Document::batchChangeEnd()
     }
 }
 
+// While the nodes are dragged the mesh is generated in the coarse tier, which skips the costly passes to follow the pointer
+void Document::interactiveEditBegin()
+{
+    m_isInteractiveEditing = true;
+}
+
+void Document::interactiveEditEnd()
+{
+    m_isInteractiveEditing = false;
+    if (m_isResultMeshCoarse || m_isCoarseMeshGenerating)
+        generateMesh();
+}
+
 void Document::regenerateMesh()
 {
     if (objectLocked)
@@ -2034,8 +2088,18 @@ void Document::enableWeld(bool enabled)
 
 void Document::generateMesh()
 {
+    // Both the preview and the result mesh are generated around the settled origin
+    if (0 == m_batchChangeRefCount) {
+        settleOrigin();
+        generatePreviewMesh();
+    }
+    
     if (nullptr != m_meshGenerator || m_batchChangeRefCount > 0) {
         m_isResultMeshObsolete = true;
+        // The running generation works on a stale snapshot, the fresh one starts as soon as it finishes,
+        // see meshReady; a coarse one is short and still worth showing, only a full one is stopped early
+        if (nullptr != m_meshGenerator && !m_isCoarseMeshGenerating)
+            m_meshGenerator->cancel();
         return;
     }
     
@@ -2043,8 +2107,6 @@ void Document::generateMesh()
     
     qDebug() << "Mesh generating..";
     
-    settleOrigin();
-    
     m_isResultMeshObsolete = false;
     
     QThread *thread = new QThread;
@@ -2055,9 +2117,15 @@ void Document::generateMesh()
     m_meshGenerator = new MeshGenerator(snapshot);
     m_meshGenerator->setId(m_nextMeshGenerationId++);
     m_meshGenerator->setDefaultPartColor(Preferences::instance().partColor());
+    m_meshGenerator->setAccurateClothCollisionEnabled(Preferences::instance().accurateClothCollision());
     if (nullptr == m_generatedCacheContext)
         m_generatedCacheContext = new GeneratedCacheContext;
     m_meshGenerator->setGeneratedCacheContext(m_generatedCacheContext);
+    m_meshGenerator->setBalancedCombinationEnabled(true);
+    m_isCoarseMeshGenerating = m_isInteractiveEditing;
+    m_meshGenerator->setCoarseTierEnabled(m_isCoarseMeshGenerating);
+    if (!m_isCoarseMeshGenerating)
+        m_meshGenerator->setDiskCache(&GeneratedDiskCache::instance());
     if (!m_smoothNormal) {
         m_meshGenerator->setSmoothShadingThresholdAngleDegrees(0);
     }
@@ -2069,6 +2137,60 @@ void Document::generateMesh()
     thread->start();
 }
 
+// The approximated model is shown while the exact generation, which is started along with it, is still running
+void Document::generatePreviewMesh()
+{
+    if (!Preferences::instance().sdfPreview())
+        return;
+    
+    if (nullptr != m_previewMeshGenerator) {
+        m_isPreviewMeshObsolete = true;
+        return;
+    }
+    
+    m_isPreviewMeshObsolete = false;
+    
+    QThread *thread = new QThread;
+    
+    Snapshot *snapshot = new Snapshot;
+    toSnapshot(snapshot);
+    m_previewMeshGenerator = new MeshGenerator(snapshot);
+    m_previewMeshGenerator->setId(m_nextMeshGenerationId++);
+    m_previewMeshGenerator->setDefaultPartColor(Preferences::instance().partColor());
+    m_previewMeshGenerator->setSdfPreviewEnabled(true);
+    if (!m_smoothNormal) {
+        m_previewMeshGenerator->setSmoothShadingThresholdAngleDegrees(0);
+    }
+    m_previewMeshGenerator->moveToThread(thread);
+    connect(thread, &QThread::started, m_previewMeshGenerator, &MeshGenerator::process);
+    connect(m_previewMeshGenerator, &MeshGenerator::finished, this, &Document::previewMeshReady);
+    connect(m_previewMeshGenerator, &MeshGenerator::finished, thread, &QThread::quit);
+    connect(thread, &QThread::finished, thread, &QThread::deleteLater);
+    thread->start();
+}
+
+void Document::previewMeshReady()
+{
+    Model *resultMesh = m_previewMeshGenerator->takeResultMesh();
+    
+    delete m_previewMeshGenerator;
+    m_previewMeshGenerator = nullptr;
+    
+    // The exact result of a newer snapshot is never replaced by an approximation
+    if (nullptr != resultMesh && nullptr != m_resultMesh && m_resultMesh->meshId() > resultMesh->meshId()) {
+        delete resultMesh;
+        resultMesh = nullptr;
+    }
+    if (nullptr != resultMesh) {
+        delete m_resultMesh;
+        m_resultMesh = resultMesh;
+        emit resultPreviewMeshChanged();
+    }
+    
+    if (m_isPreviewMeshObsolete)
+        generatePreviewMesh();
+}
+
 void Document::generateTexture()
 {
     if (objectLocked)
@@ -3347,6 +3469,7 @@ bool Document::isExportReady() const
         return true;
     
     if (m_isResultMeshObsolete ||
+            m_isResultMeshCoarse ||
             m_isTextureObsolete ||
             m_isPostProcessResultObsolete ||
             m_isRigObsolete)
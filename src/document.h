@@ -329,6 +329,7 @@ signals:
     void edgeReversed(QUuid edgeId);
     void partPreviewChanged(QUuid partId);
     void resultMeshChanged();
+    void resultPreviewMeshChanged();
     void resultPartPreviewsChanged();
     void paintedMeshChanged();
     void turnaroundChanged();
@@ -529,6 +530,8 @@ public slots:
     void generateMesh();
     void regenerateMesh();
     void meshReady();
+    void generatePreviewMesh();
+    void previewMeshReady();
     void generateTexture();
     void textureReady();
     void postProcess();
@@ -605,6 +608,8 @@ public slots:
     void saveSnapshot();
     void batchChangeBegin();
     void batchChangeEnd();
+    void interactiveEditBegin();
+    void interactiveEditEnd();
     void reset();
     void resetScript();
     void clearHistories();
@@ -633,6 +638,7 @@ public slots:
     void applyPreferencePartColorChange();
     void applyPreferenceFlatShadingChange();
     void applyPreferenceTextureSizeChange();
+    void applyPreferenceAccurateClothCollisionChange();
     void initScript(const QString &script);
     void updateScript(const QString &script);
     void runScript();
@@ -665,6 +671,11 @@ private:
 private: // need initialize
     bool m_isResultMeshObsolete;
     MeshGenerator *m_meshGenerator;
+    bool m_isPreviewMeshObsolete;
+    MeshGenerator *m_previewMeshGenerator;
+    bool m_isInteractiveEditing;
+    bool m_isCoarseMeshGenerating;
+    bool m_isResultMeshCoarse;
     Model *m_resultMesh;
     Model *m_paintedMesh;
     //std::map<QUuid, StrokeMeshBuilder::CutFaceTransform> *m_resultMeshCutFaceTransforms;
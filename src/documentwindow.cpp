@@ -1073,6 +1073,8 @@ DocumentWindow::DocumentWindow() :
     connect(graphicsWidget, &SkeletonGraphicsWidget::redo, m_document, &Document::redo);
     connect(graphicsWidget, &SkeletonGraphicsWidget::paste, m_document, &Document::paste);
     connect(graphicsWidget, &SkeletonGraphicsWidget::batchChangeBegin, m_document, &Document::batchChangeBegin);
+    connect(graphicsWidget, &SkeletonGraphicsWidget::interactiveEditBegin, m_document, &Document::interactiveEditBegin);
+    connect(graphicsWidget, &SkeletonGraphicsWidget::interactiveEditEnd, m_document, &Document::interactiveEditEnd);
     connect(graphicsWidget, &SkeletonGraphicsWidget::batchChangeEnd, m_document, &Document::batchChangeEnd);
     connect(graphicsWidget, &SkeletonGraphicsWidget::breakEdge, m_document, &Document::breakEdge);
     connect(graphicsWidget, &SkeletonGraphicsWidget::reduceNode, m_document, &Document::reduceNode);
@@ -1247,14 +1249,16 @@ DocumentWindow::DocumentWindow() :
             m_modelRenderWidget->updateColorTexture(new QImage(*m_document->textureImage));
     });
     
-    connect(m_document, &Document::resultMeshChanged, [=]() {
+    auto updateResultMesh = [=]() {
         auto resultMesh = m_document->takeResultMesh();
         if (nullptr != resultMesh)
             m_currentUpdatedMeshId = resultMesh->meshId();
         if (m_modelRemoveColor && resultMesh)
             resultMesh->removeColor();
         m_modelRenderWidget->updateMesh(resultMesh);
-    });
+    };
+    connect(m_document, &Document::resultMeshChanged, updateResultMesh);
+    connect(m_document, &Document::resultPreviewMeshChanged, updateResultMesh);
     
     connect(m_document, &Document::motionsChanged, m_document, &Document::generateMotions);
 
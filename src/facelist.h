@@ -0,0 +1,231 @@
+#ifndef DUST3D_FACE_LIST_H
+#define DUST3D_FACE_LIST_H
+#include <vector>
+#include <initializer_list>
+#include <iterator>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+// Polygon faces kept in one flat index buffer, instead of one heap allocated vector per face.
+// The indices are 32 bits, and the offsets are only materialized when the first non triangle face is added,
+// so the triangle meshes, which are most of the meshes generated, cost three indices per face and nothing else.
+
+class FaceList
+{
+public:
+    class Face
+    {
+    public:
+        Face(const uint32_t *begin, const uint32_t *end) :
+            m_begin(begin),
+            m_end(end)
+        {
+        }
+        size_t size() const
+        {
+            return (size_t)(m_end - m_begin);
+        }
+        bool empty() const
+        {
+            return m_begin == m_end;
+        }
+        size_t operator[](size_t index) const
+        {
+            return m_begin[index];
+        }
+        size_t front() const
+        {
+            return *m_begin;
+        }
+        size_t back() const
+        {
+            return *(m_end - 1);
+        }
+        const uint32_t *begin() const
+        {
+            return m_begin;
+        }
+        const uint32_t *end() const
+        {
+            return m_end;
+        }
+        std::vector<size_t> toVector() const
+        {
+            return std::vector<size_t>(m_begin, m_end);
+        }
+        operator std::vector<size_t>() const
+        {
+            return toVector();
+        }
+
+    private:
+        const uint32_t *m_begin = nullptr;
+        const uint32_t *m_end = nullptr;
+    };
+
+    class const_iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef Face value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const Face *pointer;
+        typedef Face reference;
+
+        const_iterator(const FaceList *faceList, size_t faceIndex) :
+            m_faceList(faceList),
+            m_faceIndex(faceIndex)
+        {
+        }
+        Face operator*() const
+        {
+            return (*m_faceList)[m_faceIndex];
+        }
+        const_iterator &operator++()
+        {
+            ++m_faceIndex;
+            return *this;
+        }
+        const_iterator operator++(int)
+        {
+            const_iterator previous = *this;
+            ++m_faceIndex;
+            return previous;
+        }
+        bool operator==(const const_iterator &other) const
+        {
+            return m_faceIndex == other.m_faceIndex;
+        }
+        bool operator!=(const const_iterator &other) const
+        {
+            return m_faceIndex != other.m_faceIndex;
+        }
+
+    private:
+        const FaceList *m_faceList = nullptr;
+        size_t m_faceIndex = 0;
+    };
+
+    FaceList() = default;
+    FaceList(const std::vector<std::vector<size_t>> &faces)
+    {
+        append(faces);
+    }
+    size_t size() const
+    {
+        return m_faceCount;
+    }
+    bool empty() const
+    {
+        return 0 == m_faceCount;
+    }
+    bool isTriangleOnly() const
+    {
+        return m_offsets.empty();
+    }
+    Face operator[](size_t faceIndex) const
+    {
+        const uint32_t *indices = m_indices.data();
+        if (m_offsets.empty())
+            return Face(indices + faceIndex * 3, indices + faceIndex * 3 + 3);
+        return Face(indices + m_offsets[faceIndex], indices + m_offsets[faceIndex + 1]);
+    }
+    const_iterator begin() const
+    {
+        return const_iterator(this, 0);
+    }
+    const_iterator end() const
+    {
+        return const_iterator(this, m_faceCount);
+    }
+    const std::vector<uint32_t> &indices() const
+    {
+        return m_indices;
+    }
+    void reserve(size_t faceCount, size_t indexCount)
+    {
+        m_indices.reserve(indexCount);
+        m_reservedFaceCount = faceCount;
+        if (!m_offsets.empty())
+            m_offsets.reserve(faceCount + 1);
+    }
+    void clear()
+    {
+        m_indices.clear();
+        m_offsets.clear();
+        m_faceCount = 0;
+        m_reservedFaceCount = 0;
+    }
+    template <class InputIterator>
+    void push_back(InputIterator first, InputIterator last, size_t vertexOffset=0)
+    {
+        size_t oldIndexCount = m_indices.size();
+        for (; first != last; ++first)
+            m_indices.push_back((uint32_t)(*first + vertexOffset));
+        size_t faceSize = m_indices.size() - oldIndexCount;
+        if (3 != faceSize && m_offsets.empty())
+            materializeOffsets();
+        if (!m_offsets.empty())
+            m_offsets.push_back((uint32_t)m_indices.size());
+        ++m_faceCount;
+    }
+    void push_back(const std::vector<size_t> &face)
+    {
+        push_back(face.begin(), face.end());
+    }
+    void push_back(std::initializer_list<size_t> face)
+    {
+        push_back(face.begin(), face.end());
+    }
+    void push_back(const Face &face)
+    {
+        push_back(face.begin(), face.end());
+    }
+    void append(const std::vector<std::vector<size_t>> &faces, size_t vertexOffset=0)
+    {
+        size_t indexCount = 0;
+        for (const auto &face: faces)
+            indexCount += face.size();
+        m_indices.reserve(m_indices.size() + indexCount);
+        for (const auto &face: faces)
+            push_back(face.begin(), face.end(), vertexOffset);
+    }
+    void append(const FaceList &faces, size_t vertexOffset=0)
+    {
+        if (faces.isTriangleOnly() && isTriangleOnly()) {
+            m_indices.reserve(m_indices.size() + faces.m_indices.size());
+            for (const auto &index: faces.m_indices)
+                m_indices.push_back((uint32_t)(index + vertexOffset));
+            m_faceCount += faces.m_faceCount;
+            return;
+        }
+        m_indices.reserve(m_indices.size() + faces.m_indices.size());
+        for (const auto &face: faces)
+            push_back(face.begin(), face.end(), vertexOffset);
+    }
+    std::vector<std::vector<size_t>> toVector() const
+    {
+        std::vector<std::vector<size_t>> faces;
+        faces.reserve(m_faceCount);
+        for (const auto &face: *this)
+            faces.push_back(face.toVector());
+        return faces;
+    }
+
+private:
+    std::vector<uint32_t> m_indices;
+    std::vector<uint32_t> m_offsets;
+    size_t m_faceCount = 0;
+    size_t m_reservedFaceCount = 0;
+
+    // A list reserved before its first non triangle face still grows its offsets only once
+    void materializeOffsets()
+    {
+        m_offsets.reserve(std::max(m_faceCount + 2, m_reservedFaceCount + 1));
+        for (size_t i = 0; i <= m_faceCount; ++i)
+            m_offsets.push_back((uint32_t)(i * 3));
+    }
+};
+
+#endif
@@ -0,0 +1,292 @@
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDateTime>
+#include <QStandardPaths>
+#include <QDebug>
+#include <QRunnable>
+#include "generateddiskcache.h"
+
+static const quint32 g_entryMagic = 0x44334743; // "D3GC"
+static const quint32 g_entryFormatVersion = 1;
+
+// The entries queued faster than the disk takes them are dropped beyond this size, they are only a cache
+static const qint64 g_maxPendingWriteSize = 64LL * 1024 * 1024;
+
+class GeneratedDiskCacheWriter : public QRunnable
+{
+public:
+    GeneratedDiskCacheWriter(GeneratedDiskCache *diskCache) :
+        m_diskCache(diskCache)
+    {
+    }
+    void run() override
+    {
+        m_diskCache->writePendingEntries();
+    }
+private:
+    GeneratedDiskCache *m_diskCache = nullptr;
+};
+
+const qint64 GeneratedDiskCache::defaultMaxSize = 512LL * 1024 * 1024;
+
+GeneratedDiskCache &GeneratedDiskCache::instance()
+{
+    // The location and the cap could be overridden from the environment, e.g. to share a cache between the runs of a CI job
+    static GeneratedDiskCache s_diskCache([]() {
+            QString directory = QString::fromLocal8Bit(qgetenv("DUST3D_CACHE_DIR"));
+            if (directory.isEmpty())
+                directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QDir::separator() + "generated";
+            return directory;
+        }(), []() {
+            bool ok = false;
+            qint64 maxSizeInMegabytes = qgetenv("DUST3D_CACHE_MAX_MB").toLongLong(&ok);
+            if (!ok || maxSizeInMegabytes < 0)
+                return GeneratedDiskCache::defaultMaxSize;
+            return maxSizeInMegabytes * 1024 * 1024;
+        }());
+    return s_diskCache;
+}
+
+GeneratedDiskCache::GeneratedDiskCache(const QString &directory, qint64 maxSize) :
+    m_directory(directory),
+    m_maxSize(maxSize)
+{
+    // One writer, the entries are written one after another in the background
+    m_writerPool.setMaxThreadCount(1);
+    if (m_directory.isEmpty() || 0 == m_maxSize)
+        return;
+    QDir dir(m_directory);
+    if (!dir.mkpath(dir.absolutePath())) {
+        qDebug() << "Create disk cache directory failed:" << m_directory;
+        return;
+    }
+    m_isValid = true;
+    scan();
+}
+
+GeneratedDiskCache::~GeneratedDiskCache()
+{
+    flush();
+}
+
+bool GeneratedDiskCache::isValid() const
+{
+    return m_isValid;
+}
+
+const QString &GeneratedDiskCache::directory() const
+{
+    return m_directory;
+}
+
+qint64 GeneratedDiskCache::maxSize() const
+{
+    return m_maxSize;
+}
+
+void GeneratedDiskCache::setMaxSize(qint64 maxSize)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maxSize = maxSize;
+    evict();
+}
+
+QString GeneratedDiskCache::entryFileName(const QString &name) const
+{
+    return m_directory + QDir::separator() + name + ".bin";
+}
+
+void GeneratedDiskCache::scan()
+{
+    QDir dir(m_directory);
+    for (const auto &fileInfo: dir.entryInfoList(QStringList() << "*.bin", QDir::Files)) {
+        touch(fileInfo.completeBaseName(), fileInfo.size(),
+            fileInfo.lastModified().toMSecsSinceEpoch());
+    }
+    evict();
+}
+
+void GeneratedDiskCache::touch(const QString &name, qint64 size, qint64 lastUsed)
+{
+    auto &entry = m_entries[name];
+    m_recency.erase({entry.lastUsed, name});
+    m_totalSize -= entry.size;
+    entry.lastUsed = lastUsed;
+    entry.size = size;
+    m_recency.insert({entry.lastUsed, name});
+    m_totalSize += entry.size;
+}
+
+void GeneratedDiskCache::remove(const QString &name)
+{
+    auto findEntry = m_entries.find(name);
+    if (findEntry == m_entries.end())
+        return;
+    m_recency.erase({findEntry->second.lastUsed, name});
+    m_totalSize -= findEntry->second.size;
+    m_entries.erase(findEntry);
+    QFile::remove(entryFileName(name));
+}
+
+void GeneratedDiskCache::evict()
+{
+    while (m_totalSize > m_maxSize && !m_recency.empty()) {
+        remove(m_recency.begin()->second);
+        ++evictionCount;
+    }
+}
+
+bool GeneratedDiskCache::contains(const QByteArray &key)
+{
+    if (!m_isValid)
+        return false;
+    
+    QString name = QString::fromLatin1(key.toHex());
+    QMutexLocker locker(&m_mutex);
+    return m_entries.find(name) != m_entries.end() ||
+        m_pendingWrites.find(name) != m_pendingWrites.end();
+}
+
+bool GeneratedDiskCache::load(const QByteArray &key, QByteArray *data)
+{
+    if (!m_isValid)
+        return false;
+    
+    QString name = QString::fromLatin1(key.toHex());
+    {
+        QMutexLocker locker(&m_mutex);
+        auto findPending = m_pendingWrites.find(name);
+        if (findPending != m_pendingWrites.end()) {
+            *data = findPending->second.second;
+            ++hitCount;
+            return true;
+        }
+        if (m_entries.find(name) == m_entries.end()) {
+            ++missCount;
+            return false;
+        }
+    }
+    
+    QFile file(entryFileName(name));
+    bool isLoaded = false;
+    if (file.open(QIODevice::ReadOnly)) {
+        QDataStream stream(&file);
+        quint32 magic = 0;
+        quint32 formatVersion = 0;
+        QByteArray storedKey;
+        stream >> magic >> formatVersion;
+        if (g_entryMagic == magic && g_entryFormatVersion == formatVersion) {
+            stream >> storedKey >> *data;
+            isLoaded = QDataStream::Ok == stream.status() && storedKey == key;
+        }
+    }
+    
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (isLoaded)
+        file.setFileTime(QDateTime::fromMSecsSinceEpoch(now), QFileDevice::FileModificationTime);
+    qint64 size = file.size();
+    file.close();
+    
+    QMutexLocker locker(&m_mutex);
+    if (!isLoaded) {
+        // Removed by another process, or a corrupted entry
+        remove(name);
+        ++missCount;
+        return false;
+    }
+    touch(name, size, now);
+    ++hitCount;
+    return true;
+}
+
+void GeneratedDiskCache::save(const QByteArray &key, const QByteArray &data)
+{
+    if (!m_isValid)
+        return;
+    
+    QString name = QString::fromLatin1(key.toHex());
+    
+    QMutexLocker locker(&m_mutex);
+    if (m_pendingWrites.find(name) != m_pendingWrites.end())
+        return;
+    if (m_pendingWriteSize + data.size() > g_maxPendingWriteSize)
+        return;
+    m_pendingWrites.insert({name, {key, data}});
+    m_pendingWriteSize += data.size();
+    if (!m_isWriting) {
+        m_isWriting = true;
+        m_writerPool.start(new GeneratedDiskCacheWriter(this));
+    }
+}
+
+void GeneratedDiskCache::flush()
+{
+    m_writerPool.waitForDone();
+}
+
+void GeneratedDiskCache::writePendingEntries()
+{
+    for (;;) {
+        QString name;
+        std::pair<QByteArray, QByteArray> pendingWrite;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_pendingWrites.empty()) {
+                m_isWriting = false;
+                return;
+            }
+            // The entry stays in the queue while written, so it is never missing for the readers
+            name = m_pendingWrites.begin()->first;
+            pendingWrite = m_pendingWrites.begin()->second;
+        }
+        writeEntry(name, pendingWrite.first, pendingWrite.second);
+        QMutexLocker locker(&m_mutex);
+        auto findPending = m_pendingWrites.find(name);
+        if (findPending != m_pendingWrites.end()) {
+            m_pendingWriteSize -= findPending->second.second.size();
+            m_pendingWrites.erase(findPending);
+        }
+    }
+}
+
+void GeneratedDiskCache::writeEntry(const QString &name, const QByteArray &key, const QByteArray &data)
+{
+    // The entry is written to a temporary file and renamed, so the readers never see a partial entry
+    QSaveFile file(entryFileName(name));
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+    QDataStream stream(&file);
+    stream << g_entryMagic << g_entryFormatVersion << key << data;
+    if (QDataStream::Ok != stream.status()) {
+        file.cancelWriting();
+        file.commit();
+        return;
+    }
+    if (!file.commit()) {
+        qDebug() << "Write disk cache entry failed:" << name;
+        return;
+    }
+    
+    qint64 size = QFileInfo(entryFileName(name)).size();
+    
+    QMutexLocker locker(&m_mutex);
+    touch(name, size, QDateTime::currentMSecsSinceEpoch());
+    evict();
+}
+
+void GeneratedDiskCache::clear()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_pendingWrites.clear();
+        m_pendingWriteSize = 0;
+    }
+    // The entry being written is removed along with the others
+    flush();
+    QMutexLocker locker(&m_mutex);
+    while (!m_recency.empty())
+        remove(m_recency.begin()->second);
+}
@@ -0,0 +1,69 @@
+#ifndef DUST3D_GENERATED_DISK_CACHE_H
+#define DUST3D_GENERATED_DISK_CACHE_H
+#include <map>
+#include <set>
+#include <QString>
+#include <QByteArray>
+#include <QMutex>
+#include <QThreadPool>
+
+// Content addressed store of the generated parts and components, shared by all the generators of the process.
+// The entries are files named by the content hash, the least recently used ones are removed once the total size exceeds the cap,
+// the recency is kept in the modification time of the files so it survives restarts.
+// The entries are written by a background writer, so the generation never waits for the disk.
+
+class GeneratedDiskCache
+{
+public:
+    static GeneratedDiskCache &instance();
+    GeneratedDiskCache(const QString &directory, qint64 maxSize);
+    ~GeneratedDiskCache();
+    bool isValid() const;
+    const QString &directory() const;
+    qint64 maxSize() const;
+    void setMaxSize(qint64 maxSize);
+    bool contains(const QByteArray &key);
+    bool load(const QByteArray &key, QByteArray *data);
+    // Queues the entry to be written, it is readable from the queue until then
+    void save(const QByteArray &key, const QByteArray &data);
+    // Waits for the queued entries to be written
+    void flush();
+    void clear();
+
+    size_t hitCount = 0;
+    size_t missCount = 0;
+    size_t evictionCount = 0;
+
+    static const qint64 defaultMaxSize;
+
+private:
+    struct Entry
+    {
+        qint64 lastUsed = 0;
+        qint64 size = 0;
+    };
+
+    QString m_directory;
+    qint64 m_maxSize = 0;
+    qint64 m_totalSize = 0;
+    bool m_isValid = false;
+    std::map<QString, Entry> m_entries;
+    std::set<std::pair<qint64, QString>> m_recency;
+    std::map<QString, std::pair<QByteArray, QByteArray>> m_pendingWrites;
+    qint64 m_pendingWriteSize = 0;
+    bool m_isWriting = false;
+    QThreadPool m_writerPool;
+    QMutex m_mutex;
+
+    QString entryFileName(const QString &name) const;
+    void scan();
+    void touch(const QString &name, qint64 size, qint64 lastUsed);
+    void remove(const QString &name);
+    void evict();
+    void writePendingEntries();
+    void writeEntry(const QString &name, const QByteArray &key, const QByteArray &data);
+    
+    friend class GeneratedDiskCacheWriter;
+};
+
+#endif
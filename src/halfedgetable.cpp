@@ -0,0 +1,112 @@
+#include <algorithm>
+#include "halfedgetable.h"
+
+HalfEdgeTable::HalfEdgeTable(const std::vector<std::vector<size_t>> &faces)
+{
+    build(faces);
+}
+
+HalfEdgeTable::HalfEdgeTable(const FaceList &faces)
+{
+    build(faces);
+}
+
+void HalfEdgeTable::build(const std::vector<std::vector<size_t>> &faces, const std::vector<char> *faceMask)
+{
+    buildFromFaces(faces, faceMask);
+}
+
+void HalfEdgeTable::build(const FaceList &faces, const std::vector<char> *faceMask)
+{
+    buildFromFaces(faces, faceMask);
+}
+
+template <class Faces>
+void HalfEdgeTable::buildFromFaces(const Faces &faces, const std::vector<char> *faceMask)
+{
+    size_t vertexCount = 0;
+    size_t halfEdgeCount = 0;
+    for (size_t faceIndex = 0; faceIndex < faces.size(); ++faceIndex) {
+        if (nullptr != faceMask && !(*faceMask)[faceIndex])
+            continue;
+        const auto &face = faces[faceIndex];
+        halfEdgeCount += face.size();
+        for (const auto &index: face)
+            vertexCount = std::max(vertexCount, (size_t)index + 1);
+    }
+    
+    // Counting sort by the start vertex, the faces are visited in order, so each group is already ordered by the face
+    m_vertexOffsets.assign(vertexCount + 1, 0);
+    for (size_t faceIndex = 0; faceIndex < faces.size(); ++faceIndex) {
+        if (nullptr != faceMask && !(*faceMask)[faceIndex])
+            continue;
+        for (const auto &index: faces[faceIndex])
+            ++m_vertexOffsets[index + 1];
+    }
+    for (size_t i = 1; i < m_vertexOffsets.size(); ++i)
+        m_vertexOffsets[i] += m_vertexOffsets[i - 1];
+    m_halfEdges.resize(halfEdgeCount);
+    std::vector<uint32_t> cursors(m_vertexOffsets.begin(), m_vertexOffsets.end() - 1);
+    for (size_t faceIndex = 0; faceIndex < faces.size(); ++faceIndex) {
+        if (nullptr != faceMask && !(*faceMask)[faceIndex])
+            continue;
+        const auto &face = faces[faceIndex];
+        for (size_t i = 0; i < face.size(); ++i) {
+            size_t j = (i + 1) % face.size();
+            m_halfEdges[cursors[face[i]]++] = {(uint32_t)face[i], (uint32_t)face[j], (uint32_t)faceIndex, (uint32_t)i};
+        }
+    }
+    
+    // The groups are as small as the vertex valences, a stable insertion sort by the end vertex keeps the face order
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+        HalfEdge *groupBegin = m_halfEdges.data() + m_vertexOffsets[vertex];
+        HalfEdge *groupEnd = m_halfEdges.data() + m_vertexOffsets[vertex + 1];
+        for (HalfEdge *it = groupBegin + 1; it < groupEnd; ++it) {
+            HalfEdge halfEdge = *it;
+            HalfEdge *insertAt = it;
+            while (insertAt > groupBegin && (insertAt - 1)->to > halfEdge.to) {
+                *insertAt = *(insertAt - 1);
+                --insertAt;
+            }
+            *insertAt = halfEdge;
+        }
+    }
+}
+
+const HalfEdge *HalfEdgeTable::find(size_t from, size_t to) const
+{
+    if (from + 1 >= m_vertexOffsets.size())
+        return nullptr;
+    const HalfEdge *groupEnd = m_halfEdges.data() + m_vertexOffsets[from + 1];
+    for (const HalfEdge *it = m_halfEdges.data() + m_vertexOffsets[from]; it < groupEnd; ++it) {
+        if (it->to == to)
+            return it;
+        if (it->to > to)
+            break;
+    }
+    return nullptr;
+}
+
+const HalfEdge *HalfEdgeTable::findLast(size_t from, size_t to) const
+{
+    const HalfEdge *halfEdge = find(from, to);
+    if (nullptr == halfEdge)
+        return nullptr;
+    const HalfEdge *groupEnd = m_halfEdges.data() + m_vertexOffsets[from + 1];
+    while (halfEdge + 1 < groupEnd && (halfEdge + 1)->to == to)
+        ++halfEdge;
+    return halfEdge;
+}
+
+bool HalfEdgeTable::isManifold() const
+{
+    for (size_t i = 0; i < m_halfEdges.size(); ++i) {
+        const auto &halfEdge = m_halfEdges[i];
+        if (i + 1 < m_halfEdges.size() && m_halfEdges[i + 1].from == halfEdge.from &&
+                m_halfEdges[i + 1].to == halfEdge.to)
+            return false;
+        if (nullptr == opposite(halfEdge))
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,63 @@
+#ifndef DUST3D_HALF_EDGE_TABLE_H
+#define DUST3D_HALF_EDGE_TABLE_H
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "facelist.h"
+
+// The directed edges of a polygon mesh, grouped by their start vertex in one flat array,
+// so the face on the other side of an edge is found by scanning the few half edges leaving a vertex.
+// Inside the group of a vertex the half edges are ordered by the end vertex and then by the face,
+// so iterating the table visits them in the same order as a std::map keyed by (from, to) would,
+// and a half edge repeated by a non manifold mesh is first found on the lowest face, as std::map::insert keeps it.
+
+struct HalfEdge
+{
+    uint32_t from;
+    uint32_t to;
+    uint32_t face;
+    uint32_t corner;
+};
+
+class HalfEdgeTable
+{
+public:
+    HalfEdgeTable() = default;
+    HalfEdgeTable(const std::vector<std::vector<size_t>> &faces);
+    HalfEdgeTable(const FaceList &faces);
+    // The faces with a zero in the mask are left out; building again reuses the memory of the previous build
+    void build(const std::vector<std::vector<size_t>> &faces, const std::vector<char> *faceMask=nullptr);
+    void build(const FaceList &faces, const std::vector<char> *faceMask=nullptr);
+    const HalfEdge *find(size_t from, size_t to) const;
+    const HalfEdge *findLast(size_t from, size_t to) const;
+    const HalfEdge *opposite(const HalfEdge &halfEdge) const
+    {
+        return find(halfEdge.to, halfEdge.from);
+    }
+    bool isManifold() const;
+    size_t size() const
+    {
+        return m_halfEdges.size();
+    }
+    bool empty() const
+    {
+        return m_halfEdges.empty();
+    }
+    const HalfEdge *begin() const
+    {
+        return m_halfEdges.data();
+    }
+    const HalfEdge *end() const
+    {
+        return m_halfEdges.data() + m_halfEdges.size();
+    }
+
+private:
+    std::vector<uint32_t> m_vertexOffsets;
+    std::vector<HalfEdge> m_halfEdges;
+
+    template <class Faces>
+    void buildFromFaces(const Faces &faces, const std::vector<char> *faceMask);
+};
+
+#endif
@@ -19,6 +19,8 @@ struct _dust3d
     Model *resultMesh = nullptr;
     Snapshot *snapshot = nullptr;
     Object *object = nullptr;
+    int generationMode = DUST3D_GENERATION_EXACT;
+    bool accurateClothCollision = false;
     int error = DUST3D_ERROR;
 };
 
@@ -121,6 +123,16 @@ DUST3D_DLL const char * DUST3D_API dust3dVersion()
     return APP_NAME " " APP_HUMAN_VER;
 }
 
+DUST3D_DLL void DUST3D_API dust3dSetGenerationMode(dust3d *ds3, int generationMode)
+{
+    ds3->generationMode = generationMode;
+}
+
+DUST3D_DLL void DUST3D_API dust3dSetAccurateClothCollision(dust3d *ds3, int enabled)
+{
+    ds3->accurateClothCollision = 0 != enabled;
+}
+
 DUST3D_DLL int DUST3D_API dust3dGenerateMesh(dust3d *ds3)
 {
     ds3->error = DUST3D_ERROR;
@@ -136,6 +148,9 @@ DUST3D_DLL int DUST3D_API dust3dGenerateMesh(dust3d *ds3)
     
     MeshGenerator *meshGenerator = new MeshGenerator(snapshot);
     meshGenerator->setGeneratedCacheContext(ds3->cacheContext);
+    meshGenerator->setDiskCache(&GeneratedDiskCache::instance());
+    meshGenerator->setSdfPreviewEnabled(DUST3D_GENERATION_SDF_PREVIEW == ds3->generationMode);
+    meshGenerator->setAccurateClothCollisionEnabled(ds3->accurateClothCollision);
     meshGenerator->generate();
     
     delete ds3->object;
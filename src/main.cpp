@@ -11,6 +11,8 @@
 #include "documentwindow.h"
 #include "theme.h"
 #include "version.h"
+#include "preferences.h"
+#include "tracer.h"
 
 int main(int argc, char ** argv)
 {
@@ -60,6 +62,11 @@ int main(int argc, char ** argv)
     
     Theme::initAwsomeBaseSizes();
     
+    Tracer::instance().setEnabled(Preferences::instance().generationTracing());
+    QObject::connect(&Preferences::instance(), &Preferences::generationTracingChanged, []() {
+        Tracer::instance().setEnabled(Preferences::instance().generationTracing());
+    });
+    
     DocumentWindow *firstWindow = DocumentWindow::createDocumentWindow();
     
     qDebug() << "Language:" << QLocale().name();
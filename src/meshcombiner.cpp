@@ -1,83 +1,218 @@
+// CGAL only runs the algorithms given CGAL::Parallel_tag on threads when it knows TBB is linked;
+// defined here alone, the only place passing the tag, so the other CGAL users keep their sequential paths
+#define CGAL_LINKED_WITH_TBB
 #include <CGAL/Polygon_mesh_processing/corefinement.h>
 #include <CGAL/Polygon_mesh_processing/repair.h>
 #include <CGAL/Polygon_mesh_processing/triangulate_faces.h>
+#include <CGAL/Polygon_mesh_processing/bbox.h>
+#include <CGAL/Side_of_triangle_mesh.h>
+#include <tbb/task_arena.h>
 #include <QDebug>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QHash>
+#include <QCryptographicHash>
 #include <map>
+#include <numeric>
+#include <algorithm>
+#include <cstring>
+extern "C" {
+#include <crc64.h>
+}
 #include "meshcombiner.h"
 #include "positionkey.h"
+#include "openhashmap.h"
 #include "booleanmesh.h"
 #include "util.h"
+#include "tracer.h"
 
 typedef CGAL::Exact_predicates_inexact_constructions_kernel CgalKernel;
 typedef CGAL::Surface_mesh<CgalKernel::Point_3> CgalMesh;
 
+class MeshCombiner::SurfaceMesh
+{
+public:
+    explicit SurfaceMesh(CgalMesh *cgalMesh) :
+        m_cgalMesh(cgalMesh)
+    {
+    }
+    
+    SurfaceMesh(const SurfaceMesh &other) :
+        m_cgalMesh(new CgalMesh(*other.m_cgalMesh))
+    {
+    }
+    
+    const CgalMesh &cgalMesh() const
+    {
+        return *m_cgalMesh;
+    }
+    
+    CgalMesh &cgalMesh()
+    {
+        return *m_cgalMesh;
+    }
+    
+private:
+    std::unique_ptr<CgalMesh> m_cgalMesh;
+};
+
+// The faces count from which the self intersection test is split over the threads; measured with
+// benchmark/selfintersection, the parallel path does 1.1 to 1.5 times the work of the sequential one,
+// and below this count the whole sequential test takes only a few dozen milliseconds
+static const size_t g_parallelSelfIntersectionFaceCount = 2000;
+
+// The verdicts of the checks, by the hash of the checked content; the same part meshes are checked again and again while editing,
+// and most of the checked meshes pass, so a verdict is only worth the hash and the lookup
+static QMutex g_combinableVerdictsMutex;
+static QHash<QByteArray, bool> g_combinableVerdicts;
+static const int g_maxCombinableVerdictCount = 10000;
+
+static QByteArray meshContentHash(const std::vector<QVector3D> &vertices, const std::vector<std::vector<size_t>> &faces)
+{
+    std::vector<float> positions;
+    positions.reserve(vertices.size() * 3);
+    for (const auto &vertex: vertices) {
+        positions.push_back(vertex.x());
+        positions.push_back(vertex.y());
+        positions.push_back(vertex.z());
+    }
+    std::vector<quint32> indices;
+    for (const auto &face: faces) {
+        indices.push_back((quint32)face.size());
+        for (const auto &index: face)
+            indices.push_back((quint32)index);
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData((const char *)positions.data(), (int)(positions.size() * sizeof(float)));
+    hash.addData((const char *)indices.data(), (int)(indices.size() * sizeof(quint32)));
+    return hash.result();
+}
+
+static quint64 combinedContentHash(quint64 firstContentHash, quint64 secondContentHash, MeshCombiner::Method method)
+{
+    quint64 values[] = {
+        firstContentHash,
+        secondContentHash,
+        (quint64)method
+    };
+    return crc64(0, (const unsigned char *)values, sizeof(values));
+}
+
+// Surface_mesh never holds two halfedges of the same direction between two vertices,
+// so the faces are manifold, in the sense of isManifold, when every halfedge has a face on its other side
+static bool isCgalMeshClosed(const CgalMesh &mesh)
+{
+    for (const auto &halfedge: mesh.halfedges()) {
+        if (mesh.is_border(halfedge))
+            return false;
+    }
+    return true;
+}
+
+static bool checkCgalMeshCombinable(CgalMesh *cgalMesh)
+{
+    if (!CGAL::is_valid_polygon_mesh(*cgalMesh)) {
+        qDebug() << "Mesh is not valid polygon";
+        return false;
+    }
+    if (!CGAL::Polygon_mesh_processing::triangulate_faces(*cgalMesh)) {
+        qDebug() << "Mesh triangulate failed";
+        return false;
+    }
+    // On a single thread the parallel path is only the extra work
+    bool selfIntersects = (cgalMesh->number_of_faces() >= g_parallelSelfIntersectionFaceCount &&
+            tbb::this_task_arena::max_concurrency() > 1) ?
+        CGAL::Polygon_mesh_processing::does_self_intersect<CGAL::Parallel_tag>(*cgalMesh) :
+        CGAL::Polygon_mesh_processing::does_self_intersect<CGAL::Sequential_tag>(*cgalMesh);
+    if (selfIntersects) {
+        qDebug() << "Mesh does_self_intersect";
+        return false;
+    }
+    if (!isCgalMeshClosed(*cgalMesh)) {
+        qDebug() << "Mesh does not self intersect but is not manifold";
+        return false;
+    }
+    return true;
+}
+
 MeshCombiner::Mesh::Mesh(const std::vector<QVector3D> &vertices, const std::vector<std::vector<size_t>> &faces, bool disableSelfIntersects)
 {
     CgalMesh *cgalMesh = nullptr;
     if (!faces.empty()) {
-        cgalMesh = buildCgalMesh<CgalKernel>(vertices, faces);
-        if (!disableSelfIntersects) {
-            if (!CGAL::is_valid_polygon_mesh(*cgalMesh)) {
-                qDebug() << "Mesh is not valid polygon";
-                delete cgalMesh;
-                cgalMesh = nullptr;
-            } else {
-                if (CGAL::Polygon_mesh_processing::triangulate_faces(*cgalMesh)) {
-                    if (CGAL::Polygon_mesh_processing::does_self_intersect(*cgalMesh)) {
-                        qDebug() << "Mesh does_self_intersect";
+        QByteArray contentHash = meshContentHash(vertices, faces);
+        memcpy(&m_contentHash, contentHash.constData(), sizeof(m_contentHash));
+        if (disableSelfIntersects) {
+            cgalMesh = buildCgalMesh<CgalKernel>(vertices, faces);
+        } else {
+            TraceSpan span("MeshCombiner::Mesh::check");
+            span.addArgument("faceCount", (qint64)faces.size());
+            bool hasVerdict = false;
+            bool isCombinable = false;
+            {
+                QMutexLocker locker(&g_combinableVerdictsMutex);
+                auto findVerdict = g_combinableVerdicts.constFind(contentHash);
+                if (findVerdict != g_combinableVerdicts.constEnd()) {
+                    hasVerdict = true;
+                    isCombinable = findVerdict.value();
+                }
+            }
+            span.addArgument("cached", (qint64)(hasVerdict ? 1 : 0));
+            if (hasVerdict) {
+                if (isCombinable) {
+                    // The passed mesh was triangulated by the check, which is still needed
+                    cgalMesh = buildCgalMesh<CgalKernel>(vertices, faces);
+                    if (CGAL::Polygon_mesh_processing::triangulate_faces(*cgalMesh)) {
+                        m_isCombinable = true;
+                    } else {
                         delete cgalMesh;
                         cgalMesh = nullptr;
-                    } else {
-						std::vector<QVector3D> fetchedVertices;
-						std::vector<std::vector<size_t>> fetchedFaces;
-						fetchFromCgalMesh<CgalKernel>(cgalMesh, fetchedVertices, fetchedFaces);
-						if (!isManifold(fetchedFaces)) {
-							qDebug() << "Mesh does not self intersect but is not manifold";
-							delete cgalMesh;
-							cgalMesh = nullptr;
-						} else {
-							m_isCombinable = true;
-						}
                     }
+                }
+            } else {
+                cgalMesh = buildCgalMesh<CgalKernel>(vertices, faces);
+                isCombinable = checkCgalMeshCombinable(cgalMesh);
+                if (isCombinable) {
+                    m_isCombinable = true;
                 } else {
-                    qDebug() << "Mesh triangulate failed";
                     delete cgalMesh;
                     cgalMesh = nullptr;
                 }
+                QMutexLocker locker(&g_combinableVerdictsMutex);
+                if (g_combinableVerdicts.size() >= g_maxCombinableVerdictCount)
+                    g_combinableVerdicts.clear();
+                g_combinableVerdicts.insert(contentHash, isCombinable);
             }
         }
     }
-    m_privateData = cgalMesh;
+    if (nullptr != cgalMesh)
+        m_surfaceMesh = std::make_shared<SurfaceMesh>(cgalMesh);
     validate();
 }
 
 MeshCombiner::Mesh::Mesh(const Mesh &other)
 {
-    if (other.m_privateData) {
+    if (other.m_surfaceMesh) {
 		m_isCombinable = other.m_isCombinable;
-        m_privateData = new CgalMesh(*(CgalMesh *)other.m_privateData);
-        validate();
+        m_contentHash = other.m_contentHash;
+        m_surfaceMesh = other.m_surfaceMesh;
     }
 }
 
 MeshCombiner::Mesh::~Mesh()
 {
-    CgalMesh *cgalMesh = (CgalMesh *)m_privateData;
-    delete cgalMesh;
 }
 
 void MeshCombiner::Mesh::fetch(std::vector<QVector3D> &vertices, std::vector<std::vector<size_t>> &faces) const
 {
-    CgalMesh *exactMesh = (CgalMesh *)m_privateData;
-    if (nullptr == exactMesh)
+    if (nullptr == m_surfaceMesh)
         return;
     
-    fetchFromCgalMesh<CgalKernel>(exactMesh, vertices, faces);
+    fetchFromCgalMesh<CgalKernel>(&m_surfaceMesh->cgalMesh(), vertices, faces);
 }
 
 bool MeshCombiner::Mesh::isNull() const
 {
-    return nullptr == m_privateData;
+    return nullptr == m_surfaceMesh;
 }
 
 bool MeshCombiner::Mesh::isCombinable() const
@@ -85,7 +220,57 @@ bool MeshCombiner::Mesh::isCombinable() const
     return m_isCombinable;
 }
 
-MeshCombiner::Mesh *MeshCombiner::combine(const Mesh &firstMesh, const Mesh &secondMesh, Method method,
+quint64 MeshCombiner::Mesh::contentHash() const
+{
+    return m_contentHash;
+}
+
+static bool doesMeshIntersectBox(const CgalMesh &mesh, const CGAL::Bbox_3 &box)
+{
+    for (const auto &face: mesh.faces()) {
+        auto halfedge = mesh.halfedge(face);
+        CgalKernel::Triangle_3 triangle(mesh.point(mesh.source(halfedge)),
+            mesh.point(mesh.target(halfedge)),
+            mesh.point(mesh.target(mesh.next(halfedge))));
+        if (!CGAL::do_overlap(triangle.bbox(), box))
+            continue;
+        if (CGAL::do_intersect(triangle, box))
+            return true;
+    }
+    return false;
+}
+
+static bool isPointOutsideMesh(const CgalMesh &mesh, const CgalKernel::Point_3 &point)
+{
+    CGAL::Side_of_triangle_mesh<CgalMesh, CgalKernel> sideOfMesh(mesh);
+    return CGAL::ON_UNBOUNDED_SIDE == sideOfMesh(point);
+}
+
+// The intersection of the two volumes could only be inside the overlap of the two bounding boxes,
+// if the surface of one mesh doesn't reach the overlap box, the whole overlap box is either inside or outside of that mesh
+static bool areMeshesDisjoint(const CgalMesh &firstMesh, const CgalMesh &secondMesh)
+{
+    auto firstBox = CGAL::Polygon_mesh_processing::bbox(firstMesh);
+    auto secondBox = CGAL::Polygon_mesh_processing::bbox(secondMesh);
+    if (!CGAL::do_overlap(firstBox, secondBox))
+        return true;
+    CGAL::Bbox_3 overlapBox(std::max(firstBox.xmin(), secondBox.xmin()),
+        std::max(firstBox.ymin(), secondBox.ymin()),
+        std::max(firstBox.zmin(), secondBox.zmin()),
+        std::min(firstBox.xmax(), secondBox.xmax()),
+        std::min(firstBox.ymax(), secondBox.ymax()),
+        std::min(firstBox.zmax(), secondBox.zmax()));
+    CgalKernel::Point_3 overlapCenter((overlapBox.xmin() + overlapBox.xmax()) * 0.5,
+        (overlapBox.ymin() + overlapBox.ymax()) * 0.5,
+        (overlapBox.zmin() + overlapBox.zmax()) * 0.5);
+    if (!doesMeshIntersectBox(firstMesh, overlapBox))
+        return isPointOutsideMesh(firstMesh, overlapCenter);
+    if (!doesMeshIntersectBox(secondMesh, overlapBox))
+        return isPointOutsideMesh(secondMesh, overlapCenter);
+    return false;
+}
+
+MeshCombiner::Mesh *MeshCombiner::combine(Mesh &firstMesh, Mesh &secondMesh, Method method,
     std::vector<std::pair<Source, size_t>> *combinedVerticesComeFrom)
 {
 	if (firstMesh.isNull() || !firstMesh.isCombinable() ||
@@ -93,9 +278,43 @@ MeshCombiner::Mesh *MeshCombiner::combine(const Mesh &firstMesh, const Mesh &sec
 		return nullptr;
 	
     CgalMesh *resultCgalMesh = nullptr;
-    CgalMesh *firstCgalMesh = (CgalMesh *)firstMesh.m_privateData;
-    CgalMesh *secondCgalMesh = (CgalMesh *)secondMesh.m_privateData;
-    std::map<PositionKey, std::pair<Source, size_t>> verticesSourceMap;
+    const CgalMesh &firstSharedCgalMesh = firstMesh.m_surfaceMesh->cgalMesh();
+    const CgalMesh &secondSharedCgalMesh = secondMesh.m_surfaceMesh->cgalMesh();
+    
+    TraceSpan span("MeshCombiner::combine");
+    span.addArgument("method", Method::Union == method ? "union" : "diff");
+    span.addArgument("firstVertexCount", (qint64)firstSharedCgalMesh.number_of_vertices());
+    span.addArgument("secondVertexCount", (qint64)secondSharedCgalMesh.number_of_vertices());
+    
+    if (areMeshesDisjoint(firstSharedCgalMesh, secondSharedCgalMesh)) {
+        span.addArgument("disjoint", 1);
+        // Nothing to cut, the union is the two meshes side by side, and the difference leaves the first mesh untouched
+        resultCgalMesh = new CgalMesh(firstSharedCgalMesh);
+        if (Method::Union == method)
+            *resultCgalMesh += secondSharedCgalMesh;
+        if (nullptr != combinedVerticesComeFrom) {
+            combinedVerticesComeFrom->clear();
+            size_t firstVertexCount = firstSharedCgalMesh.number_of_vertices();
+            size_t resultVertexCount = resultCgalMesh->number_of_vertices();
+            for (size_t i = 0; i < resultVertexCount; ++i) {
+                if (i < firstVertexCount)
+                    combinedVerticesComeFrom->push_back({Source::First, i});
+                else
+                    combinedVerticesComeFrom->push_back({Source::Second, i - firstVertexCount});
+            }
+        }
+        Mesh *mesh = new Mesh;
+        mesh->m_surfaceMesh = std::make_shared<SurfaceMesh>(resultCgalMesh);
+        mesh->m_isCombinable = true;
+        mesh->m_contentHash = combinedContentHash(firstMesh.m_contentHash, secondMesh.m_contentHash, method);
+        mesh->validate();
+        return mesh;
+    }
+    
+    // Corefinement refines both of the input meshes, the geometry shared with other meshes must not be touched
+    CgalMesh *firstCgalMesh = &firstMesh.detach()->cgalMesh();
+    CgalMesh *secondCgalMesh = &secondMesh.detach()->cgalMesh();
+    OpenHashMap<PositionKey, std::pair<Source, size_t>> verticesSourceMap;
     
     auto addToSourceMap = [&](CgalMesh *mesh, Source source) {
         size_t vertexIndex = 0;
@@ -112,6 +331,7 @@ MeshCombiner::Mesh *MeshCombiner::combine(const Mesh &firstMesh, const Mesh &sec
         }
     };
     if (nullptr != combinedVerticesComeFrom) {
+        verticesSourceMap.reserve(firstCgalMesh->number_of_vertices() + secondCgalMesh->number_of_vertices());
         addToSourceMap(firstCgalMesh, Source::First);
         addToSourceMap(secondCgalMesh, Source::Second);
     }
@@ -161,27 +381,92 @@ MeshCombiner::Mesh *MeshCombiner::combine(const Mesh &firstMesh, const Mesh &sec
     if (nullptr == resultCgalMesh)
         return nullptr;
     
+    span.addArgument("resultVertexCount", (qint64)resultCgalMesh->number_of_vertices());
+    
     Mesh *mesh = new Mesh;
-    mesh->m_privateData = resultCgalMesh;
-    {
-        std::vector<QVector3D> vertices;
-        std::vector<std::vector<size_t>> faces;
-        fetchFromCgalMesh<CgalKernel>(resultCgalMesh, vertices, faces);
-        mesh->m_isCombinable = isManifold(faces);
-    }
+    mesh->m_surfaceMesh = std::make_shared<SurfaceMesh>(resultCgalMesh);
+    mesh->m_isCombinable = isCgalMeshClosed(*resultCgalMesh);
+    mesh->m_contentHash = combinedContentHash(firstMesh.m_contentHash, secondMesh.m_contentHash, method);
     mesh->validate();
     return mesh;
 }
 
+MeshCombiner::Mesh *MeshCombiner::Mesh::fromVerified(const std::vector<QVector3D> &vertices, const std::vector<std::vector<size_t>> &faces, bool isCombinable)
+{
+    Mesh *mesh = new Mesh(vertices, faces, true);
+    if (!mesh->isNull())
+        mesh->m_isCombinable = isCombinable;
+    return mesh;
+}
+
+MeshCombiner::SurfaceMesh *MeshCombiner::Mesh::detach()
+{
+    if (nullptr == m_surfaceMesh)
+        return nullptr;
+    
+    if (m_surfaceMesh.use_count() > 1)
+        m_surfaceMesh = std::make_shared<SurfaceMesh>(*m_surfaceMesh);
+    // Only this mesh holds the geometry now, which was not created const
+    return const_cast<SurfaceMesh *>(m_surfaceMesh.get());
+}
+
 void MeshCombiner::Mesh::validate()
 {
-    if (nullptr == m_privateData)
+    if (nullptr == m_surfaceMesh)
         return;
     
-    CgalMesh *exactMesh = (CgalMesh *)m_privateData;
-    if (isNullCgalMesh<CgalKernel>(exactMesh)) {
-        delete exactMesh;
-        m_privateData = nullptr;
+    if (isNullCgalMesh<CgalKernel>(&m_surfaceMesh->cgalMesh())) {
+        m_surfaceMesh.reset();
         m_isCombinable = false;
     }
 }
+
+void MeshCombiner::groupOverlappingMeshes(const std::vector<const Mesh *> &meshes,
+    std::vector<std::vector<size_t>> *groups)
+{
+    std::vector<CGAL::Bbox_3> boxes(meshes.size());
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        if (nullptr == meshes[i] || meshes[i]->isNull())
+            continue;
+        boxes[i] = CGAL::Polygon_mesh_processing::bbox(meshes[i]->m_surfaceMesh->cgalMesh());
+    }
+    
+    std::vector<size_t> groupIds(meshes.size());
+    std::iota(groupIds.begin(), groupIds.end(), 0);
+    // Union-find with path halving
+    auto findGroupId = [&](size_t index) {
+        while (groupIds[index] != index) {
+            groupIds[index] = groupIds[groupIds[index]];
+            index = groupIds[index];
+        }
+        return index;
+    };
+    
+    // Sweep and prune along the X axis
+    std::vector<size_t> sortedIndices(meshes.size());
+    std::iota(sortedIndices.begin(), sortedIndices.end(), 0);
+    std::sort(sortedIndices.begin(), sortedIndices.end(), [&](size_t first, size_t second) {
+        return boxes[first].xmin() < boxes[second].xmin();
+    });
+    std::vector<size_t> activeIndices;
+    for (const auto &index: sortedIndices) {
+        const auto &box = boxes[index];
+        activeIndices.erase(std::remove_if(activeIndices.begin(), activeIndices.end(), [&](size_t activeIndex) {
+            return boxes[activeIndex].xmax() < box.xmin();
+        }), activeIndices.end());
+        for (const auto &activeIndex: activeIndices) {
+            if (!CGAL::do_overlap(boxes[activeIndex], box))
+                continue;
+            groupIds[findGroupId(activeIndex)] = findGroupId(index);
+        }
+        activeIndices.push_back(index);
+    }
+    
+    std::map<size_t, size_t> groupIdToGroupIndexMap;
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        auto insertResult = groupIdToGroupIndexMap.insert({findGroupId(i), groups->size()});
+        if (insertResult.second)
+            groups->push_back({});
+        (*groups)[insertResult.first->second].push_back(i);
+    }
+}
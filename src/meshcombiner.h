@@ -2,6 +2,7 @@
 #define DUST3D_COMBINER_H
 #include <QVector3D>
 #include <vector>
+#include <memory>
 
 class MeshCombiner
 {
@@ -18,6 +19,9 @@ public:
         First,
         Second
     };
+    
+    // The CGAL surface mesh behind a mesh, defined in the source so the header stays free of CGAL
+    class SurfaceMesh;
 
     class Mesh
     {
@@ -29,18 +33,30 @@ public:
         void fetch(std::vector<QVector3D> &vertices, std::vector<std::vector<size_t>> &faces) const;
         bool isNull() const;
         bool isCombinable() const;
+        // Identifies the geometry: hashed from the faces of a built mesh, and from the operands of a combined one
+        quint64 contentHash() const;
+        
+        // Rebuilds a mesh which has been checked before, e.g. loaded from the disk cache, so the checks are not repeated
+        static Mesh *fromVerified(const std::vector<QVector3D> &vertices, const std::vector<std::vector<size_t>> &faces, bool isCombinable);
         
         friend MeshCombiner;
         
     private:
-        void *m_privateData = nullptr;
+        // The geometry is immutable once built, so the copies of a mesh share it instead of duplicating
+        std::shared_ptr<const SurfaceMesh> m_surfaceMesh;
         bool m_isCombinable = false;
+        quint64 m_contentHash = 0;
         
+        // Makes the geometry writable by this mesh alone, copying it first if any other mesh shares it
+        SurfaceMesh *detach();
         void validate();
     };
     
-    static Mesh *combine(const Mesh &firstMesh, const Mesh &secondMesh, Method method,
+    // The corefinement refines the operands in place, their shapes stay the same
+    static Mesh *combine(Mesh &firstMesh, Mesh &secondMesh, Method method,
         std::vector<std::pair<Source, size_t>> *combinedVerticesComeFrom=nullptr);
+    static void groupOverlappingMeshes(const std::vector<const Mesh *> &meshes,
+        std::vector<std::vector<size_t>> *groups);
 };
 
 #endif
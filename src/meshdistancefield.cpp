@@ -0,0 +1,292 @@
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+#include "meshdistancefield.h"
+
+MeshDistanceField::MeshDistanceField(const std::vector<QVector3D> &vertices,
+        const std::vector<std::vector<size_t>> &triangles,
+        size_t resolution) :
+    m_vertices(&vertices),
+    m_triangles(&triangles)
+{
+    build(resolution);
+    m_closestPoints.clear();
+    m_closestPoints.shrink_to_fit();
+    m_vertices = nullptr;
+    m_triangles = nullptr;
+}
+
+void MeshDistanceField::build(size_t resolution)
+{
+    if (m_triangles->empty() || m_vertices->empty() || 0 == resolution)
+        return;
+    
+    QVector3D boundMin = (*m_vertices)[0];
+    QVector3D boundMax = boundMin;
+    for (const auto &vertex: *m_vertices) {
+        for (int axis = 0; axis < 3; ++axis) {
+            boundMin[axis] = std::min(boundMin[axis], vertex[axis]);
+            boundMax[axis] = std::max(boundMax[axis], vertex[axis]);
+        }
+    }
+    QVector3D extents = boundMax - boundMin;
+    float longestExtent = std::max(extents.x(), std::max(extents.y(), extents.z()));
+    if (longestExtent <= 0)
+        return;
+    m_cellSize = longestExtent / resolution;
+    
+    // Off by a fraction of a cell, so the samples do not line up with the flat sides of the mesh, which are common,
+    // and the crossing rays do not hit the edges exactly
+    size_t padding = ExactBandWidth + 1;
+    m_origin = boundMin - QVector3D(1.0f, 1.0f, 1.0f) * m_cellSize * (padding + 0.37f);
+    for (int axis = 0; axis < 3; ++axis)
+        m_sampleCounts[axis] = (size_t)std::ceil(extents[axis] / m_cellSize) + padding * 2 + 2;
+    size_t sampleCount = m_sampleCounts[0] * m_sampleCounts[1] * m_sampleCounts[2];
+    m_distances.resize(sampleCount, std::numeric_limits<float>::max());
+    m_closestPoints.resize(sampleCount);
+    
+    computeExactBand();
+    sweep(+1, +1, +1);
+    sweep(-1, -1, -1);
+    sweep(+1, +1, -1);
+    sweep(-1, -1, +1);
+    sweep(+1, -1, +1);
+    sweep(-1, +1, -1);
+    sweep(+1, -1, -1);
+    sweep(-1, +1, +1);
+    computeSigns();
+    computeGradients();
+}
+
+bool MeshDistanceField::isEmpty() const
+{
+    return m_distances.empty();
+}
+
+QVector3D MeshDistanceField::closestPointOnTriangle(size_t triangleIndex, const QVector3D &position) const
+{
+    const auto &triangle = (*m_triangles)[triangleIndex];
+    const QVector3D &a = (*m_vertices)[triangle[0]];
+    const QVector3D &b = (*m_vertices)[triangle[1]];
+    const QVector3D &c = (*m_vertices)[triangle[2]];
+    
+    // By the Voronoi regions of the vertices, the edges and the face
+    QVector3D ab = b - a;
+    QVector3D ac = c - a;
+    QVector3D ap = position - a;
+    float d1 = QVector3D::dotProduct(ab, ap);
+    float d2 = QVector3D::dotProduct(ac, ap);
+    if (d1 <= 0 && d2 <= 0)
+        return a;
+    QVector3D bp = position - b;
+    float d3 = QVector3D::dotProduct(ab, bp);
+    float d4 = QVector3D::dotProduct(ac, bp);
+    if (d3 >= 0 && d4 <= d3)
+        return b;
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0 && d1 >= 0 && d3 <= 0)
+        return a + ab * (d1 / (d1 - d3));
+    QVector3D cp = position - c;
+    float d5 = QVector3D::dotProduct(ab, cp);
+    float d6 = QVector3D::dotProduct(ac, cp);
+    if (d6 >= 0 && d5 <= d6)
+        return c;
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0 && d2 >= 0 && d6 <= 0)
+        return a + ac * (d2 / (d2 - d6));
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+    float denominator = va + vb + vc;
+    if (denominator <= 0)
+        return a;
+    return a + ab * (vb / denominator) + ac * (vc / denominator);
+}
+
+void MeshDistanceField::updateFromTriangle(size_t i, size_t j, size_t k, size_t triangleIndex)
+{
+    size_t index = sampleIndex(i, j, k);
+    QVector3D position = samplePosition(i, j, k);
+    QVector3D closestPoint = closestPointOnTriangle(triangleIndex, position);
+    float distance = (closestPoint - position).length();
+    if (distance < m_distances[index]) {
+        m_distances[index] = distance;
+        m_closestPoints[index] = closestPoint;
+    }
+}
+
+void MeshDistanceField::computeExactBand()
+{
+    for (size_t triangleIndex = 0; triangleIndex < m_triangles->size(); ++triangleIndex) {
+        const auto &triangle = (*m_triangles)[triangleIndex];
+        if (triangle.size() < 3)
+            continue;
+        QVector3D boundMin = (*m_vertices)[triangle[0]];
+        QVector3D boundMax = boundMin;
+        for (size_t corner = 1; corner < 3; ++corner) {
+            const auto &vertex = (*m_vertices)[triangle[corner]];
+            for (int axis = 0; axis < 3; ++axis) {
+                boundMin[axis] = std::min(boundMin[axis], vertex[axis]);
+                boundMax[axis] = std::max(boundMax[axis], vertex[axis]);
+            }
+        }
+        size_t begin[3];
+        size_t end[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            float from = (boundMin[axis] - m_origin[axis]) / m_cellSize - (float)ExactBandWidth;
+            float to = (boundMax[axis] - m_origin[axis]) / m_cellSize + (float)ExactBandWidth;
+            begin[axis] = (size_t)std::max(0.0f, std::ceil(from));
+            end[axis] = std::min(m_sampleCounts[axis], (size_t)std::max(0.0f, std::floor(to)) + 1);
+        }
+        for (size_t k = begin[2]; k < end[2]; ++k) {
+            for (size_t j = begin[1]; j < end[1]; ++j) {
+                for (size_t i = begin[0]; i < end[0]; ++i)
+                    updateFromTriangle(i, j, k, triangleIndex);
+            }
+        }
+    }
+}
+
+// Beyond the exact band, each sample tries the closest surface points of its neighbors behind it in the sweeping direction,
+// which is approximate but only a subtraction per neighbor
+void MeshDistanceField::sweep(int di, int dj, int dk)
+{
+    int i0 = di > 0 ? 1 : (int)m_sampleCounts[0] - 2;
+    int i1 = di > 0 ? (int)m_sampleCounts[0] : -1;
+    int j0 = dj > 0 ? 1 : (int)m_sampleCounts[1] - 2;
+    int j1 = dj > 0 ? (int)m_sampleCounts[1] : -1;
+    int k0 = dk > 0 ? 1 : (int)m_sampleCounts[2] - 2;
+    int k1 = dk > 0 ? (int)m_sampleCounts[2] : -1;
+    for (int k = k0; k != k1; k += dk) {
+        for (int j = j0; j != j1; j += dj) {
+            for (int i = i0; i != i1; i += di) {
+                size_t index = sampleIndex(i, j, k);
+                QVector3D position = samplePosition(i, j, k);
+                const size_t neighborIndices[3] = {
+                    sampleIndex(i - di, j, k),
+                    sampleIndex(i, j - dj, k),
+                    sampleIndex(i, j, k - dk)
+                };
+                for (const auto &neighborIndex: neighborIndices) {
+                    if (std::numeric_limits<float>::max() == m_distances[neighborIndex])
+                        continue;
+                    const QVector3D &closestPoint = m_closestPoints[neighborIndex];
+                    float distance = (closestPoint - position).length();
+                    if (distance < m_distances[index]) {
+                        m_distances[index] = distance;
+                        m_closestPoints[index] = closestPoint;
+                    }
+                }
+            }
+        }
+    }
+}
+
+static double orientation2D(double x1, double y1, double x2, double y2)
+{
+    return x1 * y2 - y1 * x2;
+}
+
+// The samples of a row along the x axis beyond odd crossings are inside
+void MeshDistanceField::computeSigns()
+{
+    std::vector<uint32_t> crossingCounts(m_distances.size(), 0);
+    for (const auto &triangle: *m_triangles) {
+        if (triangle.size() < 3)
+            continue;
+        const QVector3D &a = (*m_vertices)[triangle[0]];
+        const QVector3D &b = (*m_vertices)[triangle[1]];
+        const QVector3D &c = (*m_vertices)[triangle[2]];
+        double minY = std::min(a.y(), std::min(b.y(), c.y()));
+        double maxY = std::max(a.y(), std::max(b.y(), c.y()));
+        double minZ = std::min(a.z(), std::min(b.z(), c.z()));
+        double maxZ = std::max(a.z(), std::max(b.z(), c.z()));
+        size_t jBegin = (size_t)std::max(0.0, std::ceil((minY - m_origin.y()) / m_cellSize));
+        size_t jEnd = std::min(m_sampleCounts[1], (size_t)std::max(0.0, std::floor((maxY - m_origin.y()) / m_cellSize)) + 1);
+        size_t kBegin = (size_t)std::max(0.0, std::ceil((minZ - m_origin.z()) / m_cellSize));
+        size_t kEnd = std::min(m_sampleCounts[2], (size_t)std::max(0.0, std::floor((maxZ - m_origin.z()) / m_cellSize)) + 1);
+        for (size_t k = kBegin; k < kEnd; ++k) {
+            for (size_t j = jBegin; j < jEnd; ++j) {
+                double y = m_origin.y() + (double)j * m_cellSize;
+                double z = m_origin.z() + (double)k * m_cellSize;
+                double ay = a.y() - y, az = a.z() - z;
+                double by = b.y() - y, bz = b.z() - z;
+                double cy = c.y() - y, cz = c.z() - z;
+                double alpha = orientation2D(by, bz, cy, cz);
+                double beta = orientation2D(cy, cz, ay, az);
+                double gamma = orientation2D(ay, az, by, bz);
+                if (!((alpha > 0 && beta > 0 && gamma > 0) || (alpha < 0 && beta < 0 && gamma < 0)))
+                    continue;
+                double sum = alpha + beta + gamma;
+                double x = (alpha * a.x() + beta * b.x() + gamma * c.x()) / sum;
+                double crossing = std::ceil((x - m_origin.x()) / m_cellSize);
+                if (crossing < 0)
+                    crossing = 0;
+                if (crossing >= (double)m_sampleCounts[0])
+                    continue;
+                ++crossingCounts[sampleIndex((size_t)crossing, j, k)];
+            }
+        }
+    }
+    for (size_t k = 0; k < m_sampleCounts[2]; ++k) {
+        for (size_t j = 0; j < m_sampleCounts[1]; ++j) {
+            uint32_t crossingCount = 0;
+            for (size_t i = 0; i < m_sampleCounts[0]; ++i) {
+                size_t index = sampleIndex(i, j, k);
+                crossingCount += crossingCounts[index];
+                if (crossingCount % 2 == 1)
+                    m_distances[index] = -m_distances[index];
+            }
+        }
+    }
+}
+
+void MeshDistanceField::computeGradients()
+{
+    m_gradients.resize(m_distances.size());
+    for (size_t k = 0; k < m_sampleCounts[2]; ++k) {
+        for (size_t j = 0; j < m_sampleCounts[1]; ++j) {
+            for (size_t i = 0; i < m_sampleCounts[0]; ++i) {
+                size_t index = sampleIndex(i, j, k);
+                float length = std::abs(m_distances[index]);
+                if (length <= std::numeric_limits<float>::epsilon() || std::numeric_limits<float>::max() == length)
+                    continue;
+                QVector3D away = samplePosition(i, j, k) - m_closestPoints[index];
+                m_gradients[index] = away * ((m_distances[index] < 0 ? -1.0f : 1.0f) / away.length());
+            }
+        }
+    }
+}
+
+bool MeshDistanceField::sample(const QVector3D &position, float *distance, QVector3D *gradient) const
+{
+    if (m_distances.empty())
+        return false;
+    float coordinates[3];
+    size_t cells[3];
+    float fractions[3];
+    for (int axis = 0; axis < 3; ++axis) {
+        coordinates[axis] = (position[axis] - m_origin[axis]) / m_cellSize;
+        if (coordinates[axis] < 0 || coordinates[axis] >= (float)(m_sampleCounts[axis] - 1))
+            return false;
+        cells[axis] = (size_t)coordinates[axis];
+        fractions[axis] = coordinates[axis] - cells[axis];
+    }
+    float interpolatedDistance = 0;
+    QVector3D interpolatedGradient;
+    for (int corner = 0; corner < 8; ++corner) {
+        size_t i = cells[0] + (corner & 1);
+        size_t j = cells[1] + ((corner >> 1) & 1);
+        size_t k = cells[2] + ((corner >> 2) & 1);
+        float weight = ((corner & 1) ? fractions[0] : 1 - fractions[0]) *
+            (((corner >> 1) & 1) ? fractions[1] : 1 - fractions[1]) *
+            (((corner >> 2) & 1) ? fractions[2] : 1 - fractions[2]);
+        size_t index = sampleIndex(i, j, k);
+        interpolatedDistance += m_distances[index] * weight;
+        interpolatedGradient += m_gradients[index] * weight;
+    }
+    *distance = interpolatedDistance;
+    *gradient = interpolatedGradient;
+    return true;
+}
@@ -0,0 +1,52 @@
+#ifndef DUST3D_MESH_DISTANCE_FIELD_H
+#define DUST3D_MESH_DISTANCE_FIELD_H
+#include <QVector3D>
+#include <vector>
+
+// The signed distance to a closed triangle mesh, sampled once on a grid around the mesh, negative inside,
+// along with the gradient, which points away from the surface, so a point inside is pushed out in constant time.
+// The samples near the triangles are exact, the others take the distance to the closest surface point found by their neighbors,
+// the sign comes from the parity of the crossings along the x axis.
+
+class MeshDistanceField
+{
+public:
+    static const size_t DefaultResolution = 64;
+    static const size_t ExactBandWidth = 2;
+
+    MeshDistanceField(const std::vector<QVector3D> &vertices,
+        const std::vector<std::vector<size_t>> &triangles,
+        size_t resolution=DefaultResolution);
+    bool isEmpty() const;
+    // Trilinearly interpolated; returns false out of the grid, where every position is far outside the mesh
+    bool sample(const QVector3D &position, float *distance, QVector3D *gradient) const;
+
+private:
+    // Only referred while building
+    const std::vector<QVector3D> *m_vertices = nullptr;
+    const std::vector<std::vector<size_t>> *m_triangles = nullptr;
+    std::vector<QVector3D> m_closestPoints;
+    QVector3D m_origin;
+    float m_cellSize = 0;
+    size_t m_sampleCounts[3] = {0, 0, 0};
+    std::vector<float> m_distances;
+    std::vector<QVector3D> m_gradients;
+
+    size_t sampleIndex(size_t i, size_t j, size_t k) const
+    {
+        return (k * m_sampleCounts[1] + j) * m_sampleCounts[0] + i;
+    }
+    QVector3D samplePosition(size_t i, size_t j, size_t k) const
+    {
+        return m_origin + QVector3D(i, j, k) * m_cellSize;
+    }
+    void build(size_t resolution);
+    QVector3D closestPointOnTriangle(size_t triangleIndex, const QVector3D &position) const;
+    void updateFromTriangle(size_t i, size_t j, size_t k, size_t triangleIndex);
+    void computeExactBand();
+    void sweep(int di, int dj, int dk);
+    void computeSigns();
+    void computeGradients();
+};
+
+#endif
@@ -1,8 +1,14 @@
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#include <tbb/task_arena.h>
 #include <QDebug>
 #include <QElapsedTimer>
+#include <QThread>
 #include <QVector2D>
 #include <QGuiApplication>
 #include <QMatrix4x4>
+#include <QDataStream>
+#include <QCryptographicHash>
 #include "strokemeshbuilder.h"
 #include "strokemodifier.h"
 #include "meshrecombiner.h"
@@ -27,6 +33,377 @@
 #include "snapshotxml.h"
 #include "fixholes.h"
 #include "modeloffscreenrender.h"
+#include "version.h"
+#include "tracer.h"
+
+// Bumped whenever the generator produces a different result from the same input,
+// so the entries written by the disk cache before are not reused
+static const quint32 g_diskCacheGeneratorVersion = 1;
+
+// The generated objects of the fill meshes, shared by all the parts and generations of the process,
+// keyed by the file id and the hash of the file content and the generation settings.
+// Only the latest content of a file is kept, the entry of a changed file is replaced,
+// and the least recently used files are dropped beyond the count
+struct FillMeshCacheEntry
+{
+    QMutex mutex;
+    bool generated = false;
+    bool successful = false;
+    std::unique_ptr<Object> object;
+    quint64 lastUsed = 0;
+};
+static std::map<QUuid, std::pair<QByteArray, std::shared_ptr<FillMeshCacheEntry>>> g_fillMeshCache;
+static quint64 g_fillMeshCacheUseCount = 0;
+static const size_t g_maxFillMeshCacheCount = 16;
+static QMutex g_fillMeshCacheMutex;
+
+class ComponentChildMeshesCombiner
+{
+public:
+    ComponentChildMeshesCombiner(MeshGenerator *meshGenerator,
+            const std::vector<QString> *componentIdStrings,
+            std::vector<std::pair<MeshCombiner::Mesh *, CombineMode>> *childMeshes) :
+        m_meshGenerator(meshGenerator),
+        m_componentIdStrings(componentIdStrings),
+        m_childMeshes(childMeshes)
+    {
+    }
+    void operator()(const tbb::blocked_range<size_t> &range) const
+    {
+        for (size_t i = range.begin(); i != range.end(); ++i) {
+            auto &childMesh = (*m_childMeshes)[i];
+            childMesh.first = m_meshGenerator->combineComponentMesh((*m_componentIdStrings)[i], &childMesh.second);
+        }
+    }
+private:
+    MeshGenerator *m_meshGenerator = nullptr;
+    const std::vector<QString> *m_componentIdStrings = nullptr;
+    std::vector<std::pair<MeshCombiner::Mesh *, CombineMode>> *m_childMeshes = nullptr;
+};
+
+class MeshPairsCombiner
+{
+public:
+    MeshPairsCombiner(MeshGenerator *meshGenerator,
+            const QString *componentIdString,
+            const std::vector<std::pair<MeshCombiner::Mesh *, CombinationKey>> *meshes,
+            bool recombine,
+            std::vector<std::pair<MeshCombiner::Mesh *, CombinationKey>> *combinedMeshes) :
+        m_meshGenerator(meshGenerator),
+        m_componentIdString(componentIdString),
+        m_meshes(meshes),
+        m_recombine(recombine),
+        m_combinedMeshes(combinedMeshes)
+    {
+    }
+    void operator()(const tbb::blocked_range<size_t> &range) const
+    {
+        for (size_t i = range.begin(); i != range.end(); ++i) {
+            (*m_combinedMeshes)[i] = m_meshGenerator->combineTwoMeshesWithCache(*m_componentIdString,
+                (*m_meshes)[i * 2],
+                (*m_meshes)[i * 2 + 1],
+                MeshCombiner::Method::Union,
+                m_recombine);
+        }
+    }
+private:
+    MeshGenerator *m_meshGenerator = nullptr;
+    const QString *m_componentIdString = nullptr;
+    const std::vector<std::pair<MeshCombiner::Mesh *, CombinationKey>> *m_meshes = nullptr;
+    bool m_recombine = true;
+    std::vector<std::pair<MeshCombiner::Mesh *, CombinationKey>> *m_combinedMeshes = nullptr;
+};
+
+class PartMeshesPreparer
+{
+public:
+    PartMeshesPreparer(MeshGenerator *meshGenerator,
+            const std::vector<size_t> *partIndices) :
+        m_meshGenerator(meshGenerator),
+        m_partIndices(partIndices)
+    {
+    }
+    void operator()(const tbb::blocked_range<size_t> &range) const
+    {
+        for (size_t i = range.begin(); i != range.end(); ++i) {
+            m_meshGenerator->preparePartMesh((*m_partIndices)[i]);
+        }
+    }
+private:
+    MeshGenerator *m_meshGenerator = nullptr;
+    const std::vector<size_t> *m_partIndices = nullptr;
+};
+
+CombinationKey::CombinationKey(const QString &componentIdString, quint64 meshContentHash) :
+    contentHash(meshContentHash)
+{
+    QByteArray bytes = componentIdString.toUtf8();
+    hash = crc64(0, (const unsigned char *)bytes.constData(), bytes.size());
+}
+
+CombinationKey CombinationKey::group(const std::vector<CombinationKey> &keys, const MeshCombiner::Mesh &mesh)
+{
+    CombinationKey key;
+    key.contentHash = mesh.contentHash();
+    if (1 == keys.size()) {
+        key.hash = keys.front().hash;
+        return key;
+    }
+    const unsigned char groupTag = 'G';
+    key.hash = crc64(0, &groupTag, sizeof(groupTag));
+    for (const auto &it: keys)
+        key.hash = crc64(key.hash, (const unsigned char *)&it.hash, sizeof(it.hash));
+    return key;
+}
+
+CombinationKey CombinationKey::combine(const CombinationKey &first, const CombinationKey &second,
+    MeshCombiner::Method method, bool recombine)
+{
+    CombinationKey key;
+    quint64 values[] = {
+        first.hash,
+        second.hash,
+        (quint64)method,
+        (quint64)recombine
+    };
+    key.hash = crc64(0, (const unsigned char *)values, sizeof(values));
+    values[0] = first.contentHash;
+    values[1] = second.contentHash;
+    key.contentHash = crc64(0, (const unsigned char *)values, sizeof(values));
+    return key;
+}
+
+static void writeVertices(QDataStream &stream, const std::vector<QVector3D> &vertices)
+{
+    stream << (quint32)vertices.size();
+    for (const auto &it: vertices)
+        stream << it;
+}
+
+static void readVertices(QDataStream &stream, std::vector<QVector3D> *vertices)
+{
+    quint32 vertexCount = 0;
+    stream >> vertexCount;
+    vertices->clear();
+    for (quint32 i = 0; i < vertexCount && QDataStream::Ok == stream.status(); ++i) {
+        QVector3D vertex;
+        stream >> vertex;
+        vertices->push_back(vertex);
+    }
+}
+
+static void writeFaces(QDataStream &stream, const std::vector<std::vector<size_t>> &faces)
+{
+    stream << (quint32)faces.size();
+    for (const auto &face: faces) {
+        stream << (quint32)face.size();
+        for (const auto &index: face)
+            stream << (quint32)index;
+    }
+}
+
+static void readFaces(QDataStream &stream, size_t vertexCount, std::vector<std::vector<size_t>> *faces)
+{
+    quint32 faceCount = 0;
+    stream >> faceCount;
+    faces->clear();
+    for (quint32 i = 0; i < faceCount && QDataStream::Ok == stream.status(); ++i) {
+        quint32 indexCount = 0;
+        stream >> indexCount;
+        std::vector<size_t> face;
+        for (quint32 j = 0; j < indexCount && QDataStream::Ok == stream.status(); ++j) {
+            quint32 index = 0;
+            stream >> index;
+            if (index >= vertexCount) {
+                stream.setStatus(QDataStream::ReadCorruptData);
+                break;
+            }
+            face.push_back(index);
+        }
+        faces->push_back(face);
+    }
+}
+
+static void writeMesh(QDataStream &stream, const MeshCombiner::Mesh *mesh)
+{
+    stream << (nullptr != mesh);
+    if (nullptr == mesh)
+        return;
+    std::vector<QVector3D> vertices;
+    std::vector<std::vector<size_t>> faces;
+    mesh->fetch(vertices, faces);
+    writeVertices(stream, vertices);
+    writeFaces(stream, faces);
+    stream << mesh->isCombinable();
+}
+
+static MeshCombiner::Mesh *readMesh(QDataStream &stream)
+{
+    bool hasMesh = false;
+    stream >> hasMesh;
+    if (!hasMesh)
+        return nullptr;
+    std::vector<QVector3D> vertices;
+    std::vector<std::vector<size_t>> faces;
+    bool isCombinable = false;
+    readVertices(stream, &vertices);
+    readFaces(stream, vertices.size(), &faces);
+    stream >> isCombinable;
+    if (QDataStream::Ok != stream.status())
+        return nullptr;
+    return MeshCombiner::Mesh::fromVerified(vertices, faces, isCombinable);
+}
+
+static void writeObjectNodes(QDataStream &stream, const std::vector<ObjectNode> &objectNodes)
+{
+    stream << (quint32)objectNodes.size();
+    for (const auto &it: objectNodes) {
+        stream << it.partId << it.nodeId << it.origin << it.radius << it.color
+            << it.colorSolubility << it.metalness << it.roughness << it.materialId << it.countershaded
+            << it.mirrorFromPartId << it.mirroredByPartId << (quint32)it.boneMark << it.direction
+            << (quint32)it.layer << it.joined;
+    }
+}
+
+static void readObjectNodes(QDataStream &stream, std::vector<ObjectNode> *objectNodes)
+{
+    quint32 nodeCount = 0;
+    stream >> nodeCount;
+    objectNodes->clear();
+    for (quint32 i = 0; i < nodeCount && QDataStream::Ok == stream.status(); ++i) {
+        ObjectNode objectNode;
+        quint32 boneMark = 0;
+        quint32 layer = 0;
+        stream >> objectNode.partId >> objectNode.nodeId >> objectNode.origin >> objectNode.radius >> objectNode.color
+            >> objectNode.colorSolubility >> objectNode.metalness >> objectNode.roughness >> objectNode.materialId >> objectNode.countershaded
+            >> objectNode.mirrorFromPartId >> objectNode.mirroredByPartId >> boneMark >> objectNode.direction
+            >> layer >> objectNode.joined;
+        objectNode.boneMark = (BoneMark)boneMark;
+        objectNode.layer = (ComponentLayer)layer;
+        objectNodes->push_back(objectNode);
+    }
+}
+
+static void writeObjectEdges(QDataStream &stream, const std::vector<std::pair<std::pair<QUuid, QUuid>, std::pair<QUuid, QUuid>>> &objectEdges)
+{
+    stream << (quint32)objectEdges.size();
+    for (const auto &it: objectEdges)
+        stream << it.first.first << it.first.second << it.second.first << it.second.second;
+}
+
+static void readObjectEdges(QDataStream &stream, std::vector<std::pair<std::pair<QUuid, QUuid>, std::pair<QUuid, QUuid>>> *objectEdges)
+{
+    quint32 edgeCount = 0;
+    stream >> edgeCount;
+    objectEdges->clear();
+    for (quint32 i = 0; i < edgeCount && QDataStream::Ok == stream.status(); ++i) {
+        std::pair<std::pair<QUuid, QUuid>, std::pair<QUuid, QUuid>> edge;
+        stream >> edge.first.first >> edge.first.second >> edge.second.first >> edge.second.second;
+        objectEdges->push_back(edge);
+    }
+}
+
+static void writeObjectNodeVertices(QDataStream &stream, const std::vector<std::pair<QVector3D, std::pair<QUuid, QUuid>>> &objectNodeVertices)
+{
+    stream << (quint32)objectNodeVertices.size();
+    for (const auto &it: objectNodeVertices)
+        stream << it.first << it.second.first << it.second.second;
+}
+
+static void readObjectNodeVertices(QDataStream &stream, std::vector<std::pair<QVector3D, std::pair<QUuid, QUuid>>> *objectNodeVertices)
+{
+    quint32 vertexCount = 0;
+    stream >> vertexCount;
+    objectNodeVertices->clear();
+    for (quint32 i = 0; i < vertexCount && QDataStream::Ok == stream.status(); ++i) {
+        std::pair<QVector3D, std::pair<QUuid, QUuid>> nodeVertex;
+        stream >> nodeVertex.first >> nodeVertex.second.first >> nodeVertex.second.second;
+        objectNodeVertices->push_back(nodeVertex);
+    }
+}
+
+static void writeGeneratedPart(QDataStream &stream, const GeneratedPart &partCache)
+{
+    writeVertices(stream, partCache.vertices);
+    writeFaces(stream, partCache.faces);
+    writeMesh(stream, partCache.mesh);
+    writeObjectNodes(stream, partCache.objectNodes);
+    writeObjectEdges(stream, partCache.objectEdges);
+    writeObjectNodeVertices(stream, partCache.objectNodeVertices);
+    writeVertices(stream, partCache.previewVertices);
+    writeFaces(stream, partCache.previewTriangles);
+    stream << partCache.isSuccessful << partCache.joined;
+}
+
+static bool readGeneratedPart(QDataStream &stream, GeneratedPart *partCache)
+{
+    readVertices(stream, &partCache->vertices);
+    readFaces(stream, partCache->vertices.size(), &partCache->faces);
+    partCache->mesh = readMesh(stream);
+    readObjectNodes(stream, &partCache->objectNodes);
+    readObjectEdges(stream, &partCache->objectEdges);
+    readObjectNodeVertices(stream, &partCache->objectNodeVertices);
+    readVertices(stream, &partCache->previewVertices);
+    readFaces(stream, partCache->previewVertices.size(), &partCache->previewTriangles);
+    stream >> partCache->isSuccessful >> partCache->joined;
+    return QDataStream::Ok == stream.status();
+}
+
+static void writeGeneratedComponent(QDataStream &stream, const GeneratedComponent &componentCache)
+{
+    writeMesh(stream, componentCache.mesh);
+    stream << (quint32)componentCache.incombinableMeshes.size();
+    for (const auto &it: componentCache.incombinableMeshes)
+        writeMesh(stream, it);
+    stream << (quint32)componentCache.sharedQuadEdges.size();
+    for (const auto &it: componentCache.sharedQuadEdges)
+        stream << it.first.position() << it.second.position();
+    stream << (quint32)componentCache.noneSeamVertices.size();
+    for (const auto &it: componentCache.noneSeamVertices)
+        stream << it.position();
+    writeObjectNodes(stream, componentCache.objectNodes);
+    writeObjectEdges(stream, componentCache.objectEdges);
+    writeObjectNodeVertices(stream, componentCache.objectNodeVertices);
+}
+
+static bool readGeneratedComponent(QDataStream &stream, GeneratedComponent *componentCache)
+{
+    componentCache->mesh = readMesh(stream);
+    quint32 incombinableMeshCount = 0;
+    stream >> incombinableMeshCount;
+    for (quint32 i = 0; i < incombinableMeshCount && QDataStream::Ok == stream.status(); ++i) {
+        MeshCombiner::Mesh *mesh = readMesh(stream);
+        if (nullptr != mesh)
+            componentCache->incombinableMeshes.push_back(mesh);
+    }
+    quint32 sharedQuadEdgeCount = 0;
+    stream >> sharedQuadEdgeCount;
+    for (quint32 i = 0; i < sharedQuadEdgeCount && QDataStream::Ok == stream.status(); ++i) {
+        QVector3D first;
+        QVector3D second;
+        stream >> first >> second;
+        componentCache->sharedQuadEdges.insert({PositionKey(first), PositionKey(second)});
+    }
+    quint32 noneSeamVertexCount = 0;
+    stream >> noneSeamVertexCount;
+    for (quint32 i = 0; i < noneSeamVertexCount && QDataStream::Ok == stream.status(); ++i) {
+        QVector3D position;
+        stream >> position;
+        componentCache->noneSeamVertices.insert(PositionKey(position));
+    }
+    readObjectNodes(stream, &componentCache->objectNodes);
+    readObjectEdges(stream, &componentCache->objectEdges);
+    readObjectNodeVertices(stream, &componentCache->objectNodeVertices);
+    return QDataStream::Ok == stream.status();
+}
+
+static QString joinComponentIds(const std::set<QString> &componentIds)
+{
+    QStringList componentIdList;
+    for (const auto &it: componentIds)
+        componentIdList.append(it);
+    return componentIdList.join(",");
+}
 
 MeshGenerator::MeshGenerator(Snapshot *snapshot) :
     m_snapshot(snapshot)
@@ -42,6 +419,7 @@ MeshGenerator::~MeshGenerator()
     delete m_object;
     delete m_cutFaceTransforms;
     delete m_nodesCutFaces;
+    releasePreparedPartMeshes();
 }
 
 void MeshGenerator::setId(quint64 id)
@@ -59,6 +437,16 @@ bool MeshGenerator::isSuccessful()
     return m_isSuccessful;
 }
 
+void MeshGenerator::cancel()
+{
+    m_isCancelled = true;
+}
+
+bool MeshGenerator::isCancelled()
+{
+    return m_isCancelled;
+}
+
 Model *MeshGenerator::takeResultMesh()
 {
     Model *resultMesh = m_resultMesh;
@@ -99,302 +487,129 @@ std::map<QUuid, std::map<QString, QVector2D>> *MeshGenerator::takeNodesCutFaces(
     return nodesCutFaces;
 }
 
-void MeshGenerator::collectParts()
+bool MeshGenerator::checkIsPartDirty(size_t partIndex)
 {
-    for (const auto &node: m_snapshot->nodes) {
-        QString partId = valueOfKeyInMapOrEmpty(node.second, "partId");
-        if (partId.isEmpty())
-            continue;
-        m_partNodeIds[partId].insert(node.first);
-    }
-    for (const auto &edge: m_snapshot->edges) {
-        QString partId = valueOfKeyInMapOrEmpty(edge.second, "partId");
-        if (partId.isEmpty())
-            continue;
-        m_partEdgeIds[partId].insert(edge.first);
-    }
+    return m_compiledSnapshot.parts[partIndex].dirty;
 }
 
-bool MeshGenerator::checkIsPartDirty(const QString &partIdString)
+bool MeshGenerator::checkIsPartDependencyDirty(size_t partIndex)
 {
-    auto findPart = m_snapshot->parts.find(partIdString);
-    if (findPart == m_snapshot->parts.end()) {
-        qDebug() << "Find part failed:" << partIdString;
-        return false;
-    }
-    return isTrueValueString(valueOfKeyInMapOrEmpty(findPart->second, "__dirty"));
-}
-
-bool MeshGenerator::checkIsPartDependencyDirty(const QString &partIdString)
-{
-    auto findPart = m_snapshot->parts.find(partIdString);
-    if (findPart == m_snapshot->parts.end()) {
-        qDebug() << "Find part failed:" << partIdString;
-        return false;
-    }
-    QString cutFaceString = valueOfKeyInMapOrEmpty(findPart->second, "cutFace");
-    QUuid cutFaceLinkedPartId = QUuid(cutFaceString);
-    if (!cutFaceLinkedPartId.isNull()) {
-        if (checkIsPartDirty(cutFaceString))
-            return true;
-    }
-    for (const auto &nodeIdString: m_partNodeIds[partIdString]) {
-        auto findNode = m_snapshot->nodes.find(nodeIdString);
-        if (findNode == m_snapshot->nodes.end()) {
-            qDebug() << "Find node failed:" << nodeIdString;
-            continue;
-        }
-        QString cutFaceString = valueOfKeyInMapOrEmpty(findNode->second, "cutFace");
+    const auto &part = m_compiledSnapshot.parts[partIndex];
+    auto isCutFaceLinkedPartDirty = [&](const QString &cutFaceString) {
         QUuid cutFaceLinkedPartId = QUuid(cutFaceString);
-        if (!cutFaceLinkedPartId.isNull()) {
-            if (checkIsPartDirty(cutFaceString))
-                return true;
+        if (cutFaceLinkedPartId.isNull())
+            return false;
+        size_t cutFaceLinkedPartIndex = m_compiledSnapshot.findPart(cutFaceString);
+        if (CompiledSnapshot::InvalidIndex == cutFaceLinkedPartIndex) {
+            qDebug() << "Find part failed:" << cutFaceString;
+            return false;
         }
+        return checkIsPartDirty(cutFaceLinkedPartIndex);
+    };
+    if (isCutFaceLinkedPartDirty(part.cutFace))
+        return true;
+    for (const auto &nodeIndex: part.nodeIndices) {
+        if (isCutFaceLinkedPartDirty(m_compiledSnapshot.nodes[nodeIndex].cutFace))
+            return true;
     }
     return false;
 }
 
-bool MeshGenerator::checkIsComponentDirty(const QString &componentIdString)
+bool MeshGenerator::checkIsComponentDirty(size_t componentIndex)
 {
     bool isDirty = false;
     
-    const std::map<QString, QString> *component = &m_snapshot->rootComponent;
-    if (componentIdString != QUuid().toString()) {
-        auto findComponent = m_snapshot->components.find(componentIdString);
-        if (findComponent == m_snapshot->components.end()) {
-            qDebug() << "Component not found:" << componentIdString;
-            return isDirty;
-        }
-        component = &findComponent->second;
-    }
+    const auto &component = m_compiledSnapshot.components[componentIndex];
     
-    if (isTrueValueString(valueOfKeyInMapOrEmpty(*component, "__dirty"))) {
+    if (component.dirty) {
         isDirty = true;
     }
     
-    QString linkDataType = valueOfKeyInMapOrEmpty(*component, "linkDataType");
-    if ("partId" == linkDataType) {
-        QString partId = valueOfKeyInMapOrEmpty(*component, "linkData");
-        if (checkIsPartDirty(partId)) {
-            m_dirtyPartIds.insert(partId);
-            isDirty = true;
-        }
-        if (!isDirty) {
-            if (checkIsPartDependencyDirty(partId)) {
+    if (component.linkToPart) {
+        if (CompiledSnapshot::InvalidIndex == component.linkPartIndex) {
+            qDebug() << "Find part failed:" << component.linkPartIdString;
+        } else {
+            if (checkIsPartDirty(component.linkPartIndex)) {
+                m_dirtyPartIds.insert(component.linkPartIdString);
                 isDirty = true;
             }
+            if (!isDirty) {
+                if (checkIsPartDependencyDirty(component.linkPartIndex)) {
+                    isDirty = true;
+                }
+            }
         }
     }
     
-    for (const auto &childId: valueOfKeyInMapOrEmpty(*component, "children").split(",")) {
-        if (childId.isEmpty())
-            continue;
-        if (checkIsComponentDirty(childId)) {
+    for (const auto &childIndex: component.childIndices) {
+        if (checkIsComponentDirty(childIndex)) {
             isDirty = true;
         }
     }
     
     if (isDirty)
-        m_dirtyComponentIds.insert(componentIdString);
+        m_dirtyComponentIds.insert(component.idString);
     
     return isDirty;
 }
 
 void MeshGenerator::checkDirtyFlags()
 {
-    checkIsComponentDirty(QUuid().toString());
-}
-
-void MeshGenerator::cutFaceStringToCutTemplate(const QString &cutFaceString, std::vector<QVector2D> &cutTemplate)
-{
-    //std::map<QString, QVector2D> cutTemplateMapByName;
-    QUuid cutFaceLinkedPartId = QUuid(cutFaceString);
-    if (!cutFaceLinkedPartId.isNull()) {
-        std::map<QString, std::tuple<float, float, float>> cutFaceNodeMap;
-        auto findCutFaceLinkedPart = m_snapshot->parts.find(cutFaceString);
-        if (findCutFaceLinkedPart == m_snapshot->parts.end()) {
-            qDebug() << "Find cut face linked part failed:" << cutFaceString;
-        } else {
-            // Build node info map
-            for (const auto &nodeIdString: m_partNodeIds[cutFaceString]) {
-                auto findNode = m_snapshot->nodes.find(nodeIdString);
-                if (findNode == m_snapshot->nodes.end()) {
-                    qDebug() << "Find node failed:" << nodeIdString;
-                    continue;
-                }
-                auto &node = findNode->second;
-                float radius = valueOfKeyInMapOrEmpty(node, "radius").toFloat();
-                float x = (valueOfKeyInMapOrEmpty(node, "x").toFloat() - m_mainProfileMiddleX);
-                float y = (m_mainProfileMiddleY - valueOfKeyInMapOrEmpty(node, "y").toFloat());
-                cutFaceNodeMap.insert({nodeIdString, std::make_tuple(radius, x, y)});
-            }
-            // Build edge link
-            std::map<QString, std::vector<QString>> cutFaceNodeLinkMap;
-            for (const auto &edgeIdString: m_partEdgeIds[cutFaceString]) {
-                auto findEdge = m_snapshot->edges.find(edgeIdString);
-                if (findEdge == m_snapshot->edges.end()) {
-                    qDebug() << "Find edge failed:" << edgeIdString;
-                    continue;
-                }
-                auto &edge = findEdge->second;
-                QString fromNodeIdString = valueOfKeyInMapOrEmpty(edge, "from");
-                QString toNodeIdString = valueOfKeyInMapOrEmpty(edge, "to");
-                cutFaceNodeLinkMap[fromNodeIdString].push_back(toNodeIdString);
-                cutFaceNodeLinkMap[toNodeIdString].push_back(fromNodeIdString);
-            }
-            // Find endpoint
-            QString endPointNodeIdString;
-            std::vector<std::pair<QString, std::tuple<float, float, float>>> endpointNodes;
-            for (const auto &it: cutFaceNodeLinkMap) {
-                if (1 == it.second.size()) {
-                    const auto &findNode = cutFaceNodeMap.find(it.first);
-                    if (findNode != cutFaceNodeMap.end())
-                        endpointNodes.push_back({it.first, findNode->second});
-                }
-            }
-            bool isRing = endpointNodes.empty();
-            if (endpointNodes.empty()) {
-                for (const auto &it: cutFaceNodeMap) {
-                    endpointNodes.push_back({it.first, it.second});
-                }
-            }
-            if (!endpointNodes.empty()) {
-                // Calculate the center points
-                QVector2D sumOfPositions;
-                for (const auto &it: endpointNodes) {
-                    sumOfPositions += QVector2D(std::get<1>(it.second), std::get<2>(it.second));
-                }
-                QVector2D center = sumOfPositions / endpointNodes.size();
-                
-                // Calculate all the directions emit from center to the endpoint,
-                // choose the minimal angle, angle: (0, 0 -> -1, -1) to the direction
-                const QVector3D referenceDirection = QVector3D(-1, -1, 0).normalized();
-                int choosenEndpoint = -1;
-                float choosenRadian = 0;
-                for (int i = 0; i < (int)endpointNodes.size(); ++i) {
-                    const auto &it = endpointNodes[i];
-                    QVector2D direction2d = (QVector2D(std::get<1>(it.second), std::get<2>(it.second)) -
-                        center);
-                    QVector3D direction = QVector3D(direction2d.x(), direction2d.y(), 0).normalized();
-                    float radian = radianBetweenVectors(referenceDirection, direction);
-                    if (-1 == choosenEndpoint || radian < choosenRadian) {
-                        choosenRadian = radian;
-                        choosenEndpoint = i;
-                    }
-                }
-                endPointNodeIdString = endpointNodes[choosenEndpoint].first;
-            }
-            // Loop all linked nodes
-            std::vector<std::tuple<float, float, float, QString>> cutFaceNodes;
-            std::set<QString> cutFaceVisitedNodeIds;
-            std::function<void (const QString &)> loopNodeLink;
-            loopNodeLink = [&](const QString &fromNodeIdString) {
-                auto findCutFaceNode = cutFaceNodeMap.find(fromNodeIdString);
-                if (findCutFaceNode == cutFaceNodeMap.end())
-                    return;
-                if (cutFaceVisitedNodeIds.find(fromNodeIdString) != cutFaceVisitedNodeIds.end())
-                    return;
-                cutFaceVisitedNodeIds.insert(fromNodeIdString);
-                cutFaceNodes.push_back(std::make_tuple(std::get<0>(findCutFaceNode->second),
-                    std::get<1>(findCutFaceNode->second),
-                    std::get<2>(findCutFaceNode->second),
-                    fromNodeIdString));
-                auto findNeighbor = cutFaceNodeLinkMap.find(fromNodeIdString);
-                if (findNeighbor == cutFaceNodeLinkMap.end())
-                    return;
-                for (const auto &it: findNeighbor->second) {
-                    if (cutFaceVisitedNodeIds.find(it) == cutFaceVisitedNodeIds.end()) {
-                        loopNodeLink(it);
-                        break;
-                    }
-                }
-            };
-            if (!endPointNodeIdString.isEmpty()) {
-                loopNodeLink(endPointNodeIdString);
-            }
-            // Fetch points from linked nodes
-            std::vector<QString> cutTemplateNames;
-            cutFacePointsFromNodes(cutTemplate, cutFaceNodes, isRing, &cutTemplateNames);
-            //for (size_t i = 0; i < cutTemplateNames.size(); ++i) {
-            //    cutTemplateMapByName.insert({cutTemplateNames[i], cutTemplate[i]});
-            //}
-        }
-    }
-    if (cutTemplate.size() < 3) {
-        CutFace cutFace = CutFaceFromString(cutFaceString.toUtf8().constData());
-        cutTemplate = CutFaceToPoints(cutFace);
-        //cutTemplateMapByName.clear();
-        //for (size_t i = 0; i < cutTemplate.size(); ++i) {
-        //    cutTemplateMapByName.insert({cutFaceString + "/" + QString::number(i + 1), cutTemplate[i]});
-        //}
-    }
+    checkIsComponentDirty(0);
 }
 
 MeshCombiner::Mesh *MeshGenerator::combinePartMesh(const QString &partIdString, bool *hasError, bool *retryable, bool addIntermediateNodes)
 {
-    auto findPart = m_snapshot->parts.find(partIdString);
-    if (findPart == m_snapshot->parts.end()) {
+    if (isCancelled())
+        return nullptr;
+    
+    TraceSpan span("combinePartMesh");
+    span.addArgument("partId", partIdString);
+    span.addArgument("addIntermediateNodes", addIntermediateNodes);
+    
+    size_t partIndex = m_compiledSnapshot.findPart(partIdString);
+    if (CompiledSnapshot::InvalidIndex == partIndex) {
         qDebug() << "Find part failed:" << partIdString;
         return nullptr;
     }
     
     QUuid partId = QUuid(partIdString);
-    auto &part = findPart->second;
+    const auto &part = m_compiledSnapshot.parts[partIndex];
     
     *retryable = true;
     
-    bool isDisabled = isTrueValueString(valueOfKeyInMapOrEmpty(part, "disabled"));
-    //bool xMirrored = isTrueValueString(valueOfKeyInMapOrEmpty(part, "xMirrored"));
-    //bool _xFlip = isTrueValueString(valueOfKeyInMapOrEmpty(part, "_xFlip"));
-    QString __mirroredByPartId = valueOfKeyInMapOrEmpty(part, "__mirroredByPartId");
-    QString __mirrorFromPartId = valueOfKeyInMapOrEmpty(part, "__mirrorFromPartId");
-    bool subdived = isTrueValueString(valueOfKeyInMapOrEmpty(part, "subdived"));
-    bool rounded = isTrueValueString(valueOfKeyInMapOrEmpty(part, "rounded"));
-    bool chamfered = isTrueValueString(valueOfKeyInMapOrEmpty(part, "chamfered"));
-    bool countershaded = isTrueValueString(valueOfKeyInMapOrEmpty(part, "countershaded"));
-    bool smooth = isTrueValueString(valueOfKeyInMapOrEmpty(part, "smooth"));
-    QString colorString = valueOfKeyInMapOrEmpty(part, "color");
-    QColor partColor = colorString.isEmpty() ? m_defaultPartColor : QColor(colorString);
-    float deformThickness = 1.0;
-    float deformWidth = 1.0;
-    float cutRotation = 0.0;
-    float hollowThickness = 0.0;
-    auto target = PartTargetFromString(valueOfKeyInMapOrEmpty(part, "target").toUtf8().constData());
-    auto base = PartBaseFromString(valueOfKeyInMapOrEmpty(part, "base").toUtf8().constData());
-    
-    QString searchPartIdString = __mirrorFromPartId.isEmpty() ? partIdString : __mirrorFromPartId;
-
-    QString cutFaceString = valueOfKeyInMapOrEmpty(part, "cutFace");
-    std::vector<QVector2D> cutTemplate;
-    cutFaceStringToCutTemplate(cutFaceString, cutTemplate);
+    bool isDisabled = part.disabled;
+    const QString &__mirroredByPartId = part.mirroredByPartIdString;
+    const QString &__mirrorFromPartId = part.mirrorFromPartIdString;
+    bool subdived = part.subdived;
+    bool rounded = part.rounded;
+    bool chamfered = part.chamfered;
+    bool countershaded = part.countershaded;
+    bool smooth = part.smooth;
+    QColor partColor = part.colorString.isEmpty() ? m_defaultPartColor : QColor(part.colorString);
+    float deformThickness = part.deformThickness;
+    float deformWidth = part.deformWidth;
+    float cutRotation = part.cutRotation;
+    float hollowThickness = part.hollowThickness;
+    auto target = part.target;
+    auto base = part.base;
+    
+    size_t searchPartIndex = __mirrorFromPartId.isEmpty() ? partIndex : part.mirrorFromPartIndex;
+    if (CompiledSnapshot::InvalidIndex == searchPartIndex) {
+        qDebug() << "Find part failed:" << __mirrorFromPartId;
+        return nullptr;
+    }
+    const auto &searchPart = m_compiledSnapshot.parts[searchPartIndex];
+
+    std::vector<QVector2D> cutTemplate = m_compiledSnapshot.cutTemplates[part.cutTemplateIndex];
     if (chamfered)
         chamferFace2D(&cutTemplate);
     
-    QString cutRotationString = valueOfKeyInMapOrEmpty(part, "cutRotation");
-    if (!cutRotationString.isEmpty()) {
-        cutRotation = cutRotationString.toFloat();
-    }
-    
-    QString hollowThicknessString = valueOfKeyInMapOrEmpty(part, "hollowThickness");
-    if (!hollowThicknessString.isEmpty()) {
-        hollowThickness = hollowThicknessString.toFloat();
-    }
-    
-    QString thicknessString = valueOfKeyInMapOrEmpty(part, "deformThickness");
-    if (!thicknessString.isEmpty()) {
-        deformThickness = thicknessString.toFloat();
-    }
-    
-    QString widthString = valueOfKeyInMapOrEmpty(part, "deformWidth");
-    if (!widthString.isEmpty()) {
-        deformWidth = widthString.toFloat();
-    }
-    
-    bool deformUnified = isTrueValueString(valueOfKeyInMapOrEmpty(part, "deformUnified"));
+    bool deformUnified = part.deformUnified;
     
     QImage deformImageStruct;
     const QImage *deformImage = nullptr;
-    QString deformMapImageIdString = valueOfKeyInMapOrEmpty(part, "deformMapImageId");
+    const QString &deformMapImageIdString = part.deformMapImageIdString;
     if (!deformMapImageIdString.isEmpty()) {
         ImageForever::copy(QUuid(deformMapImageIdString), deformImageStruct);
         if (!deformImageStruct.isNull())
@@ -404,42 +619,18 @@ MeshCombiner::Mesh *MeshGenerator::combinePartMesh(const QString &partIdString,
         }
     }
     
-    float deformMapScale = 1.0;
-    QString deformMapScaleString = valueOfKeyInMapOrEmpty(part, "deformMapScale");
-    if (!deformMapScaleString.isEmpty())
-        deformMapScale = deformMapScaleString.toFloat();
-    
-    QUuid materialId;
-    QString materialIdString = valueOfKeyInMapOrEmpty(part, "materialId");
-    if (!materialIdString.isEmpty())
-        materialId = QUuid(materialIdString);
+    float deformMapScale = part.deformMapScale;
+    QUuid materialId = part.materialId;
+    float colorSolubility = part.colorSolubility;
+    float metalness = part.metalness;
+    float roughness = part.roughness;
     
-    float colorSolubility = 0;
-    QString colorSolubilityString = valueOfKeyInMapOrEmpty(part, "colorSolubility");
-    if (!colorSolubilityString.isEmpty())
-        colorSolubility = colorSolubilityString.toFloat();
-    
-    float metalness = 0;
-    QString metalnessString = valueOfKeyInMapOrEmpty(part, "metallic");
-    if (!metalnessString.isEmpty())
-        metalness = metalnessString.toFloat();
-    
-    float roughness = 1.0;
-    QString roughnessString = valueOfKeyInMapOrEmpty(part, "roughness");
-    if (!roughnessString.isEmpty())
-        roughness = roughnessString.toFloat();
-    
-    QUuid fillMeshFileId;
-    QString fillMeshString = valueOfKeyInMapOrEmpty(part, "fillMesh");
-    if (!fillMeshString.isEmpty()) {
-        fillMeshFileId = QUuid(fillMeshString);
-        if (!fillMeshFileId.isNull()) {
-            *retryable = false;
-            //xMirrored = false;
-        }
+    QUuid fillMeshFileId = part.fillMeshFileId;
+    if (!fillMeshFileId.isNull()) {
+        *retryable = false;
     }
     
-    auto &partCache = m_cacheContext->parts[partIdString];
+    auto &partCache = m_cacheContext->partCache(partIdString);
     partCache.objectNodes.clear();
     partCache.objectEdges.clear();
     partCache.objectNodeVertices.clear();
@@ -458,77 +649,45 @@ MeshCombiner::Mesh *MeshGenerator::combinePartMesh(const QString &partIdString,
         BoneMark boneMark = BoneMark::None;
         bool hasCutFaceSettings = false;
         float cutRotation = 0.0;
-        QString cutFace;
+        size_t cutTemplateIndex = CompiledSnapshot::InvalidIndex;
     };
-    std::map<QString, NodeInfo> nodeInfos;
-    for (const auto &nodeIdString: m_partNodeIds[searchPartIdString]) {
-        auto findNode = m_snapshot->nodes.find(nodeIdString);
-        if (findNode == m_snapshot->nodes.end()) {
-            qDebug() << "Find node failed:" << nodeIdString;
-            continue;
-        }
-        auto &node = findNode->second;
+    std::map<size_t, NodeInfo> nodeInfos;
+    for (const auto &nodeIndex: searchPart.nodeIndices) {
+        const auto &node = m_compiledSnapshot.nodes[nodeIndex];
         
-        float radius = valueOfKeyInMapOrEmpty(node, "radius").toFloat();
-        float x = (valueOfKeyInMapOrEmpty(node, "x").toFloat() - m_mainProfileMiddleX);
-        float y = (m_mainProfileMiddleY - valueOfKeyInMapOrEmpty(node, "y").toFloat());
-        float z = (m_sideProfileMiddleX - valueOfKeyInMapOrEmpty(node, "z").toFloat());
-
-        BoneMark boneMark = BoneMarkFromString(valueOfKeyInMapOrEmpty(node, "boneMark").toUtf8().constData());
-        
-        bool hasCutFaceSettings = false;
-        float cutRotation = 0.0;
-        QString cutFace;
-        
-        const auto &cutFaceIt = node.find("cutFace");
-        if (cutFaceIt != node.end()) {
-            cutFace = cutFaceIt->second;
-            hasCutFaceSettings = true;
-            const auto &cutRotationIt = node.find("cutRotation");
-            if (cutRotationIt != node.end()) {
-                cutRotation = cutRotationIt->second.toFloat();
-            }
-        }
+        float x = (node.x - m_mainProfileMiddleX);
+        float y = (m_mainProfileMiddleY - node.y);
+        float z = (m_sideProfileMiddleX - node.z);
         
-        auto &nodeInfo = nodeInfos[nodeIdString];
+        auto &nodeInfo = nodeInfos[nodeIndex];
         nodeInfo.position = QVector3D(x, y, z);
-        nodeInfo.radius = radius;
-        nodeInfo.boneMark = boneMark;
-        nodeInfo.hasCutFaceSettings = hasCutFaceSettings;
-        nodeInfo.cutRotation = cutRotation;
-        nodeInfo.cutFace = cutFace;
-    }
-    
-    std::set<std::pair<QString, QString>> edges;
-    for (const auto &edgeIdString: m_partEdgeIds[searchPartIdString]) {
-        auto findEdge = m_snapshot->edges.find(edgeIdString);
-        if (findEdge == m_snapshot->edges.end()) {
-            qDebug() << "Find edge failed:" << edgeIdString;
-            continue;
-        }
-        auto &edge = findEdge->second;
-        
-        QString fromNodeIdString = valueOfKeyInMapOrEmpty(edge, "from");
-        QString toNodeIdString = valueOfKeyInMapOrEmpty(edge, "to");
+        nodeInfo.radius = node.radius;
+        nodeInfo.boneMark = node.boneMark;
+        nodeInfo.hasCutFaceSettings = node.hasCutFaceSettings;
+        nodeInfo.cutRotation = node.cutRotation;
+        nodeInfo.cutTemplateIndex = node.cutTemplateIndex;
+    }
+    
+    std::set<std::pair<size_t, size_t>> edges;
+    for (const auto &edgeIndex: searchPart.edgeIndices) {
+        const auto &edge = m_compiledSnapshot.edges[edgeIndex];
         
-        const auto &findFromNodeInfo = nodeInfos.find(fromNodeIdString);
-        if (findFromNodeInfo == nodeInfos.end()) {
-            qDebug() << "Find from-node info failed:" << fromNodeIdString;
+        if (nodeInfos.find(edge.fromNodeIndex) == nodeInfos.end()) {
+            qDebug() << "Find from-node info failed:" << m_compiledSnapshot.nodes[edge.fromNodeIndex].idString;
             continue;
         }
         
-        const auto &findToNodeInfo = nodeInfos.find(toNodeIdString);
-        if (findToNodeInfo == nodeInfos.end()) {
-            qDebug() << "Find to-node info failed:" << toNodeIdString;
+        if (nodeInfos.find(edge.toNodeIndex) == nodeInfos.end()) {
+            qDebug() << "Find to-node info failed:" << m_compiledSnapshot.nodes[edge.toNodeIndex].idString;
             continue;
         }
         
-        edges.insert({fromNodeIdString, toNodeIdString});
+        edges.insert({edge.fromNodeIndex, edge.toNodeIndex});
     }
     
     bool buildSucceed = false;
-    std::map<QString, int> nodeIdStringToIndexMap;
-    std::map<int, QString> nodeIndexToIdStringMap;
+    std::map<size_t, size_t> compiledNodeIndexToStrokeNodeIndexMap;
+    std::map<size_t, size_t> strokeNodeIndexToCompiledNodeIndexMap;
     StrokeModifier *strokeModifier = nullptr;
     
     //QString mirroredPartIdString;
@@ -539,10 +698,10 @@ MeshCombiner::Mesh *MeshGenerator::combinePartMesh(const QString &partIdString,
     //    m_cacheContext->partMirrorIdMap[mirroredPartIdString] = partIdString;
     //}
     
-    auto addNodeToPartCache = [&](const QString &nodeIdString, const NodeInfo &nodeInfo) {
+    auto addNodeToPartCache = [&](size_t compiledNodeIndex, const NodeInfo &nodeInfo) {
         ObjectNode objectNode;
-        objectNode.partId = QUuid(partIdString);
-        objectNode.nodeId = QUuid(nodeIdString);
+        objectNode.partId = partId;
+        objectNode.nodeId = m_compiledSnapshot.nodes[compiledNodeIndex].id;
         objectNode.origin = nodeInfo.position;
         objectNode.radius = nodeInfo.radius;
         objectNode.color = partColor;
@@ -568,10 +727,10 @@ MeshCombiner::Mesh *MeshGenerator::combinePartMesh(const QString &partIdString,
         //    partCache.objectNodes.push_back(objectNode);
         //}
     };
-    auto addEdgeToPartCache = [&](const QString &firstNodeIdString, const QString &secondNodeIdString) {
+    auto addEdgeToPartCache = [&](size_t firstCompiledNodeIndex, size_t secondCompiledNodeIndex) {
         partCache.objectEdges.push_back({
-            {QUuid(partIdString), QUuid(firstNodeIdString)},
-            {QUuid(partIdString), QUuid(secondNodeIdString)}
+            {partId, m_compiledSnapshot.nodes[firstCompiledNodeIndex].id},
+            {partId, m_compiledSnapshot.nodes[secondCompiledNodeIndex].id}
         });
         //if (xMirrored) {
         //    partCache.objectEdges.push_back({
@@ -589,35 +748,31 @@ MeshCombiner::Mesh *MeshGenerator::combinePartMesh(const QString &partIdString,
         strokeModifier->enableIntermediateAddition();
     
     for (const auto &nodeIt: nodeInfos) {
-        const auto &nodeIdString = nodeIt.first;
+        const auto &compiledNodeIndex = nodeIt.first;
         const auto &nodeInfo = nodeIt.second;
         size_t nodeIndex = 0;
         if (nodeInfo.hasCutFaceSettings) {
-            std::vector<QVector2D> nodeCutTemplate;
-            cutFaceStringToCutTemplate(nodeInfo.cutFace, nodeCutTemplate);
+            std::vector<QVector2D> nodeCutTemplate = m_compiledSnapshot.cutTemplates[nodeInfo.cutTemplateIndex];
             if (chamfered)
                 chamferFace2D(&nodeCutTemplate);
             nodeIndex = strokeModifier->addNode(nodeInfo.position, nodeInfo.radius, nodeCutTemplate, nodeInfo.cutRotation);
         } else {
             nodeIndex = strokeModifier->addNode(nodeInfo.position, nodeInfo.radius, cutTemplate, cutRotation);
         }
-        nodeIdStringToIndexMap[nodeIdString] = nodeIndex;
-        nodeIndexToIdStringMap[nodeIndex] = nodeIdString;
+        compiledNodeIndexToStrokeNodeIndexMap[compiledNodeIndex] = nodeIndex;
+        strokeNodeIndexToCompiledNodeIndexMap[nodeIndex] = compiledNodeIndex;
     }
     
     for (const auto &edgeIt: edges) {
-        const QString &fromNodeIdString = edgeIt.first;
-        const QString &toNodeIdString = edgeIt.second;
-        
-        auto findFromNodeIndex = nodeIdStringToIndexMap.find(fromNodeIdString);
-        if (findFromNodeIndex == nodeIdStringToIndexMap.end()) {
-            qDebug() << "Find from-node failed:" << fromNodeIdString;
+        auto findFromNodeIndex = compiledNodeIndexToStrokeNodeIndexMap.find(edgeIt.first);
+        if (findFromNodeIndex == compiledNodeIndexToStrokeNodeIndexMap.end()) {
+            qDebug() << "Find from-node failed:" << m_compiledSnapshot.nodes[edgeIt.first].idString;
             continue;
         }
         
-        auto findToNodeIndex = nodeIdStringToIndexMap.find(toNodeIdString);
-        if (findToNodeIndex == nodeIdStringToIndexMap.end()) {
-            qDebug() << "Find to-node failed:" << toNodeIdString;
+        auto findToNodeIndex = compiledNodeIndexToStrokeNodeIndexMap.find(edgeIt.second);
+        if (findToNodeIndex == compiledNodeIndexToStrokeNodeIndexMap.end()) {
+            qDebug() << "Find to-node failed:" << m_compiledSnapshot.nodes[edgeIt.second].idString;
             continue;
         }
         
@@ -661,19 +816,19 @@ MeshCombiner::Mesh *MeshGenerator::combinePartMesh(const QString &partIdString,
         strokeMeshBuilder->addEdge(edge.firstNodeIndex, edge.secondNodeIndex);
     
     if (fillMeshFileId.isNull()) {
-        for (const auto &nodeIt: nodeInfos) {
-            const auto &nodeIdString = nodeIt.first;
-            const auto &nodeInfo = nodeIt.second;
-            addNodeToPartCache(nodeIdString, nodeInfo);
-        }
+        for (const auto &nodeIt: nodeInfos)
+            addNodeToPartCache(nodeIt.first, nodeIt.second);
         
-        for (const auto &edgeIt: edges) {
-            const QString &fromNodeIdString = edgeIt.first;
-            const QString &toNodeIdString = edgeIt.second;
-            addEdgeToPartCache(fromNodeIdString, toNodeIdString);
-        }
+        for (const auto &edgeIt: edges)
+            addEdgeToPartCache(edgeIt.first, edgeIt.second);
 
-        buildSucceed = strokeMeshBuilder->build();
+        {
+            TraceSpan buildSpan("StrokeMeshBuilder::build");
+            buildSpan.addArgument("partId", partIdString);
+            buildSpan.addArgument("nodeCount", (qint64)strokeModifier->nodes().size());
+            buildSucceed = strokeMeshBuilder->build();
+            buildSpan.addArgument("vertexCount", (qint64)strokeMeshBuilder->generatedVertices().size());
+        }
         
         partCache.vertices = strokeMeshBuilder->generatedVertices();
         partCache.faces = strokeMeshBuilder->generatedFaces();
@@ -688,8 +843,11 @@ MeshCombiner::Mesh *MeshGenerator::combinePartMesh(const QString &partIdString,
             const auto &position = partCache.vertices[i];
             const auto &source = strokeMeshBuilder->generatedVerticesSourceNodeIndices()[i];
             size_t nodeIndex = strokeModifier->nodes()[source].originNodeIndex;
-            const auto &nodeIdString = nodeIndexToIdStringMap[nodeIndex];
-            partCache.objectNodeVertices.push_back({position, {partIdString, nodeIdString}});
+            QUuid nodeId;
+            auto findCompiledNodeIndex = strokeNodeIndexToCompiledNodeIndexMap.find(nodeIndex);
+            if (findCompiledNodeIndex != strokeNodeIndexToCompiledNodeIndexMap.end())
+                nodeId = m_compiledSnapshot.nodes[findCompiledNodeIndex->second].id;
+            partCache.objectNodeVertices.push_back({position, {partId, nodeId}});
         }
     } else {
         if (strokeMeshBuilder->buildBaseNormalsOnly()) {
@@ -721,26 +879,402 @@ MeshCombiner::Mesh *MeshGenerator::combinePartMesh(const QString &partIdString,
         qDebug() << "Mesh build failed";
     }
     
-    delete m_partPreviewMeshes[partId];
-    m_partPreviewMeshes[partId] = nullptr;
-    m_generatedPreviewPartIds.insert(partId);
-    
-    std::vector<QVector3D> partPreviewVertices;
-    QColor partPreviewColor = partColor;
     if (nullptr != mesh) {
         partCache.mesh = new MeshCombiner::Mesh(*mesh);
-        mesh->fetch(partPreviewVertices, partCache.previewTriangles);
-        partCache.previewVertices = partPreviewVertices;
+        mesh->fetch(partCache.previewVertices, partCache.previewTriangles);
         partCache.isSuccessful = true;
     }
     if (partCache.previewTriangles.empty()) {
-        partPreviewVertices = partCache.vertices;
-        triangulateFacesWithoutKeepVertices(partPreviewVertices, partCache.faces, partCache.previewTriangles);
-        partCache.previewVertices = partPreviewVertices;
-        partPreviewColor = Qt::red;
+        partCache.previewVertices = partCache.vertices;
+        triangulateFacesWithoutKeepVertices(partCache.previewVertices, partCache.faces, partCache.previewTriangles);
         partCache.isSuccessful = false;
     }
     
+    makePartPreviewMesh(partId, partCache, partColor, metalness, roughness, target);
+    
+    span.addArgument("vertexCount", (qint64)partCache.vertices.size());
+    span.addArgument("faceCount", (qint64)partCache.faces.size());
+    
+    delete strokeModifier;
+    
+    if (mesh && mesh->isNull()) {
+        delete mesh;
+        mesh = nullptr;
+    }
+    
+    if (isDisabled) {
+        delete mesh;
+        mesh = nullptr;
+    }
+    
+    if (target != PartTarget::Model) {
+        delete mesh;
+        mesh = nullptr;
+    }
+    
+    if (hasMeshError && target == PartTarget::Model) {
+        *hasError = true;
+    }
+    
+    return mesh;
+}
+
+MeshCombiner::Mesh *MeshGenerator::combinePartMeshWithRetry(const QString &partIdString, bool *hasError)
+{
+    bool retryable = true;
+    bool addIntermediateNodes = !m_coarseTierEnabled;
+    MeshCombiner::Mesh *mesh = combinePartMesh(partIdString, hasError, &retryable, addIntermediateNodes);
+    if (*hasError) {
+        delete mesh;
+        mesh = nullptr;
+        if (retryable && addIntermediateNodes) {
+            *hasError = false;
+            qDebug() << "Try combine part again without adding intermediate nodes";
+            mesh = combinePartMesh(partIdString, hasError, &retryable, false);
+        }
+    }
+    return mesh;
+}
+
+// Follows the cache checks of combineComponentMesh, so only the parts the component walk is going to rebuild are collected
+void MeshGenerator::collectPartsToPrepare(size_t componentIndex, std::set<size_t> *visitedPartIndices, std::vector<size_t> *partIndices)
+{
+    const auto &component = m_compiledSnapshot.components[componentIndex];
+    
+    if (m_cacheEnabled && m_dirtyComponentIds.find(component.idString) == m_dirtyComponentIds.end()) {
+        if (nullptr != m_cacheContext->componentCache(component.idString).mesh)
+            return;
+    }
+    
+    if (nullptr != m_diskCache) {
+        auto findContentHash = m_componentContentHashes.find(component.idString);
+        if (findContentHash != m_componentContentHashes.end() && m_diskCache->contains(findContentHash->second))
+            return;
+    }
+    
+    if (component.linkToPart) {
+        if (CompiledSnapshot::InvalidIndex != component.linkPartIndex &&
+                visitedPartIndices->insert(component.linkPartIndex).second) {
+            partIndices->push_back(component.linkPartIndex);
+        }
+        return;
+    }
+    
+    for (const auto &childIndex: component.childIndices)
+        collectPartsToPrepare(childIndex, visitedPartIndices, partIndices);
+}
+
+// The stroke meshes of the parts are independent of each other, they are all built concurrently before the component walk,
+// which then only runs the boolean operations
+void MeshGenerator::preparePartMeshes()
+{
+    releasePreparedPartMeshes();
+    m_preparedPartMeshes.resize(m_compiledSnapshot.parts.size());
+    
+    std::set<size_t> visitedPartIndices;
+    std::vector<size_t> partIndices;
+    collectPartsToPrepare(0, &visitedPartIndices, &partIndices);
+    
+    // The mirrored parts are reflected from the meshes of their sources, so they wait for the sources to be built
+    std::vector<size_t> sourcePartIndices;
+    std::vector<size_t> mirroredPartIndices;
+    for (const auto &partIndex: partIndices) {
+        const auto &part = m_compiledSnapshot.parts[partIndex];
+        if (!part.mirrorFromPartIdString.isEmpty() &&
+                visitedPartIndices.find(part.mirrorFromPartIndex) != visitedPartIndices.end()) {
+            mirroredPartIndices.push_back(partIndex);
+        } else {
+            sourcePartIndices.push_back(partIndex);
+        }
+    }
+    
+    TraceSpan span("preparePartMeshes");
+    span.addArgument("partCount", (qint64)sourcePartIndices.size());
+    span.addArgument("mirroredPartCount", (qint64)mirroredPartIndices.size());
+    
+    // The fill meshes are generated here, one after another, so the concurrent parts never wait for each other on them
+    std::set<QUuid> fillMeshFileIds;
+    for (const auto &partIndex: partIndices) {
+        const auto &part = m_compiledSnapshot.parts[partIndex];
+        if (!part.disabled && !part.fillMeshFileId.isNull() && fillMeshFileIds.insert(part.fillMeshFileId).second)
+            generateFillMesh(part.fillMeshFileId);
+    }
+    
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, sourcePartIndices.size()),
+        PartMeshesPreparer(this, &sourcePartIndices));
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, mirroredPartIndices.size()),
+        PartMeshesPreparer(this, &mirroredPartIndices));
+}
+
+void MeshGenerator::preparePartMesh(size_t partIndex)
+{
+    const auto &part = m_compiledSnapshot.parts[partIndex];
+    auto &preparedPartMesh = m_preparedPartMeshes[partIndex];
+    if (!part.mirrorFromPartIdString.isEmpty() && part.fillMeshFileId.isNull()) {
+        const auto &sourcePreparedPartMesh = m_preparedPartMeshes[part.mirrorFromPartIndex];
+        if (sourcePreparedPartMesh.isPrepared) {
+            const auto &sourcePartCache = m_cacheContext->partCache(part.mirrorFromPartIdString);
+            if (sourcePartCache.isSuccessful) {
+                preparedPartMesh.mesh = reflectPartMesh(partIndex, sourcePartCache);
+                preparedPartMesh.hasError = false;
+                preparedPartMesh.isPrepared = true;
+                return;
+            }
+        }
+    }
+    preparedPartMesh.mesh = combinePartMeshWithRetry(part.idString, &preparedPartMesh.hasError);
+    preparedPartMesh.isPrepared = true;
+}
+
+// Builds the part cache of a mirrored part from the one of its source, instead of building the strokes,
+// validating the mesh and triangulating the preview again; the result is what combinePartMesh produces for the mirrored part
+MeshCombiner::Mesh *MeshGenerator::reflectPartMesh(size_t partIndex, const GeneratedPart &sourcePartCache)
+{
+    const auto &part = m_compiledSnapshot.parts[partIndex];
+    
+    TraceSpan span("reflectPartMesh");
+    span.addArgument("partId", part.idString);
+    span.addArgument("sourcePartId", part.mirrorFromPartIdString);
+    
+    QUuid partId = part.id;
+    QUuid sourcePartId = QUuid(part.mirrorFromPartIdString);
+    QUuid mirroredByPartId = part.mirroredByPartIdString.isEmpty() ? QUuid() : QUuid(part.mirroredByPartIdString);
+    QColor partColor = part.colorString.isEmpty() ? m_defaultPartColor : QColor(part.colorString);
+    
+    auto &partCache = m_cacheContext->partCache(part.idString);
+    partCache.objectNodes.clear();
+    partCache.objectEdges.clear();
+    partCache.objectNodeVertices.clear();
+    partCache.vertices.clear();
+    partCache.faces.clear();
+    partCache.previewTriangles.clear();
+    partCache.previewVertices.clear();
+    partCache.joined = (part.target == PartTarget::Model && !part.disabled);
+    partCache.releaseMeshes();
+    
+    partCache.objectNodes.reserve(sourcePartCache.objectNodes.size());
+    for (const auto &sourceNode: sourcePartCache.objectNodes) {
+        ObjectNode objectNode = sourceNode;
+        objectNode.partId = partId;
+        objectNode.mirrorFromPartId = sourcePartId;
+        objectNode.mirroredByPartId = mirroredByPartId;
+        objectNode.origin.setX(-sourceNode.origin.x());
+        objectNode.joined = partCache.joined;
+        partCache.objectNodes.push_back(objectNode);
+    }
+    partCache.objectEdges.reserve(sourcePartCache.objectEdges.size());
+    for (const auto &sourceEdge: sourcePartCache.objectEdges) {
+        partCache.objectEdges.push_back({
+            {partId, sourceEdge.first.second},
+            {partId, sourceEdge.second.second}
+        });
+    }
+    
+    makeXmirror(sourcePartCache.vertices, sourcePartCache.faces, &partCache.vertices, &partCache.faces);
+    partCache.objectNodeVertices.reserve(sourcePartCache.objectNodeVertices.size());
+    for (const auto &sourceNodeVertex: sourcePartCache.objectNodeVertices) {
+        const auto &position = sourceNodeVertex.first;
+        partCache.objectNodeVertices.push_back({QVector3D(-position.x(), position.y(), position.z()),
+            {partId, sourceNodeVertex.second.second}});
+    }
+    makeXmirror(sourcePartCache.previewVertices, sourcePartCache.previewTriangles,
+        &partCache.previewVertices, &partCache.previewTriangles);
+    
+    // The preview triangles are the ones of the checked source mesh, and the reflection keeps them
+    // manifold and free of self intersections, so they take the verdict of the source mesh
+    bool isCombinable = nullptr != sourcePartCache.mesh && sourcePartCache.mesh->isCombinable();
+    MeshCombiner::Mesh *mesh = MeshCombiner::Mesh::fromVerified(partCache.previewVertices, partCache.previewTriangles,
+        isCombinable);
+    if (mesh->isNull()) {
+        delete mesh;
+        mesh = nullptr;
+    } else {
+        partCache.mesh = new MeshCombiner::Mesh(*mesh);
+    }
+    partCache.isSuccessful = true;
+    
+    makePartPreviewMesh(partId, partCache, partColor, part.metalness, part.roughness, part.target);
+    
+    span.addArgument("vertexCount", (qint64)partCache.vertices.size());
+    
+    if (part.disabled || part.target != PartTarget::Model) {
+        delete mesh;
+        mesh = nullptr;
+    }
+    
+    return mesh;
+}
+
+MeshCombiner::Mesh *MeshGenerator::takePreparedPartMesh(size_t partIndex, bool *hasError)
+{
+    auto &preparedPartMesh = m_preparedPartMeshes[partIndex];
+    MeshCombiner::Mesh *mesh = preparedPartMesh.mesh;
+    *hasError = preparedPartMesh.hasError;
+    preparedPartMesh.mesh = nullptr;
+    preparedPartMesh.isPrepared = false;
+    return mesh;
+}
+
+// The coarse tier halves the cut faces until they are under eight points,
+// the parts keep their outlines with a fraction of the faces to combine
+void MeshGenerator::coarsenCutTemplates()
+{
+    for (auto &cutTemplate: m_compiledSnapshot.cutTemplates) {
+        while (cutTemplate.size() >= 8) {
+            std::vector<QVector2D> halvedCutTemplate;
+            halvedCutTemplate.reserve((cutTemplate.size() + 1) / 2);
+            for (size_t i = 0; i < cutTemplate.size(); i += 2)
+                halvedCutTemplate.push_back(cutTemplate[i]);
+            cutTemplate.swap(halvedCutTemplate);
+        }
+    }
+}
+
+void MeshGenerator::releasePreparedPartMeshes()
+{
+    for (auto &it: m_preparedPartMeshes)
+        delete it.mesh;
+    m_preparedPartMeshes.clear();
+}
+
+// The nodes of a part are the spheres, and the edges the round cones between them,
+// the cut faces and the deformations are not taken into account
+void MeshGenerator::addPartToSdf(SdfMeshBuilder *sdfMeshBuilder, size_t group, size_t partIndex,
+    std::vector<std::pair<QUuid, QUuid>> *nodeSources)
+{
+    const auto &part = m_compiledSnapshot.parts[partIndex];
+    if (part.disabled || PartTarget::Model != part.target)
+        return;
+    
+    bool isMirrored = !part.mirrorFromPartIdString.isEmpty();
+    size_t searchPartIndex = isMirrored ? part.mirrorFromPartIndex : partIndex;
+    if (CompiledSnapshot::InvalidIndex == searchPartIndex) {
+        qDebug() << "Find part failed:" << part.mirrorFromPartIdString;
+        return;
+    }
+    const auto &searchPart = m_compiledSnapshot.parts[searchPartIndex];
+    QColor partColor = part.colorString.isEmpty() ? m_defaultPartColor : QColor(part.colorString);
+    
+    std::map<size_t, std::pair<QVector3D, size_t>> nodePositions;
+    for (const auto &nodeIndex: searchPart.nodeIndices) {
+        const auto &node = m_compiledSnapshot.nodes[nodeIndex];
+        QVector3D position(node.x - m_mainProfileMiddleX,
+            m_mainProfileMiddleY - node.y,
+            m_sideProfileMiddleX - node.z);
+        if (isMirrored)
+            position.setX(-position.x());
+        
+        ObjectNode objectNode;
+        objectNode.partId = part.id;
+        objectNode.nodeId = node.id;
+        objectNode.origin = position;
+        objectNode.radius = node.radius;
+        objectNode.color = partColor;
+        objectNode.materialId = part.materialId;
+        objectNode.countershaded = part.countershaded;
+        objectNode.colorSolubility = part.colorSolubility;
+        objectNode.metalness = part.metalness;
+        objectNode.roughness = part.roughness;
+        objectNode.boneMark = node.boneMark;
+        if (!part.mirroredByPartIdString.isEmpty())
+            objectNode.mirroredByPartId = QUuid(part.mirroredByPartIdString);
+        if (isMirrored)
+            objectNode.mirrorFromPartId = QUuid(part.mirrorFromPartIdString);
+        m_object->nodes.push_back(objectNode);
+        
+        nodePositions.insert({nodeIndex, {position, nodeSources->size()}});
+        nodeSources->push_back({part.id, node.id});
+    }
+    
+    std::set<size_t> connectedNodeIndices;
+    for (const auto &edgeIndex: searchPart.edgeIndices) {
+        const auto &edge = m_compiledSnapshot.edges[edgeIndex];
+        auto findFrom = nodePositions.find(edge.fromNodeIndex);
+        auto findTo = nodePositions.find(edge.toNodeIndex);
+        if (findFrom == nodePositions.end() || findTo == nodePositions.end())
+            continue;
+        sdfMeshBuilder->addRoundCone(group,
+            findFrom->second.first, m_compiledSnapshot.nodes[edge.fromNodeIndex].radius, findFrom->second.second,
+            findTo->second.first, m_compiledSnapshot.nodes[edge.toNodeIndex].radius, findTo->second.second);
+        m_object->edges.push_back({
+            {part.id, m_compiledSnapshot.nodes[edge.fromNodeIndex].id},
+            {part.id, m_compiledSnapshot.nodes[edge.toNodeIndex].id}
+        });
+        connectedNodeIndices.insert(edge.fromNodeIndex);
+        connectedNodeIndices.insert(edge.toNodeIndex);
+    }
+    for (const auto &it: nodePositions) {
+        if (connectedNodeIndices.find(it.first) != connectedNodeIndices.end())
+            continue;
+        sdfMeshBuilder->addSphere(group, it.second.first, m_compiledSnapshot.nodes[it.first].radius, it.second.second);
+    }
+}
+
+// The components are combined as the exact generation does, except the uncombined ones are united as well,
+// and the cloth ones are left out, they are simulated against the exact body only
+void MeshGenerator::addComponentToSdf(SdfMeshBuilder *sdfMeshBuilder, size_t parentGroup, size_t componentIndex, bool subtracted,
+    std::vector<std::pair<QUuid, QUuid>> *nodeSources)
+{
+    const auto &component = m_compiledSnapshot.components[componentIndex];
+    if (ComponentLayer::Cloth == component.layer)
+        return;
+    
+    size_t group = sdfMeshBuilder->addGroup(parentGroup, subtracted);
+    if (component.linkToPart) {
+        if (CompiledSnapshot::InvalidIndex != component.linkPartIndex)
+            addPartToSdf(sdfMeshBuilder, group, component.linkPartIndex, nodeSources);
+        return;
+    }
+    for (const auto &childIndex: component.childIndices) {
+        addComponentToSdf(sdfMeshBuilder, group, childIndex,
+            CombineMode::Inversion == componentCombineMode(&m_compiledSnapshot.components[childIndex]),
+            nodeSources);
+    }
+}
+
+void MeshGenerator::generateSdfPreview()
+{
+    TraceSpan span("generateSdfPreview");
+    
+    SdfMeshBuilder sdfMeshBuilder;
+    std::vector<std::pair<QUuid, QUuid>> nodeSources;
+    addComponentToSdf(&sdfMeshBuilder, SdfMeshBuilder::RootGroup, 0, false, &nodeSources);
+    if (!sdfMeshBuilder.build())
+        m_isSuccessful = false;
+    
+    const auto &vertices = sdfMeshBuilder.resultVertices();
+    const auto &vertexSources = sdfMeshBuilder.resultVertexSources();
+    m_object->vertices = vertices;
+    m_nodeVertices.reserve(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i)
+        m_nodeVertices.push_back({vertices[i], nodeSources[vertexSources[i]]});
+    
+    const auto &quads = sdfMeshBuilder.resultQuads();
+    m_object->triangleAndQuads.reserve(quads.size(), quads.size() * 4);
+    m_object->triangles.reserve(quads.size() * 2, quads.size() * 6);
+    for (const auto &quad: quads) {
+        m_object->triangleAndQuads.push_back(quad);
+        if ((vertices[quad[0]] - vertices[quad[2]]).lengthSquared() <= (vertices[quad[1]] - vertices[quad[3]]).lengthSquared()) {
+            m_object->triangles.push_back({quad[0], quad[1], quad[2]});
+            m_object->triangles.push_back({quad[2], quad[3], quad[0]});
+        } else {
+            m_object->triangles.push_back({quad[1], quad[2], quad[3]});
+            m_object->triangles.push_back({quad[3], quad[0], quad[1]});
+        }
+    }
+    
+    span.addArgument("vertexCount", (qint64)m_object->vertices.size());
+    span.addArgument("quadCount", (qint64)quads.size());
+    
+    postprocessObject(m_object);
+}
+
+void MeshGenerator::makePartPreviewMesh(const QUuid &partId, const GeneratedPart &partCache, const QColor &partColor,
+    float metalness, float roughness, PartTarget target)
+{
+    std::vector<QVector3D> partPreviewVertices = partCache.previewVertices;
+    QColor partPreviewColor = partCache.isSuccessful ? partColor : QColor(Qt::red);
+    
     trim(&partPreviewVertices, true);
     for (auto &it: partPreviewVertices) {
         it *= 2.0;
@@ -758,39 +1292,23 @@ MeshCombiner::Mesh *MeshGenerator::combinePartMesh(const QString &partIdString,
         partCache.previewTriangles,
         partPreviewTriangleNormals,
         &partPreviewTriangleVertexNormals);
+    Model *partPreviewMesh = nullptr;
     if (!partCache.previewTriangles.empty()) {
         if (target == PartTarget::CutFace)
             partPreviewColor = Theme::red;
-        m_partPreviewMeshes[partId] = new Model(partPreviewVertices,
+        partPreviewMesh = new Model(partPreviewVertices,
             partCache.previewTriangles,
             partPreviewTriangleVertexNormals,
             partPreviewColor,
             metalness,
             roughness);
     }
-    
-    delete strokeModifier;
-    
-    if (mesh && mesh->isNull()) {
-        delete mesh;
-        mesh = nullptr;
-    }
-    
-    if (isDisabled) {
-        delete mesh;
-        mesh = nullptr;
-    }
-    
-    if (target != PartTarget::Model) {
-        delete mesh;
-        mesh = nullptr;
-    }
-    
-    if (hasMeshError && target == PartTarget::Model) {
-        *hasError = true;
+    {
+        QMutexLocker locker(&m_partPreviewMeshesMutex);
+        delete m_partPreviewMeshes[partId];
+        m_partPreviewMeshes[partId] = partPreviewMesh;
+        m_generatedPreviewPartIds.insert(partId);
     }
-    
-    return mesh;
 }
 
 bool MeshGenerator::fillPartWithMesh(GeneratedPart &partCache, 
@@ -801,22 +1319,15 @@ bool MeshGenerator::fillPartWithMesh(GeneratedPart &partCache,
     const StrokeMeshBuilder *strokeMeshBuilder)
 {
     bool fillIsSucessful = false;
-    const QByteArray *fillMeshByteArray = FileForever::getContent(fillMeshFileId);
-    if (nullptr == fillMeshByteArray)
+    std::shared_ptr<FillMeshCacheEntry> fillMesh = generateFillMesh(fillMeshFileId);
+    if (nullptr == fillMesh)
         return false;
     
-    QXmlStreamReader fillMeshStream(*fillMeshByteArray);  
-    Snapshot *fillMeshSnapshot = new Snapshot;
-    loadSkeletonFromXmlStream(fillMeshSnapshot, fillMeshStream);
-    
-    GeneratedCacheContext *fillMeshCacheContext = new GeneratedCacheContext();
-    MeshGenerator *meshGenerator = new MeshGenerator(fillMeshSnapshot);
-    meshGenerator->setWeldEnabled(false);
-    meshGenerator->setGeneratedCacheContext(fillMeshCacheContext);
-    meshGenerator->generate();
-    fillIsSucessful = meshGenerator->isSuccessful();
-    Object *object = meshGenerator->takeObject();
+    fillIsSucessful = fillMesh->successful;
+    const Object *object = fillMesh->object.get();
     if (nullptr != object) {
+        std::vector<QVector3D> vertices = object->vertices;
+        std::vector<ObjectNode> objectNodes = object->nodes;
         MeshStroketifier stroketifier;
         std::vector<MeshStroketifier::Node> strokeNodes;
         for (const auto &nodeIndex: strokeMeshBuilder->nodeIndices()) {
@@ -829,68 +1340,123 @@ bool MeshGenerator::fillPartWithMesh(GeneratedPart &partCache,
         stroketifier.setCutRotation(cutRotation);
         stroketifier.setDeformWidth(deformWidth);
         stroketifier.setDeformThickness(deformThickness);
-        if (stroketifier.prepare(strokeNodes, object->vertices)) {
-            stroketifier.stroketify(&object->vertices);
-            std::vector<MeshStroketifier::Node> agentNodes(object->nodes.size());
-            for (size_t i = 0; i < object->nodes.size(); ++i) {
+        if (stroketifier.prepare(strokeNodes, vertices)) {
+            stroketifier.stroketify(&vertices);
+            std::vector<MeshStroketifier::Node> agentNodes(objectNodes.size());
+            for (size_t i = 0; i < objectNodes.size(); ++i) {
                 auto &dest = agentNodes[i];
-                const auto &src = object->nodes[i];
+                const auto &src = objectNodes[i];
                 dest.position = src.origin;
                 dest.radius = src.radius;
             }
             stroketifier.stroketify(&agentNodes);
-            for (size_t i = 0; i < object->nodes.size(); ++i) {
+            for (size_t i = 0; i < objectNodes.size(); ++i) {
                 const auto &src = agentNodes[i];
-                auto &dest = object->nodes[i];
+                auto &dest = objectNodes[i];
                 dest.origin = src.position;
                 dest.radius = src.radius;
             }
         }
-        partCache.objectNodes.insert(partCache.objectNodes.end(), object->nodes.begin(), object->nodes.end());
+        partCache.objectNodes.insert(partCache.objectNodes.end(), objectNodes.begin(), objectNodes.end());
         partCache.objectEdges.insert(partCache.objectEdges.end(), object->edges.begin(), object->edges.end());
-        partCache.vertices.insert(partCache.vertices.end(), object->vertices.begin(), object->vertices.end());
+        partCache.vertices.insert(partCache.vertices.end(), vertices.begin(), vertices.end());
         if (!strokeNodes.empty()) {
             for (auto &it: partCache.vertices)
                 it += strokeNodes.front().position;
         }
-        for (size_t i = 0; i < object->vertexSourceNodes.size(); ++i)
-            partCache.objectNodeVertices.push_back({partCache.vertices[i], object->vertexSourceNodes[i]});
-        partCache.faces.insert(partCache.faces.end(), object->triangleAndQuads.begin(), object->triangleAndQuads.end());
-        fillIsSucessful = true;
+        for (size_t i = 0; i < object->vertexSourceNodes.size(); ++i)
+            partCache.objectNodeVertices.push_back({partCache.vertices[i], object->vertexSourceNodes[i]});
+        partCache.faces.reserve(partCache.faces.size() + object->triangleAndQuads.size());
+        for (const auto &face: object->triangleAndQuads)
+            partCache.faces.push_back(face.toVector());
+        fillIsSucessful = true;
+    }
+
+    return fillIsSucessful;
+}
+
+// The fill mesh is generated once for all the parts using it, the parts filling at the same time wait for the first one.
+// The fill meshes are generated by preparePartMeshes before the parts are built concurrently, so normally only the generator thread waits here
+std::shared_ptr<FillMeshCacheEntry> MeshGenerator::generateFillMesh(const QUuid &fillMeshFileId)
+{
+    const QByteArray *fillMeshByteArray = FileForever::getContent(fillMeshFileId);
+    if (nullptr == fillMeshByteArray)
+        return nullptr;
+    
+    QByteArray key;
+    QDataStream stream(&key, QIODevice::WriteOnly);
+    stream << QCryptographicHash::hash(*fillMeshByteArray, QCryptographicHash::Sha1) << m_balancedCombinationEnabled;
+    
+    std::shared_ptr<FillMeshCacheEntry> fillMesh;
+    {
+        QMutexLocker locker(&g_fillMeshCacheMutex);
+        auto &cached = g_fillMeshCache[fillMeshFileId];
+        if (nullptr == cached.second || cached.first != key)
+            cached = {key, std::make_shared<FillMeshCacheEntry>()};
+        fillMesh = cached.second;
+        fillMesh->lastUsed = ++g_fillMeshCacheUseCount;
+        while (g_fillMeshCache.size() > g_maxFillMeshCacheCount) {
+            // The parts still using a dropped entry keep it alive
+            auto leastRecentlyUsed = std::min_element(g_fillMeshCache.begin(), g_fillMeshCache.end(),
+                    [](const decltype(g_fillMeshCache)::value_type &first, const decltype(g_fillMeshCache)::value_type &second) {
+                return first.second.second->lastUsed < second.second.second->lastUsed;
+            });
+            g_fillMeshCache.erase(leastRecentlyUsed);
+        }
     }
-    delete object;
+    
+    QMutexLocker locker(&fillMesh->mutex);
+    if (fillMesh->generated)
+        return fillMesh;
+    
+    TraceSpan span("generateFillMesh");
+    
+    QXmlStreamReader fillMeshStream(*fillMeshByteArray);
+    Snapshot *fillMeshSnapshot = new Snapshot;
+    loadSkeletonFromXmlStream(fillMeshSnapshot, fillMeshStream);
+    
+    GeneratedCacheContext *fillMeshCacheContext = new GeneratedCacheContext();
+    MeshGenerator *meshGenerator = new MeshGenerator(fillMeshSnapshot);
+    meshGenerator->setWeldEnabled(false);
+    meshGenerator->setBalancedCombinationEnabled(m_balancedCombinationEnabled);
+    meshGenerator->setGeneratedCacheContext(fillMeshCacheContext);
+    // The nested generation runs its own tasks, in an arena of its own, the wait for them never picks up
+    // a task of this generation, which could be a part waiting for this very fill mesh
+    tbb::task_arena arena;
+    arena.execute([&]() {
+        meshGenerator->generate();
+    });
+    fillMesh->successful = meshGenerator->isSuccessful();
+    fillMesh->object.reset(meshGenerator->takeObject());
+    fillMesh->generated = true;
     delete meshGenerator;
     delete fillMeshCacheContext;
-
-    return fillIsSucessful;
+    
+    return fillMesh;
 }
 
-const std::map<QString, QString> *MeshGenerator::findComponent(const QString &componentIdString)
+const CompiledSnapshot::Component *MeshGenerator::findComponent(const QString &componentIdString)
 {
-    const std::map<QString, QString> *component = &m_snapshot->rootComponent;
-    if (componentIdString != QUuid().toString()) {
-        auto findComponent = m_snapshot->components.find(componentIdString);
-        if (findComponent == m_snapshot->components.end()) {
-            qDebug() << "Component not found:" << componentIdString;
-            return nullptr;
-        }
-        return &findComponent->second;
+    size_t componentIndex = m_compiledSnapshot.findComponent(componentIdString);
+    if (CompiledSnapshot::InvalidIndex == componentIndex) {
+        qDebug() << "Component not found:" << componentIdString;
+        return nullptr;
     }
-    return component;
+    return &m_compiledSnapshot.components[componentIndex];
 }
 
-CombineMode MeshGenerator::componentCombineMode(const std::map<QString, QString> *component)
+CombineMode MeshGenerator::componentCombineMode(const CompiledSnapshot::Component *component)
 {
     if (nullptr == component)
         return CombineMode::Normal;
-    CombineMode combineMode = CombineModeFromString(valueOfKeyInMapOrEmpty(*component, "combineMode").toUtf8().constData());
+    CombineMode combineMode = component->combineMode;
     if (combineMode == CombineMode::Normal) {
-        if (isTrueValueString(valueOfKeyInMapOrEmpty(*component, "inverse")))
+        if (component->inverse)
             combineMode = CombineMode::Inversion;
         if (componentRemeshed(component))
             combineMode = CombineMode::Uncombined;
         if (combineMode == CombineMode::Normal) {
-            if (ComponentLayer::Body != ComponentLayerFromString(valueOfKeyInMapOrEmpty(*component, "layer").toUtf8().constData())) {
+            if (ComponentLayer::Body != component->layer) {
                 combineMode = CombineMode::Uncombined;
             }
         }
@@ -898,17 +1464,17 @@ CombineMode MeshGenerator::componentCombineMode(const std::map<QString, QString>
     return combineMode;
 }
 
-bool MeshGenerator::componentRemeshed(const std::map<QString, QString> *component, float *polyCountValue)
+bool MeshGenerator::componentRemeshed(const CompiledSnapshot::Component *component, float *polyCountValue)
 {
     if (nullptr == component)
         return false;
     bool isCloth = false;
-    if (ComponentLayer::Cloth == ComponentLayerFromString(valueOfKeyInMapOrEmpty(*component, "layer").toUtf8().constData())) {
+    if (ComponentLayer::Cloth == component->layer) {
         if (nullptr != polyCountValue)
             *polyCountValue = PolyCountToValue(PolyCount::VeryHighPoly);
         isCloth = true;
     }
-    auto polyCount = PolyCountFromString(valueOfKeyInMapOrEmpty(*component, "polyCount").toUtf8().constData());
+    auto polyCount = component->polyCount;
     if (nullptr != polyCountValue)
         *polyCountValue = PolyCountToValue(polyCount);
     if (isCloth)
@@ -916,99 +1482,85 @@ bool MeshGenerator::componentRemeshed(const std::map<QString, QString> *componen
     return polyCount != PolyCount::Original;
 }
 
-QString MeshGenerator::componentColorName(const std::map<QString, QString> *component)
+QString MeshGenerator::componentColorName(const CompiledSnapshot::Component *component)
 {
     if (nullptr == component)
         return QString();
-    QString linkDataType = valueOfKeyInMapOrEmpty(*component, "linkDataType");
-    if ("partId" == linkDataType) {
-        QString partIdString = valueOfKeyInMapOrEmpty(*component, "linkData");
-        auto findPart = m_snapshot->parts.find(partIdString);
-        if (findPart == m_snapshot->parts.end()) {
-            qDebug() << "Find part failed:" << partIdString;
-            return QString();
-        }
-        auto &part = findPart->second;
-        QString colorSolubility = valueOfKeyInMapOrEmpty(part, "colorSolubility");
-        if (!colorSolubility.isEmpty()) {
-            return QString("+");
-        }
-        QString colorName = valueOfKeyInMapOrEmpty(part, "color");
-        if (colorName.isEmpty())
-            return QString("-");
-        return colorName;
-    }
-    return QString();
+    return component->colorName;
 }
 
-ComponentLayer MeshGenerator::componentLayer(const std::map<QString, QString> *component)
+ComponentLayer MeshGenerator::componentLayer(const CompiledSnapshot::Component *component)
 {
     if (nullptr == component)
         return ComponentLayer::Body;
-    return ComponentLayerFromString(valueOfKeyInMapOrEmpty(*component, "layer").toUtf8().constData());
+    return component->layer;
 }
 
-float MeshGenerator::componentClothStiffness(const std::map<QString, QString> *component)
+float MeshGenerator::componentClothStiffness(const CompiledSnapshot::Component *component)
 {
     if (nullptr == component)
         return Component::defaultClothStiffness;
-    auto findClothStiffness = component->find("clothStiffness");
-    if (findClothStiffness == component->end())
+    if (!component->hasClothStiffness)
         return Component::defaultClothStiffness;
-    return findClothStiffness->second.toFloat();
+    return component->clothStiffness;
 }
 
-size_t MeshGenerator::componentClothIteration(const std::map<QString, QString> *component)
+size_t MeshGenerator::componentClothIteration(const CompiledSnapshot::Component *component)
 {
     if (nullptr == component)
         return Component::defaultClothIteration;
-    auto findClothIteration = component->find("clothIteration");
-    if (findClothIteration == component->end())
+    if (!component->hasClothIteration)
         return Component::defaultClothIteration;
-    return findClothIteration->second.toUInt();
+    return component->clothIteration;
 }
 
-ClothForce MeshGenerator::componentClothForce(const std::map<QString, QString> *component)
+ClothForce MeshGenerator::componentClothForce(const CompiledSnapshot::Component *component)
 {
     if (nullptr == component)
         return ClothForce::Gravitational;
-    return ClothForceFromString(valueOfKeyInMapOrEmpty(*component, "clothForce").toUtf8().constData());
+    return component->clothForce;
 }
 
-float MeshGenerator::componentClothOffset(const std::map<QString, QString> *component)
+float MeshGenerator::componentClothOffset(const CompiledSnapshot::Component *component)
 {
     if (nullptr == component)
         return 0.0f;
-    return valueOfKeyInMapOrEmpty(*component, "clothOffset").toFloat();
+    return component->clothOffset;
 }
 
 MeshCombiner::Mesh *MeshGenerator::combineComponentMesh(const QString &componentIdString, CombineMode *combineMode)
 {
     MeshCombiner::Mesh *mesh = nullptr;
     
-    QUuid componentId;
-    const std::map<QString, QString> *component = &m_snapshot->rootComponent;
-    if (componentIdString != QUuid().toString()) {
-        componentId = QUuid(componentIdString);
-        auto findComponent = m_snapshot->components.find(componentIdString);
-        if (findComponent == m_snapshot->components.end()) {
-            qDebug() << "Component not found:" << componentIdString;
-            return nullptr;
-        }
-        component = &findComponent->second;
-    }
+    const CompiledSnapshot::Component *component = findComponent(componentIdString);
+    if (nullptr == component)
+        return nullptr;
+    QUuid componentId = component->id;
 
     *combineMode = componentCombineMode(component);
     
-    auto &componentCache = m_cacheContext->components[componentIdString];
+    if (isCancelled())
+        return nullptr;
+    
+    TraceSpan span("combineComponentMesh");
+    span.addArgument("componentId", componentIdString);
+    
+    auto &componentCache = m_cacheContext->componentCache(componentIdString);
     
     if (m_cacheEnabled) {
         if (m_dirtyComponentIds.find(componentIdString) == m_dirtyComponentIds.end()) {
-            if (nullptr != componentCache.mesh)
+            if (nullptr != componentCache.mesh) {
+                span.addArgument("cache", "memory");
                 return new MeshCombiner::Mesh(*componentCache.mesh);
+            }
         }
     }
     
+    if (loadComponentFromDiskCache(component)) {
+        span.addArgument("cache", "disk");
+        return nullptr == componentCache.mesh ? nullptr : new MeshCombiner::Mesh(*componentCache.mesh);
+    }
+    
     componentCache.sharedQuadEdges.clear();
     componentCache.noneSeamVertices.clear();
     componentCache.objectNodes.clear();
@@ -1016,26 +1568,20 @@ MeshCombiner::Mesh *MeshGenerator::combineComponentMesh(const QString &component
     componentCache.objectNodeVertices.clear();
     componentCache.releaseMeshes();
     
-    QString linkDataType = valueOfKeyInMapOrEmpty(*component, "linkDataType");
-    if ("partId" == linkDataType) {
-        QString partIdString = valueOfKeyInMapOrEmpty(*component, "linkData");
+    if (component->linkToPart) {
+        const QString &partIdString = component->linkPartIdString;
         bool hasError = false;
-        bool retryable = true;
-        mesh = combinePartMesh(partIdString, &hasError, &retryable);
+        if (CompiledSnapshot::InvalidIndex != component->linkPartIndex &&
+                m_preparedPartMeshes[component->linkPartIndex].isPrepared) {
+            mesh = takePreparedPartMesh(component->linkPartIndex, &hasError);
+        } else {
+            mesh = combinePartMeshWithRetry(partIdString, &hasError);
+        }
         if (hasError) {
-            delete mesh;
-            mesh = nullptr;
-            if (retryable) {
-                hasError = false;
-                qDebug() << "Try combine part again without adding intermediate nodes";
-                mesh = combinePartMesh(partIdString, &hasError, &retryable, false);
-            }
-            if (hasError) {
-                m_isSuccessful = false;
-            }
+            m_isSuccessful = false;
         }
         
-        const auto &partCache = m_cacheContext->parts[partIdString];
+        const auto &partCache = m_cacheContext->partCache(partIdString);
         for (const auto &vertex: partCache.vertices)
             componentCache.noneSeamVertices.insert(vertex);
         collectSharedQuadEdges(partCache.vertices, partCache.faces, &componentCache.sharedQuadEdges);
@@ -1051,10 +1597,9 @@ MeshCombiner::Mesh *MeshGenerator::combineComponentMesh(const QString &component
         int currentGroupIndex = -1;
         auto lastCombineMode = CombineMode::Count;
         bool foundColorSolubilitySetting = false;
-        for (const auto &childIdString: valueOfKeyInMapOrEmpty(*component, "children").split(",")) {
-            if (childIdString.isEmpty())
-                continue;
-            const auto &child = findComponent(childIdString);
+        for (const auto &childIndex: component->childIndices) {
+            const auto &child = &m_compiledSnapshot.components[childIndex];
+            const QString &childIdString = child->idString;
             QString colorName = componentColorName(child);
             if (colorName == "+") {
                 foundColorSolubilitySetting = true;
@@ -1072,8 +1617,16 @@ MeshCombiner::Mesh *MeshGenerator::combineComponentMesh(const QString &component
             }
             combineGroups[currentGroupIndex].second.push_back({childIdString, colorName});
         }
+        // Build all the child subtrees concurrently, they are combined in the original order afterwards
+        std::vector<QString> childIdStrings;
+        for (const auto &group: combineGroups) {
+            for (const auto &it: group.second)
+                childIdStrings.push_back(it.first);
+        }
+        std::map<QString, std::pair<MeshCombiner::Mesh *, CombineMode>> preparedChildMeshes;
+        prepareComponentChildMeshes(childIdStrings, &preparedChildMeshes);
         // Secondly, sub group by color
-        std::vector<std::tuple<MeshCombiner::Mesh *, CombineMode, QString>> groupMeshes;
+        std::vector<std::tuple<MeshCombiner::Mesh *, CombineMode, CombinationKey>> groupMeshes;
         for (const auto &group: combineGroups) {
             std::set<size_t> used;
             std::vector<std::vector<QString>> componentIdStrings;
@@ -1110,29 +1663,37 @@ MeshCombiner::Mesh *MeshGenerator::combineComponentMesh(const QString &component
                     componentIdStrings[currentSubGroupIndex].push_back(group.second[j].first);
                 }
             }
-            std::vector<std::tuple<MeshCombiner::Mesh *, CombineMode, QString>> multipleMeshes;
-            QStringList subGroupMeshIdStringList;
+            std::vector<std::tuple<MeshCombiner::Mesh *, CombineMode, CombinationKey>> multipleMeshes;
+            std::vector<CombinationKey> subGroupMeshKeys;
             for (const auto &it: componentIdStrings) {
-                QStringList componentChildGroupIdStringList;
+                std::vector<CombinationKey> componentChildGroupKeys;
                 for (const auto &componentChildGroupIdString: it)
-                    componentChildGroupIdStringList += componentChildGroupIdString;
-                MeshCombiner::Mesh *childMesh = combineComponentChildGroupMesh(it, componentCache);
+                    componentChildGroupKeys.push_back(CombinationKey(componentChildGroupIdString));
+                MeshCombiner::Mesh *childMesh = combineComponentChildGroupMesh(componentIdString, it, componentCache, &preparedChildMeshes);
                 if (nullptr == childMesh)
                     continue;
                 if (childMesh->isNull()) {
                     delete childMesh;
                     continue;
                 }
-                QString componentChildGroupIdStringListString = componentChildGroupIdStringList.join("|");
-                subGroupMeshIdStringList += componentChildGroupIdStringListString;
-                multipleMeshes.push_back(std::make_tuple(childMesh, CombineMode::Normal, componentChildGroupIdStringListString));
+                CombinationKey componentChildGroupKey = CombinationKey::group(componentChildGroupKeys, *childMesh);
+                subGroupMeshKeys.push_back(componentChildGroupKey);
+                multipleMeshes.push_back(std::make_tuple(childMesh, CombineMode::Normal, componentChildGroupKey));
             }
-            MeshCombiner::Mesh *subGroupMesh = combineMultipleMeshes(multipleMeshes, true/*foundColorSolubilitySetting*/);
+            MeshCombiner::Mesh *subGroupMesh = combineMultipleMeshes(componentIdString, multipleMeshes, !m_coarseTierEnabled/*foundColorSolubilitySetting*/);
             if (nullptr == subGroupMesh)
                 continue;
-            groupMeshes.push_back(std::make_tuple(subGroupMesh, group.first, subGroupMeshIdStringList.join("&")));
+            groupMeshes.push_back(std::make_tuple(subGroupMesh, group.first, CombinationKey::group(subGroupMeshKeys, *subGroupMesh)));
         }
-        mesh = combineMultipleMeshes(groupMeshes, true);
+        mesh = combineMultipleMeshes(componentIdString, groupMeshes, !m_coarseTierEnabled);
+        for (auto &it: preparedChildMeshes)
+            delete it.second.first;
+    }
+    
+    // The children may have been skipped by the cancellation, the result is incomplete and must not be cached
+    if (isCancelled()) {
+        delete mesh;
+        return nullptr;
     }
     
     if (nullptr != mesh)
@@ -1157,8 +1718,14 @@ MeshCombiner::Mesh *MeshGenerator::combineComponentMesh(const QString &component
     
     if (nullptr != mesh) {
         float polyCountValue = 1.0f;
-        bool remeshed = componentId.isNull() ? componentRemeshed(&m_snapshot->canvas, &polyCountValue) : componentRemeshed(component, &polyCountValue);
-        if (remeshed) {
+        bool remeshed = componentId.isNull() ? componentRemeshed(&m_compiledSnapshot.canvas, &polyCountValue) : componentRemeshed(component, &polyCountValue);
+        if (remeshed && !m_coarseTierEnabled) {
+            if (isCancelled()) {
+                delete componentCache.mesh;
+                componentCache.mesh = nullptr;
+                delete mesh;
+                return nullptr;
+            }
             std::vector<QVector3D> combinedVertices;
             std::vector<std::vector<size_t>> combinedFaces;
             mesh->fetch(combinedVertices, combinedFaces);
@@ -1169,15 +1736,28 @@ MeshCombiner::Mesh *MeshGenerator::combineComponentMesh(const QString &component
             Object::buildInterpolatedNodes(componentCache.objectNodes,
                 componentCache.objectEdges,
                 &interpolatedNodes);
-            remesh(componentCache.objectNodes,
-                interpolatedNodes,
-                combinedVertices,
-                combinedFaces,
-                polyCountValue,
-                &newVertices,
-                &newQuads,
-                &newTriangles,
-                &componentCache.objectNodeVertices);
+            {
+                TraceSpan remeshSpan("Remesher::remesh");
+                remeshSpan.addArgument("componentId", componentIdString);
+                remeshSpan.addArgument("inputVertexCount", (qint64)combinedVertices.size());
+                bool remeshSucceed = remesh(componentCache,
+                    componentCache.objectNodes,
+                    interpolatedNodes,
+                    combinedVertices,
+                    combinedFaces,
+                    polyCountValue,
+                    &newVertices,
+                    &newQuads,
+                    &newTriangles,
+                    &componentCache.objectNodeVertices);
+                if (!remeshSucceed) {
+                    delete componentCache.mesh;
+                    componentCache.mesh = nullptr;
+                    delete mesh;
+                    return nullptr;
+                }
+                remeshSpan.addArgument("outputVertexCount", (qint64)newVertices.size());
+            }
             componentCache.sharedQuadEdges.clear();
             for (const auto &face: newQuads) {
                 if (face.size() != 4)
@@ -1222,18 +1802,230 @@ MeshCombiner::Mesh *MeshGenerator::combineComponentMesh(const QString &component
         }
     }
     
+    saveComponentToDiskCache(component);
+    
     return mesh;
 }
 
-MeshCombiner::Mesh *MeshGenerator::combineMultipleMeshes(const std::vector<std::tuple<MeshCombiner::Mesh *, CombineMode, QString>> &multipleMeshes, bool recombine)
+QByteArray MeshGenerator::hashPartContent(size_t partIndex)
+{
+    const auto &part = m_compiledSnapshot.parts[partIndex];
+    
+    QByteArray content;
+    QDataStream stream(&content, QIODevice::WriteOnly);
+    auto writeCutTemplate = [&](size_t cutTemplateIndex) {
+        if (CompiledSnapshot::InvalidIndex == cutTemplateIndex) {
+            stream << (quint32)0;
+            return;
+        }
+        const auto &cutTemplate = m_compiledSnapshot.cutTemplates[cutTemplateIndex];
+        stream << (quint32)cutTemplate.size();
+        for (const auto &it: cutTemplate)
+            stream << it;
+    };
+    auto writeContentHash = [&](const QByteArray *bytes) {
+        stream << (nullptr == bytes ? QByteArray() : QCryptographicHash::hash(*bytes, QCryptographicHash::Sha1));
+    };
+    
+    stream << part.idString << part.disabled << part.xMirrored << part.subdived << part.rounded << part.chamfered
+        << part.countershaded << part.smooth << part.deformUnified
+        << part.mirroredByPartIdString << part.mirrorFromPartIdString
+        << (part.colorString.isEmpty() ? m_defaultPartColor : QColor(part.colorString))
+        << (quint32)part.target << (quint32)part.base << part.cutRotation << part.hollowThickness
+        << part.deformThickness << part.deformWidth << part.deformMapScale << part.materialId
+        << part.colorSolubility << part.metalness << part.roughness;
+    writeCutTemplate(part.cutTemplateIndex);
+    
+    // The image and the file are hashed by content, the same id does not guarantee the same bytes across documents
+    if (!part.deformMapImageIdString.isEmpty())
+        writeContentHash(ImageForever::getPngByteArray(QUuid(part.deformMapImageIdString)));
+    if (!part.fillMeshFileId.isNull())
+        writeContentHash(FileForever::getContent(part.fillMeshFileId));
+    
+    stream << m_mainProfileMiddleX << m_mainProfileMiddleY << m_sideProfileMiddleX;
+    size_t searchPartIndex = part.mirrorFromPartIdString.isEmpty() ? partIndex : part.mirrorFromPartIndex;
+    if (CompiledSnapshot::InvalidIndex != searchPartIndex) {
+        const auto &searchPart = m_compiledSnapshot.parts[searchPartIndex];
+        stream << (quint32)searchPart.nodeIndices.size();
+        for (const auto &nodeIndex: searchPart.nodeIndices) {
+            const auto &node = m_compiledSnapshot.nodes[nodeIndex];
+            stream << node.idString << node.x << node.y << node.z << node.radius
+                << (quint32)node.boneMark << node.hasCutFaceSettings;
+            if (node.hasCutFaceSettings) {
+                stream << node.cutRotation;
+                writeCutTemplate(node.cutTemplateIndex);
+            }
+        }
+        stream << (quint32)searchPart.edgeIndices.size();
+        for (const auto &edgeIndex: searchPart.edgeIndices) {
+            const auto &edge = m_compiledSnapshot.edges[edgeIndex];
+            stream << m_compiledSnapshot.nodes[edge.fromNodeIndex].idString
+                << m_compiledSnapshot.nodes[edge.toNodeIndex].idString;
+        }
+    }
+    
+    return QCryptographicHash::hash(content, QCryptographicHash::Sha1);
+}
+
+QByteArray MeshGenerator::hashComponentContent(size_t componentIndex, std::map<size_t, QByteArray> *partContentHashes)
+{
+    const auto &component = m_compiledSnapshot.components[componentIndex];
+    
+    QByteArray content;
+    QDataStream stream(&content, QIODevice::WriteOnly);
+    stream << QString(APP_VER) << g_diskCacheGeneratorVersion << m_balancedCombinationEnabled << m_coarseTierEnabled;
+    stream << component.idString << (quint32)componentCombineMode(&component)
+        << (quint32)component.layer << (quint32)component.polyCount;
+    if (component.id.isNull()) {
+        // The root is remeshed by the canvas settings
+        stream << (quint32)m_compiledSnapshot.canvas.layer << (quint32)m_compiledSnapshot.canvas.polyCount;
+    }
+    
+    if (component.linkToPart) {
+        stream << component.linkPartIdString;
+        if (CompiledSnapshot::InvalidIndex != component.linkPartIndex) {
+            auto findPartContentHash = partContentHashes->find(component.linkPartIndex);
+            if (findPartContentHash == partContentHashes->end()) {
+                findPartContentHash = partContentHashes->insert({component.linkPartIndex,
+                    hashPartContent(component.linkPartIndex)}).first;
+            }
+            stream << findPartContentHash->second;
+        }
+    }
+    
+    stream << (quint32)component.childIndices.size();
+    for (const auto &childIndex: component.childIndices) {
+        stream << hashComponentContent(childIndex, partContentHashes)
+            << m_compiledSnapshot.components[childIndex].colorName;
+    }
+    
+    QByteArray hash = QCryptographicHash::hash(content, QCryptographicHash::Sha1);
+    m_componentContentHashes[component.idString] = hash;
+    return hash;
+}
+
+bool MeshGenerator::loadComponentFromDiskCache(const CompiledSnapshot::Component *component)
+{
+    if (nullptr == m_diskCache)
+        return false;
+    
+    auto findContentHash = m_componentContentHashes.find(component->idString);
+    if (findContentHash == m_componentContentHashes.end())
+        return false;
+    
+    QByteArray data;
+    if (!m_diskCache->load(findContentHash->second, &data))
+        return false;
+    
+    // The entry holds the combined result only, the caches of the children are still collected after the combination,
+    // so the whole subtree is loaded, or the component is rebuilt
+    for (const auto &childIndex: component->childIndices) {
+        const auto &child = m_compiledSnapshot.components[childIndex];
+        if (m_cacheEnabled && m_dirtyComponentIds.find(child.idString) == m_dirtyComponentIds.end()) {
+            if (nullptr != m_cacheContext->componentCache(child.idString).mesh)
+                continue;
+        }
+        if (!loadComponentFromDiskCache(&child))
+            return false;
+    }
+    
+    QDataStream stream(data);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    
+    auto &componentCache = m_cacheContext->componentCache(component->idString);
+    componentCache.sharedQuadEdges.clear();
+    componentCache.noneSeamVertices.clear();
+    componentCache.objectNodes.clear();
+    componentCache.objectEdges.clear();
+    componentCache.objectNodeVertices.clear();
+    componentCache.releaseMeshes();
+    bool isLoaded = readGeneratedComponent(stream, &componentCache);
+    
+    bool hasPart = false;
+    stream >> hasPart;
+    if (isLoaded && hasPart) {
+        auto &partCache = m_cacheContext->partCache(component->linkPartIdString);
+        partCache.releaseMeshes();
+        isLoaded = readGeneratedPart(stream, &partCache);
+        if (isLoaded) {
+            const auto &part = m_compiledSnapshot.parts[component->linkPartIndex];
+            makePartPreviewMesh(part.id, partCache,
+                part.colorString.isEmpty() ? m_defaultPartColor : QColor(part.colorString),
+                part.metalness, part.roughness, part.target);
+        }
+    }
+    
+    bool hasClothCollision = false;
+    stream >> hasClothCollision;
+    if (isLoaded && hasClothCollision) {
+        readVertices(stream, &m_clothCollisionVertices);
+        readFaces(stream, m_clothCollisionVertices.size(), &m_clothCollisionTriangles);
+    }
+    
+    if (!isLoaded || QDataStream::Ok != stream.status()) {
+        qDebug() << "Disk cache entry is corrupted:" << component->idString;
+        componentCache.releaseMeshes();
+        if (hasClothCollision) {
+            m_clothCollisionVertices.clear();
+            m_clothCollisionTriangles.clear();
+        }
+        return false;
+    }
+    
+    return true;
+}
+
+void MeshGenerator::saveComponentToDiskCache(const CompiledSnapshot::Component *component)
+{
+    if (nullptr == m_diskCache)
+        return;
+    
+    // The errors are not persisted, they are reproduced and reported by the next generation
+    if (isCancelled() || !m_isSuccessful)
+        return;
+    
+    auto findContentHash = m_componentContentHashes.find(component->idString);
+    if (findContentHash == m_componentContentHashes.end())
+        return;
+    
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    
+    writeGeneratedComponent(stream, m_cacheContext->componentCache(component->idString));
+    
+    bool hasPart = component->linkToPart && CompiledSnapshot::InvalidIndex != component->linkPartIndex;
+    stream << hasPart;
+    if (hasPart)
+        writeGeneratedPart(stream, m_cacheContext->partCache(component->linkPartIdString));
+    
+    bool hasClothCollision = component->id.isNull();
+    stream << hasClothCollision;
+    if (hasClothCollision) {
+        writeVertices(stream, m_clothCollisionVertices);
+        writeFaces(stream, m_clothCollisionTriangles);
+    }
+    
+    m_diskCache->save(findContentHash->second, data);
+}
+
+MeshCombiner::Mesh *MeshGenerator::combineMultipleMeshes(const QString &componentIdString,
+    const std::vector<std::tuple<MeshCombiner::Mesh *, CombineMode, CombinationKey>> &multipleMeshes, bool recombine)
 {
+    if (m_balancedCombinationEnabled)
+        return combineMultipleMeshesInBalancedTree(componentIdString, multipleMeshes, recombine);
+    
     MeshCombiner::Mesh *mesh = nullptr;
-    QString meshIdStrings;
+    CombinationKey meshKey;
     for (const auto &it: multipleMeshes) {
         const auto &childCombineMode = std::get<1>(it);
         MeshCombiner::Mesh *subMesh = std::get<0>(it);
-        const QString &subMeshIdString = std::get<2>(it);
+        const CombinationKey &subMeshKey = std::get<2>(it);
         //qDebug() << "Combine mode:" << CombineModeToString(childCombineMode);
+        if (isCancelled()) {
+            delete subMesh;
+            continue;
+        }
         if (nullptr == subMesh || subMesh->isNull()) {
             delete subMesh;
             qDebug() << "Child mesh is null";
@@ -1247,33 +2039,30 @@ MeshCombiner::Mesh *MeshGenerator::combineMultipleMeshes(const std::vector<std::
         }
         if (nullptr == mesh) {
             mesh = subMesh;
-            meshIdStrings = subMeshIdString;
+            meshKey = subMeshKey;
         } else {
             auto combinerMethod = childCombineMode == CombineMode::Inversion ?
                     MeshCombiner::Method::Diff : MeshCombiner::Method::Union;
-            auto combinerMethodString = combinerMethod == MeshCombiner::Method::Union ?
-                "+" : "-";
-            meshIdStrings += combinerMethodString + subMeshIdString;
-            if (recombine)
-                meshIdStrings += "!";
+            meshKey = CombinationKey::combine(meshKey, subMeshKey, combinerMethod, recombine);
             MeshCombiner::Mesh *newMesh = nullptr;
-            auto findCached = m_cacheContext->cachedCombination.find(meshIdStrings);
-            if (findCached != m_cacheContext->cachedCombination.end()) {
-                if (nullptr != findCached->second) {
-                    //qDebug() << "Use cached combination:" << meshIdStrings;
-                    newMesh = new MeshCombiner::Mesh(*findCached->second);
-                }
+            if (m_cacheContext->findCachedCombination(meshKey, &newMesh)) {
+                //qDebug() << "Use cached combination:" << meshKey.hash;
             } else {
+                TraceSpan combineSpan("combineTwoMeshes");
+                combineSpan.addArgument("componentId", componentIdString);
                 newMesh = combineTwoMeshes(*mesh,
                     *subMesh,
                     combinerMethod,
                     recombine);
                 delete subMesh;
-                if (nullptr != newMesh)
-                    m_cacheContext->cachedCombination.insert({meshIdStrings, new MeshCombiner::Mesh(*newMesh)});
-                else
-                    m_cacheContext->cachedCombination.insert({meshIdStrings, nullptr});
-                //qDebug() << "Add cached combination:" << meshIdStrings;
+                if (isCancelled()) {
+                    // The operands may be incomplete
+                } else if (nullptr != newMesh) {
+                    m_cacheContext->addCachedCombination(meshKey, componentIdString, new MeshCombiner::Mesh(*newMesh));
+                } else {
+                    m_cacheContext->addCachedCombination(meshKey, componentIdString, nullptr);
+                }
+                //qDebug() << "Add cached combination:" << meshKey.hash;
             }
             if (newMesh && !newMesh->isNull()) {
                 delete mesh;
@@ -1292,19 +2081,173 @@ MeshCombiner::Mesh *MeshGenerator::combineMultipleMeshes(const std::vector<std::
     return mesh;
 }
 
-MeshCombiner::Mesh *MeshGenerator::combineComponentChildGroupMesh(const std::vector<QString> &componentIdStrings, GeneratedComponent &componentCache)
+void MeshGenerator::prepareComponentChildMeshes(const std::vector<QString> &componentIdStrings,
+    std::map<QString, std::pair<MeshCombiner::Mesh *, CombineMode>> *preparedChildMeshes)
+{
+    std::vector<QString> uniqueComponentIdStrings;
+    std::set<QString> visitedComponentIdStrings;
+    for (const auto &it: componentIdStrings) {
+        if (visitedComponentIdStrings.insert(it).second)
+            uniqueComponentIdStrings.push_back(it);
+    }
+    std::vector<std::pair<MeshCombiner::Mesh *, CombineMode>> childMeshes(uniqueComponentIdStrings.size(),
+        {nullptr, CombineMode::Normal});
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, uniqueComponentIdStrings.size()),
+        ComponentChildMeshesCombiner(this, &uniqueComponentIdStrings, &childMeshes));
+    for (size_t i = 0; i < uniqueComponentIdStrings.size(); ++i)
+        preparedChildMeshes->insert({uniqueComponentIdStrings[i], childMeshes[i]});
+}
+
+MeshCombiner::Mesh *MeshGenerator::combineMultipleMeshesInBalancedTree(const QString &componentIdString,
+    const std::vector<std::tuple<MeshCombiner::Mesh *, CombineMode, CombinationKey>> &multipleMeshes, bool recombine)
+{
+    std::vector<std::pair<MeshCombiner::Method, std::pair<MeshCombiner::Mesh *, CombinationKey>>> validMeshes;
+    for (const auto &it: multipleMeshes) {
+        MeshCombiner::Mesh *subMesh = std::get<0>(it);
+        if (nullptr == subMesh || subMesh->isNull()) {
+            delete subMesh;
+            qDebug() << "Child mesh is null";
+            continue;
+        }
+        if (!subMesh->isCombinable()) {
+            qDebug() << "Child mesh is uncombinable";
+            delete subMesh;
+            continue;
+        }
+        // The first mesh is the base of the combination, no matter what the combine mode is
+        auto combinerMethod = (!validMeshes.empty() && std::get<1>(it) == CombineMode::Inversion) ?
+            MeshCombiner::Method::Diff : MeshCombiner::Method::Union;
+        validMeshes.push_back({combinerMethod, {subMesh, std::get<2>(it)}});
+    }
+    
+    // Unions are associative, so each run of meshes sharing the same method is reduced in a balanced tree,
+    // a run of differences is reduced as the union of the subtrahends. The runs are then applied from left to right,
+    // so an inversion only ever removes from the meshes before it, as the left fold does.
+    std::pair<MeshCombiner::Mesh *, CombinationKey> combined = {nullptr, CombinationKey()};
+    for (size_t i = 0; i < validMeshes.size(); ) {
+        auto combinerMethod = validMeshes[i].first;
+        std::vector<std::pair<MeshCombiner::Mesh *, CombinationKey>> runMeshes;
+        for (; i < validMeshes.size() && validMeshes[i].first == combinerMethod; ++i)
+            runMeshes.push_back(validMeshes[i].second);
+        auto runCombined = combineMeshesInBalancedTree(componentIdString, runMeshes, recombine);
+        if (nullptr == combined.first) {
+            combined = runCombined;
+            continue;
+        }
+        combined = combineTwoMeshesWithCache(componentIdString, combined, runCombined, combinerMethod, recombine);
+    }
+    
+    if (nullptr != combined.first && combined.first->isNull()) {
+        delete combined.first;
+        combined.first = nullptr;
+    }
+    return combined.first;
+}
+
+std::pair<MeshCombiner::Mesh *, CombinationKey> MeshGenerator::combineMeshesInBalancedTree(const QString &componentIdString,
+    const std::vector<std::pair<MeshCombiner::Mesh *, CombinationKey>> &meshes,
+    bool recombine)
+{
+    if (meshes.empty())
+        return {nullptr, CombinationKey()};
+    
+    if (meshes.size() > 2) {
+        // Only the meshes with overlapping bounding boxes need the exact kernel, the groups are disjoint to each other
+        std::vector<const MeshCombiner::Mesh *> groupingMeshes(meshes.size());
+        for (size_t i = 0; i < meshes.size(); ++i)
+            groupingMeshes[i] = meshes[i].first;
+        std::vector<std::vector<size_t>> groups;
+        MeshCombiner::groupOverlappingMeshes(groupingMeshes, &groups);
+        if (groups.size() > 1 && groups.size() < meshes.size()) {
+            std::vector<std::pair<MeshCombiner::Mesh *, CombinationKey>> groupMeshes;
+            for (const auto &group: groups) {
+                std::vector<std::pair<MeshCombiner::Mesh *, CombinationKey>> meshesInGroup;
+                for (const auto &index: group)
+                    meshesInGroup.push_back(meshes[index]);
+                groupMeshes.push_back(combineMeshesInBalancedTree(componentIdString, meshesInGroup, recombine));
+            }
+            return combineMeshesInBalancedTree(componentIdString, groupMeshes, recombine);
+        }
+    }
+    
+    std::vector<std::pair<MeshCombiner::Mesh *, CombinationKey>> level = meshes;
+    while (level.size() > 1) {
+        std::vector<std::pair<MeshCombiner::Mesh *, CombinationKey>> nextLevel((level.size() + 1) / 2);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, level.size() / 2),
+            MeshPairsCombiner(this, &componentIdString, &level, recombine, &nextLevel));
+        if (0 != level.size() % 2)
+            nextLevel.back() = level.back();
+        level.swap(nextLevel);
+    }
+    return level.front();
+}
+
+std::pair<MeshCombiner::Mesh *, CombinationKey> MeshGenerator::combineTwoMeshesWithCache(const QString &componentIdString,
+    const std::pair<MeshCombiner::Mesh *, CombinationKey> &first,
+    const std::pair<MeshCombiner::Mesh *, CombinationKey> &second,
+    MeshCombiner::Method method,
+    bool recombine)
+{
+    // The key follows the pairing, so the same meshes combined in different trees never share an entry
+    CombinationKey combinationKey = CombinationKey::combine(first.second, second.second, method, recombine);
+    
+    if (isCancelled()) {
+        delete second.first;
+        return first;
+    }
+    
+    MeshCombiner::Mesh *newMesh = nullptr;
+    if (!m_cacheContext->findCachedCombination(combinationKey, &newMesh)) {
+        TraceSpan combineSpan("combineTwoMeshes");
+        combineSpan.addArgument("componentId", componentIdString);
+        newMesh = combineTwoMeshes(*first.first,
+            *second.first,
+            method,
+            recombine);
+        if (isCancelled()) {
+            // The operands may be incomplete
+        } else if (nullptr != newMesh) {
+            m_cacheContext->addCachedCombination(combinationKey, componentIdString, new MeshCombiner::Mesh(*newMesh));
+        } else {
+            m_cacheContext->addCachedCombination(combinationKey, componentIdString, nullptr);
+        }
+    }
+    
+    delete second.first;
+    if (nullptr == newMesh || newMesh->isNull()) {
+        m_isSuccessful = false;
+        qDebug() << "Mesh combine failed";
+        delete newMesh;
+        return first;
+    }
+    delete first.first;
+    return {newMesh, combinationKey};
+}
+
+MeshCombiner::Mesh *MeshGenerator::combineComponentChildGroupMesh(const QString &componentIdString,
+    const std::vector<QString> &childIdStrings,
+    GeneratedComponent &componentCache,
+    std::map<QString, std::pair<MeshCombiner::Mesh *, CombineMode>> *preparedChildMeshes)
 {
-    std::vector<std::tuple<MeshCombiner::Mesh *, CombineMode, QString>> multipleMeshes;
-    for (const auto &childIdString: componentIdStrings) {
+    std::vector<std::tuple<MeshCombiner::Mesh *, CombineMode, CombinationKey>> multipleMeshes;
+    for (const auto &childIdString: childIdStrings) {
         CombineMode childCombineMode = CombineMode::Normal;
-        MeshCombiner::Mesh *subMesh = combineComponentMesh(childIdString, &childCombineMode);
+        MeshCombiner::Mesh *subMesh = nullptr;
+        auto findPrepared = preparedChildMeshes->find(childIdString);
+        if (findPrepared != preparedChildMeshes->end()) {
+            subMesh = findPrepared->second.first;
+            childCombineMode = findPrepared->second.second;
+            preparedChildMeshes->erase(findPrepared);
+        } else {
+            subMesh = combineComponentMesh(childIdString, &childCombineMode);
+        }
         
         if (CombineMode::Uncombined == childCombineMode) {
             delete subMesh;
             continue;
         }
         
-        const auto &childComponentCache = m_cacheContext->components[childIdString];
+        const auto &childComponentCache = m_cacheContext->componentCache(childIdString);
         for (const auto &vertex: childComponentCache.noneSeamVertices)
             componentCache.noneSeamVertices.insert(vertex);
         for (const auto &it: childComponentCache.sharedQuadEdges)
@@ -1326,12 +2269,12 @@ MeshCombiner::Mesh *MeshGenerator::combineComponentChildGroupMesh(const std::vec
             continue;
         }
     
-        multipleMeshes.push_back(std::make_tuple(subMesh, childCombineMode, childIdString));
+        multipleMeshes.push_back(std::make_tuple(subMesh, childCombineMode, CombinationKey(childIdString, subMesh->contentHash())));
     }
-    return combineMultipleMeshes(multipleMeshes);
+    return combineMultipleMeshes(componentIdString, multipleMeshes, !m_coarseTierEnabled);
 }
 
-MeshCombiner::Mesh *MeshGenerator::combineTwoMeshes(const MeshCombiner::Mesh &first, const MeshCombiner::Mesh &second,
+MeshCombiner::Mesh *MeshGenerator::combineTwoMeshes(MeshCombiner::Mesh &first, MeshCombiner::Mesh &second,
     MeshCombiner::Method method,
     bool recombine)
 {
@@ -1344,13 +2287,20 @@ MeshCombiner::Mesh *MeshGenerator::combineTwoMeshes(const MeshCombiner::Mesh &fi
         &combinedVerticesSources);
     if (nullptr == newMesh)
         return nullptr;
-    if (!newMesh->isNull() && recombine) {
+    // Without any new vertex there is no seam to recombine, this is the case of the disjoint meshes
+    bool hasNewVertices = std::find_if(combinedVerticesSources.begin(), combinedVerticesSources.end(),
+            [](const std::pair<MeshCombiner::Source, size_t> &source) {
+        return MeshCombiner::Source::None == source.first;
+    }) != combinedVerticesSources.end();
+    if (!newMesh->isNull() && recombine && hasNewVertices) {
         MeshRecombiner recombiner;
         std::vector<QVector3D> combinedVertices;
         std::vector<std::vector<size_t>> combinedFaces;
         newMesh->fetch(combinedVertices, combinedFaces);
         recombiner.setVertices(&combinedVertices, &combinedVerticesSources);
         recombiner.setFaces(&combinedFaces);
+        TraceSpan recombineSpan("MeshRecombiner::recombine");
+        recombineSpan.addArgument("vertexCount", (qint64)combinedVertices.size());
         if (recombiner.recombine()) {
             if (isManifold(recombiner.regeneratedFaces())) {
                 MeshCombiner::Mesh *reMesh = new MeshCombiner::Mesh(recombiner.regeneratedVertices(), recombiner.regeneratedFaces(), false);
@@ -1385,7 +2335,7 @@ void MeshGenerator::makeXmirror(const std::vector<QVector3D> &sourceVertices, co
 }
 
 void MeshGenerator::collectSharedQuadEdges(const std::vector<QVector3D> &vertices, const std::vector<std::vector<size_t>> &faces,
-        std::set<std::pair<PositionKey, PositionKey>> *sharedQuadEdges)
+        OpenHashSet<std::pair<PositionKey, PositionKey>> *sharedQuadEdges)
 {
     for (const auto &face: faces) {
         if (face.size() != 4)
@@ -1423,6 +2373,31 @@ void MeshGenerator::setWeldEnabled(bool enabled)
     m_weldEnabled = enabled;
 }
 
+void MeshGenerator::setBalancedCombinationEnabled(bool enabled)
+{
+    m_balancedCombinationEnabled = enabled;
+}
+
+void MeshGenerator::setDiskCache(GeneratedDiskCache *diskCache)
+{
+    m_diskCache = diskCache;
+}
+
+void MeshGenerator::setSdfPreviewEnabled(bool enabled)
+{
+    m_sdfPreviewEnabled = enabled;
+}
+
+void MeshGenerator::setCoarseTierEnabled(bool enabled)
+{
+    m_coarseTierEnabled = enabled;
+}
+
+void MeshGenerator::setAccurateClothCollisionEnabled(bool enabled)
+{
+    m_accurateClothCollisionEnabled = enabled;
+}
+
 void MeshGenerator::collectErroredParts()
 {
     for (const auto &it: m_cacheContext->parts) {
@@ -1430,22 +2405,11 @@ void MeshGenerator::collectErroredParts()
             if (!it.second.joined)
                 continue;
             
-            auto updateVertexIndices = [=](std::vector<std::vector<size_t>> &faces, size_t vertexStartIndex) {
-                for (auto &it: faces) {
-                    for (auto &subIt: it)
-                        subIt += vertexStartIndex;
-                }
-            };
-            
-            auto errorTriangleAndQuads = it.second.faces;
-            updateVertexIndices(errorTriangleAndQuads, m_object->vertices.size());
+            m_object->triangleAndQuads.append(it.second.faces, m_object->vertices.size());
             m_object->vertices.insert(m_object->vertices.end(), it.second.vertices.begin(), it.second.vertices.end());
-            m_object->triangleAndQuads.insert(m_object->triangleAndQuads.end(), errorTriangleAndQuads.begin(), errorTriangleAndQuads.end());
             
-            auto errorTriangles = it.second.previewTriangles;
-            updateVertexIndices(errorTriangles, m_object->vertices.size());
+            m_object->triangles.append(it.second.previewTriangles, m_object->vertices.size());
             m_object->vertices.insert(m_object->vertices.end(), it.second.previewVertices.begin(), it.second.previewVertices.end());
-            m_object->triangles.insert(m_object->triangles.end(), errorTriangles.begin(), errorTriangles.end());
         }
     }
 }
@@ -1463,6 +2427,9 @@ void MeshGenerator::postprocessObject(Object *object)
     
     object->triangleNormals = combinedFacesNormals;
     
+    // Built once here, for the later stages walking the triangle neighbors
+    object->buildTriangleHalfEdges();
+    
     std::vector<std::pair<QUuid, QUuid>> sourceNodes;
     triangleSourceNodeResolve(*object, m_nodeVertices, sourceNodes, &object->vertexSourceNodes);
     object->setTriangleSourceNodes(sourceNodes);
@@ -1488,7 +2455,11 @@ void MeshGenerator::postprocessObject(Object *object)
     object->setTriangleVertexNormals(triangleVertexNormals);
 }
 
-void MeshGenerator::remesh(const std::vector<ObjectNode> &inputNodes,
+// The remeshed component is reused when only the attributes that do not change the combined mesh are edited,
+// such as the color, the input is hashed instead of compared, so the previous input does not need to be kept.
+// Returns false if the generation is cancelled during the remeshing
+bool MeshGenerator::remesh(GeneratedComponent &componentCache,
+        const std::vector<ObjectNode> &inputNodes,
         const std::vector<std::tuple<QVector3D, float, size_t>> &interpolatedNodes,
         const std::vector<QVector3D> &inputVertices,
         const std::vector<std::vector<size_t>> &inputFaces,
@@ -1507,10 +2478,38 @@ void MeshGenerator::remesh(const std::vector<ObjectNode> &inputNodes,
         const auto &sourceNode = inputNodes[std::get<2>(it)];
         sourceIds.push_back(std::make_pair(sourceNode.partId, sourceNode.nodeId));
     }
+    
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData((const char *)&targetVertexMultiplyFactor, sizeof(targetVertexMultiplyFactor));
+    hash.addData((const char *)inputVertices.data(), (int)(inputVertices.size() * sizeof(QVector3D)));
+    for (const auto &face: inputFaces) {
+        quint32 faceSize = (quint32)face.size();
+        hash.addData((const char *)&faceSize, sizeof(faceSize));
+        hash.addData((const char *)face.data(), (int)(face.size() * sizeof(size_t)));
+    }
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        hash.addData((const char *)&nodes[i].first, sizeof(QVector3D));
+        hash.addData((const char *)&nodes[i].second, sizeof(float));
+        hash.addData(sourceIds[i].first.toRfc4122());
+        hash.addData(sourceIds[i].second.toRfc4122());
+    }
+    QByteArray inputHash = hash.result();
+    if (inputHash == componentCache.remeshInputHash) {
+        *outputVertices = componentCache.remeshedVertices;
+        *outputQuads = componentCache.remeshedQuads;
+        *outputTriangles = componentCache.remeshedTriangles;
+        *outputNodeVertices = componentCache.remeshedNodeVertices;
+        return true;
+    }
+    
     Remesher remesher;
     remesher.setMesh(inputVertices, inputFaces);
     remesher.setNodes(nodes, sourceIds);
-    remesher.remesh(targetVertexMultiplyFactor);
+    // One core is left to the other jobs, the remeshing would take all of them otherwise
+    remesher.setThreadCount(std::max(QThread::idealThreadCount() - 1, 1));
+    remesher.setCancelFlag(&m_isCancelled);
+    if (!remesher.remesh(targetVertexMultiplyFactor))
+        return false;
     *outputVertices = remesher.getRemeshedVertices();
     const auto &remeshedFaces = remesher.getRemeshedFaces();
     *outputQuads = remeshedFaces;
@@ -1535,6 +2534,13 @@ void MeshGenerator::remesh(const std::vector<ObjectNode> &inputNodes,
             continue;
         outputNodeVertices->push_back(std::make_pair((*outputVertices)[i], vertexSource));
     }
+    
+    componentCache.remeshInputHash = inputHash;
+    componentCache.remeshedVertices = *outputVertices;
+    componentCache.remeshedQuads = *outputQuads;
+    componentCache.remeshedTriangles = *outputTriangles;
+    componentCache.remeshedNodeVertices = *outputNodeVertices;
+    return true;
 }
 
 void MeshGenerator::collectIncombinableComponentMeshes(const QString &componentIdString)
@@ -1547,9 +2553,8 @@ void MeshGenerator::collectIncombinableComponentMeshes(const QString &componentI
         m_isSuccessful = false;
         collectIncombinableMesh(mesh, componentCache);
     }
-    for (const auto &childIdString: valueOfKeyInMapOrEmpty(*component, "children").split(",")) {
-        if (childIdString.isEmpty())
-            continue;
+    for (const auto &childIndex: component->childIndices) {
+        const QString &childIdString = m_compiledSnapshot.components[childIndex].idString;
         collectIncombinableComponentMeshes(childIdString);
     }
 }
@@ -1562,23 +2567,14 @@ void MeshGenerator::collectIncombinableMesh(const MeshCombiner::Mesh *mesh, cons
     std::vector<QVector3D> uncombinedVertices;
     std::vector<std::vector<size_t>> uncombinedFaces;
     mesh->fetch(uncombinedVertices, uncombinedFaces);
-    std::vector<std::vector<size_t>> uncombinedTriangleAndQuads;
+    FaceList uncombinedTriangleAndQuads;
     
     recoverQuads(uncombinedVertices, uncombinedFaces, componentCache.sharedQuadEdges, uncombinedTriangleAndQuads);
     
     auto vertexStartIndex = m_object->vertices.size();
-    auto updateVertexIndices = [=](std::vector<std::vector<size_t>> &faces) {
-        for (auto &it: faces) {
-            for (auto &subIt: it)
-                subIt += vertexStartIndex;
-        }
-    };
-    updateVertexIndices(uncombinedFaces);
-    updateVertexIndices(uncombinedTriangleAndQuads);
-    
     m_object->vertices.insert(m_object->vertices.end(), uncombinedVertices.begin(), uncombinedVertices.end());
-    m_object->triangles.insert(m_object->triangles.end(), uncombinedFaces.begin(), uncombinedFaces.end());
-    m_object->triangleAndQuads.insert(m_object->triangleAndQuads.end(), uncombinedTriangleAndQuads.begin(), uncombinedTriangleAndQuads.end());
+    m_object->triangles.append(uncombinedFaces, vertexStartIndex);
+    m_object->triangleAndQuads.append(uncombinedTriangleAndQuads, vertexStartIndex);
 }
 
 void MeshGenerator::collectUncombinedComponent(const QString &componentIdString)
@@ -1600,9 +2596,8 @@ void MeshGenerator::collectUncombinedComponent(const QString &componentIdString)
         collectIncombinableMesh(componentCache.mesh, componentCache);
         return;
     }
-    for (const auto &childIdString: valueOfKeyInMapOrEmpty(*component, "children").split(",")) {
-        if (childIdString.isEmpty())
-            continue;
+    for (const auto &childIndex: component->childIndices) {
+        const QString &childIdString = m_compiledSnapshot.components[childIndex].idString;
         collectUncombinedComponent(childIdString);
     }
 }
@@ -1619,9 +2614,8 @@ void MeshGenerator::collectClothComponentIdStrings(const QString &componentIdStr
         componentIdStrings->push_back(componentIdString);
         return;
     }
-    for (const auto &childIdString: valueOfKeyInMapOrEmpty(*component, "children").split(",")) {
-        if (childIdString.isEmpty())
-            continue;
+    for (const auto &childIndex: component->childIndices) {
+        const QString &childIdString = m_compiledSnapshot.components[childIndex].idString;
         collectClothComponentIdStrings(childIdString, componentIdStrings);
     }
 }
@@ -1633,11 +2627,13 @@ void MeshGenerator::collectClothComponent(const QString &componentIdString)
     
     std::vector<QString> componentIdStrings;
     collectClothComponentIdStrings(componentIdString, &componentIdStrings);
+    if (componentIdStrings.empty())
+        return;
     
     std::vector<ClothMesh> clothMeshes(componentIdStrings.size());
     for (size_t i = 0; i < componentIdStrings.size(); ++i) {
         const auto &componentIdString = componentIdStrings[i];
-        const auto &componentCache = m_cacheContext->components[componentIdString];
+        auto &componentCache = m_cacheContext->components[componentIdString];
         if (nullptr == componentCache.mesh) {
             return;
         }
@@ -1649,6 +2645,7 @@ void MeshGenerator::collectClothComponent(const QString &componentIdString)
         clothMesh.clothStiffness = componentClothStiffness(component);
         clothMesh.clothIteration = componentClothIteration(component);
         clothMesh.objectNodeVertices = &componentCache.objectNodeVertices;
+        clothMesh.simulationState = &componentCache.clothSimulationState;
         //m_object->clothNodes.insert(m_object->clothNodes.end(), componentCache.objectNodes.begin(), componentCache.objectNodes.end());
         //m_object->nodes.insert(m_object->nodes.end(), componentCache.objectNodes.begin(), componentCache.objectNodes.end());
         for (const auto &objectNode: componentCache.objectNodes) {
@@ -1658,32 +2655,44 @@ void MeshGenerator::collectClothComponent(const QString &componentIdString)
         }
         m_object->edges.insert(m_object->edges.end(), componentCache.objectEdges.begin(), componentCache.objectEdges.end());
     }
-    simulateClothMeshes(&clothMeshes,
-        &m_clothCollisionVertices,
-        &m_clothCollisionTriangles);
+    {
+        TraceSpan simulateSpan("simulateClothMeshes");
+        if (simulateSpan.isEnabled()) {
+            size_t clothVertexCount = 0;
+            for (const auto &clothMesh: clothMeshes)
+                clothVertexCount += clothMesh.vertices.size();
+            simulateSpan.addArgument("componentIds", joinComponentIds(std::set<QString>(componentIdStrings.begin(), componentIdStrings.end())));
+            simulateSpan.addArgument("clothVertexCount", (qint64)clothVertexCount);
+            simulateSpan.addArgument("collisionVertexCount", (qint64)m_clothCollisionVertices.size());
+        }
+        simulateSpan.addArgument("accurateCollision", (qint64)m_accurateClothCollisionEnabled);
+        auto previousClothCollisionShape = m_cacheContext->clothCollisionShape;
+        auto clothCollisionShape = prepareClothCollisionShape();
+        simulateSpan.addArgument("collisionShapeCached", (qint64)(nullptr != previousClothCollisionShape && previousClothCollisionShape == clothCollisionShape));
+        simulateClothMeshes(&clothMeshes, clothCollisionShape);
+        if (simulateSpan.isEnabled()) {
+            size_t simulatedIteration = 0;
+            for (const auto &clothMesh: clothMeshes)
+                simulatedIteration += clothMesh.simulatedIteration;
+            simulateSpan.addArgument("simulatedIteration", (qint64)simulatedIteration);
+        }
+    }
     for (auto &clothMesh: clothMeshes) {
         auto vertexStartIndex = m_object->vertices.size();
-        auto updateVertexIndices = [=](std::vector<std::vector<size_t>> &faces) {
-            for (auto &it: faces) {
-                for (auto &subIt: it)
-                    subIt += vertexStartIndex;
-            }
-        };
-        updateVertexIndices(clothMesh.faces);
         m_object->vertices.insert(m_object->vertices.end(), clothMesh.vertices.begin(), clothMesh.vertices.end());
         for (const auto &it: clothMesh.faces) {
             if (4 == it.size()) {
-                m_object->triangles.push_back(std::vector<size_t> {
-                    it[0], it[1], it[2]
+                m_object->triangles.push_back({
+                    it[0] + vertexStartIndex, it[1] + vertexStartIndex, it[2] + vertexStartIndex
                 });
-                m_object->triangles.push_back(std::vector<size_t> {
-                    it[2], it[3], it[0]
+                m_object->triangles.push_back({
+                    it[2] + vertexStartIndex, it[3] + vertexStartIndex, it[0] + vertexStartIndex
                 });
             } else if (3 == it.size()) {
-                m_object->triangles.push_back(it);
+                m_object->triangles.push_back(it.begin(), it.end(), vertexStartIndex);
             }
         }
-        m_object->triangleAndQuads.insert(m_object->triangleAndQuads.end(), clothMesh.faces.begin(), clothMesh.faces.end());
+        m_object->triangleAndQuads.append(clothMesh.faces, vertexStartIndex);
         for (size_t i = 0; i < clothMesh.vertices.size(); ++i) {
             const auto &source = clothMesh.vertexSources[i];
             m_nodeVertices.push_back(std::make_pair(clothMesh.vertices[i], source));
@@ -1691,7 +2700,27 @@ void MeshGenerator::collectClothComponent(const QString &componentIdString)
     }
 }
 
-void MeshGenerator::generateSmoothTriangleVertexNormals(const std::vector<QVector3D> &vertices, const std::vector<std::vector<size_t>> &triangles,
+std::shared_ptr<const ClothCollisionShape> MeshGenerator::prepareClothCollisionShape()
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData((const char *)&m_accurateClothCollisionEnabled, sizeof(m_accurateClothCollisionEnabled));
+    hash.addData((const char *)m_clothCollisionVertices.data(), (int)(m_clothCollisionVertices.size() * sizeof(QVector3D)));
+    for (const auto &triangle: m_clothCollisionTriangles)
+        hash.addData((const char *)triangle.data(), (int)(triangle.size() * sizeof(size_t)));
+    QByteArray shapeHash = hash.result();
+    if (nullptr != m_cacheContext->clothCollisionShape && shapeHash == m_cacheContext->clothCollisionShapeHash)
+        return m_cacheContext->clothCollisionShape;
+    
+    TraceSpan span("buildClothCollisionShape");
+    span.addArgument("accurate", (qint64)m_accurateClothCollisionEnabled);
+    span.addArgument("triangleCount", (qint64)m_clothCollisionTriangles.size());
+    m_cacheContext->clothCollisionShapeHash = shapeHash;
+    m_cacheContext->clothCollisionShape = std::make_shared<const ClothCollisionShape>(m_clothCollisionVertices,
+        m_clothCollisionTriangles, m_accurateClothCollisionEnabled);
+    return m_cacheContext->clothCollisionShape;
+}
+
+void MeshGenerator::generateSmoothTriangleVertexNormals(const std::vector<QVector3D> &vertices, const FaceList &triangles,
     const std::vector<QVector3D> &triangleNormals,
     std::vector<std::vector<QVector3D>> *triangleVertexNormals)
 {
@@ -1752,9 +2781,9 @@ void MeshGenerator::preprocessMirror()
         
         //qDebug() << "Added part:" << newPartIdString << "by mirror from:" << mirroredPart["id"];
         
+        // The clone keeps the dirty flag of its source, it is derived from the source mesh, so it only changes with the source
         mirroredPart["__mirrorFromPartId"] = mirroredPart["id"];
         mirroredPart["id"] = newPartIdString;
-        mirroredPart["__dirty"] = "true";
         newParts.push_back(mirroredPart);
     }
     
@@ -1791,7 +2820,6 @@ void MeshGenerator::preprocessMirror()
         //qDebug() << "Added component:" << newComponentIdString << "by mirror from:" << valueOfKeyInMapOrEmpty(componentIt.second, "id");
         mirroredComponent["linkData"] = findPart->second;
         mirroredComponent["id"] = newComponentIdString;
-        mirroredComponent["__dirty"] = "true";
         parentMap[newComponentIdString] = parentMap[valueOfKeyInMapOrEmpty(componentIt.second, "id")];
         //qDebug() << "Update component:" << newComponentIdString << "parent to:" << parentMap[valueOfKeyInMapOrEmpty(componentIt.second, "id")];
         newComponents.push_back(mirroredComponent);
@@ -1814,6 +2842,23 @@ void MeshGenerator::preprocessMirror()
     }
 }
 
+void MeshGenerator::finishCancelledGeneration(bool needDeleteCacheContext)
+{
+    m_isSuccessful = false;
+    
+    delete m_object;
+    m_object = nullptr;
+    
+    if (needDeleteCacheContext) {
+        delete m_cacheContext;
+        m_cacheContext = nullptr;
+    }
+    
+    qDebug() << "The mesh generation cancelled";
+    
+    Tracer::instance().flush();
+}
+
 void MeshGenerator::generate()
 {
     if (nullptr == m_snapshot)
@@ -1824,22 +2869,50 @@ void MeshGenerator::generate()
     QElapsedTimer countTimeConsumed;
     countTimeConsumed.start();
     
-    m_mainProfileMiddleX = valueOfKeyInMapOrEmpty(m_snapshot->canvas, "originX").toFloat();
-    m_mainProfileMiddleY = valueOfKeyInMapOrEmpty(m_snapshot->canvas, "originY").toFloat();
-    m_sideProfileMiddleX = valueOfKeyInMapOrEmpty(m_snapshot->canvas, "originZ").toFloat();
+    TraceSpan span("MeshGenerator::generate");
+    span.addArgument("meshId", (qint64)m_id);
     
     preprocessMirror();
     
+    m_compiledSnapshot.compile(*m_snapshot);
+    if (m_coarseTierEnabled)
+        coarsenCutTemplates();
+    m_mainProfileMiddleX = m_compiledSnapshot.mainProfileMiddleX;
+    m_mainProfileMiddleY = m_compiledSnapshot.mainProfileMiddleY;
+    m_sideProfileMiddleX = m_compiledSnapshot.sideProfileMiddleX;
+    span.addArgument("partCount", (qint64)m_compiledSnapshot.parts.size());
+    span.addArgument("componentCount", (qint64)m_compiledSnapshot.components.size());
+    
     m_object = new Object;
     m_object->meshId = m_id;
+    
+    // The preview leaves the cache context untouched, the exact generation of the same snapshot follows and needs the dirty flags
+    if (m_sdfPreviewEnabled) {
+        generateSdfPreview();
+        m_resultMesh = new Model(*m_object);
+        qDebug() << "The mesh preview generation took" << countTimeConsumed.elapsed() << "milliseconds";
+        span.addArgument("sdfPreview", 1);
+        span.addArgument("vertexCount", (qint64)m_object->vertices.size());
+        span.end();
+        Tracer::instance().flush();
+        return;
+    }
     //m_cutFaceTransforms = new std::map<QUuid, nodemesh::Builder::CutFaceTransform>;
     //m_nodesCutFaces = new std::map<QUuid, std::map<QString, QVector2D>>;
     
     bool needDeleteCacheContext = false;
+    std::vector<GeneratedCacheContext *> tierCacheContexts;
     if (nullptr == m_cacheContext) {
         m_cacheContext = new GeneratedCacheContext;
         needDeleteCacheContext = true;
+        tierCacheContexts.push_back(m_cacheContext);
     } else {
+        tierCacheContexts.push_back(m_cacheContext);
+        if (m_coarseTierEnabled)
+            m_cacheContext = &m_cacheContext->coarseTier();
+        if (nullptr != tierCacheContexts[0]->existingCoarseTier())
+            tierCacheContexts.push_back(tierCacheContexts[0]->existingCoarseTier());
+        
         //qDebug() << "m_cacheContext->parts.size:" << m_cacheContext->parts.size();
         //qDebug() << "m_cacheContext->components.size:" << m_cacheContext->components.size();
         //qDebug() << "m_cacheContext->cachedCombination.size:" << m_cacheContext->cachedCombination.size();
@@ -1863,15 +2936,7 @@ void MeshGenerator::generate()
         }
         for (auto it = m_cacheContext->components.begin(); it != m_cacheContext->components.end(); ) {
             if (m_snapshot->components.find(it->first) == m_snapshot->components.end()) {
-                for (auto combinationIt = m_cacheContext->cachedCombination.begin(); combinationIt != m_cacheContext->cachedCombination.end(); ) {
-                    if (-1 != combinationIt->first.indexOf(it->first)) {
-                        //qDebug() << "Removed cached combination:" << combinationIt->first;
-                        delete combinationIt->second;
-                        combinationIt = m_cacheContext->cachedCombination.erase(combinationIt);
-                        continue;
-                    }
-                    combinationIt++;
-                }
+                m_cacheContext->removeCachedCombinationsOfComponent(it->first);
                 it->second.releaseMeshes();
                 it = m_cacheContext->components.erase(it);
                 continue;
@@ -1880,27 +2945,42 @@ void MeshGenerator::generate()
         }
     }
     
-    collectParts();
     checkDirtyFlags();
     
+    if (nullptr != m_diskCache) {
+        std::map<size_t, QByteArray> partContentHashes;
+        hashComponentContent(0, &partContentHashes);
+    }
+    
+    // The owner resets the dirty flags once the snapshot is taken, so the meshes of the dirty components are released now,
+    // a cancelled generation then leaves them to be rebuilt by the next one instead of being reused as clean,
+    // the same goes for the other tier, which is generated from a later snapshot
     for (const auto &dirtyComponentId: m_dirtyComponentIds) {
-        for (auto combinationIt = m_cacheContext->cachedCombination.begin(); combinationIt != m_cacheContext->cachedCombination.end(); ) {
-            if (-1 != combinationIt->first.indexOf(dirtyComponentId)) {
-                //qDebug() << "Removed dirty cached combination:" << combinationIt->first;
-                delete combinationIt->second;
-                combinationIt = m_cacheContext->cachedCombination.erase(combinationIt);
-                continue;
-            }
-            combinationIt++;
+        for (auto &cacheContext: tierCacheContexts) {
+            cacheContext->removeCachedCombinationsOfComponent(dirtyComponentId);
+            auto findComponentCache = cacheContext->components.find(dirtyComponentId);
+            if (findComponentCache != cacheContext->components.end())
+                findComponentCache->second.releaseMeshes();
         }
     }
     
     m_dirtyComponentIds.insert(QUuid().toString());
     
-    bool remeshed = componentRemeshed(&m_snapshot->canvas);
+    bool remeshed = !m_coarseTierEnabled && componentRemeshed(&m_compiledSnapshot.canvas);
+    
+    preparePartMeshes();
     
     CombineMode combineMode;
     auto combinedMesh = combineComponentMesh(QUuid().toString(), &combineMode);
+    releasePreparedPartMeshes();
+    
+    if (isCancelled()) {
+        delete combinedMesh;
+        span.addArgument("cancelled", 1);
+        span.end();
+        finishCancelledGeneration(needDeleteCacheContext);
+        return;
+    }
     
     const auto &componentCache = m_cacheContext->components[QUuid().toString()];
     
@@ -1914,23 +2994,21 @@ void MeshGenerator::generate()
         combinedMesh->fetch(combinedVertices, combinedFaces);
         if (m_weldEnabled) {
             if (!remeshed) {
-                size_t totalAffectedNum = 0;
-                size_t affectedNum = 0;
-                do {
-                    std::vector<QVector3D> weldedVertices;
-                    std::vector<std::vector<size_t>> weldedFaces;
-                    affectedNum = weldSeam(combinedVertices, combinedFaces,
-                        0.025, componentCache.noneSeamVertices,
-                        weldedVertices, weldedFaces);
-                    combinedVertices = weldedVertices;
-                    combinedFaces = weldedFaces;
-                    totalAffectedNum += affectedNum;
-                } while (affectedNum > 0);
+                TraceSpan weldSpan("weldSeam");
+                weldSpan.addArgument("vertexCount", (qint64)combinedVertices.size());
+                std::vector<QVector3D> weldedVertices;
+                std::vector<std::vector<size_t>> weldedFaces;
+                size_t affectedNum = weldSeam(combinedVertices, combinedFaces,
+                    0.025, componentCache.noneSeamVertices,
+                    weldedVertices, weldedFaces);
+                weldSpan.addArgument("affectedCount", (qint64)affectedNum);
+                combinedVertices.swap(weldedVertices);
+                combinedFaces.swap(weldedFaces);
             }
         }
         recoverQuads(combinedVertices, combinedFaces, componentCache.sharedQuadEdges, m_object->triangleAndQuads);
         m_object->vertices = combinedVertices;
-        m_object->triangles = combinedFaces;
+        m_object->triangles.append(combinedFaces);
     }
     
     // Recursively check uncombined components
@@ -1956,17 +3034,45 @@ void MeshGenerator::generate()
     //}
     
     collectClothComponent(QUuid().toString());
+    
+    if (isCancelled()) {
+        delete combinedMesh;
+        span.addArgument("cancelled", 1);
+        span.end();
+        finishCancelledGeneration(needDeleteCacheContext);
+        return;
+    }
+    
     collectErroredParts();
-    postprocessObject(m_object);
+    {
+        TraceSpan postprocessSpan("postprocessObject");
+        postprocessSpan.addArgument("vertexCount", (qint64)m_object->vertices.size());
+        postprocessSpan.addArgument("triangleCount", (qint64)m_object->triangles.size());
+        postprocessObject(m_object);
+    }
     
     m_resultMesh = new Model(*m_object);
     
     delete combinedMesh;
 
+    qDebug() << "Cached combinations:" << m_cacheContext->cachedCombination.size()
+        << "hits:" << m_cacheContext->combinationHitCount
+        << "misses:" << m_cacheContext->combinationMissCount
+        << "evictions:" << m_cacheContext->combinationEvictionCount;
+    if (nullptr != m_diskCache) {
+        qDebug() << "Disk cache hits:" << m_diskCache->hitCount
+            << "misses:" << m_diskCache->missCount
+            << "evictions:" << m_diskCache->evictionCount;
+    }
+
     if (needDeleteCacheContext) {
         delete m_cacheContext;
         m_cacheContext = nullptr;
     }
     
     qDebug() << "The mesh generation took" << countTimeConsumed.elapsed() << "milliseconds";
+    
+    span.addArgument("vertexCount", (qint64)m_object->vertices.size());
+    span.end();
+    Tracer::instance().flush();
 }
@@ -4,15 +4,25 @@
 #include <set>
 #include <QColor>
 #include <tuple>
+#include <atomic>
+#include <memory>
+#include <QMutex>
+#include <QMutexLocker>
 #include "meshcombiner.h"
 #include "positionkey.h"
+#include "openhashmap.h"
 #include "strokemeshbuilder.h"
 #include "object.h"
 #include "snapshot.h"
+#include "compiledsnapshot.h"
 #include "combinemode.h"
 #include "model.h"
 #include "componentlayer.h"
 #include "clothforce.h"
+#include "parttarget.h"
+#include "generateddiskcache.h"
+#include "sdfmeshbuilder.h"
+#include "simulateclothmeshes.h"
 
 class GeneratedPart
 {
@@ -55,11 +65,44 @@ public:
     }
     MeshCombiner::Mesh *mesh = nullptr;
     std::vector<MeshCombiner::Mesh *> incombinableMeshes;
-    std::set<std::pair<PositionKey, PositionKey>> sharedQuadEdges;
-    std::set<PositionKey> noneSeamVertices;
+    OpenHashSet<std::pair<PositionKey, PositionKey>> sharedQuadEdges;
+    OpenHashSet<PositionKey> noneSeamVertices;
     std::vector<ObjectNode> objectNodes;
     std::vector<std::pair<std::pair<QUuid, QUuid>, std::pair<QUuid, QUuid>>> objectEdges;
     std::vector<std::pair<QVector3D, std::pair<QUuid, QUuid>>> objectNodeVertices;
+    // The last remeshing result, kept across the releases of the meshes and reused while the input is the same
+    QByteArray remeshInputHash;
+    std::vector<QVector3D> remeshedVertices;
+    std::vector<std::vector<size_t>> remeshedQuads;
+    std::vector<std::vector<size_t>> remeshedTriangles;
+    std::vector<std::pair<QVector3D, std::pair<QUuid, QUuid>>> remeshedNodeVertices;
+    // The last cloth simulation of this component, kept the same way, to reuse or warm start the next one
+    ClothSimulationState clothSimulationState;
+};
+
+class CombinationKey
+{
+public:
+    CombinationKey() = default;
+    explicit CombinationKey(const QString &componentIdString, quint64 meshContentHash=0);
+    // The content of a group is the content of its combined mesh
+    static CombinationKey group(const std::vector<CombinationKey> &keys, const MeshCombiner::Mesh &mesh);
+    static CombinationKey combine(const CombinationKey &first, const CombinationKey &second,
+        MeshCombiner::Method method, bool recombine);
+    
+    // The hash is built from the structure of the combination: the leaves hash the component ids,
+    // each combination hashes the hashes of its operands, the method and the recombine flag
+    quint64 hash = 0;
+    // Built the same way from the content hashes of the leaf meshes, so a cached combination is only reused
+    // for the same operands, whatever the hash of the structure collides with
+    quint64 contentHash = 0;
+};
+
+class CachedCombination
+{
+public:
+    MeshCombiner::Mesh *mesh = nullptr;
+    quint64 contentHash = 0;
 };
 
 class GeneratedCacheContext
@@ -68,18 +111,115 @@ public:
     ~GeneratedCacheContext()
     {
         for (auto &it: cachedCombination)
-            delete it.second;
+            delete it.second.mesh;
         for (auto &it: parts)
             it.second.releaseMeshes();
         for (auto &it: components)
             it.second.releaseMeshes();
+        delete m_coarseTier;
+    }
+    
+    // The component tree is combined concurrently, each component (and the part it links) is written by one task only,
+    // so the mutex only protects the structure of the maps, the returned references stay valid until the entry is erased
+    GeneratedComponent &componentCache(const QString &componentIdString)
+    {
+        QMutexLocker locker(&m_mutex);
+        return components[componentIdString];
+    }
+    GeneratedPart &partCache(const QString &partIdString)
+    {
+        QMutexLocker locker(&m_mutex);
+        return parts[partIdString];
+    }
+    // The coarse tier is cached apart from the full one, under the same ids; created on the first coarse generation
+    GeneratedCacheContext &coarseTier()
+    {
+        QMutexLocker locker(&m_mutex);
+        if (nullptr == m_coarseTier)
+            m_coarseTier = new GeneratedCacheContext;
+        return *m_coarseTier;
+    }
+    GeneratedCacheContext *existingCoarseTier()
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_coarseTier;
     }
+    bool findCachedCombination(const CombinationKey &combinationKey, MeshCombiner::Mesh **mesh)
+    {
+        QMutexLocker locker(&m_mutex);
+        auto findCached = cachedCombination.find(combinationKey.hash);
+        if (findCached == cachedCombination.end() ||
+                findCached->second.contentHash != combinationKey.contentHash) {
+            ++combinationMissCount;
+            return false;
+        }
+        ++combinationHitCount;
+        *mesh = nullptr == findCached->second.mesh ? nullptr : new MeshCombiner::Mesh(*findCached->second.mesh);
+        return true;
+    }
+    // The combination is indexed by the component whose children it combines, which is dirty whenever any of them is
+    void addCachedCombination(const CombinationKey &combinationKey, const QString &componentIdString, MeshCombiner::Mesh *mesh)
+    {
+        QMutexLocker locker(&m_mutex);
+        auto findCached = cachedCombination.find(combinationKey.hash);
+        if (findCached != cachedCombination.end()) {
+            if (findCached->second.contentHash == combinationKey.contentHash) {
+                delete mesh;
+                return;
+            }
+            // The operands have changed or the hash collides, the newer combination wins
+            removeCachedCombination(findCached);
+        }
+        auto &cached = cachedCombination[combinationKey.hash];
+        cached.mesh = mesh;
+        cached.contentHash = combinationKey.contentHash;
+        componentCombinations[componentIdString].insert(combinationKey.hash);
+    }
+    void removeCachedCombinationsOfComponent(const QString &componentIdString)
+    {
+        QMutexLocker locker(&m_mutex);
+        auto findCombinations = componentCombinations.find(componentIdString);
+        if (findCombinations == componentCombinations.end())
+            return;
+        std::set<quint64> hashes;
+        hashes.swap(findCombinations->second);
+        componentCombinations.erase(findCombinations);
+        for (const auto &hash: hashes) {
+            auto findCached = cachedCombination.find(hash);
+            if (findCached == cachedCombination.end())
+                continue;
+            removeCachedCombination(findCached);
+        }
+    }
+    
     std::map<QString, GeneratedComponent> components;
     std::map<QString, GeneratedPart> parts;
     std::map<QString, QString> partMirrorIdMap;
-    std::map<QString, MeshCombiner::Mesh *> cachedCombination;
+    std::map<quint64, CachedCombination> cachedCombination;
+    std::map<QString, std::set<quint64>> componentCombinations;
+    size_t combinationHitCount = 0;
+    size_t combinationMissCount = 0;
+    size_t combinationEvictionCount = 0;
+    // The collision shape of the last body the cloth was simulated against, rebuilt only when the body changes
+    QByteArray clothCollisionShapeHash;
+    std::shared_ptr<const ClothCollisionShape> clothCollisionShape;
+    
+private:
+    QMutex m_mutex;
+    GeneratedCacheContext *m_coarseTier = nullptr;
+    
+    // The hash is left in the index, the same structure is only ever combined under the same component,
+    // and a hash without its combination is skipped on the removal
+    void removeCachedCombination(std::map<quint64, CachedCombination>::iterator cachedIt)
+    {
+        delete cachedIt->second.mesh;
+        cachedCombination.erase(cachedIt);
+        ++combinationEvictionCount;
+    }
 };
 
+struct FillMeshCacheEntry;
+
 class MeshGenerator : public QObject
 {
     Q_OBJECT
@@ -99,6 +239,14 @@ public:
     void setDefaultPartColor(const QColor &color);
     void setId(quint64 id);
     void setWeldEnabled(bool enabled);
+    // Off by default, combining in the sequential order; only the document opts in to the balanced order
+    void setBalancedCombinationEnabled(bool enabled);
+    void setDiskCache(GeneratedDiskCache *diskCache);
+    void setSdfPreviewEnabled(bool enabled);
+    void setCoarseTierEnabled(bool enabled);
+    void setAccurateClothCollisionEnabled(bool enabled);
+    void cancel();
+    bool isCancelled();
     quint64 id();
 signals:
     void finished();
@@ -106,9 +254,23 @@ public slots:
     void process();
     
 private:
+    friend class ComponentChildMeshesCombiner;
+    friend class MeshPairsCombiner;
+    friend class PartMeshesPreparer;
+    
+    struct PreparedPartMesh
+    {
+        bool isPrepared = false;
+        bool hasError = false;
+        MeshCombiner::Mesh *mesh = nullptr;
+    };
+    
     QColor m_defaultPartColor = Qt::white;
     Snapshot *m_snapshot = nullptr;
+    CompiledSnapshot m_compiledSnapshot;
     GeneratedCacheContext *m_cacheContext = nullptr;
+    GeneratedDiskCache *m_diskCache = nullptr;
+    std::map<QString, QByteArray> m_componentContentHashes;
     std::set<QString> m_dirtyComponentIds;
     std::set<QString> m_dirtyPartIds;
     float m_mainProfileMiddleX = 0;
@@ -116,12 +278,12 @@ private:
     float m_mainProfileMiddleY = 0;
     Object *m_object = nullptr;
     std::vector<std::pair<QVector3D, std::pair<QUuid, QUuid>>> m_nodeVertices;
-    std::map<QString, std::set<QString>> m_partNodeIds;
-    std::map<QString, std::set<QString>> m_partEdgeIds;
     std::set<QUuid> m_generatedPreviewPartIds;
     Model *m_resultMesh = nullptr;
     std::map<QUuid, Model *> m_partPreviewMeshes;
-    bool m_isSuccessful = false;
+    QMutex m_partPreviewMeshesMutex;
+    std::atomic<bool> m_isSuccessful{false};
+    std::atomic<bool> m_isCancelled{false};
     bool m_cacheEnabled = false;
     float m_smoothShadingThresholdAngleDegrees = 60;
     std::map<QUuid, StrokeMeshBuilder::CutFaceTransform> *m_cutFaceTransforms = nullptr;
@@ -130,13 +292,17 @@ private:
     std::vector<QVector3D> m_clothCollisionVertices;
     std::vector<std::vector<size_t>> m_clothCollisionTriangles;
     bool m_weldEnabled = true;
+    bool m_balancedCombinationEnabled = false;
+    bool m_sdfPreviewEnabled = false;
+    bool m_coarseTierEnabled = false;
+    bool m_accurateClothCollisionEnabled = false;
+    std::vector<PreparedPartMesh> m_preparedPartMeshes;
     
-    void collectParts();
     void collectIncombinableComponentMeshes(const QString &componentIdString);
     void collectIncombinableMesh(const MeshCombiner::Mesh *mesh, const GeneratedComponent &componentCache);
-    bool checkIsComponentDirty(const QString &componentIdString);
-    bool checkIsPartDirty(const QString &partIdString);
-    bool checkIsPartDependencyDirty(const QString &partIdString);
+    bool checkIsComponentDirty(size_t componentIndex);
+    bool checkIsPartDirty(size_t partIndex);
+    bool checkIsPartDependencyDirty(size_t partIndex);
     void checkDirtyFlags();
     bool fillPartWithMesh(GeneratedPart &partCache, 
         const QUuid &fillMeshFileId,
@@ -144,36 +310,71 @@ private:
         float deformWidth,
         float cutRotation,
         const StrokeMeshBuilder *strokeMeshBuilder);
+    std::shared_ptr<FillMeshCacheEntry> generateFillMesh(const QUuid &fillMeshFileId);
     MeshCombiner::Mesh *combinePartMesh(const QString &partIdString, bool *hasError, bool *retryable, bool addIntermediateNodes=true);
+    MeshCombiner::Mesh *combinePartMeshWithRetry(const QString &partIdString, bool *hasError);
+    void collectPartsToPrepare(size_t componentIndex, std::set<size_t> *visitedPartIndices, std::vector<size_t> *partIndices);
+    void preparePartMeshes();
+    void preparePartMesh(size_t partIndex);
+    MeshCombiner::Mesh *reflectPartMesh(size_t partIndex, const GeneratedPart &sourcePartCache);
+    MeshCombiner::Mesh *takePreparedPartMesh(size_t partIndex, bool *hasError);
+    void releasePreparedPartMeshes();
+    void coarsenCutTemplates();
+    void generateSdfPreview();
+    void addComponentToSdf(SdfMeshBuilder *sdfMeshBuilder, size_t parentGroup, size_t componentIndex, bool subtracted,
+        std::vector<std::pair<QUuid, QUuid>> *nodeSources);
+    void addPartToSdf(SdfMeshBuilder *sdfMeshBuilder, size_t group, size_t partIndex,
+        std::vector<std::pair<QUuid, QUuid>> *nodeSources);
     MeshCombiner::Mesh *combineComponentMesh(const QString &componentIdString, CombineMode *combineMode);
+    void makePartPreviewMesh(const QUuid &partId, const GeneratedPart &partCache, const QColor &partColor,
+        float metalness, float roughness, PartTarget target);
+    QByteArray hashPartContent(size_t partIndex);
+    QByteArray hashComponentContent(size_t componentIndex, std::map<size_t, QByteArray> *partContentHashes);
+    bool loadComponentFromDiskCache(const CompiledSnapshot::Component *component);
+    void saveComponentToDiskCache(const CompiledSnapshot::Component *component);
     void makeXmirror(const std::vector<QVector3D> &sourceVertices, const std::vector<std::vector<size_t>> &sourceFaces,
         std::vector<QVector3D> *destVertices, std::vector<std::vector<size_t>> *destFaces);
     void collectSharedQuadEdges(const std::vector<QVector3D> &vertices, const std::vector<std::vector<size_t>> &faces,
-        std::set<std::pair<PositionKey, PositionKey>> *sharedQuadEdges);
-    MeshCombiner::Mesh *combineTwoMeshes(const MeshCombiner::Mesh &first, const MeshCombiner::Mesh &second,
+        OpenHashSet<std::pair<PositionKey, PositionKey>> *sharedQuadEdges);
+    MeshCombiner::Mesh *combineTwoMeshes(MeshCombiner::Mesh &first, MeshCombiner::Mesh &second,
         MeshCombiner::Method method,
         bool recombine=true);
-    void generateSmoothTriangleVertexNormals(const std::vector<QVector3D> &vertices, const std::vector<std::vector<size_t>> &triangles,
+    void generateSmoothTriangleVertexNormals(const std::vector<QVector3D> &vertices, const FaceList &triangles,
         const std::vector<QVector3D> &triangleNormals,
         std::vector<std::vector<QVector3D>> *triangleVertexNormals);
-    const std::map<QString, QString> *findComponent(const QString &componentIdString);
-    CombineMode componentCombineMode(const std::map<QString, QString> *component);
-    bool componentRemeshed(const std::map<QString, QString> *component, float *polyCountValue=nullptr);
-    MeshCombiner::Mesh *combineComponentChildGroupMesh(const std::vector<QString> &componentIdStrings,
-        GeneratedComponent &componentCache);
-    MeshCombiner::Mesh *combineMultipleMeshes(const std::vector<std::tuple<MeshCombiner::Mesh *, CombineMode, QString>> &multipleMeshes, bool recombine=true);
-    QString componentColorName(const std::map<QString, QString> *component);
-    ComponentLayer componentLayer(const std::map<QString, QString> *component);
-    float componentClothStiffness(const std::map<QString, QString> *component);
-    size_t componentClothIteration(const std::map<QString, QString> *component);
-    ClothForce componentClothForce(const std::map<QString, QString> *component);
-    float componentClothOffset(const std::map<QString, QString> *component);
+    const CompiledSnapshot::Component *findComponent(const QString &componentIdString);
+    CombineMode componentCombineMode(const CompiledSnapshot::Component *component);
+    bool componentRemeshed(const CompiledSnapshot::Component *component, float *polyCountValue=nullptr);
+    MeshCombiner::Mesh *combineComponentChildGroupMesh(const QString &componentIdString,
+        const std::vector<QString> &childIdStrings,
+        GeneratedComponent &componentCache,
+        std::map<QString, std::pair<MeshCombiner::Mesh *, CombineMode>> *preparedChildMeshes);
+    void prepareComponentChildMeshes(const std::vector<QString> &componentIdStrings,
+        std::map<QString, std::pair<MeshCombiner::Mesh *, CombineMode>> *preparedChildMeshes);
+    MeshCombiner::Mesh *combineMultipleMeshes(const QString &componentIdString,
+        const std::vector<std::tuple<MeshCombiner::Mesh *, CombineMode, CombinationKey>> &multipleMeshes, bool recombine=true);
+    MeshCombiner::Mesh *combineMultipleMeshesInBalancedTree(const QString &componentIdString,
+        const std::vector<std::tuple<MeshCombiner::Mesh *, CombineMode, CombinationKey>> &multipleMeshes, bool recombine);
+    std::pair<MeshCombiner::Mesh *, CombinationKey> combineMeshesInBalancedTree(const QString &componentIdString,
+        const std::vector<std::pair<MeshCombiner::Mesh *, CombinationKey>> &meshes, bool recombine);
+    std::pair<MeshCombiner::Mesh *, CombinationKey> combineTwoMeshesWithCache(const QString &componentIdString,
+        const std::pair<MeshCombiner::Mesh *, CombinationKey> &first,
+        const std::pair<MeshCombiner::Mesh *, CombinationKey> &second,
+        MeshCombiner::Method method,
+        bool recombine);
+    QString componentColorName(const CompiledSnapshot::Component *component);
+    ComponentLayer componentLayer(const CompiledSnapshot::Component *component);
+    float componentClothStiffness(const CompiledSnapshot::Component *component);
+    size_t componentClothIteration(const CompiledSnapshot::Component *component);
+    ClothForce componentClothForce(const CompiledSnapshot::Component *component);
+    float componentClothOffset(const CompiledSnapshot::Component *component);
     void collectUncombinedComponent(const QString &componentIdString);
     void collectClothComponent(const QString &componentIdString);
+    std::shared_ptr<const ClothCollisionShape> prepareClothCollisionShape();
     void collectClothComponentIdStrings(const QString &componentIdString,
         std::vector<QString> *componentIdStrings);
-    void cutFaceStringToCutTemplate(const QString &cutFaceString, std::vector<QVector2D> &cutTemplate);
-    void remesh(const std::vector<ObjectNode> &inputNodes,
+    bool remesh(GeneratedComponent &componentCache,
+        const std::vector<ObjectNode> &inputNodes,
         const std::vector<std::tuple<QVector3D, float, size_t>> &interpolatedNodes,
         const std::vector<QVector3D> &inputVertices,
         const std::vector<std::vector<size_t>> &inputFaces,
@@ -185,6 +386,7 @@ private:
     void postprocessObject(Object *object);
     void collectErroredParts();
     void preprocessMirror();
+    void finishCancelledGeneration(bool needDeleteCacheContext);
     QString reverseUuid(const QString &uuidString);
 };
 
@@ -95,26 +95,9 @@ size_t MeshRecombiner::splitSeamVerticesToIslands(const std::map<size_t, std::ve
     return nextIslandId;
 }
 
-bool MeshRecombiner::buildHalfEdgeToFaceMap(std::map<std::pair<size_t, size_t>, size_t> &halfEdgeToFaceMap)
-{
-    bool isSuccessful = true;
-    for (size_t faceIndex = 0; faceIndex < m_faces->size(); ++faceIndex) {
-        const auto &face = (*m_faces)[faceIndex];
-        for (size_t i = 0; i < face.size(); ++i) {
-            size_t j = (i + 1) % face.size();
-            const auto insertResult = halfEdgeToFaceMap.insert({{face[i], face[j]}, faceIndex});
-            if (!insertResult.second) {
-                //qDebug() << "Non manifold edge found:" << face[i] << face[j];
-                isSuccessful = false;
-            }
-        }
-    }
-    return isSuccessful;
-}
-
 bool MeshRecombiner::recombine()
 {
-    buildHalfEdgeToFaceMap(m_halfEdgeToFaceMap);
+    m_halfEdges.build(*m_faces);
     
     std::map<size_t, std::vector<size_t>> seamLink;
     for (const auto &face: *m_faces) {
@@ -230,11 +213,11 @@ void MeshRecombiner::updateEdgeLoopNeighborVertices(const std::vector<size_t> &e
     for (size_t i = 0; i < edgeLoop.size(); ++i) {
         size_t j = (i + 1) % edgeLoop.size();
         auto edge = std::make_pair(edgeLoop[i], edgeLoop[j]);
-        auto findFace = m_halfEdgeToFaceMap.find(edge);
-        if (findFace == m_halfEdgeToFaceMap.end()) {
+        const HalfEdge *halfEdge = m_halfEdges.find(edge.first, edge.second);
+        if (nullptr == halfEdge) {
             continue;
         }
-        const auto &face = (*m_faces)[findFace->second];
+        const auto &face = (*m_faces)[halfEdge->face];
         for (const auto &vertexIndex: face) {
             if (edge.first == vertexIndex || edge.second == vertexIndex)
                 continue;
@@ -286,12 +269,12 @@ size_t MeshRecombiner::adjustTrianglesFromSeam(std::vector<size_t> &edgeLoop, si
     std::vector<size_t> halfEdgeToFaces;
     for (size_t i = 0; i < edgeLoop.size(); ++i) {
         size_t j = (i + 1) % edgeLoop.size();
-        auto findFace = m_halfEdgeToFaceMap.find({edgeLoop[j], edgeLoop[i]});
-        if (findFace == m_halfEdgeToFaceMap.end()) {
+        const HalfEdge *halfEdge = m_halfEdges.find(edgeLoop[j], edgeLoop[i]);
+        if (nullptr == halfEdge) {
             qDebug() << "Find face for half edge failed:" << edgeLoop[j] << edgeLoop[i];
             return 0;
         }
-        halfEdgeToFaces.push_back(findFace->second);
+        halfEdgeToFaces.push_back(halfEdge->face);
     }
     
     std::vector<size_t> removedFaceIndices;
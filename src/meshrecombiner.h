@@ -5,6 +5,7 @@
 #include <set>
 #include <map>
 #include "meshcombiner.h"
+#include "halfedgetable.h"
 
 class MeshRecombiner
 {
@@ -24,13 +25,10 @@ private:
     std::vector<QVector3D> m_regeneratedVertices;
     std::vector<std::pair<MeshCombiner::Source, size_t>> m_regeneratedVerticesSourceIndices;
     std::vector<std::vector<size_t>> m_regeneratedFaces;
-    std::map<std::pair<size_t, size_t>, size_t> m_halfEdgeToFaceMap;
+    HalfEdgeTable m_halfEdges;
     std::map<size_t, size_t> m_facesInSeamArea;
     std::set<size_t> m_goodSeams;
     
-    bool addFaceToHalfEdgeToFaceMap(size_t faceIndex,
-        std::map<std::pair<size_t, size_t>, size_t> &halfEdgeToFaceMap);
-    bool buildHalfEdgeToFaceMap(std::map<std::pair<size_t, size_t>, size_t> &halfEdgeToFaceMap);
     bool convertHalfEdgesToEdgeLoops(const std::vector<std::pair<size_t, size_t>> &halfEdges,
         std::vector<std::vector<size_t>> *edgeLoops);
     size_t splitSeamVerticesToIslands(const std::map<size_t, std::vector<size_t>> &seamEdges,
@@ -133,7 +133,7 @@ Model::Model(Object &object) :
 {
     m_meshId = object.meshId;
     m_vertices = object.vertices;
-    m_faces = object.triangleAndQuads;
+    m_faces = object.triangleAndQuads.toVector();
     
     m_triangleVertexCount = object.triangles.size() * 3;
     m_triangleVertices = new ShaderVertex[m_triangleVertexCount];
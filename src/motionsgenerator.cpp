@@ -335,7 +335,7 @@ void MotionsGenerator::generateMotion(const QUuid &motionId)
         }
         
         std::vector<QVector3D> frameVertices = transformedVertices;
-        std::vector<std::vector<size_t>> frameFaces = m_object.triangles;
+        std::vector<std::vector<size_t>> frameFaces = m_object.triangles.toVector();
         std::vector<std::vector<QVector3D>> frameCornerNormals;
         const std::vector<std::vector<QVector3D>> *triangleVertexNormals = m_object.triangleVertexNormals();
         if (nullptr == triangleVertexNormals) {
@@ -9,6 +9,8 @@
 #include <QRectF>
 #include "bonemark.h"
 #include "componentlayer.h"
+#include "facelist.h"
+#include "halfedgetable.h"
 
 struct ObjectNode
 {
@@ -37,8 +39,8 @@ public:
     std::vector<std::pair<std::pair<QUuid, QUuid>, std::pair<QUuid, QUuid>>> edges;
     std::vector<QVector3D> vertices;
     std::vector<std::pair<QUuid, QUuid>> vertexSourceNodes;
-    std::vector<std::vector<size_t>> triangleAndQuads;
-    std::vector<std::vector<size_t>> triangles;
+    FaceList triangleAndQuads;
+    FaceList triangles;
     std::vector<QVector3D> triangleNormals;
     std::vector<QColor> triangleColors;
     bool alphaEnabled = false;
@@ -120,6 +122,18 @@ public:
         m_hasTriangleLinks = true;
     }
     
+    const HalfEdgeTable *triangleHalfEdges() const
+    {
+        if (!m_hasTriangleHalfEdges)
+            return nullptr;
+        return &m_triangleHalfEdges;
+    }
+    void buildTriangleHalfEdges()
+    {
+        m_triangleHalfEdges.build(triangles);
+        m_hasTriangleHalfEdges = true;
+    }
+    
     static void buildInterpolatedNodes(const std::vector<ObjectNode> &nodes,
         const std::vector<std::pair<std::pair<QUuid, QUuid>, std::pair<QUuid, QUuid>>> &edges,
         std::vector<std::tuple<QVector3D, float, size_t>> *targetNodes);
@@ -141,6 +155,9 @@ private:
     
     bool m_hasTriangleLinks = false;
     std::vector<std::pair<std::pair<size_t, size_t>, std::pair<size_t, size_t>>> m_triangleLinks;
+    
+    bool m_hasTriangleHalfEdges = false;
+    HalfEdgeTable m_triangleHalfEdges;
 };
 
 #endif
@@ -0,0 +1,165 @@
+#ifndef DUST3D_OPEN_HASH_MAP_H
+#define DUST3D_OPEN_HASH_MAP_H
+#include <vector>
+#include <functional>
+#include <utility>
+#include <cstdint>
+
+// Insert only hash tables with open addressing and linear probing, for the position lookups of the generation,
+// which are filled once and then queried many times.
+// The entries are kept in a dense array in the insertion order, the probed slots only hold indices into it,
+// so the iteration is deterministic and as fast as over a vector; inserting an existing key keeps the first entry, as std::map does
+
+template <class Key, class Entry, class KeyOfEntry, class Hash>
+class OpenHashTable
+{
+public:
+    typedef typename std::vector<Entry>::iterator iterator;
+    typedef typename std::vector<Entry>::const_iterator const_iterator;
+
+    std::pair<iterator, bool> insert(const Entry &entry)
+    {
+        if ((m_entries.size() + 1) * 2 > m_slots.size())
+            rehash(m_slots.empty() ? 16 : m_slots.size() * 2);
+        size_t slot = findSlot(KeyOfEntry()(entry));
+        if (0 != m_slots[slot])
+            return {m_entries.begin() + (m_slots[slot] - 1), false};
+        m_entries.push_back(entry);
+        m_slots[slot] = (uint32_t)m_entries.size();
+        return {m_entries.end() - 1, true};
+    }
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        for (; first != last; ++first)
+            insert(*first);
+    }
+    iterator find(const Key &key)
+    {
+        if (m_slots.empty())
+            return m_entries.end();
+        size_t slot = findSlot(key);
+        return 0 == m_slots[slot] ? m_entries.end() : m_entries.begin() + (m_slots[slot] - 1);
+    }
+    const_iterator find(const Key &key) const
+    {
+        if (m_slots.empty())
+            return m_entries.end();
+        size_t slot = findSlot(key);
+        return 0 == m_slots[slot] ? m_entries.end() : m_entries.begin() + (m_slots[slot] - 1);
+    }
+    size_t count(const Key &key) const
+    {
+        return find(key) == end() ? 0 : 1;
+    }
+    void reserve(size_t size)
+    {
+        size_t slotCount = 16;
+        while (slotCount < size * 2)
+            slotCount *= 2;
+        if (slotCount > m_slots.size())
+            rehash(slotCount);
+        m_entries.reserve(size);
+    }
+    void clear()
+    {
+        m_entries.clear();
+        m_slots.clear();
+        m_shift = 64;
+    }
+    size_t size() const
+    {
+        return m_entries.size();
+    }
+    bool empty() const
+    {
+        return m_entries.empty();
+    }
+    iterator begin()
+    {
+        return m_entries.begin();
+    }
+    iterator end()
+    {
+        return m_entries.end();
+    }
+    const_iterator begin() const
+    {
+        return m_entries.begin();
+    }
+    const_iterator end() const
+    {
+        return m_entries.end();
+    }
+
+protected:
+    std::vector<Entry> m_entries;
+    std::vector<uint32_t> m_slots;
+    int m_shift = 64;
+
+    size_t slotOfHash(size_t hash) const
+    {
+        // Fibonacci hashing spreads the weak hashes of the neighbouring cells over the whole table
+        return (size_t)(((uint64_t)hash * 0x9E3779B97F4A7C15ULL) >> m_shift);
+    }
+    size_t findSlot(const Key &key) const
+    {
+        size_t mask = m_slots.size() - 1;
+        size_t slot = slotOfHash(Hash()(key));
+        while (0 != m_slots[slot]) {
+            if (KeyOfEntry()(m_entries[m_slots[slot] - 1]) == key)
+                return slot;
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+    void rehash(size_t slotCount)
+    {
+        m_slots.assign(slotCount, 0);
+        m_shift = 64;
+        for (size_t count = slotCount; count > 1; count >>= 1)
+            --m_shift;
+        size_t mask = slotCount - 1;
+        for (size_t i = 0; i < m_entries.size(); ++i) {
+            size_t slot = slotOfHash(Hash()(KeyOfEntry()(m_entries[i])));
+            while (0 != m_slots[slot])
+                slot = (slot + 1) & mask;
+            m_slots[slot] = (uint32_t)(i + 1);
+        }
+    }
+};
+
+template <class Key>
+struct OpenHashSetKeyOfEntry
+{
+    const Key &operator()(const Key &entry) const
+    {
+        return entry;
+    }
+};
+
+template <class Key, class Value>
+struct OpenHashMapKeyOfEntry
+{
+    const Key &operator()(const std::pair<Key, Value> &entry) const
+    {
+        return entry.first;
+    }
+};
+
+template <class Key, class Hash = std::hash<Key>>
+class OpenHashSet : public OpenHashTable<Key, Key, OpenHashSetKeyOfEntry<Key>, Hash>
+{
+};
+
+template <class Key, class Value, class Hash = std::hash<Key>>
+class OpenHashMap : public OpenHashTable<Key, std::pair<Key, Value>, OpenHashMapKeyOfEntry<Key, Value>, Hash>
+{
+public:
+    Value &operator[](const Key &key)
+    {
+        return this->insert({key, Value()}).first->second;
+    }
+};
+
+#endif
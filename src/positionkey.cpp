@@ -1,26 +1,45 @@
+#include <limits>
 #include "positionkey.h"
 
-long PositionKey::m_toIntFactor = 100000;
+const float PositionKey::m_toIntFactor = 100000;
+
+qint32 PositionKey::toInt(float value)
+{
+    // Truncated toward zero, the same as the conversion of the key this replaces;
+    // clamped, because the conversion of an out of range float is undefined
+    float scaled = value * m_toIntFactor;
+    if (scaled >= (float)std::numeric_limits<qint32>::max())
+        return std::numeric_limits<qint32>::max();
+    if (scaled <= (float)std::numeric_limits<qint32>::min())
+        return std::numeric_limits<qint32>::min();
+    if (scaled != scaled)
+        return 0;
+    return (qint32)scaled;
+}
+
+float PositionKey::toFloat(qint32 value)
+{
+    // The middle of the cell, it converts back to the same cell whichever side of zero the cell is
+    if (0 == value)
+        return 0;
+    return (float)(((double)value + (value > 0 ? 0.5 : -0.5)) / m_toIntFactor);
+}
 
 PositionKey::PositionKey(const QVector3D &v) :
     PositionKey(v.x(), v.y(), v.z())
 {
 }
 
-PositionKey::PositionKey(float x, float y, float z)
+PositionKey::PositionKey(float x, float y, float z) :
+    m_intX(toInt(x)),
+    m_intY(toInt(y)),
+    m_intZ(toInt(z))
 {
-    m_position.setX(x);
-    m_position.setY(y);
-    m_position.setZ(z);
-    
-    m_intX = x * m_toIntFactor;
-    m_intY = y * m_toIntFactor;
-    m_intZ = z * m_toIntFactor;
 }
 
-const QVector3D &PositionKey::position() const
+QVector3D PositionKey::position() const
 {
-    return m_position;
+    return QVector3D(toFloat(m_intX), toFloat(m_intY), toFloat(m_intZ));
 }
 
 bool PositionKey::operator <(const PositionKey &right) const
@@ -46,3 +65,17 @@ bool PositionKey::operator ==(const PositionKey &right) const
         m_intY == right.m_intY &&
         m_intZ == right.m_intZ;
 }
+
+bool PositionKey::operator !=(const PositionKey &right) const
+{
+    return !(*this == right);
+}
+
+size_t PositionKey::hash() const
+{
+    // The quantized coordinates are hashed, so the positions equal by operator == fall into the same bucket
+    size_t seed = std::hash<qint32>()(m_intX);
+    seed ^= std::hash<qint32>()(m_intY) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed ^= std::hash<qint32>()(m_intZ) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    return seed;
+}
@@ -1,23 +1,55 @@
 #ifndef DUST3D_POSITION_KEY_H
 #define DUST3D_POSITION_KEY_H
+#include <functional>
+#include <utility>
 #include <QVector3D>
 
+// Position quantized to a grid of 1/100000, two positions are the same key when they fall into the same cell.
+// Only the cell is kept, so the key is 12 bytes and cheap to hash and compare
+
 class PositionKey
 {
 public:
+    PositionKey() = default;
     PositionKey(const QVector3D &v);
     PositionKey(float x, float y, float z);
-    const QVector3D &position() const;
+    QVector3D position() const;
     bool operator <(const PositionKey &right) const;
     bool operator ==(const PositionKey &right) const;
+    bool operator !=(const PositionKey &right) const;
+    size_t hash() const;
 
 private:
-    long m_intX = 0;
-    long m_intY = 0;
-    long m_intZ = 0;
-    QVector3D m_position;
+    qint32 m_intX = 0;
+    qint32 m_intY = 0;
+    qint32 m_intZ = 0;
+
+    static const float m_toIntFactor;
+    static qint32 toInt(float value);
+    static float toFloat(qint32 value);
+};
+
+namespace std
+{
+template<>
+struct hash<PositionKey>
+{
+    size_t operator()(const PositionKey &key) const
+    {
+        return key.hash();
+    }
+};
 
-    static long m_toIntFactor;
+template<>
+struct hash<std::pair<PositionKey, PositionKey>>
+{
+    size_t operator()(const std::pair<PositionKey, PositionKey> &pair) const
+    {
+        size_t seed = pair.first.hash();
+        seed ^= pair.second.hash() + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        return seed;
+    }
 };
+}
 
 #endif
@@ -19,6 +19,9 @@ void Preferences::loadDefault()
     m_toonLine = ToonLine::WithoutLine;
     m_textureSize = 1024;
     m_scriptEnabled = false;
+    m_generationTracing = false;
+    m_sdfPreview = false;
+    m_accurateClothCollision = false;
 }
 
 Preferences::Preferences()
@@ -65,6 +68,27 @@ Preferences::Preferences()
         else
             m_scriptEnabled = isTrueValueString(value);
     }
+    {
+        QString value = m_settings.value("generationTracing").toString();
+        if (value.isEmpty())
+            m_generationTracing = false;
+        else
+            m_generationTracing = isTrueValueString(value);
+    }
+    {
+        QString value = m_settings.value("sdfPreview").toString();
+        if (value.isEmpty())
+            m_sdfPreview = false;
+        else
+            m_sdfPreview = isTrueValueString(value);
+    }
+    {
+        QString value = m_settings.value("accurateClothCollision").toString();
+        if (value.isEmpty())
+            m_accurateClothCollision = false;
+        else
+            m_accurateClothCollision = isTrueValueString(value);
+    }
 }
 
 CombineMode Preferences::componentCombineMode() const
@@ -102,6 +126,21 @@ int Preferences::textureSize() const
     return m_textureSize;
 }
 
+bool Preferences::generationTracing() const
+{
+    return m_generationTracing;
+}
+
+bool Preferences::sdfPreview() const
+{
+    return m_sdfPreview;
+}
+
+bool Preferences::accurateClothCollision() const
+{
+    return m_accurateClothCollision;
+}
+
 void Preferences::setComponentCombineMode(CombineMode mode)
 {
     if (m_componentCombineMode == mode)
@@ -138,6 +177,33 @@ void Preferences::setScriptEnabled(bool enabled)
     emit scriptEnabledChanged();
 }
 
+void Preferences::setGenerationTracing(bool generationTracing)
+{
+    if (m_generationTracing == generationTracing)
+        return;
+    m_generationTracing = generationTracing;
+    m_settings.setValue("generationTracing", generationTracing ? "true" : "false");
+    emit generationTracingChanged();
+}
+
+void Preferences::setSdfPreview(bool sdfPreview)
+{
+    if (m_sdfPreview == sdfPreview)
+        return;
+    m_sdfPreview = sdfPreview;
+    m_settings.setValue("sdfPreview", sdfPreview ? "true" : "false");
+    emit sdfPreviewChanged();
+}
+
+void Preferences::setAccurateClothCollision(bool accurateClothCollision)
+{
+    if (m_accurateClothCollision == accurateClothCollision)
+        return;
+    m_accurateClothCollision = accurateClothCollision;
+    m_settings.setValue("accurateClothCollision", accurateClothCollision ? "true" : "false");
+    emit accurateClothCollisionChanged();
+}
+
 void Preferences::setToonShading(bool toonShading)
 {
     if (m_toonShading == toonShading)
@@ -186,4 +252,7 @@ void Preferences::reset()
     emit toonLineChanged();
     emit textureSizeChanged();
     emit scriptEnabledChanged();
+    emit generationTracingChanged();
+    emit sdfPreviewChanged();
+    emit accurateClothCollisionChanged();
 }
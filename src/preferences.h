@@ -21,6 +21,9 @@ public:
     QSize documentWindowSize() const;
     void setDocumentWindowSize(const QSize&);
     int textureSize() const;
+    bool generationTracing() const;
+    bool sdfPreview() const;
+    bool accurateClothCollision() const;
 signals:
     void componentCombineModeChanged();
     void partColorChanged();
@@ -29,6 +32,9 @@ signals:
     void toonLineChanged();
     void textureSizeChanged();
     void scriptEnabledChanged();
+    void generationTracingChanged();
+    void sdfPreviewChanged();
+    void accurateClothCollisionChanged();
 public slots:
     void setComponentCombineMode(CombineMode mode);
     void setPartColor(const QColor &color);
@@ -37,6 +43,9 @@ public slots:
     void setToonLine(ToonLine toonLine);
     void setTextureSize(int textureSize);
     void setScriptEnabled(bool enabled);
+    void setGenerationTracing(bool generationTracing);
+    void setSdfPreview(bool sdfPreview);
+    void setAccurateClothCollision(bool accurateClothCollision);
     void reset();
 private:
     CombineMode m_componentCombineMode;
@@ -47,6 +56,9 @@ private:
     QSettings m_settings;
     int m_textureSize;
     bool m_scriptEnabled;
+    bool m_generationTracing;
+    bool m_sdfPreview;
+    bool m_accurateClothCollision;
 private:
     void loadDefault();
 };
@@ -100,6 +100,24 @@ PreferencesWidget::PreferencesWidget(const Document *document, QWidget *parent)
         Preferences::instance().setScriptEnabled(scriptEnabledBox->isChecked());
     });
     
+    QCheckBox *generationTracingBox = new QCheckBox();
+    Theme::initCheckbox(generationTracingBox);
+    connect(generationTracingBox, &QCheckBox::stateChanged, this, [=]() {
+        Preferences::instance().setGenerationTracing(generationTracingBox->isChecked());
+    });
+    
+    QCheckBox *sdfPreviewBox = new QCheckBox();
+    Theme::initCheckbox(sdfPreviewBox);
+    connect(sdfPreviewBox, &QCheckBox::stateChanged, this, [=]() {
+        Preferences::instance().setSdfPreview(sdfPreviewBox->isChecked());
+    });
+    
+    QCheckBox *accurateClothCollisionBox = new QCheckBox();
+    Theme::initCheckbox(accurateClothCollisionBox);
+    connect(accurateClothCollisionBox, &QCheckBox::stateChanged, this, [=]() {
+        Preferences::instance().setAccurateClothCollision(accurateClothCollisionBox->isChecked());
+    });
+    
     QFormLayout *formLayout = new QFormLayout;
     formLayout->addRow(tr("Part color:"), colorLayout);
     formLayout->addRow(tr("Combine mode:"), combineModeSelectBox);
@@ -107,6 +125,9 @@ PreferencesWidget::PreferencesWidget(const Document *document, QWidget *parent)
     formLayout->addRow(tr("Toon shading:"), toonShadingLayout);
     formLayout->addRow(tr("Texture size:"), textureSizeSelectBox);
     formLayout->addRow(tr("Script:"), scriptEnabledBox);
+    formLayout->addRow(tr("Generation tracing:"), generationTracingBox);
+    formLayout->addRow(tr("Quick preview:"), sdfPreviewBox);
+    formLayout->addRow(tr("Accurate cloth collision:"), accurateClothCollisionBox);
     
     auto loadFromPreferences = [=]() {
         updatePickButtonColor();
@@ -118,6 +139,9 @@ PreferencesWidget::PreferencesWidget(const Document *document, QWidget *parent)
             textureSizeSelectBox->findText(QString::number(Preferences::instance().textureSize()))
         );
         scriptEnabledBox->setChecked(Preferences::instance().scriptEnabled());
+        generationTracingBox->setChecked(Preferences::instance().generationTracing());
+        sdfPreviewBox->setChecked(Preferences::instance().sdfPreview());
+        accurateClothCollisionBox->setChecked(Preferences::instance().accurateClothCollision());
     };
     
     loadFromPreferences();
@@ -1,35 +1,140 @@
 #include <tbb/parallel_for.h>
 #include <tbb/blocked_range.h>
 #include <cmath>
+#include <algorithm>
+#include <limits>
 #include "projectfacestonodes.h"
 #include "util.h"
 
+// A face could only be projected to the nodes within one and a half radius of its center,
+// so the nodes are kept in a bounding volume hierarchy over these enlarged spheres,
+// and each face only tests the few nodes whose boxes contain its center, instead of all the nodes
+class NodeSphereTree
+{
+public:
+    static const size_t LeafSize = 4;
+
+    NodeSphereTree(const std::vector<std::pair<QVector3D, float>> &sourceNodes) :
+        m_sourceNodes(&sourceNodes)
+    {
+        if (sourceNodes.empty())
+            return;
+        m_nodeIndices.resize(sourceNodes.size());
+        for (size_t i = 0; i < m_nodeIndices.size(); ++i)
+            m_nodeIndices[i] = i;
+        m_boxes.reserve(sourceNodes.size() * 2);
+        m_children.reserve(sourceNodes.size() * 2);
+        m_ranges.reserve(sourceNodes.size() * 2);
+        build(0, m_nodeIndices.size());
+    }
+
+    // Visits the nodes whose enlarged spheres could contain the position
+    template <class Visitor>
+    void query(const QVector3D &position, Visitor visitor) const
+    {
+        if (m_boxes.empty())
+            return;
+        size_t stack[64];
+        size_t stackSize = 0;
+        stack[stackSize++] = 0;
+        while (stackSize > 0) {
+            size_t treeIndex = stack[--stackSize];
+            const auto &box = m_boxes[treeIndex];
+            if (position.x() < box.first.x() || position.x() > box.second.x() ||
+                    position.y() < box.first.y() || position.y() > box.second.y() ||
+                    position.z() < box.first.z() || position.z() > box.second.z())
+                continue;
+            const auto &children = m_children[treeIndex];
+            if (0 == children.first) {
+                const auto &range = m_ranges[treeIndex];
+                for (size_t i = range.first; i < range.second; ++i)
+                    visitor(m_nodeIndices[i]);
+                continue;
+            }
+            stack[stackSize++] = children.first;
+            stack[stackSize++] = children.second;
+        }
+    }
+
+private:
+    const std::vector<std::pair<QVector3D, float>> *m_sourceNodes = nullptr;
+    std::vector<size_t> m_nodeIndices;
+    std::vector<std::pair<QVector3D, QVector3D>> m_boxes;
+    std::vector<std::pair<size_t, size_t>> m_children;
+    std::vector<std::pair<size_t, size_t>> m_ranges;
+
+    std::pair<QVector3D, QVector3D> nodeBox(size_t nodeIndex) const
+    {
+        const auto &node = (*m_sourceNodes)[nodeIndex];
+        // Padded a little, so the rounding never drops a node the exact test would accept
+        float extent = node.second * 1.5f * 1.001f + 1e-6f;
+        QVector3D extents(extent, extent, extent);
+        return {node.first - extents, node.first + extents};
+    }
+
+    size_t build(size_t begin, size_t end)
+    {
+        size_t treeIndex = m_boxes.size();
+        auto box = nodeBox(m_nodeIndices[begin]);
+        QVector3D centerMin = (*m_sourceNodes)[m_nodeIndices[begin]].first;
+        QVector3D centerMax = centerMin;
+        for (size_t i = begin + 1; i < end; ++i) {
+            auto other = nodeBox(m_nodeIndices[i]);
+            const auto &center = (*m_sourceNodes)[m_nodeIndices[i]].first;
+            for (int axis = 0; axis < 3; ++axis) {
+                box.first[axis] = std::min(box.first[axis], other.first[axis]);
+                box.second[axis] = std::max(box.second[axis], other.second[axis]);
+                centerMin[axis] = std::min(centerMin[axis], center[axis]);
+                centerMax[axis] = std::max(centerMax[axis], center[axis]);
+            }
+        }
+        m_boxes.push_back(box);
+        m_children.push_back({0, 0});
+        m_ranges.push_back({begin, end});
+        if (end - begin <= LeafSize)
+            return treeIndex;
+        
+        // Split at the median, so the depth stays under the size of the query stack
+        QVector3D centerExtents = centerMax - centerMin;
+        int splitAxis = 0;
+        if (centerExtents.y() > centerExtents[splitAxis])
+            splitAxis = 1;
+        if (centerExtents.z() > centerExtents[splitAxis])
+            splitAxis = 2;
+        size_t middle = begin + (end - begin) / 2;
+        std::nth_element(m_nodeIndices.begin() + begin, m_nodeIndices.begin() + middle, m_nodeIndices.begin() + end,
+                [&](size_t first, size_t second) {
+            return (*m_sourceNodes)[first].first[splitAxis] < (*m_sourceNodes)[second].first[splitAxis];
+        });
+        size_t left = build(begin, middle);
+        size_t right = build(middle, end);
+        m_children[treeIndex] = {left, right};
+        return treeIndex;
+    }
+};
+
 class FacesToNearestNodesProjector
 {
 public:
     FacesToNearestNodesProjector(const std::vector<QVector3D> *vertices,
             const std::vector<std::vector<size_t>> *faces,
             const std::vector<std::pair<QVector3D, float>> *sourceNodes,
+            const NodeSphereTree *nodeSphereTree,
             std::vector<size_t> *faceSources) :
         m_vertices(vertices),
         m_faces(faces),
         m_sourceNodes(sourceNodes),
+        m_nodeSphereTree(nodeSphereTree),
         m_faceSources(faceSources)
     {
     }
-    bool test(const std::vector<size_t> &face,
+    bool test(const QVector3D &faceCenter,
+            const QVector3D &inversedFaceNormal,
             const QVector3D &nodePosition,
             float nodeRadius,
             float *distance) const
     {
-        QVector3D faceCenter;
-        for (const auto &it: face) {
-            faceCenter += (*m_vertices)[it];
-        }
-        if (face.size() > 0)
-            faceCenter /= face.size();
         auto ray = (nodePosition - faceCenter).normalized();
-        auto inversedFaceNormal = -polygonNormal(*m_vertices, face);
         *distance = (faceCenter - nodePosition).length();
         if (*distance > nodeRadius * 1.5f)
             return false;
@@ -42,25 +147,37 @@ public:
     void operator()(const tbb::blocked_range<size_t> &range) const
     {
         for (size_t i = range.begin(); i != range.end(); ++i) {
-            std::vector<std::pair<size_t, float>> distanceWithNodes;
-            for (size_t j = 0; j < m_sourceNodes->size(); ++j) {
+            const auto &face = (*m_faces)[i];
+            QVector3D faceCenter;
+            for (const auto &it: face) {
+                faceCenter += (*m_vertices)[it];
+            }
+            if (face.size() > 0)
+                faceCenter /= face.size();
+            auto inversedFaceNormal = -polygonNormal(*m_vertices, face);
+            // The nearest node wins, the lowest index on a tie, the same as scanning all the nodes in order
+            size_t nearestNodeIndex = std::numeric_limits<size_t>::max();
+            float nearestDistance = std::numeric_limits<float>::max();
+            m_nodeSphereTree->query(faceCenter, [&](size_t j) {
                 const auto &node = (*m_sourceNodes)[j];
                 float distance = 0.0f;
-                if (!test((*m_faces)[i], node.first, node.second, &distance))
-                    continue;
-                distanceWithNodes.push_back(std::make_pair(j, distance));
-            }
-            if (distanceWithNodes.empty())
+                if (!test(faceCenter, inversedFaceNormal, node.first, node.second, &distance))
+                    return;
+                if (distance < nearestDistance || (distance == nearestDistance && j < nearestNodeIndex)) {
+                    nearestDistance = distance;
+                    nearestNodeIndex = j;
+                }
+            });
+            if (std::numeric_limits<size_t>::max() == nearestNodeIndex)
                 continue;
-            (*m_faceSources)[i] = std::min_element(distanceWithNodes.begin(), distanceWithNodes.end(), [](const std::pair<size_t, float> &first, const std::pair<size_t, float> &second) {
-                return first.second < second.second;
-            })->first;
+            (*m_faceSources)[i] = nearestNodeIndex;
         }
     }
 private:
     const std::vector<QVector3D> *m_vertices = nullptr;
     const std::vector<std::vector<size_t>> *m_faces = nullptr;
     const std::vector<std::pair<QVector3D, float>> *m_sourceNodes = nullptr;
+    const NodeSphereTree *m_nodeSphereTree = nullptr;
     std::vector<size_t> *m_faceSources = nullptr;
 };
 
@@ -71,6 +188,7 @@ void projectFacesToNodes(const std::vector<QVector3D> &vertices,
 {
     // Resolve the faces's source nodes
     faceSources->resize(faces.size(), std::numeric_limits<size_t>::max());
+    NodeSphereTree nodeSphereTree(sourceNodes);
     tbb::parallel_for(tbb::blocked_range<size_t>(0, faces.size()),
-        FacesToNearestNodesProjector(&vertices, &faces, &sourceNodes, faceSources));
+        FacesToNearestNodesProjector(&vertices, &faces, &sourceNodes, &nodeSphereTree, faceSources));
 }
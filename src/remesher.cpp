@@ -1,5 +1,6 @@
 #include <instant-meshes-api.h>
 #include <cmath>
+#include <algorithm>
 #include <QElapsedTimer>
 #include "remesher.h"
 #include "util.h"
@@ -35,7 +36,28 @@ const std::vector<std::pair<QUuid, QUuid>> &Remesher::getRemeshedVertexSources()
     return m_remeshedVertexSources;
 }
 
-void Remesher::remesh(float targetVertexMultiplyFactor)
+void Remesher::setThreadCount(int threadCount)
+{
+    m_threadCount = threadCount;
+}
+
+void Remesher::setCancelFlag(const std::atomic<bool> *cancelFlag)
+{
+    m_cancelFlag = cancelFlag;
+}
+
+bool Remesher::isCancelled() const
+{
+    return nullptr != m_cancelFlag && *m_cancelFlag;
+}
+
+static int DUST3D_INSTANT_MESHES_FUNCTION_CONVENTION reportRemeshProgress(float, void *tag)
+{
+    const Remesher *remesher = (const Remesher *)tag;
+    return remesher->isCancelled() ? 1 : 0;
+}
+
+bool Remesher::remesh(float targetVertexMultiplyFactor)
 {
     std::vector<Dust3D_InstantMeshesVertex> inputVertices(m_vertices.size());
     for (size_t i = 0; i < m_vertices.size(); ++i) {
@@ -58,21 +80,31 @@ void Remesher::remesh(float targetVertexMultiplyFactor)
         }});
         totalArea += areaOfTriangle(m_vertices[triangle[0]], m_vertices[triangle[1]], m_vertices[triangle[2]]);
     }
+    // The result buffers are owned by this call, so components are remeshed from multiple threads without a lock
+    Dust3D_InstantMeshesResult *result = nullptr;
     const Dust3D_InstantMeshesVertex *resultVertices = nullptr;
     size_t nResultVertices = 0;
     const Dust3D_InstantMeshesTriangle *resultTriangles = nullptr;
     size_t nResultTriangles = 0;
     const Dust3D_InstantMeshesQuad *resultQuads = nullptr;
     size_t nResultQuads = 0;
-    Dust3D_instantMeshesRemesh(inputVertices.data(), inputVertices.size(),
-        inputTriangles.data(), inputTriangles.size(),
-        (size_t)(targetVertexMultiplyFactor * 30 * std::sqrt(totalArea) / 0.02f),
-        &resultVertices,
-        &nResultVertices,
-        &resultTriangles,
-        &nResultTriangles,
-        &resultQuads,
-        &nResultQuads);
+    Dust3D_InstantMeshesOptions options;
+    options.nThreads = m_threadCount;
+    options.progressCallback = reportRemeshProgress;
+    options.tag = this;
+    if (!Dust3D_instantMeshesRemeshWithOptions(inputVertices.data(), inputVertices.size(),
+            inputTriangles.data(), inputTriangles.size(),
+            (size_t)(targetVertexMultiplyFactor * 30 * std::sqrt(totalArea) / 0.02f),
+            &options,
+            &result,
+            &resultVertices,
+            &nResultVertices,
+            &resultTriangles,
+            &nResultTriangles,
+            &resultQuads,
+            &nResultQuads)) {
+        return false;
+    }
     m_remeshedVertices.resize(nResultVertices);
     memcpy(m_remeshedVertices.data(), resultVertices, sizeof(Dust3D_InstantMeshesVertex) * nResultVertices);
     m_remeshedFaces.reserve(nResultTriangles + nResultQuads);
@@ -93,7 +125,9 @@ void Remesher::remesh(float targetVertexMultiplyFactor)
             source.indices[3]
         });
     }
+    Dust3D_instantMeshesReleaseResult(result);
     resolveSources();
+    return true;
 }
 
 void Remesher::setNodes(const std::vector<std::pair<QVector3D, float>> &nodes,
@@ -112,20 +146,32 @@ void Remesher::resolveSources()
     projectFacesToNodes(m_remeshedVertices, m_remeshedFaces, m_nodes, &faceSources);
     auto projectFacesToNodesStopTime = timer.elapsed();
     qDebug() << "Project faces to nodes took" << (projectFacesToNodesStopTime - projectFacesToNodesStartTime) << "milliseconds";
-    std::map<size_t, std::map<size_t, size_t>> vertexToNodeVotes;
+    // Each vertex takes the source voted by most of its faces, the lowest node index on a tie
+    std::vector<std::vector<size_t>> vertexToNodeVotes(m_remeshedVertices.size());
     for (size_t i = 0; i < m_remeshedFaces.size(); ++i) {
         const auto &face = m_remeshedFaces[i];
         const auto &source = faceSources[i];
         if (source >= m_nodes.size())
             continue;
         for (const auto &vertexIndex: face)
-            vertexToNodeVotes[vertexIndex][source]++;
+            vertexToNodeVotes[vertexIndex].push_back(source);
     }
     m_remeshedVertexSources.resize(m_remeshedVertices.size());
-    for (const auto &it: vertexToNodeVotes) {
-        auto sourceIndex = std::max_element(it.second.begin(), it.second.end(), [](const std::pair<size_t, size_t> &first, const std::pair<size_t, size_t> &second) {
-            return first.second < second.second;
-        })->first;
-        m_remeshedVertexSources[it.first] = m_sourceIds[sourceIndex];
+    for (size_t vertexIndex = 0; vertexIndex < vertexToNodeVotes.size(); ++vertexIndex) {
+        auto &votes = vertexToNodeVotes[vertexIndex];
+        if (votes.empty())
+            continue;
+        std::sort(votes.begin(), votes.end());
+        size_t sourceIndex = votes[0];
+        size_t sourceVoteCount = 0;
+        for (size_t begin = 0, end = 0; begin < votes.size(); begin = end) {
+            while (end < votes.size() && votes[end] == votes[begin])
+                ++end;
+            if (end - begin > sourceVoteCount) {
+                sourceVoteCount = end - begin;
+                sourceIndex = votes[begin];
+            }
+        }
+        m_remeshedVertexSources[vertexIndex] = m_sourceIds[sourceIndex];
     }
 }
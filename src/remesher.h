@@ -4,6 +4,7 @@
 #include <vector>
 #include <QVector3D>
 #include <QUuid>
+#include <atomic>
 
 class Remesher : public QObject
 {
@@ -15,7 +16,13 @@ public:
         const std::vector<std::vector<size_t>> &triangles);
     void setNodes(const std::vector<std::pair<QVector3D, float>> &nodes,
         const std::vector<std::pair<QUuid, QUuid>> &sourceIds);
-    void remesh(float targetVertexMultiplyFactor);
+    // Zero for as many threads as the cores
+    void setThreadCount(int threadCount);
+    // The remeshing stops at the next progress report once the flag is set
+    void setCancelFlag(const std::atomic<bool> *cancelFlag);
+    // Returns false if cancelled
+    bool remesh(float targetVertexMultiplyFactor);
+    bool isCancelled() const;
     const std::vector<QVector3D> &getRemeshedVertices() const;
     const std::vector<std::vector<size_t>> &getRemeshedFaces() const;
     const std::vector<std::pair<QUuid, QUuid>> &getRemeshedVertexSources() const;
@@ -27,6 +34,8 @@ private:
     std::vector<std::pair<QUuid, QUuid>> m_remeshedVertexSources;
     std::vector<std::pair<QVector3D, float>> m_nodes;
     std::vector<std::pair<QUuid, QUuid>> m_sourceIds;
+    int m_threadCount = 0;
+    const std::atomic<bool> *m_cancelFlag = nullptr;
     void resolveSources();
 };
 
@@ -0,0 +1,499 @@
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include "sdfmeshbuilder.h"
+
+class SdfBlockSampler
+{
+public:
+    SdfBlockSampler(SdfMeshBuilder *builder) :
+        m_builder(builder)
+    {
+    }
+    void operator()(const tbb::blocked_range<size_t> &range) const
+    {
+        for (size_t i = range.begin(); i != range.end(); ++i) {
+            m_builder->sampleBlock(i);
+        }
+    }
+private:
+    SdfMeshBuilder *m_builder = nullptr;
+};
+
+class SdfCellVertexPlacer
+{
+public:
+    SdfCellVertexPlacer(SdfMeshBuilder *builder) :
+        m_builder(builder)
+    {
+    }
+    void operator()(const tbb::blocked_range<size_t> &range) const
+    {
+        for (size_t i = range.begin(); i != range.end(); ++i) {
+            m_builder->placeBlockCellVertices(i);
+        }
+    }
+private:
+    SdfMeshBuilder *m_builder = nullptr;
+};
+
+static float signOf(float value)
+{
+    return value > 0 ? 1.0f : (value < 0 ? -1.0f : 0.0f);
+}
+
+// Solves the symmetric system given by its upper triangle, xx, xy, xz, yy, yz, zz
+static bool solveSymmetric3x3(const float a[6], const QVector3D &b, QVector3D *x)
+{
+    float c00 = a[3] * a[5] - a[4] * a[4];
+    float c01 = a[2] * a[4] - a[1] * a[5];
+    float c02 = a[1] * a[4] - a[2] * a[3];
+    float determinant = a[0] * c00 + a[1] * c01 + a[2] * c02;
+    if (std::abs(determinant) < 1e-12f)
+        return false;
+    float c11 = a[0] * a[5] - a[2] * a[2];
+    float c12 = a[1] * a[2] - a[0] * a[4];
+    float c22 = a[0] * a[3] - a[1] * a[1];
+    *x = QVector3D(c00 * b.x() + c01 * b.y() + c02 * b.z(),
+        c01 * b.x() + c11 * b.y() + c12 * b.z(),
+        c02 * b.x() + c12 * b.y() + c22 * b.z()) / determinant;
+    return true;
+}
+
+SdfMeshBuilder::SdfMeshBuilder()
+{
+    m_groups.push_back(Group());
+}
+
+size_t SdfMeshBuilder::addGroup(size_t parentGroup, bool subtracted)
+{
+    size_t group = m_groups.size();
+    m_groups.push_back(Group());
+    m_groups[parentGroup].children.push_back({group, subtracted});
+    return group;
+}
+
+void SdfMeshBuilder::addSphere(size_t group, const QVector3D &center, float radius, size_t source)
+{
+    addRoundCone(group, center, radius, source, center, radius, source);
+}
+
+void SdfMeshBuilder::addRoundCone(size_t group, const QVector3D &from, float fromRadius, size_t fromSource,
+        const QVector3D &to, float toRadius, size_t toSource)
+{
+    Primitive primitive;
+    primitive.from = from;
+    primitive.to = to;
+    primitive.fromRadius = fromRadius;
+    primitive.toRadius = toRadius;
+    primitive.fromSource = fromSource;
+    primitive.toSource = toSource;
+    primitive.group = group;
+    primitive.boundMin = QVector3D(std::min(from.x() - fromRadius, to.x() - toRadius),
+        std::min(from.y() - fromRadius, to.y() - toRadius),
+        std::min(from.z() - fromRadius, to.z() - toRadius));
+    primitive.boundMax = QVector3D(std::max(from.x() + fromRadius, to.x() + toRadius),
+        std::max(from.y() + fromRadius, to.y() + toRadius),
+        std::max(from.z() + fromRadius, to.z() + toRadius));
+    m_groups[group].primitiveIndices.push_back(m_primitives.size());
+    m_primitives.push_back(primitive);
+}
+
+void SdfMeshBuilder::setResolution(size_t resolution)
+{
+    m_resolution = std::max((size_t)4, resolution);
+}
+
+const std::vector<QVector3D> &SdfMeshBuilder::resultVertices() const
+{
+    return m_resultVertices;
+}
+
+const std::vector<std::vector<size_t>> &SdfMeshBuilder::resultQuads() const
+{
+    return m_resultQuads;
+}
+
+const std::vector<size_t> &SdfMeshBuilder::resultVertexSources() const
+{
+    return m_resultVertexSources;
+}
+
+float SdfMeshBuilder::primitiveDistance(const Primitive &primitive, const QVector3D &position)
+{
+    // The exact distance to a round cone, see https://iquilezles.org/articles/distfunctions/
+    QVector3D ba = primitive.to - primitive.from;
+    float l2 = QVector3D::dotProduct(ba, ba);
+    float rr = primitive.fromRadius - primitive.toRadius;
+    float a2 = l2 - rr * rr;
+    if (a2 <= l2 * 1e-6f) {
+        // One end sphere contains the other, which also covers the single spheres
+        if (primitive.fromRadius >= primitive.toRadius)
+            return (position - primitive.from).length() - primitive.fromRadius;
+        return (position - primitive.to).length() - primitive.toRadius;
+    }
+    float il2 = 1.0f / l2;
+    QVector3D pa = position - primitive.from;
+    float y = QVector3D::dotProduct(pa, ba);
+    float z = y - l2;
+    QVector3D xv = pa * l2 - ba * y;
+    float x2 = QVector3D::dotProduct(xv, xv);
+    float y2 = y * y * l2;
+    float z2 = z * z * l2;
+    float k = signOf(rr) * rr * rr * x2;
+    if (signOf(z) * a2 * z2 > k)
+        return std::sqrt(x2 + z2) * il2 - primitive.toRadius;
+    if (signOf(y) * a2 * y2 < k)
+        return std::sqrt(x2 + y2) * il2 - primitive.fromRadius;
+    return (std::sqrt(x2 * a2 * il2) + y * rr) * il2 - primitive.fromRadius;
+}
+
+float SdfMeshBuilder::evaluate(const Block &block, size_t group, const QVector3D &position) const
+{
+    float value = std::numeric_limits<float>::max();
+    for (uint32_t i = block.groupOffsets[group]; i < block.groupOffsets[group + 1]; ++i)
+        value = std::min(value, primitiveDistance(m_primitives[block.primitiveIndices[i]], position));
+    for (const auto &child: m_groups[group].children) {
+        float childValue = evaluate(block, child.first, position);
+        if (child.second)
+            value = std::max(value, -childValue);
+        else
+            value = std::min(value, childValue);
+    }
+    return value;
+}
+
+float SdfMeshBuilder::evaluate(const Block &block, const QVector3D &position) const
+{
+    return evaluate(block, RootGroup, position);
+}
+
+size_t SdfMeshBuilder::nearestSource(const Block &block, const QVector3D &position) const
+{
+    float nearestDistance = std::numeric_limits<float>::max();
+    const Primitive *nearestPrimitive = nullptr;
+    for (int pass = 0; pass < 2 && nullptr == nearestPrimitive; ++pass) {
+        for (size_t group = 0; group < m_groups.size(); ++group) {
+            if (0 == pass && m_groups[group].carved)
+                continue;
+            for (uint32_t i = block.groupOffsets[group]; i < block.groupOffsets[group + 1]; ++i) {
+                const auto &primitive = m_primitives[block.primitiveIndices[i]];
+                float distance = primitiveDistance(primitive, position);
+                if (distance < nearestDistance) {
+                    nearestDistance = distance;
+                    nearestPrimitive = &primitive;
+                }
+            }
+        }
+    }
+    if (nullptr == nearestPrimitive)
+        return 0;
+    if ((position - nearestPrimitive->from).lengthSquared() <= (position - nearestPrimitive->to).lengthSquared())
+        return nearestPrimitive->fromSource;
+    return nearestPrimitive->toSource;
+}
+
+size_t SdfMeshBuilder::sampleIndex(size_t i, size_t j, size_t k) const
+{
+    return (k * (m_cellCounts[1] + 1) + j) * (m_cellCounts[0] + 1) + i;
+}
+
+size_t SdfMeshBuilder::cellIndex(size_t i, size_t j, size_t k) const
+{
+    return (k * m_cellCounts[1] + j) * m_cellCounts[0] + i;
+}
+
+QVector3D SdfMeshBuilder::samplePosition(size_t i, size_t j, size_t k) const
+{
+    return m_origin + QVector3D(i, j, k) * m_cellSize;
+}
+
+void SdfMeshBuilder::blockRange(size_t blockIndex, size_t *begin, size_t *end) const
+{
+    size_t coords[3] = {
+        blockIndex % m_blockCounts[0],
+        (blockIndex / m_blockCounts[0]) % m_blockCounts[1],
+        blockIndex / (m_blockCounts[0] * m_blockCounts[1])
+    };
+    for (size_t axis = 0; axis < 3; ++axis) {
+        begin[axis] = coords[axis] * BlockSize;
+        end[axis] = std::min(begin[axis] + BlockSize, m_cellCounts[axis]);
+    }
+}
+
+void SdfMeshBuilder::collectBlockPrimitives(const QVector3D &boundMin, const QVector3D &boundMax, Block *block) const
+{
+    block->groupOffsets.resize(m_groups.size() + 1);
+    block->primitiveIndices.clear();
+    for (size_t group = 0; group < m_groups.size(); ++group) {
+        block->groupOffsets[group] = (uint32_t)block->primitiveIndices.size();
+        for (const auto &primitiveIndex: m_groups[group].primitiveIndices) {
+            const auto &primitive = m_primitives[primitiveIndex];
+            if (primitive.boundMin.x() > boundMax.x() || primitive.boundMax.x() < boundMin.x() ||
+                    primitive.boundMin.y() > boundMax.y() || primitive.boundMax.y() < boundMin.y() ||
+                    primitive.boundMin.z() > boundMax.z() || primitive.boundMax.z() < boundMin.z())
+                continue;
+            block->primitiveIndices.push_back((uint32_t)primitiveIndex);
+        }
+    }
+    block->groupOffsets[m_groups.size()] = (uint32_t)block->primitiveIndices.size();
+}
+
+void SdfMeshBuilder::sampleBlock(size_t blockIndex)
+{
+    Block &block = m_blocks[blockIndex];
+    size_t begin[3];
+    size_t end[3];
+    blockRange(blockIndex, begin, end);
+    
+    // The primitives three cells away are left out, they never decide the sign of a sample next to the surface,
+    // neither the position of a vertex
+    QVector3D boundMin = samplePosition(begin[0], begin[1], begin[2]);
+    QVector3D boundMax = samplePosition(end[0], end[1], end[2]);
+    QVector3D margin(m_cellSize * 3, m_cellSize * 3, m_cellSize * 3);
+    collectBlockPrimitives(boundMin - margin, boundMax + margin, &block);
+    
+    // The last block along each axis also owns the closing samples
+    size_t sampleEnd[3];
+    for (size_t axis = 0; axis < 3; ++axis)
+        sampleEnd[axis] = end[axis] == m_cellCounts[axis] ? end[axis] + 1 : end[axis];
+    
+    // The field changes no faster than the distance, so the surface is not within two cells of the block
+    // when the center is farther than that from it, and the whole block takes the value of the center
+    float centerValue = evaluate(block, (boundMin + boundMax) * 0.5f);
+    float radius = (boundMax - boundMin).length() * 0.5f + m_cellSize * 2;
+    if (std::abs(centerValue) > radius) {
+        for (size_t k = begin[2]; k < sampleEnd[2]; ++k) {
+            for (size_t j = begin[1]; j < sampleEnd[1]; ++j) {
+                for (size_t i = begin[0]; i < sampleEnd[0]; ++i)
+                    m_samples[sampleIndex(i, j, k)] = centerValue;
+            }
+        }
+        std::vector<uint32_t>().swap(block.primitiveIndices);
+        return;
+    }
+    
+    block.active = true;
+    for (size_t k = begin[2]; k < sampleEnd[2]; ++k) {
+        for (size_t j = begin[1]; j < sampleEnd[1]; ++j) {
+            for (size_t i = begin[0]; i < sampleEnd[0]; ++i)
+                m_samples[sampleIndex(i, j, k)] = evaluate(block, samplePosition(i, j, k));
+        }
+    }
+}
+
+void SdfMeshBuilder::placeBlockCellVertices(size_t activeIndex)
+{
+    static const size_t s_cellEdges[12][2] = {
+        {0, 1}, {2, 3}, {4, 5}, {6, 7},
+        {0, 2}, {1, 3}, {4, 6}, {5, 7},
+        {0, 4}, {1, 5}, {2, 6}, {3, 7}
+    };
+    
+    size_t blockIndex = m_activeBlockIndices[activeIndex];
+    const Block &block = m_blocks[blockIndex];
+    auto &cellVertices = m_blockCellVertices[activeIndex];
+    size_t begin[3];
+    size_t end[3];
+    blockRange(blockIndex, begin, end);
+    
+    float step = m_cellSize * 0.05f;
+    QVector3D steps[3] = {
+        QVector3D(step, 0, 0),
+        QVector3D(0, step, 0),
+        QVector3D(0, 0, step)
+    };
+    
+    for (size_t k = begin[2]; k < end[2]; ++k) {
+        for (size_t j = begin[1]; j < end[1]; ++j) {
+            for (size_t i = begin[0]; i < end[0]; ++i) {
+                float values[8];
+                size_t insideCount = 0;
+                for (size_t corner = 0; corner < 8; ++corner) {
+                    values[corner] = m_samples[sampleIndex(i + (corner & 1), j + ((corner >> 1) & 1), k + ((corner >> 2) & 1))];
+                    if (values[corner] < 0)
+                        ++insideCount;
+                }
+                if (0 == insideCount || 8 == insideCount)
+                    continue;
+    
+                QVector3D cellMin = samplePosition(i, j, k);
+                QVector3D points[12];
+                QVector3D normals[12];
+                size_t pointCount = 0;
+                QVector3D massPoint;
+                for (size_t edge = 0; edge < 12; ++edge) {
+                    size_t first = s_cellEdges[edge][0];
+                    size_t second = s_cellEdges[edge][1];
+                    if ((values[first] < 0) == (values[second] < 0))
+                        continue;
+                    float t = values[first] / (values[first] - values[second]);
+                    QVector3D firstPosition = cellMin + QVector3D(first & 1, (first >> 1) & 1, (first >> 2) & 1) * m_cellSize;
+                    QVector3D secondPosition = cellMin + QVector3D(second & 1, (second >> 1) & 1, (second >> 2) & 1) * m_cellSize;
+                    QVector3D point = firstPosition + (secondPosition - firstPosition) * t;
+                    QVector3D gradient;
+                    for (size_t axis = 0; axis < 3; ++axis) {
+                        gradient[axis] = evaluate(block, point + steps[axis]) - evaluate(block, point - steps[axis]);
+                    }
+                    points[pointCount] = point;
+                    normals[pointCount] = gradient.normalized();
+                    massPoint += point;
+                    ++pointCount;
+                }
+                massPoint /= pointCount;
+    
+                // Minimizes the squared distances to the tangent planes, pulled slightly toward the mass point,
+                // which keeps the flat and the degenerated cells stable
+                const float regularization = 0.05f;
+                float ata[6] = {regularization, 0, 0, regularization, 0, regularization};
+                QVector3D atb;
+                for (size_t n = 0; n < pointCount; ++n) {
+                    const auto &normal = normals[n];
+                    float distance = QVector3D::dotProduct(normal, points[n] - massPoint);
+                    ata[0] += normal.x() * normal.x();
+                    ata[1] += normal.x() * normal.y();
+                    ata[2] += normal.x() * normal.z();
+                    ata[3] += normal.y() * normal.y();
+                    ata[4] += normal.y() * normal.z();
+                    ata[5] += normal.z() * normal.z();
+                    atb += normal * distance;
+                }
+                QVector3D position = massPoint;
+                QVector3D offset;
+                if (solveSymmetric3x3(ata, atb, &offset))
+                    position += offset;
+                QVector3D cellMax = cellMin + QVector3D(m_cellSize, m_cellSize, m_cellSize);
+                for (size_t axis = 0; axis < 3; ++axis)
+                    position[axis] = std::max(cellMin[axis], std::min(cellMax[axis], position[axis]));
+    
+                cellVertices.push_back({cellIndex(i, j, k), position, nearestSource(block, position)});
+            }
+        }
+    }
+}
+
+void SdfMeshBuilder::markCarvedGroups(size_t group, bool carved)
+{
+    m_groups[group].carved = carved;
+    for (const auto &child: m_groups[group].children)
+        markCarvedGroups(child.first, carved || child.second);
+}
+
+bool SdfMeshBuilder::build()
+{
+    m_resultVertices.clear();
+    m_resultQuads.clear();
+    m_resultVertexSources.clear();
+    
+    markCarvedGroups(RootGroup, false);
+    
+    // Only the united primitives bound the result, the subtracted ones remove from it
+    QVector3D boundMin(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+    QVector3D boundMax(std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest());
+    bool hasUnitedPrimitive = false;
+    for (const auto &primitive: m_primitives) {
+        if (m_groups[primitive.group].carved)
+            continue;
+        for (size_t axis = 0; axis < 3; ++axis) {
+            boundMin[axis] = std::min(boundMin[axis], primitive.boundMin[axis]);
+            boundMax[axis] = std::max(boundMax[axis], primitive.boundMax[axis]);
+        }
+        hasUnitedPrimitive = true;
+    }
+    if (!hasUnitedPrimitive)
+        return true;
+    
+    QVector3D extent = boundMax - boundMin;
+    float longestExtent = std::max(extent.x(), std::max(extent.y(), extent.z()));
+    if (longestExtent <= 0)
+        return false;
+    
+    m_cellSize = longestExtent / m_resolution;
+    m_origin = boundMin - QVector3D(m_cellSize, m_cellSize, m_cellSize) * 2;
+    for (size_t axis = 0; axis < 3; ++axis) {
+        m_cellCounts[axis] = (size_t)std::ceil(extent[axis] / m_cellSize) + 4;
+        m_blockCounts[axis] = (m_cellCounts[axis] + BlockSize - 1) / BlockSize;
+    }
+    
+    m_samples.assign((m_cellCounts[0] + 1) * (m_cellCounts[1] + 1) * (m_cellCounts[2] + 1), 0.0f);
+    m_blocks.clear();
+    m_blocks.resize(m_blockCounts[0] * m_blockCounts[1] * m_blockCounts[2]);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, m_blocks.size()),
+        SdfBlockSampler(this));
+    
+    m_activeBlockIndices.clear();
+    for (size_t blockIndex = 0; blockIndex < m_blocks.size(); ++blockIndex) {
+        if (m_blocks[blockIndex].active)
+            m_activeBlockIndices.push_back(blockIndex);
+    }
+    
+    m_blockCellVertices.clear();
+    m_blockCellVertices.resize(m_activeBlockIndices.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, m_activeBlockIndices.size()),
+        SdfCellVertexPlacer(this));
+    
+    // The vertices are numbered in the block order, so the result does not depend on the scheduling
+    std::vector<int32_t> cellVertexIndices(m_cellCounts[0] * m_cellCounts[1] * m_cellCounts[2], -1);
+    for (const auto &cellVertices: m_blockCellVertices) {
+        for (const auto &it: cellVertices) {
+            cellVertexIndices[it.cellIndex] = (int32_t)m_resultVertices.size();
+            m_resultVertices.push_back(it.position);
+            m_resultVertexSources.push_back(it.source);
+        }
+    }
+    
+    // One quad around each edge crossing the surface, facing the outside
+    for (const auto &blockIndex: m_activeBlockIndices) {
+        size_t begin[3];
+        size_t end[3];
+        blockRange(blockIndex, begin, end);
+        for (size_t axis = 0; axis < 3; ++axis) {
+            if (end[axis] == m_cellCounts[axis])
+                ++end[axis];
+        }
+        size_t coords[3];
+        for (coords[2] = begin[2]; coords[2] < end[2]; ++coords[2]) {
+            for (coords[1] = begin[1]; coords[1] < end[1]; ++coords[1]) {
+                for (coords[0] = begin[0]; coords[0] < end[0]; ++coords[0]) {
+                    float value = m_samples[sampleIndex(coords[0], coords[1], coords[2])];
+                    for (size_t axis = 0; axis < 3; ++axis) {
+                        size_t u = (axis + 1) % 3;
+                        size_t v = (axis + 2) % 3;
+                        if (coords[axis] >= m_cellCounts[axis] ||
+                                coords[u] < 1 || coords[u] >= m_cellCounts[u] ||
+                                coords[v] < 1 || coords[v] >= m_cellCounts[v])
+                            continue;
+                        size_t next[3] = {coords[0], coords[1], coords[2]};
+                        ++next[axis];
+                        float nextValue = m_samples[sampleIndex(next[0], next[1], next[2])];
+                        if ((value < 0) == (nextValue < 0))
+                            continue;
+                        static const size_t s_quadCorners[4][2] = {{1, 1}, {0, 1}, {0, 0}, {1, 0}};
+                        std::vector<size_t> quad(4);
+                        bool isComplete = true;
+                        for (size_t n = 0; n < 4; ++n) {
+                            size_t cell[3] = {coords[0], coords[1], coords[2]};
+                            cell[u] -= s_quadCorners[n][0];
+                            cell[v] -= s_quadCorners[n][1];
+                            int32_t vertexIndex = cellVertexIndices[cellIndex(cell[0], cell[1], cell[2])];
+                            if (-1 == vertexIndex) {
+                                isComplete = false;
+                                break;
+                            }
+                            quad[n] = (size_t)vertexIndex;
+                        }
+                        if (!isComplete)
+                            continue;
+                        if (value >= 0)
+                            std::reverse(quad.begin(), quad.end());
+                        m_resultQuads.push_back(quad);
+                    }
+                }
+            }
+        }
+    }
+    
+    return true;
+}
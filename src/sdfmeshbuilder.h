@@ -0,0 +1,100 @@
+#ifndef DUST3D_SDF_MESH_BUILDER_H
+#define DUST3D_SDF_MESH_BUILDER_H
+#include <QVector3D>
+#include <vector>
+#include <cstdint>
+
+// Approximates the combined mesh from signed distance fields, for the interactive preview.
+// The parts are unions of round cones between the connected nodes, the groups are combined in order by union or subtraction,
+// the field is sampled on a sparse voxel grid, where the blocks far from the surface are skipped, and meshed by dual contouring.
+
+class SdfMeshBuilder
+{
+public:
+    static const size_t RootGroup = 0;
+    static const size_t DefaultResolution = 96;
+    static const size_t BlockSize = 8;
+
+    SdfMeshBuilder();
+    // The primitives of a group are united, then the child groups are united or subtracted in the order they were added
+    size_t addGroup(size_t parentGroup, bool subtracted);
+    void addSphere(size_t group, const QVector3D &center, float radius, size_t source);
+    void addRoundCone(size_t group, const QVector3D &from, float fromRadius, size_t fromSource,
+        const QVector3D &to, float toRadius, size_t toSource);
+    // Cells along the longest side of the bounding box
+    void setResolution(size_t resolution);
+    bool build();
+    const std::vector<QVector3D> &resultVertices() const;
+    const std::vector<std::vector<size_t>> &resultQuads() const;
+    // The source of the primitive nearest to each vertex, the subtracted primitives are not sources
+    const std::vector<size_t> &resultVertexSources() const;
+
+private:
+    friend class SdfBlockSampler;
+    friend class SdfCellVertexPlacer;
+
+    struct Primitive
+    {
+        QVector3D from;
+        QVector3D to;
+        float fromRadius = 0;
+        float toRadius = 0;
+        size_t fromSource = 0;
+        size_t toSource = 0;
+        size_t group = 0;
+        QVector3D boundMin;
+        QVector3D boundMax;
+    };
+
+    struct Group
+    {
+        std::vector<size_t> primitiveIndices;
+        std::vector<std::pair<size_t, bool>> children;
+        bool carved = false;
+    };
+
+    struct Block
+    {
+        bool active = false;
+        // The primitives near the block, grouped the same as m_groups
+        std::vector<uint32_t> groupOffsets;
+        std::vector<uint32_t> primitiveIndices;
+    };
+
+    struct CellVertex
+    {
+        size_t cellIndex;
+        QVector3D position;
+        size_t source;
+    };
+
+    std::vector<Primitive> m_primitives;
+    std::vector<Group> m_groups;
+    size_t m_resolution = DefaultResolution;
+    QVector3D m_origin;
+    float m_cellSize = 0;
+    size_t m_cellCounts[3] = {0, 0, 0};
+    size_t m_blockCounts[3] = {0, 0, 0};
+    std::vector<float> m_samples;
+    std::vector<Block> m_blocks;
+    std::vector<size_t> m_activeBlockIndices;
+    std::vector<std::vector<CellVertex>> m_blockCellVertices;
+    std::vector<QVector3D> m_resultVertices;
+    std::vector<std::vector<size_t>> m_resultQuads;
+    std::vector<size_t> m_resultVertexSources;
+
+    static float primitiveDistance(const Primitive &primitive, const QVector3D &position);
+    float evaluate(const Block &block, size_t group, const QVector3D &position) const;
+    float evaluate(const Block &block, const QVector3D &position) const;
+    size_t nearestSource(const Block &block, const QVector3D &position) const;
+    size_t sampleIndex(size_t i, size_t j, size_t k) const;
+    size_t cellIndex(size_t i, size_t j, size_t k) const;
+    QVector3D samplePosition(size_t i, size_t j, size_t k) const;
+    void blockRange(size_t blockIndex, size_t *begin, size_t *end) const;
+    void sampleBlock(size_t blockIndex);
+    void placeBlockCellVertices(size_t activeIndex);
+    void collectBlockPrimitives(const QVector3D &boundMin, const QVector3D &boundMax, Block *block) const;
+    void markCarvedGroups(size_t group, bool carved);
+};
+
+#endif
@@ -2,6 +2,7 @@
 #include <tbb/blocked_range.h>
 #include "simulateclothmeshes.h"
 #include "positionkey.h"
+#include "openhashmap.h"
 #include "util.h"
 #include "clothsimulator.h"
 
@@ -9,17 +10,16 @@ class ClothMeshesSimulator
 {
 public:
     ClothMeshesSimulator(std::vector<ClothMesh> *clothMeshes,
-            const std::vector<QVector3D> *clothCollisionVertices,
-            const std::vector<std::vector<size_t>> *clothCollisionTriangles) :
+            std::shared_ptr<const ClothCollisionShape> clothCollisionShape) :
         m_clothMeshes(clothMeshes),
-        m_clothCollisionVertices(clothCollisionVertices),
-        m_clothCollisionTriangles(clothCollisionTriangles)
+        m_clothCollisionShape(clothCollisionShape)
     {
     }
     void simulate(ClothMesh *clothMesh) const
     {
         const auto &filteredClothFaces = clothMesh->faces;
-        std::map<PositionKey, std::pair<QUuid, QUuid>> positionMap;
+        OpenHashMap<PositionKey, std::pair<QUuid, QUuid>> positionMap;
+        positionMap.reserve(clothMesh->objectNodeVertices->size());
         std::pair<QUuid, QUuid> defaultSource;
         for (const auto &it: *clothMesh->objectNodeVertices) {
             if (!it.second.first.isNull())
@@ -58,16 +58,50 @@ public:
             postProcessDirections.resize(filteredClothVertices.size(), QVector3D(0.0f, -1.0f, 0.0f) * clothOffset);
             externalForces.resize(filteredClothVertices.size(), QVector3D(0.0f, -1.0f, 0.0f));
         }
-        ClothSimulator clothSimulator(filteredClothVertices,
-            filteredClothFaces,
-            *m_clothCollisionVertices,
-            *m_clothCollisionTriangles,
-            externalForces);
-        clothSimulator.setStiffness(clothMesh->clothStiffness);
-        clothSimulator.create();
-        for (size_t i = 0; i < clothMesh->clothIteration; ++i)
-            clothSimulator.step();
-        clothSimulator.getCurrentVertices(&filteredClothVertices);
+        ClothSimulationState *state = clothMesh->simulationState;
+        bool isSameFaces = nullptr != state &&
+            state->vertices.size() == filteredClothVertices.size() &&
+            state->faces == filteredClothFaces;
+        if (isSameFaces &&
+                state->vertices == filteredClothVertices &&
+                state->clothForce == clothForce &&
+                state->clothStiffness == clothMesh->clothStiffness &&
+                state->clothIteration == clothMesh->clothIteration &&
+                state->collisionShape == m_clothCollisionShape) {
+            filteredClothVertices = state->simulatedVertices;
+        } else {
+            ClothSimulator clothSimulator(filteredClothVertices,
+                filteredClothFaces,
+                m_clothCollisionShape,
+                externalForces);
+            clothSimulator.setStiffness(clothMesh->clothStiffness);
+            if (isSameFaces && state->clothStiffness == clothMesh->clothStiffness)
+                clothSimulator.setSolverMatrices(state->solverMatrices);
+            // Only a settled result is as good as the rest positions to start from, the simulation of an unsettled one
+            // would go on from where the last one stopped
+            if (isSameFaces && state->settled)
+                clothSimulator.setInitialVertices(state->simulatedVertices);
+            clothSimulator.create();
+            for (size_t i = 0; i < clothMesh->clothIteration; ++i) {
+                clothSimulator.step();
+                ++clothMesh->simulatedIteration;
+                if (clothSimulator.isSettled())
+                    break;
+            }
+            if (nullptr != state) {
+                state->vertices = filteredClothVertices;
+                state->faces = filteredClothFaces;
+                state->clothForce = clothForce;
+                state->clothStiffness = clothMesh->clothStiffness;
+                state->clothIteration = clothMesh->clothIteration;
+                state->collisionShape = m_clothCollisionShape;
+                state->solverMatrices = clothSimulator.solverMatrices();
+                state->settled = clothSimulator.isSettled();
+            }
+            clothSimulator.getCurrentVertices(&filteredClothVertices);
+            if (nullptr != state)
+                state->simulatedVertices = filteredClothVertices;
+        }
         for (size_t i = 0; i < filteredClothVertices.size(); ++i) {
             filteredClothVertices[i] -= postProcessDirections[i];
         }
@@ -80,16 +114,13 @@ public:
     }
 private:
     std::vector<ClothMesh> *m_clothMeshes = nullptr;
-    const std::vector<QVector3D> *m_clothCollisionVertices = nullptr;
-    const std::vector<std::vector<size_t>> *m_clothCollisionTriangles = nullptr;
+    std::shared_ptr<const ClothCollisionShape> m_clothCollisionShape;
 };
 
 void simulateClothMeshes(std::vector<ClothMesh> *clothMeshes,
-    const std::vector<QVector3D> *clothCollisionVertices,
-    const std::vector<std::vector<size_t>> *clothCollisionTriangles)
+    std::shared_ptr<const ClothCollisionShape> clothCollisionShape)
 {
     tbb::parallel_for(tbb::blocked_range<size_t>(0, clothMeshes->size()),
         ClothMeshesSimulator(clothMeshes,
-            clothCollisionVertices,
-            clothCollisionTriangles));
+            clothCollisionShape));
 }
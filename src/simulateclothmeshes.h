@@ -3,8 +3,28 @@
 #include <QVector3D>
 #include <vector>
 #include <QUuid>
+#include <memory>
 #include "clothforce.h"
 
+class ClothCollisionShape;
+struct mass_spring_matrices;
+
+// What a simulation leaves to the next simulation of the same cloth: the result is reused when nothing changed,
+// the solver matrices while the faces and the stiffness are the same, and a settled result is where the next simulation
+// of the same faces starts from, instead of the rest positions
+struct ClothSimulationState
+{
+    std::vector<QVector3D> vertices;
+    std::vector<std::vector<size_t>> faces;
+    ClothForce clothForce;
+    float clothStiffness = 0.0f;
+    size_t clothIteration = 0;
+    std::shared_ptr<const ClothCollisionShape> collisionShape;
+    std::shared_ptr<const mass_spring_matrices> solverMatrices;
+    std::vector<QVector3D> simulatedVertices;
+    bool settled = false;
+};
+
 struct ClothMesh
 {
     std::vector<QVector3D> vertices;
@@ -15,10 +35,12 @@ struct ClothMesh
     float clothOffset;
     float clothStiffness;
     size_t clothIteration;
+    // Read and updated by the simulation, optional
+    ClothSimulationState *simulationState = nullptr;
+    size_t simulatedIteration = 0;
 };
 
 void simulateClothMeshes(std::vector<ClothMesh> *clothMeshes,
-    const std::vector<QVector3D> *clothCollisionVertices,
-    const std::vector<std::vector<size_t>> *clothCollisionTriangles);
+    std::shared_ptr<const ClothCollisionShape> clothCollisionShape);
 
 #endif
@@ -1496,6 +1496,7 @@ bool SkeletonGraphicsWidget::mouseRelease(QMouseEvent *event)
             m_lastRot = 0;
             if (m_moveHappened)
                 emit groupOperationAdded();
+            emit interactiveEditEnd();
         }
         if (m_rangeSelectionStarted) {
             m_selectionItem->hide();
@@ -1621,6 +1622,7 @@ bool SkeletonGraphicsWidget::mousePress(QMouseEvent *event)
                     m_lastScenePos = mouseEventScenePos(event);
                     m_moveHappened = false;
                     processed = true;
+                    emit interactiveEditBegin();
                 }
             } else {
                 if ((nullptr == m_hoveredNodeItem || m_rangeSelectionSet.find(m_hoveredNodeItem) == m_rangeSelectionSet.end()) &&
@@ -1650,6 +1652,7 @@ bool SkeletonGraphicsWidget::mousePress(QMouseEvent *event)
                             m_lastScenePos = mouseEventScenePos(event);
                             m_moveHappened = false;
                             processed = true;
+                            emit interactiveEditBegin();
                         }
                     }
                 }
@@ -480,6 +480,8 @@ signals:
     void changeTurnaround();
     void batchChangeBegin();
     void batchChangeEnd();
+    void interactiveEditBegin();
+    void interactiveEditEnd();
     void open();
     void exportResult();
     void breakEdge(QUuid edgeId);
@@ -0,0 +1,475 @@
+#include <QPainter>
+#include <QPixmap>
+#include <QRadialGradient>
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#include <cmath>
+#include <algorithm>
+#include "texturebaker.h"
+
+class TextureTileBaker
+{
+public:
+    TextureTileBaker(const TextureBaker *baker,
+            const std::vector<std::vector<size_t>> *tileCommands,
+            uchar *const *imageBits,
+            int bytesPerLine) :
+        m_baker(baker),
+        m_tileCommands(tileCommands),
+        m_imageBits(imageBits),
+        m_bytesPerLine(bytesPerLine)
+    {
+    }
+    void operator()(const tbb::blocked_range<size_t> &range) const
+    {
+        int tilesPerRow = (m_baker->m_textureSize + TextureBaker::TileSize - 1) / TextureBaker::TileSize;
+        std::vector<TextureBaker::Pixel> tilePixels(TextureBaker::TileSize * TextureBaker::TileSize);
+        for (size_t tileIndex = range.begin(); tileIndex != range.end(); ++tileIndex) {
+            int tileLeft = (int)(tileIndex % tilesPerRow) * TextureBaker::TileSize;
+            int tileTop = (int)(tileIndex / tilesPerRow) * TextureBaker::TileSize;
+            int tileRight = std::min(tileLeft + TextureBaker::TileSize, m_baker->m_textureSize);
+            int tileBottom = std::min(tileTop + TextureBaker::TileSize, m_baker->m_textureSize);
+            for (int channel = 0; channel < (int)TextureBaker::Channel::Count; ++channel) {
+                if (nullptr == m_imageBits[channel])
+                    continue;
+                const auto &commandIndices = m_tileCommands[channel][tileIndex];
+                if (commandIndices.empty()) {
+                    QRgb background = TextureBaker::unpremultipliedRgba(TextureBaker::premultipliedPixel(m_baker->m_backgrounds[channel]));
+                    for (int y = tileTop; y < tileBottom; ++y) {
+                        QRgb *line = (QRgb *)(m_imageBits[channel] + (size_t)y * m_bytesPerLine);
+                        std::fill(line + tileLeft, line + tileRight, background);
+                    }
+                    continue;
+                }
+                std::fill(tilePixels.begin(), tilePixels.end(), TextureBaker::premultipliedPixel(m_baker->m_backgrounds[channel]));
+                const auto &commands = m_baker->m_commands[channel];
+                for (const auto &commandIndex: commandIndices)
+                    m_baker->bakeCommand(commands[commandIndex], tileLeft, tileTop, tileRight, tileBottom, tilePixels.data());
+                for (int y = tileTop; y < tileBottom; ++y) {
+                    QRgb *line = (QRgb *)(m_imageBits[channel] + (size_t)y * m_bytesPerLine);
+                    const TextureBaker::Pixel *pixels = &tilePixels[(y - tileTop) * TextureBaker::TileSize];
+                    for (int x = tileLeft; x < tileRight; ++x)
+                        line[x] = TextureBaker::unpremultipliedRgba(pixels[x - tileLeft]);
+                }
+            }
+        }
+    }
+private:
+    const TextureBaker *m_baker = nullptr;
+    const std::vector<std::vector<size_t>> *m_tileCommands = nullptr;
+    uchar *const *m_imageBits = nullptr;
+    int m_bytesPerLine = 0;
+};
+
+TextureBaker::TextureBaker(int textureSize) :
+    m_textureSize(textureSize)
+{
+}
+
+void TextureBaker::setBackground(Channel channel, const QColor &color)
+{
+    m_backgrounds[(int)channel] = color;
+}
+
+void TextureBaker::setChannelEnabled(Channel channel, bool enabled)
+{
+    m_channelEnabled[(int)channel] = enabled;
+}
+
+void TextureBaker::fillRect(Channel channel, const QRectF &rect, const QColor &color)
+{
+    Command command;
+    command.type = CommandType::FillRect;
+    command.rect = rect;
+    command.color = color;
+    addCommand(channel, command, true);
+}
+
+void TextureBaker::drawTiledImage(Channel channel, const QRectF &rect, const QImage *image, const QPointF &offset, float opacity)
+{
+    if (nullptr == image || image->isNull())
+        return;
+    Command command;
+    command.type = CommandType::TiledImage;
+    command.rect = rect;
+    command.image = image;
+    command.offset = offset;
+    command.opacity = opacity;
+    addCommand(channel, command, false);
+}
+
+void TextureBaker::fillRadialGradient(Channel channel, const QRectF &rect, const QPointF &center, float radius,
+    const QColor &color, float opacity, bool softLight)
+{
+    Command command;
+    command.type = CommandType::RadialGradient;
+    command.rect = rect;
+    command.center = center;
+    command.radius = radius;
+    command.color = color;
+    command.opacity = opacity;
+    command.softLight = softLight;
+    addCommand(channel, command, true);
+}
+
+void TextureBaker::drawTiledImageInRadialGradient(Channel channel, const QRectF &rect, const QImage *image, const QPointF &offset,
+    const QPointF &center, float radius, const QColor &color, float opacity)
+{
+    if (nullptr == image || image->isNull())
+        return;
+    Command command;
+    command.type = CommandType::TiledImageInRadialGradient;
+    command.rect = rect;
+    command.image = image;
+    command.offset = offset;
+    command.center = center;
+    command.radius = radius;
+    command.color = color;
+    command.opacity = opacity;
+    addCommand(channel, command, false);
+}
+
+void TextureBaker::addCommand(Channel channel, Command &command, bool antialiased)
+{
+    if (antialiased) {
+        // Every pixel partly covered
+        command.left = (int)std::floor(command.rect.left());
+        command.top = (int)std::floor(command.rect.top());
+        command.right = (int)std::ceil(command.rect.right());
+        command.bottom = (int)std::ceil(command.rect.bottom());
+    } else if (CommandType::TiledImageInRadialGradient == command.type) {
+        // QPainter draws it through an image of the truncated size, placed on the rounded position
+        command.left = qRound(command.rect.left());
+        command.top = qRound(command.rect.top());
+        command.right = command.left + (int)command.rect.width();
+        command.bottom = command.top + (int)command.rect.height();
+    } else {
+        // The rounded rect, as QPainter draws an untransformed tiled pixmap
+        command.left = qRound(command.rect.left());
+        command.top = qRound(command.rect.top());
+        command.right = qRound(command.rect.right());
+        command.bottom = qRound(command.rect.bottom());
+    }
+    command.left = std::max(command.left, 0);
+    command.top = std::max(command.top, 0);
+    command.right = std::min(command.right, m_textureSize);
+    command.bottom = std::min(command.bottom, m_textureSize);
+    if (command.left >= command.right || command.top >= command.bottom)
+        return;
+    m_commands[(int)channel].push_back(command);
+}
+
+TextureBaker::Pixel TextureBaker::premultipliedPixel(const QColor &color)
+{
+    Pixel pixel;
+    pixel.alpha = color.alphaF();
+    pixel.red = color.redF() * pixel.alpha;
+    pixel.green = color.greenF() * pixel.alpha;
+    pixel.blue = color.blueF() * pixel.alpha;
+    return pixel;
+}
+
+TextureBaker::Pixel TextureBaker::premultipliedPixel(QRgb rgba)
+{
+    // From a premultiplied image
+    const float scale = 1.0f / 255;
+    Pixel pixel;
+    pixel.alpha = qAlpha(rgba) * scale;
+    pixel.red = qRed(rgba) * scale;
+    pixel.green = qGreen(rgba) * scale;
+    pixel.blue = qBlue(rgba) * scale;
+    return pixel;
+}
+
+QRgb TextureBaker::unpremultipliedRgba(const Pixel &pixel)
+{
+    int alpha = qRound(std::max(0.0f, std::min(pixel.alpha, 1.0f)) * 255);
+    if (0 == alpha)
+        return 0;
+    float scale = 255.0f / pixel.alpha;
+    auto component = [&](float value) {
+        return qRound(std::max(0.0f, std::min(value * scale, 255.0f)));
+    };
+    return qRgba(component(pixel.red), component(pixel.green), component(pixel.blue), alpha);
+}
+
+float TextureBaker::coverage(const QRectF &rect, int x, int y)
+{
+    float width = std::min((float)rect.right(), x + 1.0f) - std::max((float)rect.left(), (float)x);
+    if (width <= 0)
+        return 0.0f;
+    float height = std::min((float)rect.bottom(), y + 1.0f) - std::max((float)rect.top(), (float)y);
+    if (height <= 0)
+        return 0.0f;
+    return width * height;
+}
+
+float TextureBaker::gradientAlpha(const Command &command, float x, float y)
+{
+    if (command.radius <= 0)
+        return 0.0f;
+    float dx = x - (float)command.center.x();
+    float dy = y - (float)command.center.y();
+    float t = std::sqrt(dx * dx + dy * dy) / command.radius;
+    return t >= 1.0f ? 0.0f : 1.0f - t;
+}
+
+const QImage &TextureBaker::premultipliedImage(const QImage *image) const
+{
+    return m_premultipliedImages.find(image)->second;
+}
+
+void TextureBaker::blendSourceOver(Pixel *destination, float red, float green, float blue, float alpha)
+{
+    float inverseAlpha = 1.0f - alpha;
+    destination->red = red + destination->red * inverseAlpha;
+    destination->green = green + destination->green * inverseAlpha;
+    destination->blue = blue + destination->blue * inverseAlpha;
+    destination->alpha = alpha + destination->alpha * inverseAlpha;
+}
+
+// The soft light of QPainter, on premultiplied components
+static float softLight(float destination, float source, float destinationAlpha, float sourceAlpha)
+{
+    float destinationRatio = destinationAlpha > 0 ? destination / destinationAlpha : 0.0f;
+    float rest = source * (1.0f - destinationAlpha) + destination * (1.0f - sourceAlpha);
+    if (2 * source <= sourceAlpha)
+        return destination * (sourceAlpha + (2 * source - sourceAlpha) * (1.0f - destinationRatio)) + rest;
+    if (4 * destination <= destinationAlpha) {
+        return destination * sourceAlpha + destinationAlpha * (2 * source - sourceAlpha) *
+            (4 * destinationRatio * (4 * destinationRatio + 1) * (destinationRatio - 1) + 7 * destinationRatio) + rest;
+    }
+    return destination * sourceAlpha + destinationAlpha * (2 * source - sourceAlpha) *
+        (std::sqrt(destinationRatio) - destinationRatio) + rest;
+}
+
+void TextureBaker::blendSoftLight(Pixel *destination, float red, float green, float blue, float alpha, float coverage)
+{
+    float blendedRed = softLight(destination->red, red, destination->alpha, alpha);
+    float blendedGreen = softLight(destination->green, green, destination->alpha, alpha);
+    float blendedBlue = softLight(destination->blue, blue, destination->alpha, alpha);
+    float blendedAlpha = alpha + destination->alpha - alpha * destination->alpha;
+    destination->red += (blendedRed - destination->red) * coverage;
+    destination->green += (blendedGreen - destination->green) * coverage;
+    destination->blue += (blendedBlue - destination->blue) * coverage;
+    destination->alpha += (blendedAlpha - destination->alpha) * coverage;
+}
+
+static int positiveModulo(int value, int divisor)
+{
+    int result = value % divisor;
+    return result < 0 ? result + divisor : result;
+}
+
+void TextureBaker::bakeCommand(const Command &command, int tileLeft, int tileTop, int tileRight, int tileBottom,
+    Pixel *tilePixels) const
+{
+    int left = std::max(command.left, tileLeft);
+    int top = std::max(command.top, tileTop);
+    int right = std::min(command.right, tileRight);
+    int bottom = std::min(command.bottom, tileBottom);
+    if (left >= right || top >= bottom)
+        return;
+    
+    auto pixelAt = [&](int x, int y) {
+        return &tilePixels[(y - tileTop) * TileSize + (x - tileLeft)];
+    };
+    
+    switch (command.type) {
+    case CommandType::FillRect: {
+        Pixel source = premultipliedPixel(command.color);
+        for (int y = top; y < bottom; ++y) {
+            for (int x = left; x < right; ++x) {
+                float pixelCoverage = coverage(command.rect, x, y);
+                if (pixelCoverage <= 0)
+                    continue;
+                blendSourceOver(pixelAt(x, y), source.red * pixelCoverage, source.green * pixelCoverage,
+                    source.blue * pixelCoverage, source.alpha * pixelCoverage);
+            }
+        }
+        break;
+    }
+    case CommandType::TiledImage: {
+        const QImage &image = premultipliedImage(command.image);
+        int imageLeft = qRound(command.rect.left() - command.offset.x());
+        int imageTop = qRound(command.rect.top() - command.offset.y());
+        int imageLineLeft = positiveModulo(left - imageLeft, image.width());
+        for (int y = top; y < bottom; ++y) {
+            const QRgb *imageLine = (const QRgb *)image.constScanLine(positiveModulo(y - imageTop, image.height()));
+            int imageX = imageLineLeft;
+            for (int x = left; x < right; ++x) {
+                Pixel source = premultipliedPixel(imageLine[imageX]);
+                if (++imageX == image.width())
+                    imageX = 0;
+                blendSourceOver(pixelAt(x, y), source.red * command.opacity, source.green * command.opacity,
+                    source.blue * command.opacity, source.alpha * command.opacity);
+            }
+        }
+        break;
+    }
+    case CommandType::RadialGradient: {
+        Pixel color = premultipliedPixel(command.color);
+        for (int y = top; y < bottom; ++y) {
+            for (int x = left; x < right; ++x) {
+                float pixelCoverage = coverage(command.rect, x, y) * command.opacity;
+                if (pixelCoverage <= 0)
+                    continue;
+                float fade = gradientAlpha(command, x + 0.5f, y + 0.5f);
+                if (command.softLight) {
+                    blendSoftLight(pixelAt(x, y), color.red * fade, color.green * fade,
+                        color.blue * fade, color.alpha * fade, pixelCoverage);
+                } else {
+                    float scale = fade * pixelCoverage;
+                    blendSourceOver(pixelAt(x, y), color.red * scale, color.green * scale,
+                        color.blue * scale, color.alpha * scale);
+                }
+            }
+        }
+        break;
+    }
+    case CommandType::TiledImageInRadialGradient: {
+        // Through an image placed on the rounded top left, the image is tiled from the offset, the gradient is centered in it
+        const QImage &image = premultipliedImage(command.image);
+        int frameLeft = qRound(command.rect.left());
+        int frameTop = qRound(command.rect.top());
+        int imageLeft = frameLeft - qRound(command.offset.x());
+        int imageTop = frameTop - qRound(command.offset.y());
+        float centerLeft = (float)(command.center.x() - command.rect.left()) + frameLeft;
+        float centerTop = (float)(command.center.y() - command.rect.top()) + frameTop;
+        Command gradient = command;
+        gradient.center = QPointF(centerLeft, centerTop);
+        float colorAlpha = command.color.alphaF();
+        int imageLineLeft = positiveModulo(left - imageLeft, image.width());
+        for (int y = top; y < bottom; ++y) {
+            const QRgb *imageLine = (const QRgb *)image.constScanLine(positiveModulo(y - imageTop, image.height()));
+            int imageX = imageLineLeft;
+            for (int x = left; x < right; ++x, imageX = (imageX + 1 == image.width() ? 0 : imageX + 1)) {
+                float scale = command.opacity * command.opacity * colorAlpha * gradientAlpha(gradient, x + 0.5f, y + 0.5f);
+                if (scale <= 0)
+                    continue;
+                Pixel source = premultipliedPixel(imageLine[imageX]);
+                blendSourceOver(pixelAt(x, y), source.red * scale, source.green * scale,
+                    source.blue * scale, source.alpha * scale);
+            }
+        }
+        break;
+    }
+    }
+}
+
+void TextureBaker::bake(QImage *images[(int)Channel::Count])
+{
+    for (int channel = 0; channel < (int)Channel::Count; ++channel) {
+        for (const auto &command: m_commands[channel]) {
+            if (nullptr == command.image || m_premultipliedImages.find(command.image) != m_premultipliedImages.end())
+                continue;
+            m_premultipliedImages.insert({command.image, command.image->convertToFormat(QImage::Format_ARGB32_Premultiplied)});
+        }
+    }
+    
+    // The commands of each tile, in the recorded order
+    int tilesPerRow = (m_textureSize + TileSize - 1) / TileSize;
+    size_t tileCount = (size_t)tilesPerRow * tilesPerRow;
+    std::vector<std::vector<size_t>> tileCommands[(int)Channel::Count];
+    uchar *imageBits[(int)Channel::Count] = {nullptr};
+    int bytesPerLine = 0;
+    for (int channel = 0; channel < (int)Channel::Count; ++channel) {
+        images[channel] = nullptr;
+        if (!m_channelEnabled[channel])
+            continue;
+        auto &channelTileCommands = tileCommands[channel];
+        channelTileCommands.resize(tileCount);
+        const auto &commands = m_commands[channel];
+        for (size_t commandIndex = 0; commandIndex < commands.size(); ++commandIndex) {
+            const auto &command = commands[commandIndex];
+            for (int tileY = command.top / TileSize; tileY <= (command.bottom - 1) / TileSize; ++tileY) {
+                for (int tileX = command.left / TileSize; tileX <= (command.right - 1) / TileSize; ++tileX)
+                    channelTileCommands[(size_t)tileY * tilesPerRow + tileX].push_back(commandIndex);
+            }
+        }
+        images[channel] = new QImage(m_textureSize, m_textureSize, QImage::Format_ARGB32);
+        imageBits[channel] = images[channel]->bits();
+        bytesPerLine = images[channel]->bytesPerLine();
+    }
+    
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, tileCount),
+        TextureTileBaker(this, tileCommands, imageBits, bytesPerLine));
+}
+
+void TextureBaker::paint(QImage *images[(int)Channel::Count])
+{
+    std::map<const QImage *, QPixmap> pixmaps;
+    auto pixmapOf = [&](const QImage *image) -> const QPixmap & {
+        auto findPixmap = pixmaps.find(image);
+        if (findPixmap == pixmaps.end())
+            findPixmap = pixmaps.insert({image, QPixmap::fromImage(*image)}).first;
+        return findPixmap->second;
+    };
+    
+    for (int channel = 0; channel < (int)Channel::Count; ++channel) {
+        images[channel] = nullptr;
+        if (!m_channelEnabled[channel])
+            continue;
+        images[channel] = new QImage(m_textureSize, m_textureSize, QImage::Format_ARGB32);
+        images[channel]->fill(m_backgrounds[channel]);
+        
+        QPainter painter;
+        painter.begin(images[channel]);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setRenderHint(QPainter::HighQualityAntialiasing);
+        painter.setPen(Qt::NoPen);
+        
+        for (const auto &command: m_commands[channel]) {
+            painter.setOpacity(command.opacity);
+            switch (command.type) {
+            case CommandType::FillRect:
+                painter.fillRect(command.rect, QBrush(command.color));
+                break;
+            case CommandType::TiledImage:
+                painter.drawTiledPixmap(command.rect, pixmapOf(command.image), command.offset);
+                break;
+            case CommandType::RadialGradient: {
+                QRadialGradient gradient(command.center, command.radius);
+                gradient.setColorAt(0.0, command.color);
+                gradient.setColorAt(1.0, Qt::transparent);
+                if (command.softLight)
+                    painter.setCompositionMode(QPainter::CompositionMode_SoftLight);
+                painter.fillRect(command.rect, gradient);
+                painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+                break;
+            }
+            case CommandType::TiledImageInRadialGradient: {
+                // Filled with transparent first, the image used to be drawn over uninitialized pixels
+                QImage tmpImage((int)command.rect.width(), (int)command.rect.height(), QImage::Format_ARGB32);
+                tmpImage.fill(Qt::transparent);
+                QPixmap tmpPixmap = QPixmap::fromImage(tmpImage);
+                QPainter tmpPainter;
+                QRectF tmpImageFrame = QRectF(0, 0, command.rect.width(), command.rect.height());
+                    
+                // Fill tiled texture
+                tmpPainter.begin(&tmpPixmap);
+                tmpPainter.setOpacity(command.opacity);
+                tmpPainter.drawTiledPixmap(tmpImageFrame, pixmapOf(command.image), command.offset);
+                tmpPainter.setOpacity(1.0);
+                tmpPainter.end();
+                    
+                // Apply gradient
+                QRadialGradient gradient(command.center - command.rect.topLeft(), command.radius);
+                gradient.setColorAt(0.0, command.color);
+                gradient.setColorAt(1.0, Qt::transparent);
+                    
+                tmpPainter.begin(&tmpPixmap);
+                tmpPainter.setCompositionMode(QPainter::CompositionMode_DestinationIn);
+                tmpPainter.fillRect(tmpImageFrame, gradient);
+                tmpPainter.end();
+                    
+                painter.drawPixmap(command.rect, tmpPixmap, tmpImageFrame);
+                break;
+            }
+            }
+        }
+        painter.setOpacity(1.0);
+        
+        painter.end();
+    }
+}
@@ -0,0 +1,105 @@
+#ifndef DUST3D_TEXTURE_BAKER_H
+#define DUST3D_TEXTURE_BAKER_H
+#include <QImage>
+#include <QColor>
+#include <QRectF>
+#include <QPointF>
+#include <vector>
+#include <map>
+
+// Records the drawing of the texture maps, then either bakes all the maps in one pass over square tiles of the atlas,
+// the tiles in parallel, each applying the commands overlapping it in the recorded order,
+// or paints them with QPainter, one map after another, which is the reference of the baking.
+// All the positions are in pixels.
+
+class TextureBaker
+{
+public:
+    enum class Channel
+    {
+        Color = 0,
+        Normal,
+        Metalness,
+        Roughness,
+        AmbientOcclusion,
+        Count
+    };
+
+    static const int TileSize = 64;
+
+    TextureBaker(int textureSize);
+    void setBackground(Channel channel, const QColor &color);
+    // A disabled channel is neither baked nor painted, its image is left null
+    void setChannelEnabled(Channel channel, bool enabled);
+    // Antialiased on the edges
+    void fillRect(Channel channel, const QRectF &rect, const QColor &color);
+    // The image is tiled over the rect, with the point at the offset of the image on the top left of the rect
+    void drawTiledImage(Channel channel, const QRectF &rect, const QImage *image, const QPointF &offset, float opacity);
+    // A radial gradient from the color at the center to transparent at the radius, blended by soft light or over
+    void fillRadialGradient(Channel channel, const QRectF &rect, const QPointF &center, float radius,
+        const QColor &color, float opacity, bool softLight);
+    // The tiled image, faded out by the alpha of the radial gradient, then drawn over with the opacity
+    void drawTiledImageInRadialGradient(Channel channel, const QRectF &rect, const QImage *image, const QPointF &offset,
+        const QPointF &center, float radius, const QColor &color, float opacity);
+    // The images of the enabled channels are created, the channels without commands are filled with the background only
+    void bake(QImage *images[(int)Channel::Count]);
+    void paint(QImage *images[(int)Channel::Count]);
+
+private:
+    enum class CommandType
+    {
+        FillRect,
+        TiledImage,
+        RadialGradient,
+        TiledImageInRadialGradient
+    };
+
+    struct Command
+    {
+        CommandType type;
+        QRectF rect;
+        QColor color;
+        const QImage *image = nullptr;
+        QPointF offset;
+        QPointF center;
+        float radius = 0.0f;
+        float opacity = 1.0f;
+        bool softLight = false;
+        // The pixels touched, the right and bottom exclusive, clipped to the texture
+        int left = 0;
+        int top = 0;
+        int right = 0;
+        int bottom = 0;
+    };
+
+    struct Pixel
+    {
+        float red = 0.0f;
+        float green = 0.0f;
+        float blue = 0.0f;
+        float alpha = 0.0f;
+    };
+
+    friend class TextureTileBaker;
+
+    int m_textureSize = 0;
+    QColor m_backgrounds[(int)Channel::Count];
+    bool m_channelEnabled[(int)Channel::Count] = {true, true, true, true, true};
+    std::vector<Command> m_commands[(int)Channel::Count];
+    // The recorded images, premultiplied, for sampling while baking
+    std::map<const QImage *, QImage> m_premultipliedImages;
+
+    void addCommand(Channel channel, Command &command, bool antialiased);
+    static Pixel premultipliedPixel(const QColor &color);
+    static Pixel premultipliedPixel(QRgb rgba);
+    static QRgb unpremultipliedRgba(const Pixel &pixel);
+    static float coverage(const QRectF &rect, int x, int y);
+    static float gradientAlpha(const Command &command, float x, float y);
+    static void blendSourceOver(Pixel *destination, float red, float green, float blue, float alpha);
+    static void blendSoftLight(Pixel *destination, float red, float green, float blue, float alpha, float coverage);
+    const QImage &premultipliedImage(const QImage *image) const;
+    void bakeCommand(const Command &command, int tileLeft, int tileTop, int tileRight, int tileBottom,
+        Pixel *tilePixels) const;
+};
+
+#endif
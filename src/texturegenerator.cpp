@@ -1,12 +1,13 @@
-#include <QPainter>
 #include <QGuiApplication>
 #include <QRegion>
 #include <QPolygon>
 #include <QElapsedTimer>
-#include <QRadialGradient>
+#include <QMatrix>
 #include "texturegenerator.h"
+#include "texturebaker.h"
 #include "theme.h"
 #include "util.h"
+#include "halfedgetable.h"
 #include "texturetype.h"
 #include "material.h"
 #include "preferences.h"
@@ -22,6 +23,7 @@ TextureGenerator::TextureGenerator(const Object &object, Snapshot *snapshot) :
     m_resultMesh(nullptr),
     m_snapshot(snapshot),
     m_hasTransparencySettings(false),
+    m_painterEnabled(false),
     m_textureSize(Preferences::instance().textureSize())
 {
     m_object = new Object();
@@ -126,6 +128,11 @@ void TextureGenerator::addPartAmbientOcclusionMap(QUuid partId, const QImage *im
     m_partAmbientOcclusionTextureMap[partId] = std::make_pair(*image, tileScale);
 }
 
+void TextureGenerator::setPainterEnabled(bool painterEnabled)
+{
+    m_painterEnabled = painterEnabled;
+}
+
 void TextureGenerator::prepare()
 {
     if (nullptr == m_snapshot)
@@ -226,55 +233,14 @@ void TextureGenerator::generate()
         partRoughnessMap.insert({item.partId, item.roughness});
     }
     
-    auto createImageBeginTime = countTimeConsumed.elapsed();
-    
-    m_resultTextureColorImage = new QImage(TextureGenerator::m_textureSize, TextureGenerator::m_textureSize, QImage::Format_ARGB32);
-    m_resultTextureColorImage->fill(m_hasTransparencySettings ? m_defaultTextureColor : Qt::white);
-    
-    m_resultTextureNormalImage = new QImage(TextureGenerator::m_textureSize, TextureGenerator::m_textureSize, QImage::Format_ARGB32);
-    m_resultTextureNormalImage->fill(QColor(128, 128, 255));
-    
-    m_resultTextureMetalnessImage = new QImage(TextureGenerator::m_textureSize, TextureGenerator::m_textureSize, QImage::Format_ARGB32);
-    m_resultTextureMetalnessImage->fill(Qt::black);
-    
-    m_resultTextureRoughnessImage = new QImage(TextureGenerator::m_textureSize, TextureGenerator::m_textureSize, QImage::Format_ARGB32);
-    m_resultTextureRoughnessImage->fill(Qt::white);
-    
-    m_resultTextureAmbientOcclusionImage = new QImage(TextureGenerator::m_textureSize, TextureGenerator::m_textureSize, QImage::Format_ARGB32);
-    m_resultTextureAmbientOcclusionImage->fill(Qt::white);
-    
-    auto createImageEndTime = countTimeConsumed.elapsed();
-    
-    QColor borderColor = Qt::darkGray;
-    QPen pen(borderColor);
-    
-    QPainter texturePainter;
-    texturePainter.begin(m_resultTextureColorImage);
-    texturePainter.setRenderHint(QPainter::Antialiasing);
-    texturePainter.setRenderHint(QPainter::HighQualityAntialiasing);
-    
-    QPainter textureNormalPainter;
-    textureNormalPainter.begin(m_resultTextureNormalImage);
-    textureNormalPainter.setRenderHint(QPainter::Antialiasing);
-    textureNormalPainter.setRenderHint(QPainter::HighQualityAntialiasing);
-    
-    QPainter textureMetalnessPainter;
-    textureMetalnessPainter.begin(m_resultTextureMetalnessImage);
-    textureMetalnessPainter.setRenderHint(QPainter::Antialiasing);
-    textureMetalnessPainter.setRenderHint(QPainter::HighQualityAntialiasing);
-    
-    QPainter textureRoughnessPainter;
-    textureRoughnessPainter.begin(m_resultTextureRoughnessImage);
-    textureRoughnessPainter.setRenderHint(QPainter::Antialiasing);
-    textureRoughnessPainter.setRenderHint(QPainter::HighQualityAntialiasing);
-    
-    QPainter textureAmbientOcclusionPainter;
-    textureAmbientOcclusionPainter.begin(m_resultTextureAmbientOcclusionImage);
-    textureAmbientOcclusionPainter.setRenderHint(QPainter::Antialiasing);
-    textureAmbientOcclusionPainter.setRenderHint(QPainter::HighQualityAntialiasing);
+    TextureBaker textureBaker(TextureGenerator::m_textureSize);
+    textureBaker.setBackground(TextureBaker::Channel::Color, m_hasTransparencySettings ? m_defaultTextureColor : Qt::white);
+    textureBaker.setBackground(TextureBaker::Channel::Normal, QColor(128, 128, 255));
+    textureBaker.setBackground(TextureBaker::Channel::Metalness, Qt::black);
+    textureBaker.setBackground(TextureBaker::Channel::Roughness, Qt::white);
+    textureBaker.setBackground(TextureBaker::Channel::AmbientOcclusion, Qt::white);
     
-    auto paintTextureBeginTime = countTimeConsumed.elapsed();
-    texturePainter.setPen(Qt::NoPen);
+    auto recordTextureBeginTime = countTimeConsumed.elapsed();
     
     for (const auto &it: partUvRects) {
         const auto &partId = it.first;
@@ -282,7 +248,6 @@ void TextureGenerator::generate()
         auto findSourceColorResult = partColorMap.find(partId);
         if (findSourceColorResult != partColorMap.end()) {
             const auto &color = findSourceColorResult->second;
-            QBrush brush(color);
             float fillExpandSize = 2;
             for (const auto &rect: rects) {
                 QRectF translatedRect = {
@@ -291,7 +256,7 @@ void TextureGenerator::generate()
                     rect.width() * TextureGenerator::m_textureSize + fillExpandSize * 2,
                     rect.height() * TextureGenerator::m_textureSize + fillExpandSize * 2
                 };
-                texturePainter.fillRect(translatedRect, brush);
+                textureBaker.fillRect(TextureBaker::Channel::Color, translatedRect, color);
             }
         }
     }
@@ -306,7 +271,6 @@ void TextureGenerator::generate()
             const auto &color = QColor(findMetalnessResult->second * 255,
                 findMetalnessResult->second * 255,
                 findMetalnessResult->second * 255);
-            QBrush brush(color);
             float fillExpandSize = 2;
             for (const auto &rect: rects) {
                 QRectF translatedRect = {
@@ -315,7 +279,7 @@ void TextureGenerator::generate()
                     rect.width() * TextureGenerator::m_textureSize + fillExpandSize * 2,
                     rect.height() * TextureGenerator::m_textureSize + fillExpandSize * 2
                 };
-                textureMetalnessPainter.fillRect(translatedRect, brush);
+                textureBaker.fillRect(TextureBaker::Channel::Metalness, translatedRect, color);
                 hasMetalnessMap = true;
             }
         }
@@ -331,7 +295,6 @@ void TextureGenerator::generate()
             const auto &color = QColor(findRoughnessResult->second * 255,
                 findRoughnessResult->second * 255,
                 findRoughnessResult->second * 255);
-            QBrush brush(color);
             float fillExpandSize = 2;
             for (const auto &rect: rects) {
                 QRectF translatedRect = {
@@ -340,13 +303,13 @@ void TextureGenerator::generate()
                     rect.width() * TextureGenerator::m_textureSize + fillExpandSize * 2,
                     rect.height() * TextureGenerator::m_textureSize + fillExpandSize * 2
                 };
-                textureRoughnessPainter.fillRect(translatedRect, brush);
+                textureBaker.fillRect(TextureBaker::Channel::Roughness, translatedRect, color);
                 hasRoughnessMap = true;
             }
         }
     }
     
-    auto drawTexture = [&](const std::map<QUuid, std::pair<QPixmap, QPixmap>> &map, QPainter &painter, bool useAlpha) {
+    auto drawTexture = [&](const std::map<QUuid, std::pair<QImage, QImage>> &map, TextureBaker::Channel channel, bool useAlpha) {
         for (const auto &it: partUvRects) {
             const auto &partId = it.first;
             const auto &rects = it.second;
@@ -360,9 +323,8 @@ void TextureGenerator::generate()
             }
             auto findTextureResult = map.find(partId);
             if (findTextureResult != map.end()) {
-                const auto &pixmap = findTextureResult->second.first;
-                const auto &rotatedPixmap = findTextureResult->second.second;
-                painter.setOpacity(alpha);
+                const auto &image = findTextureResult->second.first;
+                const auto &rotatedImage = findTextureResult->second.second;
                 for (const auto &rect: rects) {
                     QRectF translatedRect = {
                         rect.left() * TextureGenerator::m_textureSize,
@@ -371,18 +333,17 @@ void TextureGenerator::generate()
                         rect.height() * TextureGenerator::m_textureSize
                     };
                     if (translatedRect.width() < translatedRect.height()) {
-                        painter.drawTiledPixmap(translatedRect, rotatedPixmap, QPointF(rect.top(), rect.left()));
+                        textureBaker.drawTiledImage(channel, translatedRect, &rotatedImage, QPointF(rect.top(), rect.left()), alpha);
                     } else {
-                        painter.drawTiledPixmap(translatedRect, pixmap, rect.topLeft());
+                        textureBaker.drawTiledImage(channel, translatedRect, &image, rect.topLeft(), alpha);
                     }
                 }
-                painter.setOpacity(1.0);
             }
         }
     };
     
-    auto convertTextureImageToPixmap = [&](const std::map<QUuid, std::pair<QImage, float>> &sourceMap,
-            std::map<QUuid, std::pair<QPixmap, QPixmap>> &targetMap) {
+    auto convertTextureImages = [&](const std::map<QUuid, std::pair<QImage, float>> &sourceMap,
+            std::map<QUuid, std::pair<QImage, QImage>> &targetMap) {
         for (const auto &it: sourceMap) {
             float tileScale = it.second.second;
             const auto &image = it.second.first;
@@ -393,28 +354,27 @@ void TextureGenerator::generate()
             matrix.translate(center.x(), center.y());
             matrix.rotate(90);
             auto rotatedImage = scaledImage.transformed(matrix).mirrored(true, false);
-            targetMap[it.first] = std::make_pair(QPixmap::fromImage(scaledImage),
-                QPixmap::fromImage(rotatedImage));
+            targetMap[it.first] = std::make_pair(scaledImage, rotatedImage);
         }
     };
     
-    std::map<QUuid, std::pair<QPixmap, QPixmap>> partColorTexturePixmaps;
-    std::map<QUuid, std::pair<QPixmap, QPixmap>> partNormalTexturePixmaps;
-    std::map<QUuid, std::pair<QPixmap, QPixmap>> partMetalnessTexturePixmaps;
-    std::map<QUuid, std::pair<QPixmap, QPixmap>> partRoughnessTexturePixmaps;
-    std::map<QUuid, std::pair<QPixmap, QPixmap>> partAmbientOcclusionTexturePixmaps;
+    std::map<QUuid, std::pair<QImage, QImage>> partColorTextureImages;
+    std::map<QUuid, std::pair<QImage, QImage>> partNormalTextureImages;
+    std::map<QUuid, std::pair<QImage, QImage>> partMetalnessTextureImages;
+    std::map<QUuid, std::pair<QImage, QImage>> partRoughnessTextureImages;
+    std::map<QUuid, std::pair<QImage, QImage>> partAmbientOcclusionTextureImages;
     
-    convertTextureImageToPixmap(m_partColorTextureMap, partColorTexturePixmaps);
-    convertTextureImageToPixmap(m_partNormalTextureMap, partNormalTexturePixmaps);
-    convertTextureImageToPixmap(m_partMetalnessTextureMap, partMetalnessTexturePixmaps);
-    convertTextureImageToPixmap(m_partRoughnessTextureMap, partRoughnessTexturePixmaps);
-    convertTextureImageToPixmap(m_partAmbientOcclusionTextureMap, partAmbientOcclusionTexturePixmaps);
+    convertTextureImages(m_partColorTextureMap, partColorTextureImages);
+    convertTextureImages(m_partNormalTextureMap, partNormalTextureImages);
+    convertTextureImages(m_partMetalnessTextureMap, partMetalnessTextureImages);
+    convertTextureImages(m_partRoughnessTextureMap, partRoughnessTextureImages);
+    convertTextureImages(m_partAmbientOcclusionTextureMap, partAmbientOcclusionTextureImages);
     
-    drawTexture(partColorTexturePixmaps, texturePainter, true);
-    drawTexture(partNormalTexturePixmaps, textureNormalPainter, false);
-    drawTexture(partMetalnessTexturePixmaps, textureMetalnessPainter, false);
-    drawTexture(partRoughnessTexturePixmaps, textureRoughnessPainter, false);
-    drawTexture(partAmbientOcclusionTexturePixmaps, textureAmbientOcclusionPainter, false);
+    drawTexture(partColorTextureImages, TextureBaker::Channel::Color, true);
+    drawTexture(partNormalTextureImages, TextureBaker::Channel::Normal, false);
+    drawTexture(partMetalnessTextureImages, TextureBaker::Channel::Metalness, false);
+    drawTexture(partRoughnessTextureImages, TextureBaker::Channel::Roughness, false);
+    drawTexture(partAmbientOcclusionTextureImages, TextureBaker::Channel::AmbientOcclusion, false);
     
     auto drawBySolubility = [&](const QUuid &partId, size_t triangleIndex, size_t firstVertexIndex, size_t secondVertexIndex,
             const QUuid &neighborPartId) {
@@ -458,83 +418,58 @@ void TextureGenerator::generate()
                     clippedRect.width() * TextureGenerator::m_textureSize,
                     clippedRect.height() * TextureGenerator::m_textureSize
                 };
-                texturePainter.setOpacity(alpha);
-                auto findTextureResult = partColorTexturePixmaps.find(neighborPartId);
-                if (findTextureResult != partColorTexturePixmaps.end()) {
-                    const auto &pixmap = findTextureResult->second.first;
-                    const auto &rotatedPixmap = findTextureResult->second.second;
-                    
-                    QImage tmpImage(translatedRect.width(), translatedRect.height(), QImage::Format_ARGB32);
-                    QPixmap tmpPixmap = QPixmap::fromImage(tmpImage);
-                    QPainter tmpPainter;
-                    QRectF tmpImageFrame = QRectF(0, 0, translatedRect.width(), translatedRect.height());
-                    
-                    // Fill tiled texture
-                    tmpPainter.begin(&tmpPixmap);
-                    tmpPainter.setOpacity(alpha);
+                QPointF center(middlePoint.x() * TextureGenerator::m_textureSize,
+                    middlePoint.y() * TextureGenerator::m_textureSize);
+                auto findTextureResult = partColorTextureImages.find(neighborPartId);
+                if (findTextureResult != partColorTextureImages.end()) {
+                    const auto &image = findTextureResult->second.first;
+                    const auto &rotatedImage = findTextureResult->second.second;
                     if (it.width() < it.height()) {
-                        tmpPainter.drawTiledPixmap(tmpImageFrame, rotatedPixmap, QPointF(translatedRect.top(), translatedRect.left()));
+                        textureBaker.drawTiledImageInRadialGradient(TextureBaker::Channel::Color, translatedRect,
+                            &rotatedImage, QPointF(translatedRect.top(), translatedRect.left()),
+                            center, finalRadius * TextureGenerator::m_textureSize, findNeighborColor->second, alpha);
                     } else {
-                        tmpPainter.drawTiledPixmap(tmpImageFrame, pixmap, translatedRect.topLeft());
+                        textureBaker.drawTiledImageInRadialGradient(TextureBaker::Channel::Color, translatedRect,
+                            &image, translatedRect.topLeft(),
+                            center, finalRadius * TextureGenerator::m_textureSize, findNeighborColor->second, alpha);
                     }
-                    tmpPainter.setOpacity(1.0);
-                    tmpPainter.end();
-                    
-                    // Apply gradient
-                    QRadialGradient gradient(QPointF(middlePoint.x() * TextureGenerator::m_textureSize - translatedRect.left(),
-                        middlePoint.y() * TextureGenerator::m_textureSize - translatedRect.top()),
-                        finalRadius * TextureGenerator::m_textureSize);
-                    gradient.setColorAt(0.0, findNeighborColor->second);
-                    gradient.setColorAt(1.0, Qt::transparent);
-                    
-                    tmpPainter.begin(&tmpPixmap);
-                    tmpPainter.setCompositionMode(QPainter::CompositionMode_DestinationIn);
-                    tmpPainter.fillRect(tmpImageFrame, gradient);
-                    tmpPainter.end();
-                    
-                    texturePainter.drawPixmap(translatedRect, tmpPixmap, tmpImageFrame);
                 } else {
-                    QRadialGradient gradient(QPointF(middlePoint.x() * TextureGenerator::m_textureSize,
-                        middlePoint.y() * TextureGenerator::m_textureSize),
-                        finalRadius * TextureGenerator::m_textureSize);
-                    gradient.setColorAt(0.0, findNeighborColor->second);
-                    gradient.setColorAt(1.0, Qt::transparent);
-                    texturePainter.fillRect(translatedRect, gradient);
+                    textureBaker.fillRadialGradient(TextureBaker::Channel::Color, translatedRect,
+                        center, finalRadius * TextureGenerator::m_textureSize, findNeighborColor->second, alpha, false);
                 }
-                texturePainter.setOpacity(1.0);
                 break;
             }
         }
     };
     
-    std::map<std::pair<size_t, size_t>, std::tuple<size_t, size_t, size_t>> halfEdgeToTriangleMap;
-    for (size_t i = 0; i < m_object->triangles.size(); ++i) {
-        const auto &triangleIndices = m_object->triangles[i];
-        if (triangleIndices.size() != 3) {
-            qDebug() << "Found invalid triangle indices";
-            continue;
-        }
-        for (size_t j = 0; j < triangleIndices.size(); ++j) {
-            size_t k = (j + 1) % triangleIndices.size();
-            halfEdgeToTriangleMap.insert(std::make_pair(std::make_pair(triangleIndices[j], triangleIndices[k]),
-                std::make_tuple(i, j, k)));
-        }
+    // The half edges of the generated object are reused, they are only built here for an object loaded without them
+    HalfEdgeTable localHalfEdges;
+    const HalfEdgeTable *halfEdges = m_object->triangleHalfEdges();
+    if (nullptr == halfEdges) {
+        localHalfEdges.build(m_object->triangles);
+        halfEdges = &localHalfEdges;
     }
-    for (const auto &it: halfEdgeToTriangleMap) {
-        auto oppositeHalfEdge = std::make_pair(it.first.second, it.first.first);
-        const auto &opposite = halfEdgeToTriangleMap.find(oppositeHalfEdge);
-        if (opposite == halfEdgeToTriangleMap.end())
+    auto isTriangleHalfEdge = [&](const HalfEdge *halfEdge) {
+        return 3 == m_object->triangles[halfEdge->face].size();
+    };
+    for (const auto &halfEdge: *halfEdges) {
+        // A repeated half edge is taken from its first face
+        if (&halfEdge != halfEdges->begin() && (&halfEdge - 1)->from == halfEdge.from && (&halfEdge - 1)->to == halfEdge.to)
+            continue;
+        if (!isTriangleHalfEdge(&halfEdge))
+            continue;
+        const HalfEdge *opposite = halfEdges->opposite(halfEdge);
+        if (nullptr == opposite || !isTriangleHalfEdge(opposite))
             continue;
-        const std::pair<QUuid, QUuid> &source = triangleSourceNodes[std::get<0>(it.second)];
-        const std::pair<QUuid, QUuid> &oppositeSource = triangleSourceNodes[std::get<0>(opposite->second)];
+        const std::pair<QUuid, QUuid> &source = triangleSourceNodes[halfEdge.face];
+        const std::pair<QUuid, QUuid> &oppositeSource = triangleSourceNodes[opposite->face];
         if (source.first == oppositeSource.first)
             continue;
-        drawBySolubility(source.first, std::get<0>(it.second), std::get<1>(it.second), std::get<2>(it.second), oppositeSource.first);
-        drawBySolubility(oppositeSource.first, std::get<0>(opposite->second), std::get<1>(opposite->second), std::get<2>(opposite->second), source.first);
+        drawBySolubility(source.first, halfEdge.face, halfEdge.corner, (halfEdge.corner + 1) % 3, oppositeSource.first);
+        drawBySolubility(oppositeSource.first, opposite->face, opposite->corner, (opposite->corner + 1) % 3, source.first);
     }
     
     // Draw belly white
-    texturePainter.setCompositionMode(QPainter::CompositionMode_SoftLight);
     for (size_t triangleIndex = 0; triangleIndex < m_object->triangles.size(); ++triangleIndex) {
         const auto &normal = triangleNormals[triangleIndex];
         const std::pair<QUuid, QUuid> &source = triangleSourceNodes[triangleIndex];
@@ -571,11 +506,8 @@ void TextureGenerator::generate()
         float finalRadius = (uv[0].distanceToPoint(uv[1]) +
             uv[1].distanceToPoint(uv[2]) +
             uv[2].distanceToPoint(uv[0])) / 3.0;
-        QRadialGradient gradient(QPointF(middlePoint.x() * TextureGenerator::m_textureSize,
-            middlePoint.y() * TextureGenerator::m_textureSize),
-            finalRadius * TextureGenerator::m_textureSize);
-        gradient.setColorAt(0.0, Qt::white);
-        gradient.setColorAt(1.0, Qt::transparent);
+        QPointF center(middlePoint.x() * TextureGenerator::m_textureSize,
+            middlePoint.y() * TextureGenerator::m_textureSize);
         for (const auto &it: allRects->second) {
             if (it.contains(middlePoint.x(), middlePoint.y())) {
                 QRectF fillTarget((middlePoint.x() - finalRadius),
@@ -589,18 +521,18 @@ void TextureGenerator::generate()
                     clippedRect.width() * TextureGenerator::m_textureSize,
                     clippedRect.height() * TextureGenerator::m_textureSize
                 };
-                texturePainter.fillRect(translatedRect, gradient);
+                textureBaker.fillRadialGradient(TextureBaker::Channel::Color, translatedRect,
+                    center, finalRadius * TextureGenerator::m_textureSize, Qt::white, 1.0, true);
             }
         }
         
         // Fill the neighbor halfedges
         for (int i = 0; i < 3; ++i) {
             int j = (i + 1) % 3;
-            auto oppositeHalfEdge = std::make_pair(triangleIndices[j], triangleIndices[i]);
-            const auto &opposite = halfEdgeToTriangleMap.find(oppositeHalfEdge);
-            if (opposite == halfEdgeToTriangleMap.end())
+            const HalfEdge *opposite = halfEdges->find(triangleIndices[j], triangleIndices[i]);
+            if (nullptr == opposite || !isTriangleHalfEdge(opposite))
                 continue;
-            auto oppositeTriangleIndex = std::get<0>(opposite->second);
+            auto oppositeTriangleIndex = opposite->face;
             const std::pair<QUuid, QUuid> &oppositeSource = triangleSourceNodes[oppositeTriangleIndex];
             if (partId == oppositeSource.first)
                 continue;
@@ -610,12 +542,9 @@ void TextureGenerator::generate()
                 continue;
             }
             const std::vector<QVector2D> &oppositeUv = triangleVertexUvs[oppositeTriangleIndex];
-            QVector2D oppositeMiddlePoint = (oppositeUv[std::get<1>(opposite->second)] + oppositeUv[std::get<2>(opposite->second)]) * 0.5;
-            QRadialGradient oppositeGradient(QPointF(oppositeMiddlePoint.x() * TextureGenerator::m_textureSize,
-                oppositeMiddlePoint.y() * TextureGenerator::m_textureSize),
-                finalRadius * TextureGenerator::m_textureSize);
-            oppositeGradient.setColorAt(0.0, Qt::white);
-            oppositeGradient.setColorAt(1.0, Qt::transparent);
+            QVector2D oppositeMiddlePoint = (oppositeUv[opposite->corner] + oppositeUv[(opposite->corner + 1) % 3]) * 0.5;
+            QPointF oppositeCenter(oppositeMiddlePoint.x() * TextureGenerator::m_textureSize,
+                oppositeMiddlePoint.y() * TextureGenerator::m_textureSize);
             for (const auto &it: oppositeAllRects->second) {
                 if (it.contains(oppositeMiddlePoint.x(), oppositeMiddlePoint.y())) {
                     QRectF fillTarget((oppositeMiddlePoint.x() - finalRadius),
@@ -629,7 +558,8 @@ void TextureGenerator::generate()
                         clippedRect.width() * TextureGenerator::m_textureSize,
                         clippedRect.height() * TextureGenerator::m_textureSize
                     };
-                    texturePainter.fillRect(translatedRect, oppositeGradient);
+                    textureBaker.fillRadialGradient(TextureBaker::Channel::Color, translatedRect,
+                        oppositeCenter, finalRadius * TextureGenerator::m_textureSize, Qt::white, 1.0, true);
                 }
             }
         }
@@ -642,35 +572,31 @@ void TextureGenerator::generate()
         hasRoughnessMap = true;
     hasAmbientOcclusionMap = !m_partAmbientOcclusionTextureMap.empty();
     
-    auto paintTextureEndTime = countTimeConsumed.elapsed();
-
-    texturePainter.end();
-    textureNormalPainter.end();
-    textureMetalnessPainter.end();
-    textureRoughnessPainter.end();
-    textureAmbientOcclusionPainter.end();
-    
-    if (!hasNormalMap) {
-        delete m_resultTextureNormalImage;
-        m_resultTextureNormalImage = nullptr;
-    }
-    
-    if (!hasMetalnessMap && !hasRoughnessMap && !hasAmbientOcclusionMap) {
-        delete m_resultTextureMetalnessImage;
-        m_resultTextureMetalnessImage = nullptr;
-
-        delete m_resultTextureRoughnessImage;
-        m_resultTextureRoughnessImage = nullptr;
-
-        delete m_resultTextureAmbientOcclusionImage;
-        m_resultTextureAmbientOcclusionImage = nullptr;
-    }
+    auto bakeTextureBeginTime = countTimeConsumed.elapsed();
+    
+    bool hasMetalnessRoughnessAmbientOcclusionMap = hasMetalnessMap || hasRoughnessMap || hasAmbientOcclusionMap;
+    textureBaker.setChannelEnabled(TextureBaker::Channel::Normal, hasNormalMap);
+    textureBaker.setChannelEnabled(TextureBaker::Channel::Metalness, hasMetalnessRoughnessAmbientOcclusionMap);
+    textureBaker.setChannelEnabled(TextureBaker::Channel::Roughness, hasMetalnessRoughnessAmbientOcclusionMap);
+    textureBaker.setChannelEnabled(TextureBaker::Channel::AmbientOcclusion, hasMetalnessRoughnessAmbientOcclusionMap);
+    QImage *images[(int)TextureBaker::Channel::Count] = {nullptr};
+    if (m_painterEnabled)
+        textureBaker.paint(images);
+    else
+        textureBaker.bake(images);
+    m_resultTextureColorImage = images[(int)TextureBaker::Channel::Color];
+    m_resultTextureNormalImage = images[(int)TextureBaker::Channel::Normal];
+    m_resultTextureMetalnessImage = images[(int)TextureBaker::Channel::Metalness];
+    m_resultTextureRoughnessImage = images[(int)TextureBaker::Channel::Roughness];
+    m_resultTextureAmbientOcclusionImage = images[(int)TextureBaker::Channel::AmbientOcclusion];
+    
+    auto bakeTextureEndTime = countTimeConsumed.elapsed();
     
     auto createResultBeginTime = countTimeConsumed.elapsed();
     m_resultMesh->setTextureImage(new QImage(*m_resultTextureColorImage));
     if (nullptr != m_resultTextureNormalImage)
         m_resultMesh->setNormalMapImage(new QImage(*m_resultTextureNormalImage));
-    if (hasMetalnessMap || hasRoughnessMap || hasAmbientOcclusionMap) {
+    if (hasMetalnessRoughnessAmbientOcclusionMap) {
         m_resultMesh->setMetalnessRoughnessAmbientOcclusionImage(combineMetalnessRoughnessAmbientOcclusionImages(
             m_resultTextureMetalnessImage,
             m_resultTextureRoughnessImage,
@@ -681,7 +607,9 @@ void TextureGenerator::generate()
     }
     auto createResultEndTime = countTimeConsumed.elapsed();
     
-    qDebug() << "The texture[" << TextureGenerator::m_textureSize << "x" << TextureGenerator::m_textureSize << "] generation took" << countTimeConsumed.elapsed() << "milliseconds";
+    qDebug() << "The texture[" << TextureGenerator::m_textureSize << "x" << TextureGenerator::m_textureSize << "] generation took" << countTimeConsumed.elapsed() << "milliseconds"
+        << "(recording:" << (bakeTextureBeginTime - recordTextureBeginTime) << "baking:" << (bakeTextureEndTime - bakeTextureBeginTime)
+        << (m_painterEnabled ? "by QPainter)" : "in tiles)");
 }
 
 QImage *TextureGenerator::combineMetalnessRoughnessAmbientOcclusionImages(QImage *metalnessImage,
@@ -28,6 +28,8 @@ public:
     void addPartMetalnessMap(QUuid partId, const QImage *image, float tileScale);
     void addPartRoughnessMap(QUuid partId, const QImage *image, float tileScale);
     void addPartAmbientOcclusionMap(QUuid partId, const QImage *image, float tileScale);
+    // Paint the maps with QPainter, one after another, instead of baking them in parallel tiles; the reference of the baking
+    void setPainterEnabled(bool painterEnabled);
     void generate();
     static QImage *combineMetalnessRoughnessAmbientOcclusionImages(QImage *metalnessImage,
             QImage *roughnessImage,
@@ -56,6 +58,7 @@ private:
     std::set<QUuid> m_countershadedPartIds;
     Snapshot *m_snapshot;
     bool m_hasTransparencySettings;
+    bool m_painterEnabled;
     int m_textureSize;
 };
 
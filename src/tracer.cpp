@@ -0,0 +1,153 @@
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+#include <QCoreApplication>
+#include <QDebug>
+#include "tracer.h"
+
+const size_t Tracer::maxEventCount = 1000000;
+
+static size_t currentThreadIndex()
+{
+    static std::atomic<size_t> s_nextThreadIndex{0};
+    thread_local size_t s_threadIndex = s_nextThreadIndex++;
+    return s_threadIndex;
+}
+
+Tracer &Tracer::instance()
+{
+    static Tracer s_tracer;
+    return s_tracer;
+}
+
+Tracer::Tracer()
+{
+    m_timer.start();
+    m_fileName = QString::fromLocal8Bit(qgetenv("DUST3D_TRACE_FILE"));
+    if (!m_fileName.isEmpty()) {
+        m_isEnabledByEnvironment = true;
+        m_isEnabled = true;
+    }
+}
+
+bool Tracer::isEnabled() const
+{
+    return m_isEnabled;
+}
+
+void Tracer::setEnabled(bool enabled)
+{
+    if (m_isEnabledByEnvironment)
+        return;
+    QMutexLocker locker(&m_mutex);
+    if (enabled && m_fileName.isEmpty()) {
+        QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(dir);
+        m_fileName = dir + QDir::separator() + "generation-trace.json";
+    }
+    m_isEnabled = enabled;
+}
+
+const QString &Tracer::fileName() const
+{
+    return m_fileName;
+}
+
+qint64 Tracer::timestamp() const
+{
+    return m_timer.nsecsElapsed() / 1000;
+}
+
+void Tracer::addSpan(const char *name, qint64 begin, qint64 end, nlohmann::json &&arguments)
+{
+    nlohmann::json event = {
+        {"name", name},
+        {"cat", "generation"},
+        {"ph", "X"},
+        {"ts", begin},
+        {"dur", end - begin},
+        {"pid", QCoreApplication::applicationPid()},
+        {"tid", currentThreadIndex()}
+    };
+    if (!arguments.is_null())
+        event["args"] = std::move(arguments);
+    
+    QMutexLocker locker(&m_mutex);
+    m_events.push_back(std::move(event));
+    while (m_events.size() > maxEventCount)
+        m_events.pop_front();
+}
+
+void Tracer::flush()
+{
+    if (!m_isEnabled)
+        return;
+    
+    std::deque<nlohmann::json> events;
+    {
+        QMutexLocker locker(&m_mutex);
+        events.swap(m_events);
+    }
+    if (events.empty())
+        return;
+    
+    // The events are serialized out of the lock the spans are added under
+    QMutexLocker locker(&m_fileMutex);
+    // Past the cap the file starts over, so it is kept as bounded as the events in memory
+    if (m_writtenEventCount + events.size() > maxEventCount)
+        m_writtenEventCount = 0;
+    bool startsFile = 0 == m_writtenEventCount;
+    std::string content;
+    for (const auto &it: events) {
+        content += 0 == m_writtenEventCount ? "[\n" : ",\n";
+        content += it.dump();
+        ++m_writtenEventCount;
+    }
+    
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::WriteOnly | (startsFile ? QIODevice::Truncate : QIODevice::Append))) {
+        qDebug() << "Open trace file failed:" << m_fileName;
+        m_writtenEventCount = 0;
+        return;
+    }
+    if ((qint64)content.size() != file.write(content.data(), content.size())) {
+        qDebug() << "Write trace file failed:" << m_fileName;
+        m_writtenEventCount = 0;
+        return;
+    }
+}
+
+TraceSpan::TraceSpan(const char *name) :
+    m_name(name),
+    m_isEnabled(Tracer::instance().isEnabled())
+{
+    if (m_isEnabled)
+        m_begin = Tracer::instance().timestamp();
+}
+
+TraceSpan::~TraceSpan()
+{
+    end();
+}
+
+void TraceSpan::end()
+{
+    if (!m_isEnabled)
+        return;
+    m_isEnabled = false;
+    Tracer::instance().addSpan(m_name, m_begin, Tracer::instance().timestamp(), std::move(m_arguments));
+}
+
+void TraceSpan::addArgument(const char *key, const QString &value)
+{
+    if (!m_isEnabled)
+        return;
+    m_arguments[key] = value.toUtf8().toStdString();
+}
+
+void TraceSpan::addArgument(const char *key, qint64 value)
+{
+    if (!m_isEnabled)
+        return;
+    m_arguments[key] = value;
+}
@@ -0,0 +1,61 @@
+#ifndef DUST3D_TRACER_H
+#define DUST3D_TRACER_H
+#include <deque>
+#include <atomic>
+#include <QString>
+#include <QMutex>
+#include <QElapsedTimer>
+#include "json.hpp"
+
+// Collects the spans of the generation stages and writes them as a Chrome trace file (chrome://tracing, ui.perfetto.dev).
+// The tracing is enabled by the DUST3D_TRACE_FILE environment variable, which also names the output file,
+// or by the preference, in which case the file is written to the application data location.
+// The file is in the JSON array format, which the viewers read without the closing bracket,
+// so each flush only appends the events collected since the last one.
+
+class Tracer
+{
+public:
+    static Tracer &instance();
+    Tracer();
+    bool isEnabled() const;
+    void setEnabled(bool enabled);
+    const QString &fileName() const;
+    qint64 timestamp() const;
+    void addSpan(const char *name, qint64 begin, qint64 end, nlohmann::json &&arguments);
+    void flush();
+
+    static const size_t maxEventCount;
+
+private:
+    std::atomic<bool> m_isEnabled{false};
+    bool m_isEnabledByEnvironment = false;
+    QString m_fileName;
+    QElapsedTimer m_timer;
+    std::deque<nlohmann::json> m_events;
+    size_t m_writtenEventCount = 0;
+    QMutex m_mutex;
+    QMutex m_fileMutex;
+};
+
+class TraceSpan
+{
+public:
+    TraceSpan(const char *name);
+    ~TraceSpan();
+    bool isEnabled() const
+    {
+        return m_isEnabled;
+    }
+    void addArgument(const char *key, const QString &value);
+    void addArgument(const char *key, qint64 value);
+    void end();
+
+private:
+    const char *m_name = nullptr;
+    bool m_isEnabled = false;
+    qint64 m_begin = 0;
+    nlohmann::json m_arguments;
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include <map>
 #include "trianglesourcenoderesolve.h"
 #include "positionkey.h"
+#include "openhashmap.h"
 
 struct HalfColorEdge
 {
@@ -45,9 +46,10 @@ void triangleSourceNodeResolve(const Object &object,
     std::vector<std::pair<QUuid, QUuid>> *vertexSourceNodes)
 {
     std::map<int, std::pair<QUuid, QUuid>> vertexSourceMap;
-    std::map<PositionKey, std::pair<QUuid, QUuid>> positionMap;
+    OpenHashMap<PositionKey, std::pair<QUuid, QUuid>> positionMap;
     std::map<std::pair<int, int>, HalfColorEdge> halfColorEdgeMap;
     std::set<int> brokenTriangleSet;
+    positionMap.reserve(nodeVertices.size());
     for (const auto &it: nodeVertices) {
         positionMap.insert({PositionKey(it.first), it.second});
     }
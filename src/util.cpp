@@ -3,8 +3,10 @@
 #include <QFile>
 #include <unordered_set>
 #include <unordered_map>
+#include <algorithm>
 #include "util.h"
 #include "version.h"
+#include "halfedgetable.h"
 
 QString valueOfKeyInMapOrEmpty(const std::map<QString, QString> &map, const QString &key)
 {
@@ -151,7 +153,7 @@ bool pointInTriangle(const QVector3D &a, const QVector3D &b, const QVector3D &c,
 }
 
 void angleSmooth(const std::vector<QVector3D> &vertices,
-    const std::vector<std::vector<size_t>> &triangles,
+    const FaceList &triangles,
     const std::vector<QVector3D> &triangleNormals,
     float thresholdAngleDegrees,
     std::vector<QVector3D> &triangleVertexNormals)
@@ -208,40 +210,39 @@ void angleSmooth(const std::vector<QVector3D> &vertices,
         item.normalize();
 }
 
-void recoverQuads(const std::vector<QVector3D> &vertices, const std::vector<std::vector<size_t>> &triangles, const std::set<std::pair<PositionKey, PositionKey>> &sharedQuadEdges, std::vector<std::vector<size_t>> &triangleAndQuads)
+void recoverQuads(const std::vector<QVector3D> &vertices, const std::vector<std::vector<size_t>> &triangles, const OpenHashSet<std::pair<PositionKey, PositionKey>> &sharedQuadEdges, FaceList &triangleAndQuads)
 {
     std::vector<PositionKey> verticesPositionKeys;
+    verticesPositionKeys.reserve(vertices.size());
     for (const auto &position: vertices) {
         verticesPositionKeys.push_back(PositionKey(position));
     }
-    std::map<std::pair<size_t, size_t>, std::pair<size_t, size_t>> triangleEdgeMap;
-    for (size_t i = 0; i < triangles.size(); i++) {
-        const auto &faceIndices = triangles[i];
-        if (faceIndices.size() == 3) {
-            triangleEdgeMap[std::make_pair(faceIndices[0], faceIndices[1])] = std::make_pair(i, faceIndices[2]);
-            triangleEdgeMap[std::make_pair(faceIndices[1], faceIndices[2])] = std::make_pair(i, faceIndices[0]);
-            triangleEdgeMap[std::make_pair(faceIndices[2], faceIndices[0])] = std::make_pair(i, faceIndices[1]);
-        }
-    }
+    std::vector<char> isTriangle(triangles.size());
+    for (size_t i = 0; i < triangles.size(); i++)
+        isTriangle[i] = 3 == triangles[i].size();
+    HalfEdgeTable halfEdges;
+    halfEdges.build(triangles, &isTriangle);
     std::unordered_set<size_t> unionedFaces;
-    std::vector<std::vector<size_t>> newUnionedFaceIndices;
-    for (const auto &edge: triangleEdgeMap) {
-        if (unionedFaces.find(edge.second.first) != unionedFaces.end())
+    for (const auto &halfEdge: halfEdges) {
+        // A repeated half edge is taken from its last face
+        if (&halfEdge + 1 != halfEdges.end() && (&halfEdge + 1)->from == halfEdge.from && (&halfEdge + 1)->to == halfEdge.to)
             continue;
-        auto pair = std::make_pair(verticesPositionKeys[edge.first.first], verticesPositionKeys[edge.first.second]);
+        if (unionedFaces.find(halfEdge.face) != unionedFaces.end())
+            continue;
+        auto pair = std::make_pair(verticesPositionKeys[halfEdge.from], verticesPositionKeys[halfEdge.to]);
         if (sharedQuadEdges.find(pair) != sharedQuadEdges.end()) {
-            auto oppositeEdge = triangleEdgeMap.find(std::make_pair(edge.first.second, edge.first.first));
-            if (oppositeEdge == triangleEdgeMap.end()) {
+            const HalfEdge *oppositeHalfEdge = halfEdges.findLast(halfEdge.to, halfEdge.from);
+            if (nullptr == oppositeHalfEdge) {
                 //qDebug() << "Find opposite edge failed";
             } else {
-                if (unionedFaces.find(oppositeEdge->second.first) == unionedFaces.end()) {
-                    unionedFaces.insert(edge.second.first);
-                    unionedFaces.insert(oppositeEdge->second.first);
+                if (unionedFaces.find(oppositeHalfEdge->face) == unionedFaces.end()) {
+                    unionedFaces.insert(halfEdge.face);
+                    unionedFaces.insert(oppositeHalfEdge->face);
                     std::vector<size_t> indices;
-                    indices.push_back(edge.second.second);
-                    indices.push_back(edge.first.first);
-                    indices.push_back(oppositeEdge->second.second);
-                    indices.push_back(edge.first.second);
+                    indices.push_back(triangles[halfEdge.face][(halfEdge.corner + 2) % 3]);
+                    indices.push_back(halfEdge.from);
+                    indices.push_back(triangles[oppositeHalfEdge->face][(oppositeHalfEdge->corner + 2) % 3]);
+                    indices.push_back(halfEdge.to);
                     triangleAndQuads.push_back(indices);
                 }
             }
@@ -254,150 +255,166 @@ void recoverQuads(const std::vector<QVector3D> &vertices, const std::vector<std:
     }
 }
 
+// Welds the short edges left along the seams by the boolean operations, the faces collapsed by a weld are removed.
+// The pass is repeated until nothing is welded, each round resolves its welds with a union-find over the vertex indices
+// and rewrites the faces in place, the vertices are compacted once at the end;
+// the vertices are numbered by their first appearance in the remaining faces, so the result is the same as
+// compacting after each round
 size_t weldSeam(const std::vector<QVector3D> &sourceVertices, const std::vector<std::vector<size_t>> &sourceTriangles,
-    float allowedSmallestDistance, const std::set<PositionKey> &excludePositions,
+    float allowedSmallestDistance, const OpenHashSet<PositionKey> &excludePositions,
     std::vector<QVector3D> &destVertices, std::vector<std::vector<size_t>> &destTriangles)
 {
-    std::unordered_set<int> excludeVertices;
-    for (size_t i = 0; i < sourceVertices.size(); ++i) {
-        if (excludePositions.find(sourceVertices[i]) != excludePositions.end())
-            excludeVertices.insert(i);
-    }
+    const int maxWeldChainLength = 500;
     float squareOfAllowedSmallestDistance = allowedSmallestDistance * allowedSmallestDistance;
-    std::map<int, int> weldVertexToMap;
-    std::unordered_set<int> weldTargetVertices;
-    std::unordered_set<int> processedFaces;
-    std::map<std::pair<int, int>, std::pair<int, int>> triangleEdgeMap;
-    std::unordered_map<int, int> vertexAdjFaceCountMap;
-    for (int i = 0; i < (int)sourceTriangles.size(); i++) {
-        const auto &faceIndices = sourceTriangles[i];
-        if (faceIndices.size() == 3) {
-            vertexAdjFaceCountMap[faceIndices[0]]++;
-            vertexAdjFaceCountMap[faceIndices[1]]++;
-            vertexAdjFaceCountMap[faceIndices[2]]++;
-            triangleEdgeMap[std::make_pair(faceIndices[0], faceIndices[1])] = std::make_pair(i, faceIndices[2]);
-            triangleEdgeMap[std::make_pair(faceIndices[1], faceIndices[2])] = std::make_pair(i, faceIndices[0]);
-            triangleEdgeMap[std::make_pair(faceIndices[2], faceIndices[0])] = std::make_pair(i, faceIndices[1]);
+    
+    // The vertices keep their positions when welded, so the exclusion is decided once, against the hashed grid of the quantized positions
+    std::vector<char> isSeamVertex(sourceVertices.size(), 1);
+    if (!excludePositions.empty()) {
+        for (size_t i = 0; i < sourceVertices.size(); ++i) {
+            if (excludePositions.find(PositionKey(sourceVertices[i])) != excludePositions.end())
+                isSeamVertex[i] = 0;
         }
     }
-    for (int i = 0; i < (int)sourceTriangles.size(); i++) {
-        if (processedFaces.find(i) != processedFaces.end())
-            continue;
-        const auto &faceIndices = sourceTriangles[i];
-        if (faceIndices.size() == 3) {
-            bool indicesSeamCheck[3] = {
-                excludeVertices.find(faceIndices[0]) == excludeVertices.end(),
-                excludeVertices.find(faceIndices[1]) == excludeVertices.end(),
-                excludeVertices.find(faceIndices[2]) == excludeVertices.end()
-            };
-            for (int j = 0; j < 3; j++) {
+    
+    std::vector<std::vector<size_t>> faces = sourceTriangles;
+    std::vector<char> isFaceAlive(faces.size(), 1);
+    std::vector<char> processedFaces(faces.size());
+    std::vector<int> vertexAdjFaceCounts(sourceVertices.size());
+    std::vector<int> weldVertexTo(sourceVertices.size());
+    std::vector<char> isFaceInTable(faces.size());
+    HalfEdgeTable halfEdges;
+    size_t totalWeldedCount = 0;
+    
+    for (;;) {
+        std::fill(processedFaces.begin(), processedFaces.end(), 0);
+        std::fill(vertexAdjFaceCounts.begin(), vertexAdjFaceCounts.end(), 0);
+        std::fill(weldVertexTo.begin(), weldVertexTo.end(), -1);
+        
+        // The last face of a duplicated edge wins
+        for (int i = 0; i < (int)faces.size(); ++i) {
+            isFaceInTable[i] = isFaceAlive[i] && 3 == faces[i].size();
+            if (!isFaceInTable[i])
+                continue;
+            for (const auto &index: faces[i])
+                ++vertexAdjFaceCounts[index];
+        }
+        halfEdges.build(faces, &isFaceInTable);
+        auto findFace = [&](size_t first, size_t second) {
+            const HalfEdge *halfEdge = halfEdges.findLast(first, second);
+            if (nullptr == halfEdge)
+                return -1;
+            return (int)halfEdge->face;
+        };
+        
+        for (int i = 0; i < (int)faces.size(); ++i) {
+            if (!isFaceAlive[i] || processedFaces[i])
+                continue;
+            const auto &faceIndices = faces[i];
+            if (faceIndices.size() != 3)
+                continue;
+            for (int j = 0; j < 3; ++j) {
                 int next = (j + 1) % 3;
                 int nextNext = (j + 2) % 3;
-                if (indicesSeamCheck[j] && indicesSeamCheck[next]) {
-                    std::pair<int, int> edge = std::make_pair(faceIndices[j], faceIndices[next]);
-                    int thirdVertexIndex = faceIndices[nextNext];
-                    if ((sourceVertices[edge.first] - sourceVertices[edge.second]).lengthSquared() < squareOfAllowedSmallestDistance) {
-                        auto oppositeEdge = std::make_pair(edge.second, edge.first);
-                        auto findOppositeFace = triangleEdgeMap.find(oppositeEdge);
-                        if (findOppositeFace == triangleEdgeMap.end()) {
-                            //qDebug() << "Find opposite edge failed";
-                            continue;
-                        }
-                        int oppositeFaceIndex = findOppositeFace->second.first;
-                        if (((sourceVertices[edge.first] - sourceVertices[thirdVertexIndex]).lengthSquared() <
-                                    (sourceVertices[edge.second] - sourceVertices[thirdVertexIndex]).lengthSquared()) &&
-                                vertexAdjFaceCountMap[edge.second] <= 4 &&
-                                weldVertexToMap.find(edge.second) == weldVertexToMap.end()) {
-                            weldVertexToMap[edge.second] = edge.first;
-                            weldTargetVertices.insert(edge.first);
-                            processedFaces.insert(i);
-                            processedFaces.insert(oppositeFaceIndex);
-                            break;
-                        } else if (vertexAdjFaceCountMap[edge.first] <= 4 &&
-                                weldVertexToMap.find(edge.first) == weldVertexToMap.end()) {
-                            weldVertexToMap[edge.first] = edge.second;
-                            weldTargetVertices.insert(edge.second);
-                            processedFaces.insert(i);
-                            processedFaces.insert(oppositeFaceIndex);
-                            break;
-                        }
-                    }
+                if (!isSeamVertex[faceIndices[j]] || !isSeamVertex[faceIndices[next]])
+                    continue;
+                size_t first = faceIndices[j];
+                size_t second = faceIndices[next];
+                size_t third = faceIndices[nextNext];
+                if ((sourceVertices[first] - sourceVertices[second]).lengthSquared() >= squareOfAllowedSmallestDistance)
+                    continue;
+                int oppositeFaceIndex = findFace(second, first);
+                if (-1 == oppositeFaceIndex)
+                    continue;
+                if ((sourceVertices[first] - sourceVertices[third]).lengthSquared() <
+                            (sourceVertices[second] - sourceVertices[third]).lengthSquared() &&
+                        vertexAdjFaceCounts[second] <= 4 &&
+                        -1 == weldVertexTo[second]) {
+                    weldVertexTo[second] = first;
+                    processedFaces[i] = 1;
+                    processedFaces[oppositeFaceIndex] = 1;
+                    break;
+                } else if (vertexAdjFaceCounts[first] <= 4 &&
+                        -1 == weldVertexTo[first]) {
+                    weldVertexTo[first] = second;
+                    processedFaces[i] = 1;
+                    processedFaces[oppositeFaceIndex] = 1;
+                    break;
                 }
             }
         }
-    }
-    int weldedCount = 0;
-    int faceCountAfterWeld = 0;
-    std::map<int, int> oldToNewVerticesMap;
-    for (int i = 0; i < (int)sourceTriangles.size(); i++) {
-        const auto &faceIndices = sourceTriangles[i];
-        std::vector<int> mappedFaceIndices;
-        bool errored = false;
-        for (const auto &index: faceIndices) {
-            int finalIndex = index;
-            int mapTimes = 0;
-            while (mapTimes < 500) {
-                auto findMapResult = weldVertexToMap.find(finalIndex);
-                if (findMapResult == weldVertexToMap.end())
+        
+        // A vertex is only welded while it is a root, so the root of its set is where its chain of welds ends;
+        // the chains running into a cycle are reported as failed, the same as an overlong chain
+        auto findWeldTarget = [&](int vertex) {
+            int root = vertex;
+            int chainLength = 0;
+            while (-1 != weldVertexTo[root]) {
+                root = weldVertexTo[root];
+                if (++chainLength >= maxWeldChainLength)
+                    return -1;
+            }
+            while (vertex != root) {
+                int next = weldVertexTo[vertex];
+                weldVertexTo[vertex] = root;
+                vertex = next;
+            }
+            return root;
+        };
+        
+        size_t weldedCount = 0;
+        for (size_t i = 0; i < faces.size(); ++i) {
+            if (!isFaceAlive[i])
+                continue;
+            auto &faceIndices = faces[i];
+            bool errored = false;
+            for (auto &index: faceIndices) {
+                int target = findWeldTarget((int)index);
+                if (-1 == target) {
+                    qDebug() << "Map too much times";
+                    errored = true;
                     break;
-                finalIndex = findMapResult->second;
-                mapTimes++;
+                }
+                index = (size_t)target;
             }
-            if (mapTimes >= 500) {
-                qDebug() << "Map too much times";
-                errored = true;
-                break;
+            if (errored || faceIndices.size() < 3) {
+                isFaceAlive[i] = 0;
+                continue;
             }
-            mappedFaceIndices.push_back(finalIndex);
-        }
-        if (errored || mappedFaceIndices.size() < 3)
-            continue;
-        bool welded = false;
-        for (decltype(mappedFaceIndices.size()) j = 0; j < mappedFaceIndices.size(); j++) {
-            int next = (j + 1) % 3;
-            if (mappedFaceIndices[j] == mappedFaceIndices[next]) {
-                welded = true;
-                break;
+            for (size_t j = 0; j < faceIndices.size(); ++j) {
+                if (faceIndices[j] == faceIndices[(j + 1) % 3]) {
+                    isFaceAlive[i] = 0;
+                    ++weldedCount;
+                    break;
+                }
             }
         }
-        if (welded) {
-            weldedCount++;
+        
+        totalWeldedCount += weldedCount;
+        if (0 == weldedCount)
+            break;
+    }
+    
+    std::vector<int> oldToNewVertices(sourceVertices.size(), -1);
+    for (size_t i = 0; i < faces.size(); ++i) {
+        if (!isFaceAlive[i])
             continue;
-        }
-        faceCountAfterWeld++;
         std::vector<size_t> newFace;
-        for (const auto &index: mappedFaceIndices) {
-            auto findMap = oldToNewVerticesMap.find(index);
-            if (findMap == oldToNewVerticesMap.end()) {
-                size_t newIndex = destVertices.size();
-                newFace.push_back(newIndex);
+        newFace.reserve(faces[i].size());
+        for (const auto &index: faces[i]) {
+            if (-1 == oldToNewVertices[index]) {
+                oldToNewVertices[index] = (int)destVertices.size();
                 destVertices.push_back(sourceVertices[index]);
-                oldToNewVerticesMap.insert({index, newIndex});
-            } else {
-                newFace.push_back(findMap->second);
             }
+            newFace.push_back((size_t)oldToNewVertices[index]);
         }
         destTriangles.push_back(newFace);
     }
-    return weldedCount;
+    return totalWeldedCount;
 }
 
 bool isManifold(const std::vector<std::vector<size_t>> &faces)
 {
-    std::set<std::pair<size_t, size_t>> halfEdges;
-    for (const auto &face: faces) {
-        for (size_t i = 0; i < face.size(); ++i) {
-            size_t j = (i + 1) % face.size();
-            auto insertResult = halfEdges.insert({face[i], face[j]});
-            if (!insertResult.second)
-                return false;
-        }
-    }
-    for (const auto &it: halfEdges) {
-        if (halfEdges.find({it.second, it.first}) == halfEdges.end())
-            return false;
-    }
-    return true;
+    return HalfEdgeTable(faces).isManifold();
 }
 
 void trim(std::vector<QVector3D> *vertices, bool normalize)
@@ -559,7 +576,7 @@ bool intersectSegmentAndTriangle(const QVector3D &segmentPoint0, const QVector3D
 bool intersectRayAndPolyhedron(const QVector3D &rayNear,
     const QVector3D &rayFar,
     const std::vector<QVector3D> &vertices,
-    const std::vector<std::vector<size_t>> &triangles,
+    const FaceList &triangles,
     const std::vector<QVector3D> &triangleNormals,
     QVector3D *intersection,
     size_t *intersectedTriangleIndex)
@@ -8,6 +8,8 @@
 #include <QQuaternion>
 #include <set>
 #include "positionkey.h"
+#include "openhashmap.h"
+#include "facelist.h"
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -32,13 +34,13 @@ void quaternionToEulerAnglesXYZ(const QQuaternion &q, double *pitch, double *yaw
 bool pointInTriangle(const QVector3D &a, const QVector3D &b, const QVector3D &c, const QVector3D &p);
 QVector3D polygonNormal(const std::vector<QVector3D> &vertices, const std::vector<size_t> &polygon);
 void angleSmooth(const std::vector<QVector3D> &vertices,
-    const std::vector<std::vector<size_t>> &triangles,
+    const FaceList &triangles,
     const std::vector<QVector3D> &triangleNormals,
     float thresholdAngleDegrees,
     std::vector<QVector3D> &triangleVertexNormals);
-void recoverQuads(const std::vector<QVector3D> &vertices, const std::vector<std::vector<size_t>> &triangles, const std::set<std::pair<PositionKey, PositionKey>> &sharedQuadEdges, std::vector<std::vector<size_t>> &triangleAndQuads);
+void recoverQuads(const std::vector<QVector3D> &vertices, const std::vector<std::vector<size_t>> &triangles, const OpenHashSet<std::pair<PositionKey, PositionKey>> &sharedQuadEdges, FaceList &triangleAndQuads);
 size_t weldSeam(const std::vector<QVector3D> &sourceVertices, const std::vector<std::vector<size_t>> &sourceTriangles,
-    float allowedSmallestDistance, const std::set<PositionKey> &excludePositions,
+    float allowedSmallestDistance, const OpenHashSet<PositionKey> &excludePositions,
     std::vector<QVector3D> &destVertices, std::vector<std::vector<size_t>> &destTriangles);
 bool isManifold(const std::vector<std::vector<size_t>> &faces);
 void trim(std::vector<QVector3D> *vertices, bool normalize=false);
@@ -57,7 +59,7 @@ bool intersectSegmentAndTriangle(const QVector3D &segmentPoint0, const QVector3D
 bool intersectRayAndPolyhedron(const QVector3D &rayNear,
     const QVector3D &rayFar,
     const std::vector<QVector3D> &vertices,
-    const std::vector<std::vector<size_t>> &triangles,
+    const FaceList &triangles,
     const std::vector<QVector3D> &triangleNormals,
     QVector3D *intersection=nullptr,
     size_t *intersectedTriangleIndex=nullptr);
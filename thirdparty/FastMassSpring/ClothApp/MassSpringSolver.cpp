@@ -19,10 +19,7 @@ mass_spring_system::mass_spring_system(
 	fext(fext), damping_factor(damping_factor) {}
 
 // S O L V E R //////////////////////////////////////////////////////////////////////////////////////
-MassSpringSolver::MassSpringSolver(mass_spring_system* system, float* vbuff) 
-	: system(system), current_state(vbuff, system->n_points * 3), 
-	prev_state(current_state), spring_directions(system->n_springs * 3) {
-	
+mass_spring_matrices::mass_spring_matrices(const mass_spring_system* system) {
 	float h2 = system->time_step * system->time_step; // shorthand
 
 	// compute M, L, J
@@ -30,7 +27,7 @@ MassSpringSolver::MassSpringSolver(mass_spring_system* system, float* vbuff)
 	// L
 	L.resize(3 * system->n_points, 3 * system->n_points);
 	unsigned int k = 0; // spring counter
-	for (Edge& i : system->spring_list) {
+	for (const Edge& i : system->spring_list) {
 		for (int j = 0; j < 3; j++) {
 			LTriplets.push_back(
 				Triplet(3 * i.first + j, 3 * i.first  + j,  1 * system->stiffnesses[k]));
@@ -48,7 +45,7 @@ MassSpringSolver::MassSpringSolver(mass_spring_system* system, float* vbuff)
 	// J
 	J.resize(3 * system->n_points, 3 * system->n_springs);
 	k = 0; // spring counter
-	for (Edge& i : system->spring_list) {
+	for (const Edge& i : system->spring_list) {
 		for (unsigned int j = 0; j < 3; j++) {
 			JTriplets.push_back(
 				Triplet(3 * i.first  + j, 3 * k + j,  1 * system->stiffnesses[k]));
@@ -74,16 +71,26 @@ MassSpringSolver::MassSpringSolver(mass_spring_system* system, float* vbuff)
 	system_matrix.compute(A);
 }
 
+MassSpringSolver::MassSpringSolver(mass_spring_system* system, float* vbuff) 
+	: MassSpringSolver(system, vbuff, std::make_shared<const mass_spring_matrices>(system)) {}
+
+MassSpringSolver::MassSpringSolver(mass_spring_system* system, float* vbuff,
+	std::shared_ptr<const mass_spring_matrices> matrices) 
+	: system(system), matrices(matrices), current_state(vbuff, system->n_points * 3), 
+	prev_state(current_state), spring_directions(system->n_springs * 3) {}
+
+std::shared_ptr<const mass_spring_matrices> MassSpringSolver::getMatrices() const { return matrices; }
+
 void MassSpringSolver::globalStep() {
 	float h2 = system->time_step * system->time_step; // shorthand
 
 	// compute right hand side
 	VectorXf b = inertial_term
-		+ h2 * J * spring_directions
+		+ h2 * matrices->J * spring_directions
 		+ h2 * system->fext;
 
 	// solve system and update state
-	current_state = system_matrix.solve(b);
+	current_state = matrices->system_matrix.solve(b);
 }
 
 void MassSpringSolver::localStep() {
@@ -107,7 +114,7 @@ void MassSpringSolver::solve(unsigned int n) {
 	float a = system->damping_factor; // shorthand
 
 	// update inertial term
-	inertial_term = M * ((a + 1) * (current_state) - a * prev_state);
+	inertial_term = matrices->M * ((a + 1) * (current_state) - a * prev_state);
 
 	// save current state in previous state
 	prev_state = current_state;
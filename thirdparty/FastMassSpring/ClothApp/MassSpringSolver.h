@@ -2,6 +2,7 @@
 #include <Eigen/Dense>
 #include <Eigen/Sparse>
 #include <vector>
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -36,27 +37,38 @@ struct mass_spring_system {
 	);
 };
 
-// Mass-Spring System Solver class
-class MassSpringSolver {
-private:
-	typedef Eigen::Vector3f Vector3f;
-	typedef Eigen::VectorXf VectorXf;
+// Mass-Spring System matrices, only depend on the springs, the stiffnesses, the masses and the time step,
+// read only once computed, so the prefactored system could be shared by the solvers of the same system
+struct mass_spring_matrices {
 	typedef Eigen::SparseMatrix<float> SparseMatrix;
 	typedef Eigen::SimplicialLLT<Eigen::SparseMatrix<float> > Cholesky;
-	typedef Eigen::Map<Eigen::VectorXf> Map;
 	typedef std::pair<unsigned int, unsigned int> Edge;
 	typedef Eigen::Triplet<float> Triplet;
 	typedef std::vector<Triplet> TripletList;
 
-	// system
-	mass_spring_system* system;
-	Cholesky system_matrix;
-
 	// M, L, J matrices
 	SparseMatrix M;
 	SparseMatrix L;
 	SparseMatrix J;
 
+	// pre-factored system matrix, M + h^2 * L
+	Cholesky system_matrix;
+
+	mass_spring_matrices(const mass_spring_system* system);
+};
+
+// Mass-Spring System Solver class
+class MassSpringSolver {
+private:
+	typedef Eigen::Vector3f Vector3f;
+	typedef Eigen::VectorXf VectorXf;
+	typedef Eigen::Map<Eigen::VectorXf> Map;
+	typedef std::pair<unsigned int, unsigned int> Edge;
+
+	// system
+	mass_spring_system* system;
+	std::shared_ptr<const mass_spring_matrices> matrices;
+
 	// state
 	Map current_state; // q(n), current state
 	VectorXf prev_state; // q(n - 1), previous state
@@ -69,6 +81,10 @@ private:
 
 public:
 	MassSpringSolver(mass_spring_system* system, float* vbuff);
+	// reuses the matrices computed for the same springs, stiffnesses, masses and time step
+	MassSpringSolver(mass_spring_system* system, float* vbuff, std::shared_ptr<const mass_spring_matrices> matrices);
+
+	std::shared_ptr<const mass_spring_matrices> getMatrices() const;
 
 	// solve iterations
 	void solve(unsigned int n);
@@ -52,14 +52,21 @@ derivative works thereof, in binary and source code form.
 #include <bvh.h>
 #include <simpleuv/triangulate.h>
 #include <map>
+#include <chrono>
+#include <thread>
 #include "instant-meshes-api.h"
 
-static bool g_engineInitialized = false;
-int nprocs = -1;
 static std::vector<Dust3D_InstantMeshesVertex> g_resultVertices;
 static std::vector<Dust3D_InstantMeshesTriangle> g_resultTriangles;
 static std::vector<Dust3D_InstantMeshesQuad> g_resultQuads;
 
+struct Dust3D_InstantMeshesResult
+{
+    std::vector<Dust3D_InstantMeshesVertex> vertices;
+    std::vector<Dust3D_InstantMeshesTriangle> triangles;
+    std::vector<Dust3D_InstantMeshesQuad> quads;
+};
+
 void DUST3D_INSTANT_MESHES_FUNCTION_CONVENTION Dust3D_instantMeshesRemesh(const Dust3D_InstantMeshesVertex *vertices, size_t nVertices,
     const Dust3D_InstantMeshesTriangle *triangles, size_t nTriangles,
     size_t nTargetVertex,
@@ -70,10 +77,60 @@ void DUST3D_INSTANT_MESHES_FUNCTION_CONVENTION Dust3D_instantMeshesRemesh(const
     const Dust3D_InstantMeshesQuad **resultQuads,
     size_t *nResultQuads)
 {
-    if (!g_engineInitialized) {
-        g_engineInitialized = true;
-        tbb::task_scheduler_init init(nprocs == -1 ? tbb::task_scheduler_init::automatic : nprocs);
-    }
+    Dust3D_InstantMeshesResult *result = nullptr;
+    Dust3D_instantMeshesRemeshWithOptions(vertices, nVertices,
+        triangles, nTriangles,
+        nTargetVertex,
+        nullptr,
+        &result,
+        resultVertices,
+        nResultVertices,
+        resultTriangles,
+        nResultTriangles,
+        resultQuads,
+        nResultQuads);
+    g_resultVertices = result->vertices;
+    g_resultTriangles = result->triangles;
+    g_resultQuads = result->quads;
+    Dust3D_instantMeshesReleaseResult(result);
+    *resultVertices = g_resultVertices.data();
+    *resultTriangles = g_resultTriangles.data();
+    *resultQuads = g_resultQuads.data();
+}
+
+void DUST3D_INSTANT_MESHES_FUNCTION_CONVENTION Dust3D_instantMeshesReleaseResult(Dust3D_InstantMeshesResult *result)
+{
+    delete result;
+}
+
+static int remesh(const Dust3D_InstantMeshesVertex *vertices, size_t nVertices,
+    const Dust3D_InstantMeshesTriangle *triangles, size_t nTriangles,
+    size_t nTargetVertex,
+    const Dust3D_InstantMeshesOptions *options,
+    int nThreads,
+    Dust3D_InstantMeshesResult **result,
+    const Dust3D_InstantMeshesVertex **resultVertices,
+    size_t *nResultVertices,
+    const Dust3D_InstantMeshesTriangle **resultTriangles,
+    size_t *nResultTriangles,
+    const Dust3D_InstantMeshesQuad **resultQuads,
+    size_t *nResultQuads)
+{
+    *result = nullptr;
+    *nResultVertices = 0;
+    *resultVertices = nullptr;
+    *nResultTriangles = 0;
+    *resultTriangles = nullptr;
+    *nResultQuads = 0;
+    *resultQuads = nullptr;
+    
+    auto reportProgress = [&](float progress) {
+        if (nullptr == options || nullptr == options->progressCallback)
+            return true;
+        return 0 == options->progressCallback(progress, options->tag);
+    };
+    if (!reportProgress(0.0f))
+        return 0;
 
     int rosy = 4;
     int posy = 4;
@@ -107,6 +164,13 @@ void DUST3D_INSTANT_MESHES_FUNCTION_CONVENTION Dust3D_instantMeshesRemesh(const
     }
     
     bool pointcloud = F.size() == 0;
+    
+    auto releaseBvh = [&]() {
+        if (bvh) {
+            delete bvh;
+            bvh = nullptr;
+        }
+    };
 
     Timer<> timer;
     MeshStats stats = compute_mesh_stats(F, V, deterministic);
@@ -204,22 +268,46 @@ void DUST3D_INSTANT_MESHES_FUNCTION_CONVENTION Dust3D_instantMeshesRemesh(const
         bvh->build();
     }
 
-    Optimizer optimizer(mRes, false);
+    if (!reportProgress(0.1f)) {
+        releaseBvh();
+        return 0;
+    }
+
+    Optimizer optimizer(mRes, false, nThreads);
     optimizer.setRoSy(rosy);
     optimizer.setPoSy(posy);
     optimizer.setExtrinsic(extrinsic);
+    
+    // Polls the optimizer instead of waiting on it, so the progress is reported and the remeshing could be cancelled,
+    // a cancelled optimizer stops after the iteration in progress
+    auto waitOptimizer = [&](float progressFrom, float progressTo) {
+        optimizer.notify();
+        while (optimizer.active()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            if (!reportProgress(progressFrom + (progressTo - progressFrom) * std::min((float)optimizer.progress(), 1.0f))) {
+                optimizer.shutdown();
+                return false;
+            }
+        }
+        optimizer.wait();
+        return true;
+    };
 
     optimizer.optimizeOrientations(-1);
-    optimizer.notify();
-    optimizer.wait();
+    if (!waitOptimizer(0.1f, 0.5f)) {
+        releaseBvh();
+        return 0;
+    }
 
     std::map<uint32_t, uint32_t> sing;
     compute_orientation_singularities(mRes, sing, extrinsic, rosy);
     timer.reset();
 
     optimizer.optimizePositions(-1);
-    optimizer.notify();
-    optimizer.wait();
+    if (!waitOptimizer(0.5f, 0.9f)) {
+        releaseBvh();
+        return 0;
+    }
 
     optimizer.shutdown();
     
@@ -232,6 +320,8 @@ void DUST3D_INSTANT_MESHES_FUNCTION_CONVENTION Dust3D_instantMeshesRemesh(const
     extract_faces(adj_extr, O_extr, N_extr, Nf_extr, F_extr, posy,
             mRes.scale(), crease_out, true, pure_quad, bvh, smooth_iter);
 
+    Dust3D_InstantMeshesResult *output = new Dust3D_InstantMeshesResult;
+    
     auto outputFace = [&](const std::vector<size_t> &newFace) {
         if (newFace.size() > 4) {
             std::vector<simpleuv::Vertex> verticesForTriangulation;
@@ -240,13 +330,13 @@ void DUST3D_INSTANT_MESHES_FUNCTION_CONVENTION Dust3D_instantMeshesRemesh(const
             std::vector<size_t> ringForTriangulation;
             ringForTriangulation.reserve(newFace.size());
             for (const auto &it: newFace) {
-                const auto &position = g_resultVertices[it];
+                const auto &position = output->vertices[it];
                 ringForTriangulation.push_back(verticesForTriangulation.size());
                 verticesForTriangulation.push_back(simpleuv::Vertex {{position.x, position.y, position.z}});
             }
             simpleuv::triangulate(verticesForTriangulation, facesFromTriangulation, ringForTriangulation);
             for (const auto &it: facesFromTriangulation) {
-                g_resultTriangles.push_back(Dust3D_InstantMeshesTriangle {{
+                output->triangles.push_back(Dust3D_InstantMeshesTriangle {{
                     newFace[it.indices[0]],
                     newFace[it.indices[1]],
                     newFace[it.indices[2]]
@@ -254,7 +344,7 @@ void DUST3D_INSTANT_MESHES_FUNCTION_CONVENTION Dust3D_instantMeshesRemesh(const
             }
             return;
         } else if (newFace.size() == 4) {
-            g_resultQuads.push_back(Dust3D_InstantMeshesQuad {{
+            output->quads.push_back(Dust3D_InstantMeshesQuad {{
                 newFace[0],
                 newFace[1],
                 newFace[2],
@@ -262,7 +352,7 @@ void DUST3D_INSTANT_MESHES_FUNCTION_CONVENTION Dust3D_instantMeshesRemesh(const
             }});
             return;
         } else if (newFace.size() == 3) {
-            g_resultTriangles.push_back(Dust3D_InstantMeshesTriangle {{
+            output->triangles.push_back(Dust3D_InstantMeshesTriangle {{
                 newFace[0],
                 newFace[1],
                 newFace[2]
@@ -272,13 +362,13 @@ void DUST3D_INSTANT_MESHES_FUNCTION_CONVENTION Dust3D_instantMeshesRemesh(const
     };
     
     auto outputMesh = [&](const MatrixXf &V, const MatrixXu &F) {
-        g_resultVertices.resize(V.cols());
+        output->vertices.resize(V.cols());
         for (uint32_t i = 0; i < V.cols(); ++i) {
-            g_resultVertices[i] = Dust3D_InstantMeshesVertex {V(0, i), V(1, i), V(2, i)};
+            output->vertices[i] = Dust3D_InstantMeshesVertex {V(0, i), V(1, i), V(2, i)};
         }
         
-        g_resultTriangles.clear();
-        g_resultQuads.clear();
+        output->triangles.clear();
+        output->quads.clear();
         
         std::map<uint32_t, std::pair<uint32_t, std::map<uint32_t, uint32_t>>> irregularMap;
         size_t nIrregular = 0;
@@ -312,13 +402,50 @@ void DUST3D_INSTANT_MESHES_FUNCTION_CONVENTION Dust3D_instantMeshesRemesh(const
     };
     outputMesh(O_extr, F_extr);
     
-    if (bvh)
-        delete bvh;
+    releaseBvh();
+
+    *result = output;
+    *nResultVertices = output->vertices.size();
+    *resultVertices = output->vertices.data();
+    *nResultTriangles = output->triangles.size();
+    *resultTriangles = output->triangles.data();
+    *nResultQuads = output->quads.size();
+    *resultQuads = output->quads.data();
+    
+    reportProgress(1.0f);
+    return 1;
+}
 
-    *nResultVertices = g_resultVertices.size();
-    *resultVertices = g_resultVertices.data();
-    *nResultTriangles = g_resultTriangles.size();
-    *resultTriangles = g_resultTriangles.data();
-    *nResultQuads = g_resultQuads.size();
-    *resultQuads = g_resultQuads.data();
+int DUST3D_INSTANT_MESHES_FUNCTION_CONVENTION Dust3D_instantMeshesRemeshWithOptions(const Dust3D_InstantMeshesVertex *vertices, size_t nVertices,
+    const Dust3D_InstantMeshesTriangle *triangles, size_t nTriangles,
+    size_t nTargetVertex,
+    const Dust3D_InstantMeshesOptions *options,
+    Dust3D_InstantMeshesResult **result,
+    const Dust3D_InstantMeshesVertex **resultVertices,
+    size_t *nResultVertices,
+    const Dust3D_InstantMeshesTriangle **resultTriangles,
+    size_t *nResultTriangles,
+    const Dust3D_InstantMeshesQuad **resultQuads,
+    size_t *nResultQuads)
+{
+    // Each remeshing runs in arenas of its own, the calling thread in this one and the optimizer thread in another,
+    // so the thread count of one leaves the other remeshings and the global scheduler alone
+    int nThreads = (nullptr != options && options->nThreads > 0) ? options->nThreads : tbb::task_arena::automatic;
+    tbb::task_arena arena(nThreads);
+    int succeed = 0;
+    arena.execute([&]() {
+        succeed = remesh(vertices, nVertices,
+            triangles, nTriangles,
+            nTargetVertex,
+            options,
+            nThreads,
+            result,
+            resultVertices,
+            nResultVertices,
+            resultTriangles,
+            nResultTriangles,
+            resultQuads,
+            nResultQuads);
+    });
+    return succeed;
 }
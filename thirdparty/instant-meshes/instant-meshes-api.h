@@ -72,6 +72,20 @@ typedef struct
 #    define DUST3D_INSTANT_MESHES_API extern "C"
 #endif
 
+/* Called from the calling thread with the progress from 0 to 1, returns non zero to cancel the remeshing */
+typedef int (DUST3D_INSTANT_MESHES_FUNCTION_CONVENTION *Dust3D_InstantMeshesProgressCallback)(float progress, void *tag);
+
+/* Owns the result buffers of one remeshing */
+typedef struct Dust3D_InstantMeshesResult Dust3D_InstantMeshesResult;
+
+typedef struct
+{
+    int nThreads; /* Zero for as many threads as the cores */
+    Dust3D_InstantMeshesProgressCallback progressCallback; /* Could be null */
+    void *tag;
+} Dust3D_InstantMeshesOptions;
+
+/* The results are kept in buffers shared by all the calls, not safe to be called from multiple threads */
 DUST3D_INSTANT_MESHES_API void DUST3D_INSTANT_MESHES_FUNCTION_CONVENTION Dust3D_instantMeshesRemesh(const Dust3D_InstantMeshesVertex *vertices, size_t nVertices,
     const Dust3D_InstantMeshesTriangle *triangles, size_t nTriangles,
     size_t nTargetVertex,
@@ -82,4 +96,21 @@ DUST3D_INSTANT_MESHES_API void DUST3D_INSTANT_MESHES_FUNCTION_CONVENTION Dust3D_
     const Dust3D_InstantMeshesQuad **resultQuads,
     size_t *nResultQuads);
 
+/* Returns zero when cancelled by the progress callback, the results are left empty and *result null then;
+   the result buffers belong to *result, which is released by Dust3D_instantMeshesReleaseResult,
+   so this could be called from multiple threads at the same time */
+DUST3D_INSTANT_MESHES_API int DUST3D_INSTANT_MESHES_FUNCTION_CONVENTION Dust3D_instantMeshesRemeshWithOptions(const Dust3D_InstantMeshesVertex *vertices, size_t nVertices,
+    const Dust3D_InstantMeshesTriangle *triangles, size_t nTriangles,
+    size_t nTargetVertex,
+    const Dust3D_InstantMeshesOptions *options,
+    Dust3D_InstantMeshesResult **result,
+    const Dust3D_InstantMeshesVertex **resultVertices,
+    size_t *nResultVertices,
+    const Dust3D_InstantMeshesTriangle **resultTriangles,
+    size_t *nResultTriangles,
+    const Dust3D_InstantMeshesQuad **resultQuads,
+    size_t *nResultQuads);
+
+DUST3D_INSTANT_MESHES_API void DUST3D_INSTANT_MESHES_FUNCTION_CONVENTION Dust3D_instantMeshesReleaseResult(Dust3D_InstantMeshesResult *result);
+
 #endif
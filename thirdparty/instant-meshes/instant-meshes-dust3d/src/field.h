@@ -156,7 +156,9 @@ compute_position_singularities(const MultiResolutionHierarchy &mRes,
 class Serializer;
 class Optimizer {
 public:
-    Optimizer(MultiResolutionHierarchy &mRes, bool interactive);
+    /* The optimizer runs in an arena of its own with at most threadCount threads */
+    Optimizer(MultiResolutionHierarchy &mRes, bool interactive,
+              int threadCount = tbb::task_arena::automatic);
     void save(Serializer &state);
     void load(const Serializer &state);
 
@@ -201,6 +203,8 @@ public:
 
     void run();
 protected:
+    void runIterations();
+
     MultiResolutionHierarchy &mRes;
     std::vector<std::pair<bool, std::vector<uint32_t>>> mAttractorStrokes;
     bool mRunning;
@@ -215,6 +219,7 @@ protected:
     bool mInteractive;
     double mLastUpdate;
     Float mProgress;
+    int mThreadCount;
 #ifdef VISUALIZE_ERROR
     VectorXf mError;
 #endif
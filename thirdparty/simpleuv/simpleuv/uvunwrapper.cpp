@@ -1,5 +1,6 @@
 #include <map>
 #include <unordered_set>
+#include <unordered_map>
 #include <set>
 #include <queue>
 #include <cmath>
@@ -40,33 +41,35 @@ const std::vector<int> &UvUnwrapper::getChartSourcePartitions() const
     return m_chartSourcePartitions;
 }
 
-void UvUnwrapper::buildEdgeToFaceMap(const std::vector<Face> &faces, std::map<std::pair<size_t, size_t>, size_t> &edgeToFaceMap)
+void UvUnwrapper::buildEdgeToFaceMap(const std::vector<Face> &faces, EdgeToFaceMap &edgeToFaceMap)
 {
     edgeToFaceMap.clear();
+    edgeToFaceMap.reserve(faces.size() * 3);
     for (decltype(faces.size()) index = 0; index < faces.size(); ++index) {
         const auto &face = faces[index];
         for (size_t i = 0; i < 3; i++) {
             size_t j = (i + 1) % 3;
-            edgeToFaceMap[{face.indices[i], face.indices[j]}] = index;
+            edgeToFaceMap[edgeKey(face.indices[i], face.indices[j])] = index;
         }
     }
 }
 
-void UvUnwrapper::buildEdgeToFaceMap(const std::vector<size_t> &group, std::map<std::pair<size_t, size_t>, size_t> &edgeToFaceMap)
+void UvUnwrapper::buildEdgeToFaceMap(const std::vector<size_t> &group, EdgeToFaceMap &edgeToFaceMap)
 {
     edgeToFaceMap.clear();
+    edgeToFaceMap.reserve(group.size() * 3);
     for (const auto &index: group) {
         const auto &face = m_mesh.faces[index];
         for (size_t i = 0; i < 3; i++) {
             size_t j = (i + 1) % 3;
-            edgeToFaceMap[{face.indices[i], face.indices[j]}] = index;
+            edgeToFaceMap[edgeKey(face.indices[i], face.indices[j])] = index;
         }
     }
 }
 
 void UvUnwrapper::splitPartitionToIslands(const std::vector<size_t> &group, std::vector<std::vector<size_t>> &islands)
 {
-    std::map<std::pair<size_t, size_t>, size_t> edgeToFaceMap;
+    EdgeToFaceMap edgeToFaceMap;
     buildEdgeToFaceMap(group, edgeToFaceMap);
     bool segmentByNormal = !m_mesh.faceNormals.empty() && m_segmentByNormal;
     
@@ -85,7 +88,7 @@ void UvUnwrapper::splitPartitionToIslands(const std::vector<size_t> &group, std:
             const auto &face = m_mesh.faces[index];
             for (size_t i = 0; i < 3; i++) {
                 size_t j = (i + 1) % 3;
-                auto findOppositeFaceResult = edgeToFaceMap.find({face.indices[j], face.indices[i]});
+                auto findOppositeFaceResult = edgeToFaceMap.find(edgeKey(face.indices[j], face.indices[i]));
                 if (findOppositeFaceResult == edgeToFaceMap.end())
                     continue;
                 if (segmentByNormal) {
@@ -153,14 +156,14 @@ void UvUnwrapper::triangulateRing(const std::vector<Vertex> &verticies,
 // The hole filling faces should be put in the back of faces vector, so these uv coords of appended faces will be disgarded.
 bool UvUnwrapper::fixHolesExceptTheLongestRing(const std::vector<Vertex> &verticies, std::vector<Face> &faces, size_t *remainingHoleNum)
 {
-    std::map<std::pair<size_t, size_t>, size_t> edgeToFaceMap;
+    EdgeToFaceMap edgeToFaceMap;
     buildEdgeToFaceMap(faces, edgeToFaceMap);
     
     std::map<size_t, std::vector<size_t>> holeVertexLink;
     for (const auto &face: faces) {
         for (size_t i = 0; i < 3; i++) {
             size_t j = (i + 1) % 3;
-            auto findOppositeFaceResult = edgeToFaceMap.find({face.indices[j], face.indices[i]});
+            auto findOppositeFaceResult = edgeToFaceMap.find(edgeKey(face.indices[j], face.indices[i]));
             if (findOppositeFaceResult != edgeToFaceMap.end())
                 continue;
             holeVertexLink[face.indices[j]].push_back(face.indices[i]);
@@ -285,7 +288,7 @@ void UvUnwrapper::makeSeamAndCut(const std::vector<Vertex> &verticies,
     if (-1 == choosenIndex)
         return;
     
-    std::map<std::pair<size_t, size_t>, size_t> edgeToFaceMap;
+    EdgeToFaceMap edgeToFaceMap;
     buildEdgeToFaceMap(faces, edgeToFaceMap);
     
     std::unordered_set<size_t> processedFaces;
@@ -299,7 +302,7 @@ void UvUnwrapper::makeSeamAndCut(const std::vector<Vertex> &verticies,
         const auto &face = faces[index];
         for (size_t i = 0; i < 3; i++) {
             size_t j = (i + 1) % 3;
-            auto findOppositeFaceResult = edgeToFaceMap.find({face.indices[j], face.indices[i]});
+            auto findOppositeFaceResult = edgeToFaceMap.find(edgeKey(face.indices[j], face.indices[i]));
             if (findOppositeFaceResult == edgeToFaceMap.end())
                 continue;
             waitFaces.push(findOppositeFaceResult->second);
@@ -2,6 +2,8 @@
 #define SIMPLEUV_UV_UNWRAPPER_H
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <cstdint>
 #include <simpleuv/meshdatatype.h>
 #include <Eigen/Dense>
 #include <tuple>
@@ -37,8 +39,13 @@ private:
     void calculateSizeAndRemoveInvalidCharts();
     void packCharts();
     void finalizeUv();
-    void buildEdgeToFaceMap(const std::vector<size_t> &group, std::map<std::pair<size_t, size_t>, size_t> &edgeToFaceMap);
-    void buildEdgeToFaceMap(const std::vector<Face> &faces, std::map<std::pair<size_t, size_t>, size_t> &edgeToFaceMap);
+    typedef std::unordered_map<uint64_t, size_t> EdgeToFaceMap;
+    static uint64_t edgeKey(size_t from, size_t to)
+    {
+        return ((uint64_t)from << 32) | (uint64_t)to;
+    }
+    void buildEdgeToFaceMap(const std::vector<size_t> &group, EdgeToFaceMap &edgeToFaceMap);
+    void buildEdgeToFaceMap(const std::vector<Face> &faces, EdgeToFaceMap &edgeToFaceMap);
     double distanceBetweenVertices(const Vertex &first, const Vertex &second);
     float areaOf3dTriangle(const Eigen::Vector3d &a, const Eigen::Vector3d &b, const Eigen::Vector3d &c);
     float areaOf2dTriangle(const Eigen::Vector2d &a, const Eigen::Vector2d &b, const Eigen::Vector2d &c);